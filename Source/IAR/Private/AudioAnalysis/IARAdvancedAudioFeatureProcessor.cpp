@@ -38,11 +38,11 @@ UIARAdvancedAudioFeatureProcessor::~UIARAdvancedAudioFeatureProcessor()
 void UIARAdvancedAudioFeatureProcessor::Initialize()
 {
     Super::Initialize(); 
-    SpectrogramDataHistory.Empty();
-    FilteredSpectrogramDataHistory.Empty(); // NOVO: Limpa o hist�rico filtrado
     CurrentSpectrogramPixels.Empty();
     CurrentFilteredSpectrogramPixels.Empty(); // NOVO: Limpa os pixels filtrados
     CurrentWaveformPixels.Empty();
+    SpectrogramColumnsWritten = 0;
+    LastSpectrum.Empty();
     // Re-initialize LastDetectedNote and bHasPreviousNote from base class
     LastDetectedNote = FIAR_AudioNoteFeature(); 
     bHasPreviousNote = false;
@@ -52,11 +52,11 @@ void UIARAdvancedAudioFeatureProcessor::Initialize()
 void UIARAdvancedAudioFeatureProcessor::Shutdown()
 {
     Super::Shutdown(); 
-    SpectrogramDataHistory.Empty();
-    FilteredSpectrogramDataHistory.Empty(); // NOVO: Limpa o hist�rico filtrado
     CurrentSpectrogramPixels.Empty();
     CurrentFilteredSpectrogramPixels.Empty(); // NOVO: Limpa os pixels filtrados
     CurrentWaveformPixels.Empty();
+    SpectrogramColumnsWritten = 0;
+    LastSpectrum.Empty();
     // Re-initialize LastDetectedNote and bHasPreviousNote from base class
     LastDetectedNote = FIAR_AudioNoteFeature(); 
     bHasPreviousNote = false;
@@ -228,45 +228,35 @@ TArray<FIAR_AudioNoteFeature> UIARAdvancedAudioFeatureProcessor::FindTopFrequenc
     return DetectedNotes;
 }
 
-// Este m�todo agora recebe o hist�rico (filtrado ou n�o) como par�metro
-void UIARAdvancedAudioFeatureProcessor::GenerateSpectrogramPixels(TArray<FColor>& OutPixels, int32 Width, int32 Height, const TArray<TArray<float>>& InHistory)
+FColor UIARAdvancedAudioFeatureProcessor::SpectrogramValueToColor(float Value)
 {
-    OutPixels.SetNumZeroed(Width * Height);
-    
-    float MaxValInHistory = 0.0f;
-    if (InHistory.Num() > 0)
+    // --- MELHORIA DE BRILHO/CONTRASTE ---
+    // Raiz quadrada para amplificar valores baixos, e um piso de brilho
+    Value = FMath::Lerp(0.05f, 1.0f, FMath::Sqrt(FMath::Max(Value, 0.0f)));
+    Value = FMath::Clamp(Value, 0.0f, 1.0f);
+
+    float Hue = (1.0f - Value) * 240.0f; // Mapeia 0.0 (alto valor) para azul (240), 1.0 (baixo valor) para vermelho/roxo (0)
+    return FLinearColor::MakeFromHSV8(Hue, 255, Value * 255).ToFColor(true);
+}
+
+// Escreve somente a coluna nova no buffer circular (antes o histórico inteiro era deslocado e regerado a cada frame)
+void UIARAdvancedAudioFeatureProcessor::WriteSpectrogramColumn(TArray<FColor>& InOutPixels, int32 Width, int32 Height, int32 Column, const TArray<float>& Spectrum)
+{
+    if (Width <= 0 || Height <= 0 || Column < 0 || Column >= Width)
     {
-        for (const TArray<float>& Spectrum : InHistory)
-        {
-            for (float Val : Spectrum)
-            {
-                MaxValInHistory = FMath::Max(MaxValInHistory, Val);
-            }
-        }
+        return;
     }
-    // UE_LOG(LogIAR, Log, TEXT("Spectrogram: Max Value in History (Raw): %.6f"), MaxValInHistory);
-    for (int32 y = 0; y < Height; ++y) 
+
+    if (InOutPixels.Num() != Width * Height)
     {
-        for (int32 x = 0; x < Width; ++x) 
-        {
-            float Value = 0.0f; 
-            // Garante que o acesso ao hist�rico est� dentro dos limites
-            if (x < InHistory.Num() && y < InHistory[x].Num())
-            {
-                // Acesso aos dados do espectro, normalizado para 0-1
-                Value = InHistory[x][y]; 
-            }
+        // Primeira escrita (ou mudança de dimensões): preenche com a cor de "silêncio"
+        InOutPixels.Init(SpectrogramValueToColor(0.0f), Width * Height);
+    }
 
-            // --- MELHORIA DE BRILHO/CONTRASTE ---
-            // Raiz quadrada para amplificar valores baixos, e um piso de brilho
-            Value = FMath::Lerp(0.05f, 1.0f, FMath::Sqrt(Value)); 
-            Value = FMath::Clamp(Value, 0.0f, 1.0f); 
-            
-            FColor PixelColor;
-            float Hue = (1.0f - Value) * 240.0f; // Mapeia 0.0 (alto valor) para azul (240), 1.0 (baixo valor) para vermelho/roxo (0)
-            PixelColor = FLinearColor::MakeFromHSV8(Hue, 255, Value * 255).ToFColor(true); 
-            OutPixels[y * Width + x] = PixelColor;
-        }
+    for (int32 y = 0; y < Height; ++y)
+    {
+        const float Value = (y < Spectrum.Num()) ? Spectrum[y] : 0.0f;
+        InOutPixels[y * Width + Column] = SpectrogramValueToColor(Value);
     }
 }
 
@@ -396,8 +386,8 @@ FIAR_AudioFeatures UIARAdvancedAudioFeatureProcessor::ProcessFrame(const TShared
 
     GenerateWaveformPixels(MonoSamples, CurrentWaveformPixels, WaveformDisplayWidth, WaveformDisplayHeight);
 
-    // Espectro ORIGINAL (n�o filtrado)
-    TArray<float> CurrentSpectrum;
+    // Espectro ORIGINAL (n�o filtrado), calculado diretamente no membro exposto por GetLastSpectrum
+    TArray<float>& CurrentSpectrum = LastSpectrum;
     if (!CalculateFFT(MonoSamples, SampleRate, CurrentSpectrum)) 
     {
         UE_LOG(LogIAR, Error, TEXT("UIARAdvancedAudioFeatureProcessor: Falha ao calcular FFT."));
@@ -415,24 +405,12 @@ FIAR_AudioFeatures UIARAdvancedAudioFeatureProcessor::ProcessFrame(const TShared
     // O PitchEstimate ainda � feito no MonoSamples, antes de qualquer filtragem de espectro
     Features.PitchEstimate = CalculateZeroCrossingRatePitchEstimate(MonoSamples, SampleRate);
 
-    // --- Hist�ricos e Gera��o de Pixels para Espectrogramas ---
-    // Hist�rico de espectro ORIGINAL (para o SpectrogramTexture principal)
-    SpectrogramDataHistory.Add(CurrentSpectrum);
-    while (SpectrogramDataHistory.Num() > MaxSpectrogramHistoryFrames)
-    {
-        SpectrogramDataHistory.RemoveAt(0); 
-    }
-    // Gera pixels para o espectrograma ORIGINAL
-    GenerateSpectrogramPixels(CurrentSpectrogramPixels, MaxSpectrogramHistoryFrames, SpectrogramHeight, SpectrogramDataHistory);
-
-    // Hist�rico de espectro FILTRADO (para o FilteredSpectrogramTexture)
-    FilteredSpectrogramDataHistory.Add(FilteredSpectrum);
-    while (FilteredSpectrogramDataHistory.Num() > MaxSpectrogramHistoryFrames)
-    {
-        FilteredSpectrogramDataHistory.RemoveAt(0);
-    }
-    // Gera pixels para o espectrograma FILTRADO
-    GenerateSpectrogramPixels(CurrentFilteredSpectrogramPixels, MaxSpectrogramHistoryFrames, SpectrogramHeight, FilteredSpectrogramDataHistory);
+    // --- Geração de Pixels para Espectrogramas (buffer circular de colunas) ---
+    // Cada frame escreve apenas a coluna atual; o consumidor envia à GPU somente as colunas novas.
+    const int32 SpectrogramColumn = static_cast<int32>(SpectrogramColumnsWritten % (uint64)MaxSpectrogramHistoryFrames);
+    WriteSpectrogramColumn(CurrentSpectrogramPixels, MaxSpectrogramHistoryFrames, SpectrogramHeight, SpectrogramColumn, CurrentSpectrum);
+    WriteSpectrogramColumn(CurrentFilteredSpectrogramPixels, MaxSpectrogramHistoryFrames, SpectrogramHeight, SpectrogramColumn, FilteredSpectrum);
+    ++SpectrogramColumnsWritten;
 
     // OutSpectrogramTexture n�o � definido aqui, � no AudioComponent.
 
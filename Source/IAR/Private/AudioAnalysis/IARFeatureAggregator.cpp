@@ -0,0 +1,202 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "AudioAnalysis/IARFeatureAggregator.h"
+#include "../IAR.h" // Para logging
+
+namespace IARFeatureAggregatorPrivate
+{
+    // Aplica Func a cada métrica instantânea (escalar) das features, em pares (Dest, Source)
+    template<typename FuncType>
+    void ForEachScalar(FIAR_AudioFeatures& Dest, const FIAR_AudioFeatures& Source, FuncType Func)
+    {
+        Func(Dest.RMSAmplitude, Source.RMSAmplitude);
+        Func(Dest.PeakAmplitude, Source.PeakAmplitude);
+        Func(Dest.ZeroCrossingRate, Source.ZeroCrossingRate);
+        Func(Dest.SpectralCentroid, Source.SpectralCentroid);
+        Func(Dest.SpectralBandwidth, Source.SpectralBandwidth);
+        Func(Dest.SpectralFlatness, Source.SpectralFlatness);
+        Func(Dest.SpectralRollOff, Source.SpectralRollOff);
+        Func(Dest.PitchEstimate, Source.PitchEstimate);
+
+        const int32 NumMFCCs = FMath::Min(Dest.MFCCs.Num(), Source.MFCCs.Num());
+        for (int32 i = 0; i < NumMFCCs; ++i)
+        {
+            Func(Dest.MFCCs[i], Source.MFCCs[i]);
+        }
+    }
+
+    // Copia os escalares e dimensiona os MFCCs de Dest como os de Source
+    void CopyScalars(FIAR_AudioFeatures& Dest, const FIAR_AudioFeatures& Source)
+    {
+        Dest.MFCCs.SetNumZeroed(Source.MFCCs.Num(), EAllowShrinking::No);
+        ForEachScalar(Dest, Source, [](float& D, float S) { D = S; });
+    }
+}
+
+FIARFeatureAggregator::FIARFeatureAggregator(int32 InMaxMIDIEvents)
+    : NumFrames(0)
+    , MaxMIDIEvents(FMath::Max(1, InMaxMIDIEvents))
+    , NumDroppedMIDIEvents(0)
+{
+}
+
+void FIARFeatureAggregator::SetMaxMIDIEvents(int32 InMaxMIDIEvents)
+{
+    MaxMIDIEvents = FMath::Max(1, InMaxMIDIEvents);
+    TrimMIDIEvents();
+}
+
+void FIARFeatureAggregator::Accumulate(const FIAR_AudioFeatures& Features)
+{
+    using namespace IARFeatureAggregatorPrivate;
+
+    if (NumFrames == 0)
+    {
+        CopyScalars(SumFeatures, Features);
+        CopyScalars(MaxFeatures, Features);
+    }
+    else
+    {
+        ForEachScalar(SumFeatures, Features, [](float& D, float S) { D += S; });
+        ForEachScalar(MaxFeatures, Features, [](float& D, float S) { D = FMath::Max(D, S); });
+    }
+
+    // Arrays de LastFeatures ficam vazios: notas e eventos vivem em UnionNotes/AllMIDIEvents
+    CopyScalars(LastFeatures, Features);
+    LastFeatures.OctavesUsed = Features.OctavesUsed;
+    LastFeatures.AccidentalsUsed = Features.AccidentalsUsed;
+    LastFeatures.AverageNoteDuration = Features.AverageNoteDuration;
+    LastFeatures.MostUsedMidiNote = Features.MostUsedMidiNote;
+    LastFeatures.UniqueMidiNotesCount = Features.UniqueMidiNotesCount;
+    LastFeatures.MaxConsecutiveRepeats = Features.MaxConsecutiveRepeats;
+    LastFeatures.AverageBPM = Features.AverageBPM;
+    LastFeatures.AttitudeScore = Features.AttitudeScore;
+
+    for (const FIAR_AudioNoteFeature& Note : Features.DetectedNotes)
+    {
+        AddNote(Note);
+    }
+    AllMIDIEvents.Append(Features.ProcessedMIDIEvents);
+    TrimMIDIEvents();
+
+    ++NumFrames;
+}
+
+void FIARFeatureAggregator::Merge(const FIARFeatureAggregator& Other)
+{
+    using namespace IARFeatureAggregatorPrivate;
+
+    if (Other.NumFrames == 0)
+    {
+        return;
+    }
+
+    if (NumFrames == 0)
+    {
+        // Preserva o limite deste agregador e os descartes já contados desde o último Reset
+        const int32 OwnMaxMIDIEvents = MaxMIDIEvents;
+        const int32 OwnDroppedMIDIEvents = NumDroppedMIDIEvents;
+        *this = Other;
+        MaxMIDIEvents = OwnMaxMIDIEvents;
+        NumDroppedMIDIEvents += OwnDroppedMIDIEvents;
+        TrimMIDIEvents();
+        return;
+    }
+
+    ForEachScalar(SumFeatures, Other.SumFeatures, [](float& D, float S) { D += S; });
+    ForEachScalar(MaxFeatures, Other.MaxFeatures, [](float& D, float S) { D = FMath::Max(D, S); });
+    LastFeatures = Other.LastFeatures;
+
+    for (const FIAR_AudioNoteFeature& Note : Other.UnionNotes)
+    {
+        AddNote(Note);
+    }
+    AllMIDIEvents.Append(Other.AllMIDIEvents);
+    NumDroppedMIDIEvents += Other.NumDroppedMIDIEvents;
+    TrimMIDIEvents();
+
+    NumFrames += Other.NumFrames;
+}
+
+void FIARFeatureAggregator::Finalize(EIARFeatureAggregationMode Mode, FIAR_AudioFeatures& OutFeatures) const
+{
+    using namespace IARFeatureAggregatorPrivate;
+
+    // Parte do último frame (inclui o Attitude-Gram, que já é cumulativo)
+    CopyScalars(OutFeatures, LastFeatures);
+    OutFeatures.OctavesUsed = LastFeatures.OctavesUsed;
+    OutFeatures.AccidentalsUsed = LastFeatures.AccidentalsUsed;
+    OutFeatures.AverageNoteDuration = LastFeatures.AverageNoteDuration;
+    OutFeatures.MostUsedMidiNote = LastFeatures.MostUsedMidiNote;
+    OutFeatures.UniqueMidiNotesCount = LastFeatures.UniqueMidiNotesCount;
+    OutFeatures.MaxConsecutiveRepeats = LastFeatures.MaxConsecutiveRepeats;
+    OutFeatures.AverageBPM = LastFeatures.AverageBPM;
+    OutFeatures.AttitudeScore = LastFeatures.AttitudeScore;
+
+    if (NumFrames > 0)
+    {
+        if (Mode == EIARFeatureAggregationMode::Mean)
+        {
+            const float InvNumFrames = 1.0f / (float)NumFrames;
+            ForEachScalar(OutFeatures, SumFeatures, [InvNumFrames](float& D, float S) { D = S * InvNumFrames; });
+        }
+        else if (Mode == EIARFeatureAggregationMode::Max)
+        {
+            ForEachScalar(OutFeatures, MaxFeatures, [](float& D, float S) { D = S; });
+        }
+    }
+
+    OutFeatures.DetectedNotes.Reset();
+    OutFeatures.DetectedNotes.Append(UnionNotes);
+    // Notas mais fortes primeiro, como no processador (a primeira é a nota principal)
+    OutFeatures.DetectedNotes.Sort([](const FIAR_AudioNoteFeature& A, const FIAR_AudioNoteFeature& B)
+    {
+        return A.Velocity > B.Velocity;
+    });
+
+    OutFeatures.ProcessedMIDIEvents.Reset();
+    OutFeatures.ProcessedMIDIEvents.Append(AllMIDIEvents);
+}
+
+void FIARFeatureAggregator::Reset()
+{
+    NumFrames = 0;
+    NumDroppedMIDIEvents = 0;
+    UnionNotes.Reset();
+    AllMIDIEvents.Reset();
+}
+
+void FIARFeatureAggregator::TrimMIDIEvents()
+{
+    // Mantém os eventos mais recentes: os mais antigos já teriam perdido o sentido para quem consome em tempo real
+    const int32 Excess = AllMIDIEvents.Num() - MaxMIDIEvents;
+    if (Excess > 0)
+    {
+        AllMIDIEvents.RemoveAt(0, Excess, EAllowShrinking::No);
+        NumDroppedMIDIEvents += Excess;
+    }
+}
+
+void FIARFeatureAggregator::AddNote(const FIAR_AudioNoteFeature& Note)
+{
+    for (FIAR_AudioNoteFeature& Existing : UnionNotes)
+    {
+        if (Existing.MIDINoteNumber == Note.MIDINoteNumber)
+        {
+            // Mesma nota em vários frames: mantém a ocorrência mais forte, mas preserva o início mais antigo
+            const float EarliestStart = (Existing.StartTime >= 0.0f && (Note.StartTime < 0.0f || Existing.StartTime < Note.StartTime)) ? Existing.StartTime : Note.StartTime;
+            if (Note.Velocity > Existing.Velocity)
+            {
+                Existing = Note;
+            }
+            Existing.StartTime = EarliestStart;
+            return;
+        }
+    }
+    UnionNotes.Add(Note);
+}
@@ -0,0 +1,288 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "AudioAnalysis/IARWaveformSummary.h"
+#include "../IAR.h" // Para logging
+#include "Misc/ScopeLock.h"
+
+void FIARWaveformSummary::FBucket::Merge(const FBucket& Other)
+{
+    if (Other.NumSamples == 0)
+    {
+        return;
+    }
+    if (NumSamples == 0)
+    {
+        *this = Other;
+        return;
+    }
+    Min = FMath::Min(Min, Other.Min);
+    Max = FMath::Max(Max, Other.Max);
+    SumSquares += Other.SumSquares;
+    NumSamples += Other.NumSamples;
+}
+
+FIARWaveformSummary::FIARWaveformSummary(int32 InBaseBlockFrames, int32 InMaxFinestBuckets)
+    : BaseBlockFrames(FMath::Max(1, InBaseBlockFrames))
+    , MaxFinestBuckets(FMath::Max(2, InMaxFinestBuckets))
+    , FinestLevel(0)
+    , SampleRate(0)
+    , NumChannels(0)
+    , TotalFrames(0)
+    , SamplesInCurrentFrame(0)
+    , FramesInPartialBlock(0)
+{
+}
+
+void FIARWaveformSummary::Reset(int32 InSampleRate, int32 InNumChannels)
+{
+    FScopeLock Lock(&SummaryLock);
+    SampleRate = InSampleRate;
+    NumChannels = FMath::Max(1, InNumChannels);
+    TotalFrames = 0;
+    SamplesInCurrentFrame = 0;
+    FramesInPartialBlock = 0;
+    FinestLevel = 0;
+    Levels.Empty();
+    PartialBuckets.Empty();
+    PartialChildren.Empty();
+}
+
+int64 FIARWaveformSummary::GetNumFrames() const
+{
+    FScopeLock Lock(&SummaryLock);
+    return TotalFrames;
+}
+
+double FIARWaveformSummary::GetDurationSeconds() const
+{
+    FScopeLock Lock(&SummaryLock);
+    return (SampleRate > 0) ? (double)TotalFrames / (double)SampleRate : 0.0;
+}
+
+void FIARWaveformSummary::AppendInterleaved(const float* Samples, int64 NumSamples)
+{
+    if (!Samples || NumSamples <= 0)
+    {
+        return;
+    }
+
+    FScopeLock Lock(&SummaryLock);
+    if (NumChannels <= 0 || SampleRate <= 0)
+    {
+        UE_LOG(LogIAR, Warning, TEXT("FIARWaveformSummary: AppendInterleaved chamado antes de Reset. Amostras ignoradas."));
+        return;
+    }
+
+    if (PartialBuckets.Num() == 0)
+    {
+        PartialBuckets.AddDefaulted(1);
+        PartialChildren.AddZeroed(1);
+        Levels.AddDefaulted(1);
+    }
+
+    int64 Offset = 0;
+    while (Offset < NumSamples)
+    {
+        // Processa em blocos contíguos até completar o bloco de nível 0 atual (laço simples, vetorizável)
+        const int64 SamplesToCompleteBlock = (int64)(BaseBlockFrames - FramesInPartialBlock) * NumChannels - SamplesInCurrentFrame;
+        const int64 Count = FMath::Min(SamplesToCompleteBlock, NumSamples - Offset);
+
+        const float* Chunk = Samples + Offset;
+        float ChunkMin = Chunk[0];
+        float ChunkMax = Chunk[0];
+        double ChunkSumSquares = 0.0;
+        for (int64 i = 0; i < Count; ++i)
+        {
+            const float Sample = Chunk[i];
+            ChunkMin = FMath::Min(ChunkMin, Sample);
+            ChunkMax = FMath::Max(ChunkMax, Sample);
+            ChunkSumSquares += (double)Sample * Sample;
+        }
+
+        FBucket ChunkBucket;
+        ChunkBucket.Min = ChunkMin;
+        ChunkBucket.Max = ChunkMax;
+        ChunkBucket.SumSquares = ChunkSumSquares;
+        ChunkBucket.NumSamples = Count;
+        PartialBuckets[0].Merge(ChunkBucket);
+
+        // Atualiza a contagem de frames completos
+        const int64 SamplesWithCurrent = SamplesInCurrentFrame + Count;
+        const int64 NewFrames = SamplesWithCurrent / NumChannels;
+        SamplesInCurrentFrame = (int32)(SamplesWithCurrent % NumChannels);
+        FramesInPartialBlock += (int32)NewFrames;
+        TotalFrames += NewFrames;
+
+        if (FramesInPartialBlock >= BaseBlockFrames)
+        {
+            const FBucket Completed = PartialBuckets[0];
+            PartialBuckets[0] = FBucket();
+            FramesInPartialBlock = 0;
+            PushBucket(0, Completed);
+        }
+
+        Offset += Count;
+    }
+}
+
+void FIARWaveformSummary::PushBucket(int32 Level, const FBucket& Bucket)
+{
+    // Níveis descartados continuam alimentando os pais, mas não guardam mais blocos
+    if (Level >= FinestLevel)
+    {
+        Levels[Level].Add(Bucket);
+    }
+
+    const int32 ParentLevel = Level + 1;
+    if (PartialBuckets.Num() <= ParentLevel)
+    {
+        PartialBuckets.AddDefaulted(1);
+        PartialChildren.AddZeroed(1);
+        Levels.AddDefaulted(1);
+    }
+
+    // Limite de memória: o nível mais fino é descartado e o pai (com metade dos blocos) assume a resolução máxima
+    if (Level == FinestLevel && Levels[Level].Num() > MaxFinestBuckets)
+    {
+        Levels[Level].Empty();
+        ++FinestLevel;
+        UE_LOG(LogIAR, Log, TEXT("FIARWaveformSummary: Limite de %d blocos atingido; resolução máxima passa a %d frames por bloco."),
+            MaxFinestBuckets, BaseBlockFrames << FinestLevel);
+    }
+
+    PartialBuckets[ParentLevel].Merge(Bucket);
+    if (++PartialChildren[ParentLevel] == 2)
+    {
+        const FBucket Completed = PartialBuckets[ParentLevel];
+        PartialBuckets[ParentLevel] = FBucket();
+        PartialChildren[ParentLevel] = 0;
+        PushBucket(ParentLevel, Completed);
+    }
+}
+
+void FIARWaveformSummary::MergeRange(int32 Level, int64 FrameStart, int64 FrameEnd, FBucket& Accumulator) const
+{
+    if (FrameEnd <= FrameStart)
+    {
+        return;
+    }
+
+    const int64 BlockFrames = (int64)BaseBlockFrames << Level;
+    const int64 NumComplete = Levels[Level].Num();
+    const int64 FirstBlock = FrameStart / BlockFrames;
+    const int64 EndBlock = FMath::Min((FrameEnd + BlockFrames - 1) / BlockFrames, NumComplete);
+
+    for (int64 Block = FirstBlock; Block < EndBlock; ++Block)
+    {
+        Accumulator.Merge(Levels[Level][(int32)Block]);
+    }
+
+    // O final do intervalo ainda não foi resumido neste nível: desce para os níveis mais finos
+    const int64 CoveredEnd = NumComplete * BlockFrames;
+    if (FrameEnd > CoveredEnd)
+    {
+        const int64 TailStart = FMath::Max(FrameStart, CoveredEnd);
+        if (Level > FinestLevel)
+        {
+            MergeRange(Level - 1, TailStart, FrameEnd, Accumulator);
+        }
+        else
+        {
+            // Nível mais fino retido: o fim ainda em construção está nos blocos parciais deste nível e dos descartados
+            for (int32 PartialLevel = Level; PartialLevel >= 0; --PartialLevel)
+            {
+                Accumulator.Merge(PartialBuckets[PartialLevel]);
+            }
+        }
+    }
+}
+
+bool FIARWaveformSummary::GetColumns(double StartSeconds, double EndSeconds, int32 NumColumns, TArray<FIAR_WaveformColumn>& OutColumns) const
+{
+    FScopeLock Lock(&SummaryLock);
+
+    OutColumns.Reset();
+    if (NumColumns <= 0 || SampleRate <= 0 || TotalFrames <= 0 || Levels.Num() == 0 || EndSeconds <= StartSeconds)
+    {
+        return false;
+    }
+    OutColumns.SetNum(NumColumns);
+
+    const double StartFrame = StartSeconds * SampleRate;
+    const double FramesPerColumn = (EndSeconds - StartSeconds) * SampleRate / NumColumns;
+
+    // Nível mais grosso cujo bloco ainda cabe em uma coluna (cada coluna lê poucos blocos => O(pixels))
+    int32 Level = FinestLevel;
+    while (Level + 1 < Levels.Num() && (double)((int64)BaseBlockFrames << (Level + 1)) <= FramesPerColumn)
+    {
+        ++Level;
+    }
+
+    for (int32 Column = 0; Column < NumColumns; ++Column)
+    {
+        const int64 ColumnStart = FMath::Max<int64>(0, (int64)FMath::FloorToDouble(StartFrame + Column * FramesPerColumn));
+        const int64 ColumnEnd = FMath::Min<int64>(TotalFrames, FMath::Max<int64>(ColumnStart + 1, (int64)FMath::FloorToDouble(StartFrame + (Column + 1) * FramesPerColumn)));
+        if (ColumnStart >= TotalFrames)
+        {
+            continue; // Além do fim do áudio: coluna vazia
+        }
+
+        FBucket Accumulator;
+        MergeRange(Level, ColumnStart, ColumnEnd, Accumulator);
+        if (Accumulator.NumSamples > 0)
+        {
+            FIAR_WaveformColumn& Out = OutColumns[Column];
+            Out.Min = Accumulator.Min;
+            Out.Max = Accumulator.Max;
+            Out.RMS = (float)FMath::Sqrt(Accumulator.SumSquares / (double)Accumulator.NumSamples);
+            Out.bHasData = true;
+        }
+    }
+    return true;
+}
+
+void FIARWaveformSummary::RenderPixels(double StartSeconds, double EndSeconds, int32 Width, int32 Height, TArray<FColor>& OutPixels) const
+{
+    if (Width <= 0 || Height <= 0)
+    {
+        OutPixels.Reset();
+        return;
+    }
+    OutPixels.Init(FColor::Black, Width * Height);
+
+    TArray<FIAR_WaveformColumn> Columns;
+    if (!GetColumns(StartSeconds, EndSeconds, Width, Columns))
+    {
+        return;
+    }
+
+    // Mesmo mapeamento de GenerateWaveformPixels: amplitude [-1, 1] -> pixels [0, Height-1]
+    auto AmplitudeToY = [Height](float Amplitude)
+    {
+        return FMath::Clamp(FMath::FloorToInt(((Amplitude + 1.0f) / 2.0f) * (Height - 1)), 0, Height - 1);
+    };
+
+    const FColor PeakColor(0, 140, 160);
+    for (int32 X = 0; X < Width; ++X)
+    {
+        const FIAR_WaveformColumn& Column = Columns[X];
+        if (!Column.bHasData)
+        {
+            continue;
+        }
+
+        const int32 MinY = AmplitudeToY(Column.Min);
+        const int32 MaxY = AmplitudeToY(Column.Max);
+        const int32 RMSMinY = FMath::Max(MinY, AmplitudeToY(-Column.RMS));
+        const int32 RMSMaxY = FMath::Min(MaxY, AmplitudeToY(Column.RMS));
+        for (int32 Y = MinY; Y <= MaxY; ++Y)
+        {
+            OutPixels[Y * Width + X] = (Y >= RMSMinY && Y <= RMSMaxY) ? FColor::Cyan : PeakColor;
+        }
+    }
+}
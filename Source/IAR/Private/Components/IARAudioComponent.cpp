@@ -9,6 +9,7 @@
 #include "../IAR.h"
 #include "Recording/IARAudioSimulatedSource.h"
 #include "Recording/IARAudioMixerSource.h"
+#include "Recording/IARAudioAggregateSource.h"
 #include "Recording/IARAudioFileSource.h" // Adicionado para AudioFileSource
 #include "Recording/IARMIDIFileSource.h" // NOVO: Adicionado para MIDIFileSource
 #include "Recording/IARAudioFolderSource.h" // <<-- ADICIONADO
@@ -60,7 +61,9 @@ UIARAudioComponent::UIARAudioComponent()
     , bEnableHighPassFilter(false)
     , HighPassCutoffFrequencyHz(20.0f)
 {
-    PrimaryComponentTick.bCanEverTick = false;
+    // O Tick consome o snapshot mais recente da caixa de correio de tempo real (no máximo um por frame de jogo)
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = true;
     UE_LOG(LogIAR, Log, TEXT("UIARAudioComponent: Construtor chamado."));
 
     // Criação de instâncias que devem aparecer no editor (com EditAnywhere e Instanced)
@@ -90,9 +93,18 @@ void UIARAudioComponent::BeginPlay()
     EnumerateAudioInputDevices(); 
 }
 
+void UIARAudioComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    // Consome no máximo um snapshot por frame de jogo, independente da taxa de frames de áudio
+    ConsumeRealTimeSnapshot(DeltaTime);
+}
+
 void UIARAudioComponent::EndPlay(const EEndPlayReason::Type EndPlayReason) 
 {
     StopRecording();
+    ResetRealTimeDelivery();
 
     if (FeatureProcessorInstance) 
     {
@@ -570,6 +582,9 @@ void UIARAudioComponent::InitializeAudioPipelineInternal()
     bIsOverallPipelineInitialized = false; 
     bIsRecordingCapable = false; 
 
+    // Nova sessão: recomeça a visão geral da waveform
+    SessionWaveformSummary.Reset(AudioStreamSettings.SampleRate, AudioStreamSettings.NumChannels);
+
     // O FeatureProcessorInstance já é um DefaultSubobject
     if (FeatureProcessorInstance) 
     {
@@ -694,6 +709,21 @@ void UIARAudioComponent::InitializeAudioPipelineInternal()
             }
             break;
         }
+        case EIARAudioSourceType::AggregateDevices:
+        {
+            CurrentMediaSource = NewObject<UIARAudioAggregateSource>(this);
+            if (CurrentMediaSource)
+            {
+                CurrentMediaSource->Initialize(AudioStreamSettings, FramePool);
+                CurrentMediaSource->OnAudioFrameAcquired.AddUObject(this, &UIARAudioComponent::OnAudioFrameAcquired);
+                UE_LOG(LogIAR, Log, TEXT("UIARAudioComponent: Fonte de áudio agregada configurada (%d dispositivos)."), AudioStreamSettings.AggregateInputDevices.Num());
+            }
+            else
+            {
+                UE_LOG(LogIAR, Error, TEXT("UIARAudioComponent: Falha ao criar UIARAudioAggregateSource."));
+            }
+            break;
+        }
         case EIARAudioSourceType::AudioFile: 
         {
             CurrentMediaSource = NewObject<UIARAudioFileSource>(this);
@@ -703,6 +733,8 @@ void UIARAudioComponent::InitializeAudioPipelineInternal()
                 Cast<UIARAudioFileSource>(CurrentMediaSource)->ResetFileSource();
                 CurrentMediaSource->Initialize(AudioStreamSettings, FramePool);
                 CurrentMediaSource->OnAudioFrameAcquired.AddUObject(this, &UIARAudioComponent::OnAudioFrameAcquired);
+                // A fonte é deste componente e é desligada antes dele: a consulta pode capturar 'this'
+                Cast<UIARAudioFileSource>(CurrentMediaSource)->SetDownstreamCapacityQuery([this]() { return HasPipelineCapacity(); });
                 UE_LOG(LogIAR, Log, TEXT("UIARAudioComponent: Fonte de áudio de arquivo configurada."));
             }
             else
@@ -830,6 +862,8 @@ void UIARAudioComponent::OnAudioFrameAcquired(TSharedPtr<FIAR_AudioFrameData> Au
             NewFrameForConversion->SampleRate = CurrentProcessedFrame->SampleRate;
             NewFrameForConversion->NumChannels = AudioStreamSettings.NumChannels; 
             NewFrameForConversion->Timestamp = CurrentProcessedFrame->Timestamp;
+            NewFrameForConversion->StartFrameIndex = CurrentProcessedFrame->StartFrameIndex;
+            NewFrameForConversion->OverlapFrames = CurrentProcessedFrame->OverlapFrames; // Mesmos frames, outros canais
             NewFrameForConversion->CurrentStreamSettings = AudioStreamSettings; 
 
             if (FramePool) { FramePool->ReleaseFrame(CurrentProcessedFrame); } 
@@ -873,6 +907,10 @@ void UIARAudioComponent::OnAudioFrameAcquired(TSharedPtr<FIAR_AudioFrameData> Au
             NewFrameForResampling->SampleRate = DesiredOutputSampleRate;
             NewFrameForResampling->NumChannels = CurrentProcessedFrame->NumChannels; 
             NewFrameForResampling->Timestamp = CurrentProcessedFrame->Timestamp;
+            // A parte repetida escala com a taxa (limitada ao frame convertido)
+            NewFrameForResampling->OverlapFrames = FMath::Min(
+                (int32)FMath::RoundToInt((double)CurrentProcessedFrame->OverlapFrames * DesiredOutputSampleRate / CurrentProcessedFrame->SampleRate),
+                NewFrameForResampling->RawSamplesPtr->Num() / FMath::Max(1, NewFrameForResampling->NumChannels));
             NewFrameForResampling->CurrentStreamSettings = AudioStreamSettings; 
 
             if (FramePool) { FramePool->ReleaseFrame(CurrentProcessedFrame); } 
@@ -902,200 +940,46 @@ void UIARAudioComponent::OnAudioFrameAcquired(TSharedPtr<FIAR_AudioFrameData> Au
         }
     }
 
+    // Alimenta a pirâmide de resumo da sessão (visão geral de longa duração, sem reler o PCM depois).
+    // A memória é limitada pela própria pirâmide: em sessões longas a resolução máxima diminui em vez de crescer.
+    if (SessionWaveformSummary.GetSampleRate() != CurrentProcessedFrame->SampleRate || SessionWaveformSummary.GetNumChannels() != CurrentProcessedFrame->NumChannels)
+    {
+        SessionWaveformSummary.Reset(CurrentProcessedFrame->SampleRate, CurrentProcessedFrame->NumChannels);
+    }
+    // Só a parte nova do frame: com janelas sobrepostas o início repete o frame anterior
+    const int32 SummaryOffset = FMath::Min(CurrentProcessedFrame->OverlapFrames * CurrentProcessedFrame->NumChannels, CurrentProcessedFrame->RawSamplesPtr->Num());
+    SessionWaveformSummary.AppendInterleaved(CurrentProcessedFrame->RawSamplesPtr->GetData() + SummaryOffset, CurrentProcessedFrame->RawSamplesPtr->Num() - SummaryOffset);
 
     if (AudioStreamSettings.bEnableRTFeatures)
     {
-        FIAR_JustRTFrame RTFrame;
         UTexture2D* DummySpectrogramTexture = nullptr; 
         if (FeatureProcessorInstance) 
         {
-            if (CurrentProcessedFrame->RawSamplesPtr.IsValid())
-            {
-                RTFrame.RawAudioBuffer = *(CurrentProcessedFrame->RawSamplesPtr); 
-            }
-            RTFrame.SampleRate = CurrentProcessedFrame->SampleRate;
-            RTFrame.NumChannels = CurrentProcessedFrame->NumChannels;
-            RTFrame.Timestamp = CurrentProcessedFrame->Timestamp;
-
-            RTFrame.Features = FeatureProcessorInstance->ProcessFrame(CurrentProcessedFrame, DummySpectrogramTexture); 
+            // O RawAudioBuffer não é mais copiado aqui: o snapshot da caixa de correio reutiliza seus próprios buffers.
+            const FIAR_AudioFeatures Features = FeatureProcessorInstance->ProcessFrame(CurrentProcessedFrame, DummySpectrogramTexture); 
+            const float CurrentFrameDuration = (float)CurrentProcessedFrame->RawSamplesPtr->Num() / (float)CurrentProcessedFrame->SampleRate / (float)CurrentProcessedFrame->NumChannels;
             if (MIDITranscriber)
             {
-                float CurrentFrameDuration = (float)CurrentProcessedFrame->RawSamplesPtr->Num() / (float)CurrentProcessedFrame->SampleRate / (float)CurrentProcessedFrame->NumChannels;
-                MIDITranscriber->ProcessAudioFeatures(RTFrame.Features, RTFrame.Timestamp, CurrentFrameDuration);
+                MIDITranscriber->ProcessAudioFeatures(Features, CurrentProcessedFrame->Timestamp, CurrentFrameDuration);
             }
 
-            if (AudioStreamSettings.bDebugDrawFeatures) 
+            // Assinantes nativos na thread de análise: visões diretas sobre o frame e o espectro, sem cópias
+            if (OnRealTimeFrameAnalyzedNative.IsBound())
             {
-                int32 SpectrogramPixelsWidth = 0, SpectrogramPixelsHeight = 0; 
-                UIARAdvancedAudioFeatureProcessor* AdvancedProcessor = Cast<UIARAdvancedAudioFeatureProcessor>(FeatureProcessorInstance);
-                
-                const TArray<FColor>* SpectrogramPixelsPtr = nullptr;
-                if (AdvancedProcessor) 
-                {
-                    SpectrogramPixelsPtr = &AdvancedProcessor->GetSpectrogramPixels(SpectrogramPixelsWidth, SpectrogramPixelsHeight);
-                }
-                
-                int32 WaveformPixelsWidth = 0, WaveformPixelsHeight = 0; 
-                const TArray<FColor>* WaveformPixelsPtr = nullptr;
-                if (AdvancedProcessor) 
-                {
-                    WaveformPixelsPtr = &AdvancedProcessor->GetWaveformPixels(WaveformPixelsWidth, WaveformPixelsHeight);
-                }
-                
-                int32 FilteredSpectrogramPixelsWidth = 0, FilteredSpectrogramPixelsHeight = 0;
-                const TArray<FColor>* FilteredSpectrogramPixelsPtr = nullptr;
-
-                if (AdvancedProcessor && AdvancedProcessor->bEnableContextualFrequencyFiltering) 
-                {
-                    FilteredSpectrogramPixelsPtr = &AdvancedProcessor->GetFilteredSpectrogramPixels(FilteredSpectrogramPixelsWidth, FilteredSpectrogramPixelsHeight);
-                }
-
-                AsyncTask(ENamedThreads::GameThread, [this, RTFrame, SpectrogramPixelsPtr, SpectrogramPixelsWidth, SpectrogramPixelsHeight, WaveformPixelsPtr, WaveformPixelsWidth, WaveformPixelsHeight,
-                                                        FilteredSpectrogramPixelsPtr, FilteredSpectrogramPixelsWidth, FilteredSpectrogramPixelsHeight]() mutable {
-                    if (SpectrogramPixelsPtr && SpectrogramPixelsWidth > 0 && SpectrogramPixelsHeight > 0)
-                    {
-                        if (!SpectrogramTexture || SpectrogramTexture->GetSizeX() != SpectrogramPixelsWidth || SpectrogramTexture->GetSizeY() != SpectrogramPixelsHeight)
-                        {
-                            if (SpectrogramTexture) { SpectrogramTexture = nullptr; } 
-                            SpectrogramTexture = UTexture2D::CreateTransient(SpectrogramPixelsWidth, SpectrogramPixelsHeight, PF_B8G8R8A8);
-                            SpectrogramTexture->bNoTiling = false;
-                            SpectrogramTexture->CompressionSettings = TC_EditorIcon;
-                            SpectrogramTexture->SRGB = false;
-                            SpectrogramTexture->Filter = TF_Nearest;
-                            SpectrogramTexture->AddressX = TA_Clamp;
-                            SpectrogramTexture->AddressY = TA_Clamp;
-                            SpectrogramTexture->UpdateResource(); 
-                        }
-                        
-                        if (SpectrogramTexture && SpectrogramTexture->GetResource())
-                        {
-                            FTexture2DResource* TextureResource = static_cast<FTexture2DResource*>(SpectrogramTexture->GetResource()->GetTexture2DResource());
-                            if (TextureResource)
-                            {
-                                ENQUEUE_RENDER_COMMAND(UpdateSpectrogramTexture)([TextureResource, SpectrogramPixels = *SpectrogramPixelsPtr](FRHICommandListImmediate& RHICmdList)
-                                {
-                                    if (TextureResource->GetTexture2DRHI())
-                                    {
-                                        uint32 Stride = 0;
-                                        void* LockedData = RHICmdList.LockTexture2D(TextureResource->GetTexture2DRHI(), 0, EResourceLockMode::RLM_WriteOnly, Stride, false);
-                                        FMemory::Memcpy(LockedData, SpectrogramPixels.GetData(), SpectrogramPixels.Num() * sizeof(FColor));
-                                        RHICmdList.UnlockTexture2D(TextureResource->GetTexture2DRHI(), 0, true);
-                                    }
-                                });
-                                RTFrame.SpectrogramTexture = SpectrogramTexture; 
-                            }
-                            else
-                            {
-                                UE_LOG(LogIAR, Warning, TEXT("UIARAudioComponent: Recurso de textura RHI para espectrograma (original) não disponível para update de pixels."));
-                            }
-                        }
-                        else
-                        {
-                            UE_LOG(LogIAR, Warning, TEXT("UIARAudioComponent: Textura do espectrograma (original) não é válida ou recurso não existe na Game Thread."));
-                        }
-                    }
-                    else 
-                    {
-                        RTFrame.SpectrogramTexture = nullptr;
-                    }
-                    
-                    if (WaveformPixelsPtr && WaveformPixelsWidth > 0 && WaveformPixelsHeight > 0)
-                    {
-                        if (!WaveformTexture || WaveformTexture->GetSizeX() != WaveformPixelsWidth || WaveformTexture->GetSizeY() != WaveformPixelsHeight)
-                        {
-                            if (WaveformTexture) { WaveformTexture = nullptr; }
-                            WaveformTexture = UTexture2D::CreateTransient(WaveformPixelsWidth, WaveformPixelsHeight, PF_B8G8R8A8);
-                            WaveformTexture->bNoTiling = false;
-                            WaveformTexture->CompressionSettings = TC_EditorIcon;
-                            WaveformTexture->SRGB = false;
-                            WaveformTexture->Filter = TF_Nearest;
-                            WaveformTexture->AddressX = TA_Clamp;
-                            WaveformTexture->AddressY = TA_Clamp;
-                            WaveformTexture->UpdateResource();
-                        }
-
-                        if (WaveformTexture && WaveformTexture->GetResource())
-                        {
-                            FTexture2DResource* TextureResource = static_cast<FTexture2DResource*>(WaveformTexture->GetResource()->GetTexture2DResource());
-                            if (TextureResource)
-                            {
-                                ENQUEUE_RENDER_COMMAND(UpdateWaveformTexture)([TextureResource, WaveformPixels = *WaveformPixelsPtr](FRHICommandListImmediate& RHICmdList)
-                                {
-                                    if (TextureResource->GetTexture2DRHI())
-                                    {
-                                        uint32 Stride = 0;
-                                        void* LockedData = RHICmdList.LockTexture2D(TextureResource->GetTexture2DRHI(), 0, EResourceLockMode::RLM_WriteOnly, Stride, false);
-                                        FMemory::Memcpy(LockedData, WaveformPixels.GetData(), WaveformPixels.Num() * sizeof(FColor));
-                                        RHICmdList.UnlockTexture2D(TextureResource->GetTexture2DRHI(), 0, true);
-                                    }
-                                });
-                                RTFrame.WaveformTexture = WaveformTexture; 
-                            }
-                            else
-                            {
-                                UE_LOG(LogIAR, Warning, TEXT("UIARAudioComponent: Recurso de textura RHI para waveform não disponível para update de pixels."));
-                            }
-                        }
-                        else
-                        {
-                            UE_LOG(LogIAR, Warning, TEXT("UIARAudioComponent: Textura da waveform não é válida ou recurso não existe na Game Thread."));
-                        }
-                    }
-                    else 
-                    {
-                        RTFrame.WaveformTexture = nullptr;
-                    }
-
-                    if (FilteredSpectrogramPixelsPtr && FilteredSpectrogramPixelsWidth > 0 && FilteredSpectrogramPixelsHeight > 0)
-                    {
-                        if (!FilteredSpectrogramTexture || FilteredSpectrogramTexture->GetSizeX() != FilteredSpectrogramPixelsWidth || FilteredSpectrogramTexture->GetSizeY() != FilteredSpectrogramPixelsHeight)
-                        {
-                            if (FilteredSpectrogramTexture) { FilteredSpectrogramTexture = nullptr; }
-                            FilteredSpectrogramTexture = UTexture2D::CreateTransient(FilteredSpectrogramPixelsWidth, FilteredSpectrogramPixelsHeight, PF_B8G8R8A8);
-                            FilteredSpectrogramTexture->bNoTiling = false;
-                            FilteredSpectrogramTexture->CompressionSettings = TC_EditorIcon;
-                            FilteredSpectrogramTexture->SRGB = false;
-                            FilteredSpectrogramTexture->Filter = TF_Nearest;
-                            FilteredSpectrogramTexture->AddressX = TA_Clamp;
-                            FilteredSpectrogramTexture->AddressY = TA_Clamp;
-                            FilteredSpectrogramTexture->UpdateResource();
-                        }
-
-                        if (FilteredSpectrogramTexture && FilteredSpectrogramTexture->GetResource())
-                        {
-                            FTexture2DResource* TextureResource = static_cast<FTexture2DResource*>(FilteredSpectrogramTexture->GetResource()->GetTexture2DResource());
-                            if (TextureResource)
-                            {
-                                ENQUEUE_RENDER_COMMAND(UpdateFilteredSpectrogramTexture)([TextureResource, FilteredSpectrogramPixels = *FilteredSpectrogramPixelsPtr](FRHICommandListImmediate& RHICmdList)
-                                {
-                                    if (TextureResource->GetTexture2DRHI())
-                                    {
-                                        uint32 Stride = 0;
-                                        void* LockedData = RHICmdList.LockTexture2D(TextureResource->GetTexture2DRHI(), 0, EResourceLockMode::RLM_WriteOnly, Stride, false);
-                                        FMemory::Memcpy(LockedData, FilteredSpectrogramPixels.GetData(), FilteredSpectrogramPixels.Num() * sizeof(FColor));
-                                        RHICmdList.UnlockTexture2D(TextureResource->GetTexture2DRHI(), 0, true);
-                                    }
-                                });
-                                RTFrame.FilteredSpectrogramTexture = FilteredSpectrogramTexture;
-                            }
-                            else
-                            {
-                                UE_LOG(LogIAR, Warning, TEXT("UIARAudioComponent: Recurso de textura RHI para espectrograma filtrado não disponível para update de pixels."));
-                            }
-                        }
-                        else
-                        {
-                            UE_LOG(LogIAR, Warning, TEXT("UIARAudioComponent: Textura do espectrograma filtrado não é válida ou recurso não existe na Game Thread."));
-                        }
-                    }
-                    else 
-                    {
-                        RTFrame.FilteredSpectrogramTexture = nullptr; 
-                    }
-                    
-                    OnRealTimeAudioFrameReady.Broadcast(RTFrame);
-                });
+                FIAR_RTFrameView FrameView;
+                FrameView.Samples = *(CurrentProcessedFrame->RawSamplesPtr);
+                FrameView.Spectrum = FeatureProcessorInstance->GetLastSpectrum();
+                FrameView.Features = &Features;
+                FrameView.SampleRate = CurrentProcessedFrame->SampleRate;
+                FrameView.NumChannels = CurrentProcessedFrame->NumChannels;
+                FrameView.Timestamp = CurrentProcessedFrame->Timestamp;
+                FrameView.NumAggregatedFrames = 1;
+                OnRealTimeFrameAnalyzedNative.Broadcast(FrameView);
             }
+
+            // Publica o snapshot na caixa de correio; o TickComponent o consome na Game Thread.
+            // As features são agregadas por janela de broadcast; os pixels só são copiados se bDebugDrawFeatures.
+            PublishRealTimeSnapshot(CurrentProcessedFrame, Features, CurrentFrameDuration);
         }
         else
         {
@@ -1126,6 +1010,340 @@ void UIARAudioComponent::OnAudioFrameAcquired(TSharedPtr<FIAR_AudioFrameData> Au
     }
 }
 
+bool UIARAudioComponent::HasPipelineCapacity() const
+{
+    // Em tempo real a análise roda dentro do broadcast: a própria fonte espera o processamento de cada frame
+    if (AudioStreamSettings.bEnableRTFeatures || !AudioCaptureSession)
+    {
+        return true;
+    }
+    return AudioCaptureSession->HasEncoderCapacity();
+}
+
+void UIARAudioComponent::PublishRealTimeSnapshot(const TSharedPtr<FIAR_AudioFrameData>& ProcessedFrame, const FIAR_AudioFeatures& Features, float FrameDuration)
+{
+    FIAR_RTFrameSnapshot& Snapshot = RealTimeFrameMailbox.BeginPublish();
+
+    // Reset + Append reaproveita a capacidade do slot: sem alocações após o aquecimento
+    Snapshot.RawAudioBuffer.Reset();
+    if (bCopyRawAudioToGameThread && ProcessedFrame->RawSamplesPtr.IsValid())
+    {
+        Snapshot.RawAudioBuffer.Append(*(ProcessedFrame->RawSamplesPtr));
+    }
+    Snapshot.Spectrum.Reset();
+    if (FeatureProcessorInstance)
+    {
+        Snapshot.Spectrum.Append(FeatureProcessorInstance->GetLastSpectrum());
+    }
+    Snapshot.SampleRate = ProcessedFrame->SampleRate;
+    Snapshot.NumChannels = ProcessedFrame->NumChannels;
+    Snapshot.Timestamp = ProcessedFrame->Timestamp;
+    Snapshot.SpectrogramColumnsWritten = 0;
+
+    // --- Agregação das features por janela de broadcast (em tempo de áudio) ---
+    FeatureWindowAggregator.Accumulate(Features);
+    FeatureWindowElapsedSeconds += FrameDuration;
+    const float BroadcastInterval = (FeatureBroadcastRateHz > 0.0f) ? (1.0f / FeatureBroadcastRateHz) : 0.0f;
+    if (FeatureWindowElapsedSeconds >= BroadcastInterval)
+    {
+        // Se a Game Thread ainda não transmitiu a última janela publicada (snapshot sobrescrito ou Tick atrasado),
+        // a nova janela é unida a ela: notas e eventos MIDI não se perdem (entrega "pelo menos uma vez").
+        // Os eventos MIDI pendentes são limitados: sem consumidor, os mais antigos são descartados e contados.
+        if ((uint64)AcknowledgedFeatureWindowSequence.GetValue() >= PublishedFeatureWindowSequence)
+        {
+            PendingFeatureAggregator.Reset();
+        }
+        PendingFeatureAggregator.SetMaxMIDIEvents(MaxPendingMIDIEvents);
+        const int32 DroppedBeforeMerge = PendingFeatureAggregator.GetNumDroppedMIDIEvents();
+        PendingFeatureAggregator.Merge(FeatureWindowAggregator);
+        const int32 NewlyDropped = PendingFeatureAggregator.GetNumDroppedMIDIEvents() - DroppedBeforeMerge;
+        if (NewlyDropped > 0 && DroppedMIDIEventCount.Add(NewlyDropped) == 0)
+        {
+            UE_LOG(LogIAR, Warning, TEXT("UIARAudioComponent: A Game Thread não está transmitindo as features; eventos MIDI mais antigos que os últimos %d estão sendo descartados."), MaxPendingMIDIEvents);
+        }
+        PendingFeatureAggregator.Finalize(FeatureAggregationMode, PendingAggregatedFeatures);
+        PendingAggregatedFrames = PendingFeatureAggregator.GetNumFrames();
+        ++PendingAggregatedFeaturesVersion;
+
+        FeatureWindowAggregator.Reset();
+        FeatureWindowElapsedSeconds = (BroadcastInterval > 0.0f) ? FMath::Fmod(FeatureWindowElapsedSeconds, BroadcastInterval) : 0.0f;
+        ++PublishedFeatureWindowSequence;
+    }
+    // Cada buffer do triple buffer só recebe a cópia quando a janela muda, não a cada frame analisado
+    if (Snapshot.FeaturesVersion != PendingAggregatedFeaturesVersion)
+    {
+        Snapshot.Features = PendingAggregatedFeatures;
+        Snapshot.FeaturesVersion = PendingAggregatedFeaturesVersion;
+    }
+    Snapshot.FeatureWindowSequence = PublishedFeatureWindowSequence;
+    Snapshot.NumAggregatedFrames = PendingAggregatedFrames;
+
+    if (!AudioStreamSettings.bDebugDrawFeatures)
+    {
+        Snapshot.SpectrogramPixels.Reset();
+        Snapshot.WaveformPixels.Reset();
+        Snapshot.FilteredSpectrogramPixels.Reset();
+        Snapshot.SpectrogramWidth = Snapshot.SpectrogramHeight = 0;
+        Snapshot.WaveformWidth = Snapshot.WaveformHeight = 0;
+        Snapshot.FilteredSpectrogramWidth = Snapshot.FilteredSpectrogramHeight = 0;
+        RealTimeFrameMailbox.EndPublish();
+        return;
+    }
+
+    UIARAdvancedAudioFeatureProcessor* AdvancedProcessor = Cast<UIARAdvancedAudioFeatureProcessor>(FeatureProcessorInstance);
+
+    // Os pixels são copiados aqui, na thread do produtor, enquanto ainda são válidos.
+    // (Antes, a lambda da Game Thread lia os buffers do processador que já podiam estar sendo reescritos.)
+    Snapshot.SpectrogramWidth = Snapshot.SpectrogramHeight = 0;
+    Snapshot.WaveformWidth = Snapshot.WaveformHeight = 0;
+    Snapshot.FilteredSpectrogramWidth = Snapshot.FilteredSpectrogramHeight = 0;
+    FIAR_RTFrameSnapshot::CopyPixels(Snapshot.SpectrogramPixels, AdvancedProcessor ? &AdvancedProcessor->GetSpectrogramPixels(Snapshot.SpectrogramWidth, Snapshot.SpectrogramHeight) : nullptr);
+    FIAR_RTFrameSnapshot::CopyPixels(Snapshot.WaveformPixels, AdvancedProcessor ? &AdvancedProcessor->GetWaveformPixels(Snapshot.WaveformWidth, Snapshot.WaveformHeight) : nullptr);
+    FIAR_RTFrameSnapshot::CopyPixels(Snapshot.FilteredSpectrogramPixels, (AdvancedProcessor && AdvancedProcessor->bEnableContextualFrequencyFiltering) ?
+        &AdvancedProcessor->GetFilteredSpectrogramPixels(Snapshot.FilteredSpectrogramWidth, Snapshot.FilteredSpectrogramHeight) : nullptr);
+    if (AdvancedProcessor)
+    {
+        Snapshot.SpectrogramColumnsWritten = AdvancedProcessor->GetSpectrogramColumnsWritten();
+    }
+
+    RealTimeFrameMailbox.EndPublish();
+}
+
+void UIARAudioComponent::ConsumeRealTimeSnapshot(float DeltaTime)
+{
+    if (const FIAR_RTFrameSnapshot* NewSnapshot = RealTimeFrameMailbox.ConsumeLatest())
+    {
+        LatestRealTimeSnapshot = NewSnapshot;
+        bRealTimeVisualizationDirty = true;
+    }
+
+    if (!LatestRealTimeSnapshot)
+    {
+        return; // Nada publicado ainda
+    }
+    const FIAR_RTFrameSnapshot& Snapshot = *LatestRealTimeSnapshot;
+
+    // --- Visualização: limitada a VisualizationUpdateRateHz (as colunas acumuladas são enviadas juntas) ---
+    VisualizationTimeAccumulator += DeltaTime;
+    const float VisualizationInterval = (VisualizationUpdateRateHz > 0.0f) ? (1.0f / VisualizationUpdateRateHz) : 0.0f;
+    if (bRealTimeVisualizationDirty && VisualizationTimeAccumulator >= VisualizationInterval)
+    {
+        UpdateDebugTexture(SpectrogramTexture, Snapshot.SpectrogramPixels, Snapshot.SpectrogramWidth, Snapshot.SpectrogramHeight,
+                           Snapshot.SpectrogramColumnsWritten, &UploadedSpectrogramColumns, TEXT("espectrograma (original)"));
+        // A waveform é regerada inteira a cada frame, então é sempre enviada completa
+        UpdateDebugTexture(WaveformTexture, Snapshot.WaveformPixels, Snapshot.WaveformWidth, Snapshot.WaveformHeight,
+                           0, nullptr, TEXT("waveform"));
+        UpdateDebugTexture(FilteredSpectrogramTexture, Snapshot.FilteredSpectrogramPixels, Snapshot.FilteredSpectrogramWidth, Snapshot.FilteredSpectrogramHeight,
+                           Snapshot.SpectrogramColumnsWritten, &UploadedFilteredSpectrogramColumns, TEXT("espectrograma filtrado"));
+        bRealTimeVisualizationDirty = false;
+        VisualizationTimeAccumulator = 0.0f;
+    }
+
+    // --- Broadcast: apenas quando o produtor concluiu uma nova janela de features ---
+    if (Snapshot.FeatureWindowSequence <= LastBroadcastFeatureWindowSequence)
+    {
+        return;
+    }
+    LastBroadcastFeatureWindowSequence = Snapshot.FeatureWindowSequence;
+    AcknowledgedFeatureWindowSequence.Set((int64)Snapshot.FeatureWindowSequence);
+
+    // Assinantes nativos: visões sobre o snapshot (válido até o próximo ConsumeLatest), sem cópias por assinante
+    if (OnRealTimeFrameReadyNative.IsBound())
+    {
+        FIAR_RTFrameView FrameView;
+        FrameView.Samples = Snapshot.RawAudioBuffer;
+        FrameView.Spectrum = Snapshot.Spectrum;
+        FrameView.Features = &Snapshot.Features;
+        FrameView.SampleRate = Snapshot.SampleRate;
+        FrameView.NumChannels = Snapshot.NumChannels;
+        FrameView.Timestamp = Snapshot.Timestamp;
+        FrameView.NumAggregatedFrames = Snapshot.NumAggregatedFrames;
+        OnRealTimeFrameReadyNative.Broadcast(FrameView);
+    }
+
+    // O FIAR_JustRTFrame (cópia completa) só é montado se houver ouvintes Blueprint/dinâmicos
+    if (!OnRealTimeAudioFrameReady.IsBound())
+    {
+        return;
+    }
+
+    FIAR_JustRTFrame RTFrame;
+    RTFrame.RawAudioBuffer = Snapshot.RawAudioBuffer;
+    RTFrame.SampleRate = Snapshot.SampleRate;
+    RTFrame.NumChannels = Snapshot.NumChannels;
+    RTFrame.Timestamp = Snapshot.Timestamp;
+    RTFrame.Features = Snapshot.Features;
+
+    const bool bHasPixels = AudioStreamSettings.bDebugDrawFeatures;
+    RTFrame.SpectrogramTexture = (bHasPixels && Snapshot.SpectrogramWidth > 0) ? SpectrogramTexture : nullptr;
+    RTFrame.WaveformTexture = (bHasPixels && Snapshot.WaveformWidth > 0) ? WaveformTexture : nullptr;
+    RTFrame.FilteredSpectrogramTexture = (bHasPixels && Snapshot.FilteredSpectrogramWidth > 0) ? FilteredSpectrogramTexture : nullptr;
+
+    // A próxima coluna a ser enviada é a mais antiga do buffer circular já presente na GPU
+    if (Snapshot.SpectrogramWidth > 0)
+    {
+        RTFrame.SpectrogramScrollOffset = (float)(UploadedSpectrogramColumns % (uint64)Snapshot.SpectrogramWidth) / (float)Snapshot.SpectrogramWidth;
+    }
+
+    OnRealTimeAudioFrameReady.Broadcast(RTFrame);
+}
+
+void UIARAudioComponent::ResetRealTimeDelivery()
+{
+    RealTimeFrameMailbox.Reset();
+    LatestRealTimeSnapshot = nullptr;
+    bRealTimeVisualizationDirty = false;
+    VisualizationTimeAccumulator = 0.0f;
+    UploadedSpectrogramColumns = 0;
+    UploadedFilteredSpectrogramColumns = 0;
+
+    FeatureWindowAggregator.Reset();
+    PendingFeatureAggregator.Reset();
+    PendingAggregatedFeatures = FIAR_AudioFeatures();
+    ++PendingAggregatedFeaturesVersion; // Snapshots antigos não podem reaproveitar features da sessão anterior
+    DroppedMIDIEventCount.Reset();
+    FeatureWindowElapsedSeconds = 0.0f;
+    PublishedFeatureWindowSequence = 0;
+    PendingAggregatedFrames = 0;
+    AcknowledgedFeatureWindowSequence.Reset();
+    LastBroadcastFeatureWindowSequence = 0;
+}
+
+UTexture2D* UIARAudioComponent::UpdateDebugTexture(UTexture2D*& Texture, const TArray<FColor>& Pixels, int32 Width, int32 Height, uint64 ColumnsWritten, uint64* InOutUploadedColumns, const TCHAR* DebugName)
+{
+    if (Width <= 0 || Height <= 0 || Pixels.Num() < Width * Height)
+    {
+        return nullptr;
+    }
+
+    bool bNeedsFullUpload = (InOutUploadedColumns == nullptr);
+    if (!Texture || Texture->GetSizeX() != Width || Texture->GetSizeY() != Height)
+    {
+        Texture = UTexture2D::CreateTransient(Width, Height, PF_B8G8R8A8);
+        Texture->bNoTiling = false;
+        Texture->CompressionSettings = TC_EditorIcon;
+        Texture->SRGB = false;
+        Texture->Filter = TF_Nearest;
+        Texture->AddressX = TA_Clamp;
+        Texture->AddressY = TA_Clamp;
+        Texture->UpdateResource();
+        bNeedsFullUpload = true; // Textura nova: conteúdo indefinido na GPU
+    }
+
+    if (!Texture || !Texture->GetResource())
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioComponent: Textura do %s não é válida ou recurso não existe na Game Thread."), DebugName);
+        return nullptr;
+    }
+
+    if (bNeedsFullUpload)
+    {
+        UploadTextureColumns(Texture, Pixels, Width, Height, 0, Width);
+    }
+    else
+    {
+        // Apenas as colunas escritas desde o último upload (podem ser várias se snapshots foram sobrescritos na caixa de correio)
+        const uint64 NewColumns = (ColumnsWritten >= *InOutUploadedColumns) ? (ColumnsWritten - *InOutUploadedColumns) : (uint64)Width;
+        if (NewColumns >= (uint64)Width)
+        {
+            UploadTextureColumns(Texture, Pixels, Width, Height, 0, Width);
+        }
+        else if (NewColumns > 0)
+        {
+            UploadTextureColumns(Texture, Pixels, Width, Height, static_cast<int32>(*InOutUploadedColumns % (uint64)Width), static_cast<int32>(NewColumns));
+        }
+    }
+
+    if (InOutUploadedColumns)
+    {
+        *InOutUploadedColumns = ColumnsWritten;
+    }
+
+    return Texture;
+}
+
+void UIARAudioComponent::UploadTextureColumns(UTexture2D* Texture, const TArray<FColor>& Pixels, int32 Width, int32 Height, int32 FirstColumn, int32 NumColumns)
+{
+    if (!Texture || NumColumns <= 0 || Width <= 0 || Height <= 0)
+    {
+        return;
+    }
+    NumColumns = FMath::Min(NumColumns, Width);
+    FirstColumn = FirstColumn % Width;
+
+    // Com wrap-around, o intervalo de colunas vira no máximo duas regiões
+    const int32 FirstRegionColumns = FMath::Min(NumColumns, Width - FirstColumn);
+    const int32 SecondRegionColumns = NumColumns - FirstRegionColumns;
+    const uint32 NumRegions = (SecondRegionColumns > 0) ? 2 : 1;
+
+    // As colunas são empacotadas em um buffer compacto (NumColumns x Height): o upload é proporcional aos dados novos.
+    // Buffer e regiões precisam viver até o render thread executar a atualização; são liberados no DataCleanupFunc.
+    const int32 SrcPitch = NumColumns * sizeof(FColor);
+    uint8* SrcData = new uint8[SrcPitch * Height];
+    for (int32 y = 0; y < Height; ++y)
+    {
+        uint8* DestRow = SrcData + y * SrcPitch;
+        const FColor* SrcRow = Pixels.GetData() + y * Width;
+        FMemory::Memcpy(DestRow, SrcRow + FirstColumn, FirstRegionColumns * sizeof(FColor));
+        if (SecondRegionColumns > 0)
+        {
+            FMemory::Memcpy(DestRow + FirstRegionColumns * sizeof(FColor), SrcRow, SecondRegionColumns * sizeof(FColor));
+        }
+    }
+
+    FUpdateTextureRegion2D* Regions = new FUpdateTextureRegion2D[NumRegions];
+    Regions[0] = FUpdateTextureRegion2D(FirstColumn, 0, 0, 0, FirstRegionColumns, Height);
+    if (SecondRegionColumns > 0)
+    {
+        Regions[1] = FUpdateTextureRegion2D(0, 0, FirstRegionColumns, 0, SecondRegionColumns, Height);
+    }
+
+    Texture->UpdateTextureRegions(0, NumRegions, Regions, SrcPitch, sizeof(FColor), SrcData,
+        [](uint8* InSrcData, const FUpdateTextureRegion2D* InRegions)
+        {
+            delete[] InSrcData;
+            delete[] InRegions;
+        });
+}
+
+const FIARWaveformSummary& UIARAudioComponent::GetWaveformOverviewSummary() const
+{
+    // Um arquivo carregado tem o resumo completo desde o início; caso contrário, usa o que a sessão já processou
+    if (const UIARAudioFileSource* FileSource = Cast<UIARAudioFileSource>(CurrentMediaSource))
+    {
+        if (FileSource->IsFileLoaded() && !FileSource->GetWaveformSummary().IsEmpty())
+        {
+            return FileSource->GetWaveformSummary();
+        }
+    }
+    return SessionWaveformSummary;
+}
+
+float UIARAudioComponent::GetWaveformOverviewDuration() const
+{
+    return (float)GetWaveformOverviewSummary().GetDurationSeconds();
+}
+
+UTexture2D* UIARAudioComponent::RenderWaveformOverview(float StartSeconds, float EndSeconds, int32 Width, int32 Height)
+{
+    const FIARWaveformSummary& Summary = GetWaveformOverviewSummary();
+    if (Summary.IsEmpty() || Width <= 0 || Height <= 0)
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioComponent: Nenhum áudio disponível para a visão geral da waveform (ou dimensões inválidas)."));
+        return nullptr;
+    }
+
+    StartSeconds = FMath::Max(0.0f, StartSeconds);
+    if (EndSeconds <= StartSeconds)
+    {
+        EndSeconds = (float)Summary.GetDurationSeconds();
+    }
+
+    TArray<FColor> Pixels;
+    Summary.RenderPixels(StartSeconds, EndSeconds, Width, Height, Pixels);
+    return UpdateDebugTexture(WaveformOverviewTexture, Pixels, Width, Height, 0, nullptr, TEXT("visão geral da waveform"));
+}
+
 void UIARAudioComponent::OnMIDIFrameAcquired(TSharedPtr<FIAR_MIDIFrame> MIDIFrame)
 {
     if (!MIDIFrame.IsValid() || MIDIFrame->Events.Num() == 0)
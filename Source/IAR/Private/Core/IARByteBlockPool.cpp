@@ -0,0 +1,44 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Core/IARByteBlockPool.h"
+#include "../IAR.h" // Para logging
+
+FIARByteBlockPool::FIARByteBlockPool(int32 InBlockCapacity, int32 InMaxPooledBlocks)
+    : BlockCapacity(FMath::Max(1, InBlockCapacity))
+    , MaxPooledBlocks(FMath::Max(0, InMaxPooledBlocks))
+{
+}
+
+TArray<uint8> FIARByteBlockPool::Acquire(int32 NumBytes)
+{
+    TArray<uint8> Block;
+    if (FreeBlocks.Dequeue(Block))
+    {
+        NumPooledBlocks.Decrement();
+    }
+    else
+    {
+        Block.Reserve(BlockCapacity);
+    }
+
+    // Reaproveita a capacidade já alocada; só realoca se o frame for maior que o bloco
+    Block.SetNumUninitialized(NumBytes, EAllowShrinking::No);
+    return Block;
+}
+
+void FIARByteBlockPool::Release(TArray<uint8>&& Block)
+{
+    if (Block.Max() == 0 || NumPooledBlocks.GetValue() >= MaxPooledBlocks)
+    {
+        return; // Bloco vazio ou pool cheio: a memória é liberada com o TArray
+    }
+
+    Block.Reset();
+    FreeBlocks.Enqueue(MoveTemp(Block));
+    NumPooledBlocks.Increment();
+}
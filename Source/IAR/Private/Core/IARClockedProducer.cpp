@@ -0,0 +1,280 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Core/IARClockedProducer.h"
+#include "../IAR.h" // Para logging
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+namespace IARClockedProducerPrivate
+{
+    FCriticalSection InstanceLock;
+    FIARClockedProducer* Instance = nullptr;
+
+    /** Espera máxima sem registros (ou até o próximo bloco), para observar Stop. */
+    constexpr double MaxWaitSeconds = 0.1;
+    /** Abaixo disso a espera termina cedendo a thread em vez de dormir (precisão do sleep do sistema). */
+    constexpr double SpinThresholdSeconds = 0.002;
+}
+
+// Estado de um registro. Compartilhado com a thread produtora, que pode estar no meio de um callback durante o Unregister.
+struct FIARClockedProducer::FRegistration
+{
+    FProduceCallback Callback;
+    FCapacityQuery HasCapacity; // Definida apenas nos registros sem relógio
+    int32 SampleRate = 0;
+    int32 FramesPerBlock = 0;
+    double AnchorSeconds = 0.0;  // Instante (relógio monotônico) em que o bloco AnchorBlock começa
+    int64 AnchorBlock = 0;
+    int64 NextBlock = 0;
+    FCriticalSection CallbackLock; // Segurado durante o callback; recursivo, então o callback pode chamar Unregister
+    FThreadSafeBool bUnregistered;
+
+    double GetBlockDuration() const { return (double)FramesPerBlock / SampleRate; }
+    double GetBlockEndTime(int64 Block) const { return AnchorSeconds + (double)(Block - AnchorBlock + 1) * FramesPerBlock / SampleRate; }
+};
+
+FIARClockedProducer::FIARClockedProducer()
+    : ProducerThread(nullptr)
+    , WakeEvent(nullptr)
+    , bStopRequested(false)
+    , bWaitingForCapacity(false)
+    , NextRegistrationId(1)
+{
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+FIARClockedProducer::~FIARClockedProducer()
+{
+    if (ProducerThread)
+    {
+        Stop();
+        ProducerThread->WaitForCompletion();
+        delete ProducerThread;
+        ProducerThread = nullptr;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+    WakeEvent = nullptr;
+}
+
+FIARClockedProducer* FIARClockedProducer::Get()
+{
+    using namespace IARClockedProducerPrivate;
+    FScopeLock Lock(&InstanceLock);
+    if (!Instance)
+    {
+        FIARClockedProducer* NewProducer = new FIARClockedProducer();
+        NewProducer->ProducerThread = FRunnableThread::Create(NewProducer, TEXT("IARClockedProducerThread"), 0, TPri_AboveNormal);
+        if (!NewProducer->ProducerThread)
+        {
+            UE_LOG(LogIAR, Error, TEXT("FIARClockedProducer: Falha ao criar a thread produtora."));
+            delete NewProducer;
+            return nullptr;
+        }
+        Instance = NewProducer;
+        UE_LOG(LogIAR, Log, TEXT("FIARClockedProducer: Thread produtora iniciada."));
+    }
+    return Instance;
+}
+
+void FIARClockedProducer::Shutdown()
+{
+    using namespace IARClockedProducerPrivate;
+    FScopeLock Lock(&InstanceLock);
+    if (Instance)
+    {
+        if (Instance->Registrations.Num() > 0)
+        {
+            UE_LOG(LogIAR, Warning, TEXT("FIARClockedProducer: Encerrando com %d registros ativos."), Instance->Registrations.Num());
+        }
+        delete Instance;
+        Instance = nullptr;
+    }
+}
+
+void FIARClockedProducer::NotifyCapacityAvailable()
+{
+    using namespace IARClockedProducerPrivate;
+    FScopeLock Lock(&InstanceLock);
+    if (Instance && Instance->bWaitingForCapacity)
+    {
+        // O evento é de reset automático: um Trigger antes do Wait faz a próxima espera retornar na hora
+        Instance->WakeEvent->Trigger();
+    }
+}
+
+int32 FIARClockedProducer::Register(int32 SampleRate, int32 FramesPerBlock, FProduceCallback&& Callback)
+{
+    if (SampleRate <= 0 || FramesPerBlock <= 0 || !Callback)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARClockedProducer: Registro inválido. SR: %d, Frames por bloco: %d"), SampleRate, FramesPerBlock);
+        return 0;
+    }
+
+    TSharedPtr<FRegistration, ESPMode::ThreadSafe> Registration = MakeShared<FRegistration, ESPMode::ThreadSafe>();
+    Registration->Callback = MoveTemp(Callback);
+    Registration->SampleRate = SampleRate;
+    Registration->FramesPerBlock = FramesPerBlock;
+    Registration->AnchorSeconds = FPlatformTime::Seconds();
+    return AddRegistration(MoveTemp(Registration));
+}
+
+int32 FIARClockedProducer::RegisterUnpaced(int32 SampleRate, int32 FramesPerBlock, FCapacityQuery&& HasCapacity, FProduceCallback&& Callback)
+{
+    if (SampleRate <= 0 || FramesPerBlock <= 0 || !Callback || !HasCapacity)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARClockedProducer: Registro sem relógio inválido. SR: %d, Frames por bloco: %d"), SampleRate, FramesPerBlock);
+        return 0;
+    }
+
+    TSharedPtr<FRegistration, ESPMode::ThreadSafe> Registration = MakeShared<FRegistration, ESPMode::ThreadSafe>();
+    Registration->Callback = MoveTemp(Callback);
+    Registration->HasCapacity = MoveTemp(HasCapacity);
+    Registration->SampleRate = SampleRate;
+    Registration->FramesPerBlock = FramesPerBlock;
+    return AddRegistration(MoveTemp(Registration));
+}
+
+int32 FIARClockedProducer::AddRegistration(TSharedPtr<FRegistration, ESPMode::ThreadSafe>&& Registration)
+{
+    int32 RegistrationId = 0;
+    {
+        FScopeLock Lock(&RegistrationsLock);
+        RegistrationId = NextRegistrationId++;
+        Registrations.Add(RegistrationId, Registration);
+    }
+    WakeEvent->Trigger();
+    return RegistrationId;
+}
+
+void FIARClockedProducer::Unregister(int32 RegistrationId)
+{
+    TSharedPtr<FRegistration, ESPMode::ThreadSafe> Registration;
+    {
+        FScopeLock Lock(&RegistrationsLock);
+        Registrations.RemoveAndCopyValue(RegistrationId, Registration);
+    }
+    if (Registration.IsValid())
+    {
+        // Espera o callback em andamento (se houver) e impede os próximos
+        FScopeLock CallbackLock(&Registration->CallbackLock);
+        Registration->bUnregistered.AtomicSet(true);
+    }
+}
+
+double FIARClockedProducer::ProduceDueBlocks(FRegistration& Registration, double Now)
+{
+    FScopeLock CallbackLock(&Registration.CallbackLock);
+
+    // Atraso grande demais (hitch, breakpoint, suspensão): reancora em vez de produzir uma rajada longa
+    const double Lag = Now - Registration.GetBlockEndTime(Registration.NextBlock);
+    if (Lag > MaxCatchUpSeconds)
+    {
+        UE_LOG(LogIAR, Warning, TEXT("FIARClockedProducer: Registro atrasado %.3f s; %lld blocos descartados do relógio."),
+            Lag, (int64)(Lag / Registration.GetBlockDuration()));
+        Registration.AnchorSeconds = Now - Registration.GetBlockDuration();
+        Registration.AnchorBlock = Registration.NextBlock;
+    }
+
+    while (!Registration.bUnregistered && !bStopRequested && Registration.GetBlockEndTime(Registration.NextBlock) <= Now)
+    {
+        const int64 Block = Registration.NextBlock++;
+        Registration.Callback(Block, (double)Block * Registration.GetBlockDuration());
+    }
+    return Registration.GetBlockEndTime(Registration.NextBlock);
+}
+
+double FIARClockedProducer::ProduceUnpacedBlocks(FRegistration& Registration, double Now, bool& bOutBackpressured)
+{
+    FScopeLock CallbackLock(&Registration.CallbackLock);
+
+    // Um lote limitado por passada: os registros no relógio continuam sendo atendidos no prazo
+    for (int32 Count = 0; Count < MaxUnpacedBlocksPerPass; ++Count)
+    {
+        if (Registration.bUnregistered || bStopRequested)
+        {
+            return Now;
+        }
+        if (!Registration.HasCapacity())
+        {
+            // Marca a espera antes de consultar de novo: um consumidor que esvaziar a fila entre as duas consultas
+            // já vê a marca e acorda a thread, então o aviso não se perde
+            bWaitingForCapacity.AtomicSet(true);
+            if (!Registration.HasCapacity())
+            {
+                bOutBackpressured = true;
+                return Now + UnpacedBackpressureWaitSeconds; // Consumidor cheio: dorme até o aviso ou o timeout
+            }
+        }
+        const int64 Block = Registration.NextBlock++;
+        Registration.Callback(Block, (double)Block * Registration.GetBlockDuration());
+    }
+    return Now;
+}
+
+uint32 FIARClockedProducer::Run()
+{
+    using namespace IARClockedProducerPrivate;
+
+    TArray<TSharedPtr<FRegistration, ESPMode::ThreadSafe>> Snapshot;
+    while (!bStopRequested)
+    {
+        {
+            FScopeLock Lock(&RegistrationsLock);
+            Registrations.GenerateValueArray(Snapshot);
+        }
+
+        bWaitingForCapacity.AtomicSet(false);
+        double Now = FPlatformTime::Seconds();
+        double NextDue = Now + MaxWaitSeconds;           // Próximo prazo que exige precisão (relógio, ou trabalho imediato)
+        double NextCapacityCheck = Now + MaxWaitSeconds; // Próxima consulta dos registros com o consumidor cheio
+        for (const TSharedPtr<FRegistration, ESPMode::ThreadSafe>& Registration : Snapshot)
+        {
+            if (Registration->bUnregistered)
+            {
+                continue;
+            }
+            if (Registration->HasCapacity)
+            {
+                bool bBackpressured = false;
+                const double RegistrationNextDue = ProduceUnpacedBlocks(*Registration, Now, bBackpressured);
+                double& Target = bBackpressured ? NextCapacityCheck : NextDue;
+                Target = FMath::Min(Target, RegistrationNextDue);
+            }
+            else
+            {
+                NextDue = FMath::Min(NextDue, ProduceDueBlocks(*Registration, Now));
+            }
+        }
+        Snapshot.Reset();
+
+        // Dorme a maior parte da espera e cede a thread no final, para vencer com precisão sub-milissegundo.
+        // Só os prazos do relógio justificam a espera ativa: a backpressure espera no evento, com timeout.
+        Now = FPlatformTime::Seconds();
+        const double WaitSeconds = NextDue - Now;
+        if (WaitSeconds > SpinThresholdSeconds)
+        {
+            const double SleepSeconds = FMath::Min(WaitSeconds - SpinThresholdSeconds, NextCapacityCheck - Now);
+            WakeEvent->Wait(FMath::Max(1, (int32)(SleepSeconds * 1000.0)));
+        }
+        else
+        {
+            while (!bStopRequested && FPlatformTime::Seconds() < NextDue)
+            {
+                FPlatformProcess::YieldThread();
+            }
+        }
+    }
+    return 0;
+}
+
+void FIARClockedProducer::Stop()
+{
+    bStopRequested.AtomicSet(true);
+    if (WakeEvent) { WakeEvent->Trigger(); }
+}
@@ -0,0 +1,261 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Core/IARDriftCompensator.h"
+#include "../IAR.h" // Para logging
+#include "Misc/ScopeLock.h"
+
+namespace IARDriftCompensatorPrivate
+{
+    // Interpolação Hermite (Catmull-Rom) entre X0 e X1
+    FORCEINLINE float Hermite4(float XM1, float X0, float X1, float X2, float Frac)
+    {
+        const float C1 = 0.5f * (X1 - XM1);
+        const float C2 = XM1 - 2.5f * X0 + 2.0f * X1 - 0.5f * X2;
+        const float C3 = 0.5f * (X2 - XM1) + 1.5f * (X0 - X1);
+        return ((C3 * Frac + C2) * Frac + C1) * Frac + X0;
+    }
+}
+
+FIARDriftCompensator::FIARDriftCompensator()
+    : NumChannels(0)
+    , InputSampleRate(0)
+    , NominalRatio(1.0)
+    , TargetLatencyFrames(0)
+    , MaxLatencyFrames(0)
+    , LargestPullFrames(0)
+    , LargestPushFrames(0)
+    , ReadPosition(1.0)
+    , LastPushTimeSeconds(-1.0)
+    , bPrimed(false)
+    , SmoothedFillFrames(0.0)
+    , IntegralTerm(0.0)
+    , UnderrunCount(0)
+    , UnderrunsSinceLog(0)
+    , FramesSinceUnderrunLog(0)
+    , UnderrunLogIntervalFrames(0)
+{
+}
+
+int32 FIARDriftCompensator::GetMinimumTargetFrames(double NominalRatio, int32 InputSampleRate, int32 PullFrames, int32 PushFrames)
+{
+    const int32 PullConsumedFrames = FMath::CeilToInt32(FMath::Max(0, PullFrames) * NominalRatio * (1.0 + MaxCorrection));
+    // Enquanto a correção não alcança a deriva, a ocupação cai abaixo do alvo; no pior caso até saturar o termo proporcional
+    const int32 ControllerMarginFrames = FMath::CeilToInt32(FMath::Max(0, InputSampleRate) * MaxCorrection / ProportionalGain);
+    return PullConsumedFrames + FMath::Max(0, PushFrames) + InterpolationMarginFrames + ControllerMarginFrames;
+}
+
+bool FIARDriftCompensator::RaiseTargetForBlocks()
+{
+    const int32 MinimumTargetFrames = GetMinimumTargetFrames(NominalRatio, InputSampleRate, LargestPullFrames, LargestPushFrames);
+    if (MinimumTargetFrames <= TargetLatencyFrames)
+    {
+        return false;
+    }
+    TargetLatencyFrames = MinimumTargetFrames;
+    // Acima de alvo + 250ms o atraso já é perceptível: descarta em vez de corrigir lentamente
+    MaxLatencyFrames = TargetLatencyFrames + InputSampleRate / 4;
+    return true;
+}
+
+bool FIARDriftCompensator::Initialize(int32 InNumChannels, int32 InInputSampleRate, int32 InOutputSampleRate, int32 InTargetLatencyFrames,
+    int32 InExpectedPullFrames, int32 InExpectedPushFrames)
+{
+    if (InNumChannels <= 0 || InInputSampleRate <= 0 || InOutputSampleRate <= 0 || InTargetLatencyFrames <= 0)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARDriftCompensator: Parâmetros inválidos. CH: %d, SR: %d -> %d, Latência: %d"),
+            InNumChannels, InInputSampleRate, InOutputSampleRate, InTargetLatencyFrames);
+        return false;
+    }
+
+    FScopeLock Lock(&FifoLock);
+    NumChannels = InNumChannels;
+    InputSampleRate = InInputSampleRate;
+    NominalRatio = (double)InInputSampleRate / InOutputSampleRate;
+    TargetLatencyFrames = InTargetLatencyFrames;
+    MaxLatencyFrames = InTargetLatencyFrames + InInputSampleRate / 4;
+    LargestPullFrames = FMath::Max(0, InExpectedPullFrames);
+    LargestPushFrames = FMath::Max(0, InExpectedPushFrames);
+    if (RaiseTargetForBlocks())
+    {
+        UE_LOG(LogIAR, Log, TEXT("FIARDriftCompensator: Latência alvo elevada de %d para %d frames (blocos: %d no mestre, %d no secundário)."),
+            InTargetLatencyFrames, TargetLatencyFrames, LargestPullFrames, LargestPushFrames);
+    }
+    IntegralTerm = 0.0;
+    UnderrunCount = 0;
+    UnderrunsSinceLog = 0;
+    UnderrunLogIntervalFrames = FMath::Max<int64>(1, (int64)(UnderrunLogIntervalSeconds * InOutputSampleRate));
+    FramesSinceUnderrunLog = UnderrunLogIntervalFrames; // O primeiro underrun é registrado imediatamente
+    Fifo.Reset();
+    Fifo.Reserve((MaxLatencyFrames + 4096) * NumChannels);
+    ReadPosition = 1.0;
+    LastPushTimeSeconds = -1.0;
+    bPrimed = false;
+    return true;
+}
+
+void FIARDriftCompensator::Reset()
+{
+    FScopeLock Lock(&FifoLock);
+    Fifo.Reset();
+    ReadPosition = 1.0;
+    LastPushTimeSeconds = -1.0;
+    bPrimed = false;
+}
+
+void FIARDriftCompensator::Push(const float* InterleavedSamples, int32 NumFrames, int32 InNumChannels, double CaptureTimeSeconds)
+{
+    if (!InterleavedSamples || NumFrames <= 0 || InNumChannels <= 0 || NumChannels <= 0)
+    {
+        return;
+    }
+
+    FScopeLock Lock(&FifoLock);
+    LargestPushFrames = FMath::Max(LargestPushFrames, NumFrames);
+    LastPushTimeSeconds = CaptureTimeSeconds;
+    const int32 FirstNewSample = Fifo.Num();
+    if (InNumChannels == NumChannels)
+    {
+        Fifo.Append(InterleavedSamples, NumFrames * NumChannels);
+        return;
+    }
+
+    // O dispositivo abriu com outro número de canais: copia os que existem e completa com silêncio
+    Fifo.AddZeroed(NumFrames * NumChannels);
+    const int32 CopyChannels = FMath::Min(InNumChannels, NumChannels);
+    float* Dest = Fifo.GetData() + FirstNewSample;
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+    {
+        FMemory::Memcpy(Dest + Frame * NumChannels, InterleavedSamples + Frame * InNumChannels, CopyChannels * sizeof(float));
+    }
+}
+
+bool FIARDriftCompensator::Pull(float* Out, int32 OutStride, int32 ChannelOffset, int32 NumFrames, double CaptureTimeSeconds)
+{
+    using namespace IARDriftCompensatorPrivate;
+
+    if (!Out || NumFrames <= 0 || NumChannels <= 0 || ChannelOffset + NumChannels > OutStride)
+    {
+        return false;
+    }
+
+    FScopeLock Lock(&FifoLock);
+    int32 AvailableFrames = Fifo.Num() / NumChannels;
+    FramesSinceUnderrunLog = FMath::Min(FramesSinceUnderrunLog + NumFrames, UnderrunLogIntervalFrames);
+
+    // Um driver que entrega blocos maiores que os pedidos exige mais ocupação: volta a encher até o novo alvo
+    LargestPullFrames = FMath::Max(LargestPullFrames, NumFrames);
+    if (RaiseTargetForBlocks())
+    {
+        UE_LOG(LogIAR, Log, TEXT("FIARDriftCompensator: Latência alvo elevada para %d frames (blocos: %d no mestre, %d no secundário)."),
+            TargetLatencyFrames, LargestPullFrames, LargestPushFrames);
+        bPrimed = false;
+    }
+
+    // Frames que o secundário já capturou mas ainda entrega no próximo Push (no máximo um bloco)
+    const double PendingPushFrames = LastPushTimeSeconds >= 0.0
+        ? FMath::Clamp((CaptureTimeSeconds - LastPushTimeSeconds) * InputSampleRate, 0.0, (double)LargestPushFrames)
+        : 0.0;
+    const int32 PendingPushWholeFrames = FMath::FloorToInt32(PendingPushFrames);
+
+    if (!bPrimed)
+    {
+        if (AvailableFrames < TargetLatencyFrames + 3)
+        {
+            for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+            {
+                FMemory::Memzero(Out + Frame * OutStride + ChannelOffset, NumChannels * sizeof(float));
+            }
+            return false;
+        }
+        // Começa com a FIFO (mais o bloco já capturado pelo secundário) exatamente na latência alvo
+        const int32 ExcessFrames = AvailableFrames + PendingPushWholeFrames - TargetLatencyFrames - 1;
+        Fifo.RemoveAt(0, ExcessFrames * NumChannels, EAllowShrinking::No);
+        AvailableFrames -= ExcessFrames;
+        ReadPosition = 1.0;
+        SmoothedFillFrames = TargetLatencyFrames;
+        bPrimed = true;
+    }
+    else if (AvailableFrames > MaxLatencyFrames)
+    {
+        const int32 DroppedFrames = AvailableFrames + PendingPushWholeFrames - TargetLatencyFrames - 1;
+        UE_LOG(LogIAR, Warning, TEXT("FIARDriftCompensator: FIFO acima do limite (%d frames): %d frames descartados."), AvailableFrames, DroppedFrames);
+        Fifo.RemoveAt(0, DroppedFrames * NumChannels, EAllowShrinking::No);
+        AvailableFrames -= DroppedFrames;
+        SmoothedFillFrames = TargetLatencyFrames;
+    }
+
+    // Controlador PI sobre a ocupação suavizada: FIFO crescendo = secundário mais rápido = consumir mais rápido
+    const double BlockSeconds = (double)NumFrames * NominalRatio / InputSampleRate;
+    const double Alpha = FMath::Min(1.0, BlockSeconds / FillSmoothingSeconds);
+    SmoothedFillFrames += Alpha * ((AvailableFrames - ReadPosition + PendingPushFrames) - SmoothedFillFrames);
+    const double ErrorSeconds = (SmoothedFillFrames - TargetLatencyFrames) / InputSampleRate;
+    IntegralTerm = FMath::Clamp(IntegralTerm + IntegralGain * ErrorSeconds * BlockSeconds, -MaxCorrection, MaxCorrection);
+    const double Correction = FMath::Clamp(IntegralTerm + ProportionalGain * ErrorSeconds, -MaxCorrection, MaxCorrection);
+    const double Ratio = NominalRatio * (1.0 + Correction);
+
+    const float* In = Fifo.GetData();
+    int32 Frame = 0;
+    for (; Frame < NumFrames; ++Frame)
+    {
+        const int32 Index = (int32)ReadPosition;
+        if (Index + 2 >= AvailableFrames)
+        {
+            break; // Underrun: sem os pontos da interpolação
+        }
+        const float Frac = (float)(ReadPosition - Index);
+        const float* XM1 = In + (Index - 1) * NumChannels;
+        float* Dest = Out + Frame * OutStride + ChannelOffset;
+        for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+        {
+            Dest[Channel] = Hermite4(XM1[Channel], XM1[NumChannels + Channel], XM1[2 * NumChannels + Channel], XM1[3 * NumChannels + Channel], Frac);
+        }
+        ReadPosition += Ratio;
+    }
+
+    const bool bUnderrun = Frame < NumFrames;
+    for (; Frame < NumFrames; ++Frame)
+    {
+        FMemory::Memzero(Out + Frame * OutStride + ChannelOffset, NumChannels * sizeof(float));
+    }
+
+    // Descarta os frames consumidos, mantendo o histórico da interpolação
+    const int32 ConsumedFrames = FMath::Min((int32)ReadPosition - 1, AvailableFrames);
+    if (ConsumedFrames > 0)
+    {
+        Fifo.RemoveAt(0, ConsumedFrames * NumChannels, EAllowShrinking::No);
+        ReadPosition -= ConsumedFrames;
+    }
+
+    if (bUnderrun)
+    {
+        ++UnderrunCount;
+        ++UnderrunsSinceLog;
+        bPrimed = false; // Volta a encher até a latência alvo
+    }
+    // Chamado na thread de áudio a cada bloco: no máximo um aviso por intervalo
+    if (UnderrunsSinceLog > 0 && FramesSinceUnderrunLog >= UnderrunLogIntervalFrames)
+    {
+        UE_LOG(LogIAR, Warning, TEXT("FIARDriftCompensator: FIFO vazia (%d underruns desde o último aviso, %d no total); silêncio inserido até reencher."),
+            UnderrunsSinceLog, UnderrunCount);
+        UnderrunsSinceLog = 0;
+        FramesSinceUnderrunLog = 0;
+    }
+    return !bUnderrun;
+}
+
+double FIARDriftCompensator::GetEstimatedDriftPPM() const
+{
+    FScopeLock Lock(&FifoLock);
+    return IntegralTerm * 1.0e6;
+}
+
+int32 FIARDriftCompensator::GetTargetLatencyFrames() const
+{
+    FScopeLock Lock(&FifoLock);
+    return TargetLatencyFrames;
+}
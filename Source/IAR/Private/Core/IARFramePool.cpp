@@ -46,6 +46,8 @@ TSharedPtr<FIAR_AudioFrameData> UIARFramePool::AcquireFrame()
     {
         // Reset timestamp and ensure buffer size is correct (though it should be from init)
         Frame->Timestamp = 0.0f;
+        Frame->StartFrameIndex = INDEX_NONE;
+        Frame->OverlapFrames = 0;
         Frame->SampleRate = DefaultSampleRate;
         Frame->NumChannels = DefaultNumChannels;
         // The RawSamplesPtr->TArray<float> is reused, so its memory is kept. Just ensure its size is correct.
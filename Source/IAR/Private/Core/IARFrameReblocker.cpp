@@ -0,0 +1,93 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Core/IARFrameReblocker.h"
+#include "../IAR.h" // Para logging
+
+FIARFrameReblocker::FIARFrameReblocker()
+    : WindowFrames(0)
+    , HopFrames(0)
+    , SampleRate(0)
+    , NumChannels(0)
+    , NextWindowStartFrame(0)
+    , EmittedEndFrame(0)
+{
+}
+
+bool FIARFrameReblocker::Configure(int32 InWindowFrames, int32 InHopFrames)
+{
+    if (InWindowFrames <= 0 || InHopFrames <= 0 || InHopFrames > InWindowFrames)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARFrameReblocker: Janela inválida. Frames: %d, Passo: %d"), InWindowFrames, InHopFrames);
+        return false;
+    }
+
+    WindowFrames = InWindowFrames;
+    HopFrames = InHopFrames;
+    Reset(SampleRate, NumChannels);
+    return true;
+}
+
+bool FIARFrameReblocker::ConfigureWithOverlap(int32 InWindowFrames, float Overlap)
+{
+    const float ClampedOverlap = FMath::Clamp(Overlap, 0.0f, 0.875f);
+    return Configure(InWindowFrames, FMath::Clamp(FMath::RoundToInt(InWindowFrames * (1.0f - ClampedOverlap)), 1, FMath::Max(1, InWindowFrames)));
+}
+
+void FIARFrameReblocker::Reset(int32 InSampleRate, int32 InNumChannels)
+{
+    SampleRate = InSampleRate;
+    NumChannels = InNumChannels;
+    NextWindowStartFrame = 0;
+    EmittedEndFrame = 0;
+    Pending.Reset();
+    if (NumChannels > 0 && WindowFrames > 0)
+    {
+        // Uma janela mais o maior bloco típico de driver, para não realocar durante a captura
+        Pending.Reserve((WindowFrames * 2 + 4096) * NumChannels);
+    }
+}
+
+void FIARFrameReblocker::Push(const float* InterleavedSamples, int32 NumFrames, FEmitWindow Emit)
+{
+    if (!InterleavedSamples || NumFrames <= 0 || NumChannels <= 0 || WindowFrames <= 0)
+    {
+        return;
+    }
+
+    Pending.Append(InterleavedSamples, NumFrames * NumChannels);
+
+    const int32 TotalFrames = Pending.Num() / NumChannels;
+    int32 ReadFrame = 0;
+    while (TotalFrames - ReadFrame >= WindowFrames)
+    {
+        const int32 OverlapFrames = (int32)FMath::Max<int64>(0, EmittedEndFrame - NextWindowStartFrame);
+        Emit(Pending.GetData() + (int64)ReadFrame * NumChannels, WindowFrames, NextWindowStartFrame, OverlapFrames);
+        EmittedEndFrame = NextWindowStartFrame + WindowFrames;
+        ReadFrame += HopFrames;
+        NextWindowStartFrame += HopFrames;
+    }
+
+    // Compacta uma vez por bloco: mantém no início apenas o que as próximas janelas ainda usam
+    if (ReadFrame > 0)
+    {
+        Pending.RemoveAt(0, ReadFrame * NumChannels, EAllowShrinking::No);
+    }
+}
+
+void FIARFrameReblocker::Flush(FEmitWindow Emit)
+{
+    const int32 PendingFrames = GetPendingFrames();
+    const int32 OverlapFrames = (int32)FMath::Clamp<int64>(EmittedEndFrame - NextWindowStartFrame, 0, PendingFrames);
+    if (PendingFrames > OverlapFrames)
+    {
+        Emit(Pending.GetData(), PendingFrames, NextWindowStartFrame, OverlapFrames);
+        EmittedEndFrame = NextWindowStartFrame + PendingFrames;
+    }
+    NextWindowStartFrame += PendingFrames;
+    Pending.Reset();
+}
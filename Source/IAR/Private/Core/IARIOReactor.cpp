@@ -0,0 +1,382 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Core/IARIOReactor.h"
+#include "../IAR.h" // Para logging
+#include "Async/Async.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Misc/ScopeLock.h"
+
+#if PLATFORM_LINUX
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace IARIOReactorPrivate
+{
+    FCriticalSection InstanceLock;
+    FIARIOReactor* Instance = nullptr;
+    bool bStartFailed = false;
+
+    /** Id reservado para o eventfd de despertar. */
+    constexpr uint64 WakeRegistrationId = 0;
+}
+
+// Estado de um registro. Compartilhado com os callbacks em andamento, que podem terminar depois do Unregister.
+struct FIARIOReactor::FRegistration
+{
+    int32 FileDescriptor = -1;
+    FIOCallback Callback;
+    // Callbacks em andamento + 1 referência do próprio registro, solta pelo Unregister: quem levar a 0 sinaliza o evento
+    FThreadSafeCounter CallbacksInFlight;
+    FEvent* CallbacksDoneEvent = nullptr;
+    FThreadSafeBool bArmed;        // Ligado por Arm e consumido pelo evento; ERR/HUP com o registro desarmado são ignorados
+    FThreadSafeBool bUnregistered;
+
+    FRegistration()
+        : CallbacksInFlight(1)
+        , CallbacksDoneEvent(FPlatformProcess::GetSynchEventFromPool(true))
+    {
+    }
+
+    ~FRegistration()
+    {
+        FPlatformProcess::ReturnSynchEventToPool(CallbacksDoneEvent);
+    }
+
+    void ReleaseReference()
+    {
+        if (CallbacksInFlight.Decrement() == 0)
+        {
+            CallbacksDoneEvent->Trigger();
+        }
+    }
+};
+
+FIARIOReactor::FIARIOReactor()
+    : EpollDescriptor(-1)
+    , WakeDescriptor(-1)
+    , ReactorThread(nullptr)
+    , bStopRequested(false)
+    , NextRegistrationId(1)
+{
+}
+
+FIARIOReactor::~FIARIOReactor()
+{
+    if (ReactorThread)
+    {
+        Stop();
+        ReactorThread->WaitForCompletion();
+        delete ReactorThread;
+        ReactorThread = nullptr;
+    }
+#if PLATFORM_LINUX
+    if (WakeDescriptor != -1) { close(WakeDescriptor); }
+    if (EpollDescriptor != -1) { close(EpollDescriptor); }
+#endif
+    WakeDescriptor = -1;
+    EpollDescriptor = -1;
+}
+
+FIARIOReactor* FIARIOReactor::Get()
+{
+#if PLATFORM_LINUX
+    using namespace IARIOReactorPrivate;
+    FScopeLock Lock(&InstanceLock);
+    if (!Instance && !bStartFailed)
+    {
+        FIARIOReactor* NewReactor = new FIARIOReactor();
+        if (NewReactor->Start())
+        {
+            Instance = NewReactor;
+        }
+        else
+        {
+            // Não tenta de novo a cada encoder: os chamadores seguem com suas threads
+            delete NewReactor;
+            bStartFailed = true;
+        }
+    }
+    return Instance;
+#else
+    return nullptr;
+#endif
+}
+
+void FIARIOReactor::Shutdown()
+{
+    using namespace IARIOReactorPrivate;
+    FScopeLock Lock(&InstanceLock);
+    if (Instance)
+    {
+        if (Instance->Registrations.Num() > 0)
+        {
+            UE_LOG(LogIAR, Warning, TEXT("FIARIOReactor: Encerrando com %d registros ativos."), Instance->Registrations.Num());
+        }
+        delete Instance;
+        Instance = nullptr;
+    }
+}
+
+bool FIARIOReactor::Start()
+{
+#if PLATFORM_LINUX
+    EpollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    WakeDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (EpollDescriptor == -1 || WakeDescriptor == -1)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARIOReactor: Falha ao criar epoll/eventfd. Erro: %s"), UTF8_TO_TCHAR(strerror(errno)));
+        return false;
+    }
+
+    epoll_event WakeEvent = {};
+    WakeEvent.events = EPOLLIN;
+    WakeEvent.data.u64 = IARIOReactorPrivate::WakeRegistrationId;
+    if (epoll_ctl(EpollDescriptor, EPOLL_CTL_ADD, WakeDescriptor, &WakeEvent) == -1)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARIOReactor: Falha ao registrar o eventfd. Erro: %s"), UTF8_TO_TCHAR(strerror(errno)));
+        return false;
+    }
+
+    ReactorThread = FRunnableThread::Create(this, TEXT("IARIOReactorThread"), 0, TPri_AboveNormal);
+    if (!ReactorThread)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARIOReactor: Falha ao criar a thread do reator."));
+        return false;
+    }
+
+    UE_LOG(LogIAR, Log, TEXT("FIARIOReactor: Reator de I/O iniciado."));
+    return true;
+#else
+    return false;
+#endif
+}
+
+int32 FIARIOReactor::Register(int32 FileDescriptor, FIOCallback&& Callback)
+{
+#if PLATFORM_LINUX
+    if (FileDescriptor < 0 || !Callback)
+    {
+        return 0;
+    }
+
+    TSharedPtr<FRegistration, ESPMode::ThreadSafe> Registration = MakeShared<FRegistration, ESPMode::ThreadSafe>();
+    Registration->FileDescriptor = FileDescriptor;
+    Registration->Callback = MoveTemp(Callback);
+
+    FScopeLock Lock(&RegistrationsLock);
+    const int32 RegistrationId = NextRegistrationId++;
+
+    // Adicionado desarmado: EPOLLONESHOT sem eventos de interesse (o dono chama Arm quando quiser o primeiro evento)
+    epoll_event Event = {};
+    Event.events = EPOLLONESHOT;
+    Event.data.u64 = (uint64)RegistrationId;
+    if (epoll_ctl(EpollDescriptor, EPOLL_CTL_ADD, FileDescriptor, &Event) == -1)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARIOReactor: Falha ao registrar o descritor %d. Erro: %s"), FileDescriptor, UTF8_TO_TCHAR(strerror(errno)));
+        return 0;
+    }
+    Registrations.Add(RegistrationId, Registration);
+    return RegistrationId;
+#else
+    return 0;
+#endif
+}
+
+bool FIARIOReactor::Arm(int32 RegistrationId, uint32 Events)
+{
+#if PLATFORM_LINUX
+    FScopeLock Lock(&RegistrationsLock);
+    const TSharedPtr<FRegistration, ESPMode::ThreadSafe>* Registration = Registrations.Find(RegistrationId);
+    if (!Registration)
+    {
+        return false;
+    }
+
+    (*Registration)->bArmed.AtomicSet(true);
+    epoll_event Event = {};
+    Event.events = EPOLLONESHOT | ((Events & Readable) ? (uint32)(EPOLLIN | EPOLLRDHUP) : 0u) | ((Events & Writable) ? (uint32)EPOLLOUT : 0u);
+    Event.data.u64 = (uint64)RegistrationId;
+    if (epoll_ctl(EpollDescriptor, EPOLL_CTL_MOD, (*Registration)->FileDescriptor, &Event) == -1)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARIOReactor: Falha ao armar o descritor %d. Erro: %s"), (*Registration)->FileDescriptor, UTF8_TO_TCHAR(strerror(errno)));
+        (*Registration)->bArmed.AtomicSet(false);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FIARIOReactor::Unregister(int32 RegistrationId)
+{
+#if PLATFORM_LINUX
+    TSharedPtr<FRegistration, ESPMode::ThreadSafe> Registration;
+    {
+        FScopeLock Lock(&RegistrationsLock);
+        if (!Registrations.RemoveAndCopyValue(RegistrationId, Registration))
+        {
+            return;
+        }
+        Registration->bUnregistered.AtomicSet(true);
+        epoll_ctl(EpollDescriptor, EPOLL_CTL_DEL, Registration->FileDescriptor, nullptr);
+    }
+
+    // Eventos já retirados do epoll ainda podem estar a caminho do pool: os callbacks verificam bUnregistered antes de rodar.
+    // O último a terminar (este Unregister ou um callback) sinaliza o evento; sem espera ativa na thread chamadora.
+    Registration->ReleaseReference();
+    while (!Registration->CallbacksDoneEvent->Wait(UnregisterWaitWarningMs))
+    {
+        // Não dá para abandonar: o callback ainda pode usar o dono do registro
+        UE_LOG(LogIAR, Warning, TEXT("FIARIOReactor: Unregister do descritor %d aguardando há mais de %u ms por %d callback(s) em andamento."),
+            Registration->FileDescriptor, UnregisterWaitWarningMs, Registration->CallbacksInFlight.GetValue());
+    }
+#endif
+}
+
+void FIARIOReactor::Dispatch(TUniqueFunction<void()>&& Work)
+{
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, MoveTemp(Work));
+}
+
+void FIARIOReactor::DispatchAfter(double DelaySeconds, TUniqueFunction<void()>&& Work)
+{
+#if PLATFORM_LINUX
+    {
+        FScopeLock Lock(&TimersLock);
+        Timers.Add({ FPlatformTime::Seconds() + FMath::Max(0.0, DelaySeconds), MoveTemp(Work) });
+    }
+    Wake(); // A thread recalcula o timeout do epoll_wait
+#else
+    Dispatch(MoveTemp(Work));
+#endif
+}
+
+void FIARIOReactor::Wake()
+{
+#if PLATFORM_LINUX
+    if (WakeDescriptor != -1)
+    {
+        const uint64 One = 1;
+        const ssize_t Ignored = write(WakeDescriptor, &One, sizeof(One));
+        (void)Ignored;
+    }
+#endif
+}
+
+int32 FIARIOReactor::DispatchDueTimers(bool bAll)
+{
+    TArray<TUniqueFunction<void()>> DueWork;
+    int32 NextTimeoutMs = -1;
+    {
+        FScopeLock Lock(&TimersLock);
+        const double Now = FPlatformTime::Seconds();
+        double NextDueTime = TNumericLimits<double>::Max();
+        for (int32 Index = Timers.Num() - 1; Index >= 0; --Index)
+        {
+            if (bAll || Timers[Index].DueTime <= Now)
+            {
+                DueWork.Add(MoveTemp(Timers[Index].Work));
+                Timers.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+            }
+            else
+            {
+                NextDueTime = FMath::Min(NextDueTime, Timers[Index].DueTime);
+            }
+        }
+        if (Timers.Num() > 0)
+        {
+            NextTimeoutMs = FMath::Max(1, FMath::CeilToInt((NextDueTime - Now) * 1000.0));
+        }
+    }
+    for (TUniqueFunction<void()>& Work : DueWork)
+    {
+        Dispatch(MoveTemp(Work));
+    }
+    return NextTimeoutMs;
+}
+
+uint32 FIARIOReactor::Run()
+{
+#if PLATFORM_LINUX
+    epoll_event Events[MaxEventsPerWait];
+    while (!bStopRequested)
+    {
+        const int32 TimeoutMs = DispatchDueTimers(false);
+        const int NumEvents = epoll_wait(EpollDescriptor, Events, MaxEventsPerWait, TimeoutMs);
+        if (NumEvents == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            UE_LOG(LogIAR, Error, TEXT("FIARIOReactor: epoll_wait falhou. Erro: %s"), UTF8_TO_TCHAR(strerror(errno)));
+            break;
+        }
+
+        for (int32 Index = 0; Index < NumEvents; ++Index)
+        {
+            const uint64 RegistrationId = Events[Index].data.u64;
+            if (RegistrationId == IARIOReactorPrivate::WakeRegistrationId)
+            {
+                uint64 WakeCount = 0;
+                const ssize_t Ignored = read(WakeDescriptor, &WakeCount, sizeof(WakeCount));
+                (void)Ignored;
+                continue;
+            }
+
+            TSharedPtr<FRegistration, ESPMode::ThreadSafe> Registration;
+            {
+                FScopeLock Lock(&RegistrationsLock);
+                const TSharedPtr<FRegistration, ESPMode::ThreadSafe>* Found = Registrations.Find((int32)RegistrationId);
+                // Um callback por Arm: o epoll entrega ERR/HUP mesmo sem interesse armado (logo após o Register)
+                if (Found && (*Found)->bArmed.AtomicSet(false))
+                {
+                    Registration = *Found;
+                    // Contado ainda sob o lock, para o Unregister não retornar antes deste callback terminar
+                    Registration->CallbacksInFlight.Increment();
+                }
+            }
+            if (!Registration.IsValid())
+            {
+                continue;
+            }
+
+            // Erro ou HUP acordam os dois lados: a próxima leitura/escrita do dono reporta a condição
+            const uint32 EpollEvents = Events[Index].events;
+            uint32 ReadyEvents = 0;
+            if (EpollEvents & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) { ReadyEvents |= Readable; }
+            if (EpollEvents & (EPOLLOUT | EPOLLHUP | EPOLLERR)) { ReadyEvents |= Writable; }
+
+            Dispatch([Registration, ReadyEvents]()
+            {
+                if (!Registration->bUnregistered)
+                {
+                    Registration->Callback(ReadyEvents);
+                }
+                Registration->ReleaseReference();
+            });
+        }
+    }
+    // Os donos contam os trabalhos agendados: nenhum fica sem rodar (eles veem as próprias flags de parada)
+    DispatchDueTimers(true);
+#endif
+    return 0;
+}
+
+void FIARIOReactor::Stop()
+{
+    bStopRequested.AtomicSet(true);
+    Wake();
+}
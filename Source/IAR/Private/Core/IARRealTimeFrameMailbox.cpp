@@ -0,0 +1,64 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Core/IARRealTimeFrameMailbox.h"
+#include "../IAR.h" // Para logging
+
+void FIAR_RTFrameSnapshot::CopyPixels(TArray<FColor>& Dest, const TArray<FColor>* Source)
+{
+    // Reset mantém a capacidade, então após o primeiro frame não há realocação
+    Dest.Reset();
+    if (Source)
+    {
+        Dest.Append(*Source);
+    }
+}
+
+FIARRealTimeFrameMailbox::FIARRealTimeFrameMailbox()
+    : NextSequenceNumber(1)
+    , LastConsumedSequenceNumber(0)
+{
+}
+
+FIAR_RTFrameSnapshot& FIARRealTimeFrameMailbox::BeginPublish()
+{
+    return Buffer.GetWriteBuffer();
+}
+
+void FIARRealTimeFrameMailbox::EndPublish()
+{
+    Buffer.GetWriteBuffer().SequenceNumber = NextSequenceNumber++;
+    Buffer.SwapWriteBuffers();
+}
+
+const FIAR_RTFrameSnapshot* FIARRealTimeFrameMailbox::ConsumeLatest()
+{
+    if (!Buffer.IsDirty())
+    {
+        return nullptr;
+    }
+
+    Buffer.SwapReadBuffers();
+    const FIAR_RTFrameSnapshot& Snapshot = Buffer.Read();
+
+    // Qualquer salto na sequência corresponde a snapshots sobrescritos pelo produtor
+    if (LastConsumedSequenceNumber != 0 && Snapshot.SequenceNumber > LastConsumedSequenceNumber + 1)
+    {
+        DroppedSnapshots.Add(static_cast<int32>(Snapshot.SequenceNumber - LastConsumedSequenceNumber - 1));
+    }
+    LastConsumedSequenceNumber = Snapshot.SequenceNumber;
+
+    return &Snapshot;
+}
+
+void FIARRealTimeFrameMailbox::Reset()
+{
+    Buffer.Reset();
+    NextSequenceNumber = 1;
+    LastConsumedSequenceNumber = 0;
+    DroppedSnapshots.Reset();
+}
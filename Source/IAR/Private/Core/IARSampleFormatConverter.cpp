@@ -0,0 +1,210 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Core/IARSampleFormatConverter.h"
+#include "../IAR.h" // Para logging
+#include "Math/VectorRegister.h"
+
+// As amostras são copiadas direto da memória para o arquivo/pipe, que são little-endian
+static_assert(PLATFORM_LITTLE_ENDIAN, "FIARSampleFormatConverter assume uma plataforma little-endian.");
+
+namespace IARSampleFormatPrivate
+{
+    /** Limites e escala de cada formato inteiro (o máximo de S32 é o maior float abaixo de 2^31). */
+    constexpr float S16Scale = 32767.0f;
+    constexpr float S16Min = -32768.0f;
+    constexpr float S16Max = 32767.0f;
+    constexpr float S24Scale = 8388607.0f;
+    constexpr float S24Min = -8388608.0f;
+    constexpr float S24Max = 8388607.0f;
+    constexpr float S32Scale = 2147483647.0f;
+    constexpr float S32Min = -2147483648.0f;
+    constexpr float S32Max = 2147483520.0f;
+
+    // Quantiza 4 amostras: escala, soma o dither, satura e arredonda ao inteiro mais próximo
+    FORCEINLINE void QuantizeVector(const float* In, const float* Dither, float Scale, float MinValue, float MaxValue, int32* OutInts)
+    {
+        VectorRegister4Float Value = VectorMultiply(VectorLoad(In), VectorSetFloat1(Scale));
+        if (Dither)
+        {
+            Value = VectorAdd(Value, VectorLoad(Dither));
+        }
+        Value = VectorMin(VectorMax(Value, VectorSetFloat1(MinValue)), VectorSetFloat1(MaxValue));
+        // VectorFloatToInt trunca em direção a zero: soma ±0.5 para arredondar
+        const VectorRegister4Float Rounding = VectorSelect(VectorCompareGE(Value, VectorZeroFloat()), VectorSetFloat1(0.5f), VectorSetFloat1(-0.5f));
+        VectorIntStore(VectorFloatToInt(VectorAdd(Value, Rounding)), OutInts);
+    }
+
+    // Versão escalar para as amostras que sobram depois dos blocos de 4
+    FORCEINLINE int32 QuantizeScalar(float Sample, float Dither, float Scale, float MinValue, float MaxValue)
+    {
+        const float Value = FMath::Clamp(Sample * Scale + Dither, MinValue, MaxValue);
+        return (int32)(Value + (Value >= 0.0f ? 0.5f : -0.5f));
+    }
+}
+
+FIARSampleFormatConverter::FIARSampleFormatConverter(EIARSampleFormat InFormat, bool bInApplyDither)
+    : Format(InFormat)
+    , bApplyDither(bInApplyDither)
+    , DitherState(0x9E3779B9u)
+{
+}
+
+bool FIARSampleFormatConverter::FormatFromBitDepth(int32 BitDepth, bool bFloatSamples, EIARSampleFormat& OutFormat)
+{
+    if (bFloatSamples)
+    {
+        if (BitDepth != 32)
+        {
+            return false;
+        }
+        OutFormat = EIARSampleFormat::F32;
+        return true;
+    }
+
+    switch (BitDepth)
+    {
+    case 16: OutFormat = EIARSampleFormat::S16; return true;
+    case 24: OutFormat = EIARSampleFormat::S24; return true;
+    case 32: OutFormat = EIARSampleFormat::S32; return true;
+    default: return false;
+    }
+}
+
+int32 FIARSampleFormatConverter::GetBytesPerSample(EIARSampleFormat InFormat)
+{
+    switch (InFormat)
+    {
+    case EIARSampleFormat::S16: return 2;
+    case EIARSampleFormat::S24: return 3;
+    case EIARSampleFormat::S32: return 4;
+    case EIARSampleFormat::F32: return 4;
+    default: return 2;
+    }
+}
+
+const TCHAR* FIARSampleFormatConverter::GetRawFormatName(EIARSampleFormat InFormat)
+{
+    switch (InFormat)
+    {
+    case EIARSampleFormat::S24: return TEXT("s24le");
+    case EIARSampleFormat::S32: return TEXT("s32le");
+    case EIARSampleFormat::F32: return TEXT("f32le");
+    default: return TEXT("s16le");
+    }
+}
+
+void FIARSampleFormatConverter::Convert(const float* In, int32 NumSamples, uint8* Out)
+{
+    if (!In || !Out || NumSamples <= 0)
+    {
+        return;
+    }
+
+    // Dither só faz sentido quando a quantização perde resolução em relação ao float (16 e 24 bits)
+    const bool bUseDither = bApplyDither && (Format == EIARSampleFormat::S16 || Format == EIARSampleFormat::S24);
+    if (bUseDither)
+    {
+        GenerateDither(NumSamples);
+    }
+    const float* Dither = bUseDither ? DitherBuffer.GetData() : nullptr;
+
+    switch (Format)
+    {
+    case EIARSampleFormat::S16: ConvertToS16(In, NumSamples, Out, Dither); break;
+    case EIARSampleFormat::S24: ConvertToS24(In, NumSamples, Out, Dither); break;
+    case EIARSampleFormat::S32: ConvertToS32(In, NumSamples, Out); break;
+    case EIARSampleFormat::F32: FMemory::Memcpy(Out, In, NumSamples * sizeof(float)); break;
+    }
+}
+
+void FIARSampleFormatConverter::GenerateDither(int32 NumSamples)
+{
+    DitherBuffer.SetNumUninitialized(NumSamples, EAllowShrinking::No);
+
+    // xorshift32: barato e suficiente para ruído de dither
+    uint32 State = DitherState;
+    auto NextUniform = [&State]()
+    {
+        State ^= State << 13;
+        State ^= State >> 17;
+        State ^= State << 5;
+        return (float)(State >> 8) * (1.0f / 16777216.0f) - 0.5f;
+    };
+
+    float* Dither = DitherBuffer.GetData();
+    for (int32 i = 0; i < NumSamples; ++i)
+    {
+        Dither[i] = NextUniform() + NextUniform();
+    }
+    DitherState = State;
+}
+
+void FIARSampleFormatConverter::ConvertToS16(const float* In, int32 NumSamples, uint8* Out, const float* Dither)
+{
+    using namespace IARSampleFormatPrivate;
+
+    int16* OutSamples = reinterpret_cast<int16*>(Out);
+    const int32 NumVectorSamples = NumSamples & ~3;
+    alignas(16) int32 Ints[4];
+
+    for (int32 i = 0; i < NumVectorSamples; i += 4)
+    {
+        QuantizeVector(In + i, Dither ? Dither + i : nullptr, S16Scale, S16Min, S16Max, Ints);
+        OutSamples[i + 0] = (int16)Ints[0];
+        OutSamples[i + 1] = (int16)Ints[1];
+        OutSamples[i + 2] = (int16)Ints[2];
+        OutSamples[i + 3] = (int16)Ints[3];
+    }
+    for (int32 i = NumVectorSamples; i < NumSamples; ++i)
+    {
+        OutSamples[i] = (int16)QuantizeScalar(In[i], Dither ? Dither[i] : 0.0f, S16Scale, S16Min, S16Max);
+    }
+}
+
+void FIARSampleFormatConverter::ConvertToS24(const float* In, int32 NumSamples, uint8* Out, const float* Dither)
+{
+    using namespace IARSampleFormatPrivate;
+
+    const int32 NumVectorSamples = NumSamples & ~3;
+    alignas(16) int32 Ints[4];
+
+    // Cada amostra ocupa 3 bytes: copia os 3 bytes menos significativos do int32 (little-endian)
+    for (int32 i = 0; i < NumVectorSamples; i += 4)
+    {
+        QuantizeVector(In + i, Dither ? Dither + i : nullptr, S24Scale, S24Min, S24Max, Ints);
+        uint8* Dest = Out + i * 3;
+        FMemory::Memcpy(Dest + 0, &Ints[0], 3);
+        FMemory::Memcpy(Dest + 3, &Ints[1], 3);
+        FMemory::Memcpy(Dest + 6, &Ints[2], 3);
+        FMemory::Memcpy(Dest + 9, &Ints[3], 3);
+    }
+    for (int32 i = NumVectorSamples; i < NumSamples; ++i)
+    {
+        const int32 Value = QuantizeScalar(In[i], Dither ? Dither[i] : 0.0f, S24Scale, S24Min, S24Max);
+        FMemory::Memcpy(Out + i * 3, &Value, 3);
+    }
+}
+
+void FIARSampleFormatConverter::ConvertToS32(const float* In, int32 NumSamples, uint8* Out)
+{
+    using namespace IARSampleFormatPrivate;
+
+    int32* OutSamples = reinterpret_cast<int32*>(Out);
+    const int32 NumVectorSamples = NumSamples & ~3;
+
+    for (int32 i = 0; i < NumVectorSamples; i += 4)
+    {
+        alignas(16) int32 Ints[4];
+        QuantizeVector(In + i, nullptr, S32Scale, S32Min, S32Max, Ints);
+        FMemory::Memcpy(OutSamples + i, Ints, sizeof(Ints));
+    }
+    for (int32 i = NumVectorSamples; i < NumSamples; ++i)
+    {
+        OutSamples[i] = QuantizeScalar(In[i], 0.0f, S32Scale, S32Min, S32Max);
+    }
+}
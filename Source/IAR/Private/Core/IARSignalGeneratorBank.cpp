@@ -0,0 +1,325 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Core/IARSignalGeneratorBank.h"
+#include "../IAR.h" // Para logging
+#include "Math/VectorRegister.h"
+
+static_assert(FIARSignalGeneratorBank::ReseedIntervalFrames % 4 == 0, "ReseedIntervalFrames deve ser múltiplo de 4.");
+
+namespace IARSignalGeneratorPrivate
+{
+    /** Um ciclo completo no acumulador de fase de 64 bits. */
+    constexpr double PhaseCycle = 18446744073709551616.0; // 2^64
+    constexpr double PhaseToRadians = 2.0 * UE_DOUBLE_PI / PhaseCycle;
+    /** Os 32 bits mais altos da fase, lidos como int32, cobrem [-PI, PI). */
+    constexpr float HighPhaseToRadians = UE_PI / 2147483648.0f;
+
+    FORCEINLINE uint64 FrequencyToPhaseIncrement(double FrequencyHz, int32 SampleRate)
+    {
+        // FrequencyHz < Nyquist: o incremento cabe em 63 bits
+        return (uint64)(FrequencyHz / SampleRate * PhaseCycle);
+    }
+
+    FORCEINLINE float PhaseToRadiansFast(uint64 Phase)
+    {
+        return (float)(int32)(uint32)(Phase >> 32) * HighPhaseToRadians;
+    }
+}
+
+FIARSignalGeneratorBank::FIARSignalGeneratorBank()
+    : SampleRate(0)
+    , NumChannels(0)
+    , FramePosition(0)
+{
+}
+
+bool FIARSignalGeneratorBank::Configure(int32 InSampleRate, int32 InNumChannels)
+{
+    Voices.Reset();
+    Buses.Reset();
+    BusUsed.Reset();
+    FramePosition = 0;
+
+    if (InSampleRate <= 0 || InNumChannels <= 0)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARSignalGeneratorBank: Formato inválido. SR: %d, CH: %d"), InSampleRate, InNumChannels);
+        SampleRate = 0;
+        NumChannels = 0;
+        return false;
+    }
+
+    SampleRate = InSampleRate;
+    NumChannels = InNumChannels;
+    Buses.SetNum(NumChannels + 1);
+    BusUsed.Init(false, NumChannels + 1);
+    return true;
+}
+
+bool FIARSignalGeneratorBank::ValidateVoice(float FrequencyHz, int32 Channel) const
+{
+    if (SampleRate <= 0)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARSignalGeneratorBank: Chame Configure() antes de adicionar vozes."));
+        return false;
+    }
+    if (Channel != INDEX_NONE && (Channel < 0 || Channel >= NumChannels))
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARSignalGeneratorBank: Canal inválido %d (%d canais)."), Channel, NumChannels);
+        return false;
+    }
+    if (!(FrequencyHz > 0.0f) || FrequencyHz >= SampleRate * 0.5f)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARSignalGeneratorBank: Frequência %.2f Hz fora de (0, %.1f) Hz."), FrequencyHz, SampleRate * 0.5f);
+        return false;
+    }
+    return true;
+}
+
+void FIARSignalGeneratorBank::AddVoice(FVoice&& Voice)
+{
+    BusUsed[Voice.Channel + 1] = true;
+    Voices.Add(MoveTemp(Voice));
+}
+
+bool FIARSignalGeneratorBank::AddSine(float FrequencyHz, float Amplitude, int32 Channel)
+{
+    if (!ValidateVoice(FrequencyHz, Channel))
+    {
+        return false;
+    }
+
+    FVoice Voice;
+    Voice.Type = EVoiceType::Sine;
+    Voice.Channel = Channel;
+    Voice.Amplitude = Amplitude;
+    Voice.PhaseIncrement = IARSignalGeneratorPrivate::FrequencyToPhaseIncrement(FrequencyHz, SampleRate);
+    AddVoice(MoveTemp(Voice));
+    return true;
+}
+
+bool FIARSignalGeneratorBank::AddChord(float RootFrequencyHz, const TArray<float>& FrequencyRatios, float Amplitude, int32 Channel)
+{
+    if (FrequencyRatios.Num() == 0)
+    {
+        return false;
+    }
+    for (float Ratio : FrequencyRatios)
+    {
+        if (!ValidateVoice(RootFrequencyHz * Ratio, Channel))
+        {
+            return false;
+        }
+    }
+
+    const float NoteAmplitude = Amplitude / FrequencyRatios.Num();
+    for (float Ratio : FrequencyRatios)
+    {
+        AddSine(RootFrequencyHz * Ratio, NoteAmplitude, Channel);
+    }
+    return true;
+}
+
+bool FIARSignalGeneratorBank::AddSweep(float StartHz, float EndHz, float DurationSeconds, float Amplitude, int32 Channel)
+{
+    using namespace IARSignalGeneratorPrivate;
+
+    if (!ValidateVoice(StartHz, Channel) || !ValidateVoice(EndHz, Channel))
+    {
+        return false;
+    }
+    if (!(DurationSeconds > 0.0f))
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARSignalGeneratorBank: Duração de varredura inválida (%.3f s)."), DurationSeconds);
+        return false;
+    }
+
+    FVoice Voice;
+    Voice.Type = EVoiceType::Sweep;
+    Voice.Channel = Channel;
+    Voice.Amplitude = Amplitude;
+    Voice.SweepLengthFrames = FMath::Max<int64>(1, (int64)FMath::RoundToDouble((double)DurationSeconds * SampleRate));
+    Voice.PhaseIncrement = FrequencyToPhaseIncrement(StartHz, SampleRate);
+    // Incremento inteiro por frame: a trajetória da fase é exata e não depende de arredondamentos em float
+    const double EndIncrement = (double)FrequencyToPhaseIncrement(EndHz, SampleRate);
+    Voice.PhaseIncrementDelta = (int64)((EndIncrement - (double)Voice.PhaseIncrement) / Voice.SweepLengthFrames);
+    AddVoice(MoveTemp(Voice));
+    return true;
+}
+
+bool FIARSignalGeneratorBank::AddNoise(uint32 Seed, float Amplitude, int32 Channel)
+{
+    if (!ValidateVoice(1.0f, Channel))
+    {
+        return false;
+    }
+
+    FVoice Voice;
+    Voice.Type = EVoiceType::Noise;
+    Voice.Channel = Channel;
+    Voice.Amplitude = Amplitude;
+    // xorshift32 fica preso em zero: a semente 0 é trocada por uma constante
+    Voice.NoiseSeed = Seed != 0 ? Seed : 0x9E3779B9u;
+    Voice.NoiseState = Voice.NoiseSeed;
+    AddVoice(MoveTemp(Voice));
+    return true;
+}
+
+void FIARSignalGeneratorBank::ClearVoices()
+{
+    Voices.Reset();
+    BusUsed.Init(false, Buses.Num());
+}
+
+void FIARSignalGeneratorBank::Reset()
+{
+    FramePosition = 0;
+    for (FVoice& Voice : Voices)
+    {
+        Voice.Phase = 0;
+        Voice.SweepPosition = 0;
+        Voice.NoiseState = Voice.NoiseSeed;
+    }
+}
+
+void FIARSignalGeneratorBank::Render(float* OutInterleaved, int32 NumFrames)
+{
+    if (!OutInterleaved || NumFrames <= 0 || NumChannels <= 0)
+    {
+        return;
+    }
+
+    // Os barramentos são processados em grupos de 4 frames: o excedente do último grupo é descartado
+    const int32 PaddedFrames = Align(NumFrames, 4);
+    for (int32 BusIndex = 0; BusIndex < Buses.Num(); ++BusIndex)
+    {
+        if (BusUsed[BusIndex])
+        {
+            Buses[BusIndex].SetNumUninitialized(PaddedFrames, EAllowShrinking::No);
+            FMemory::Memzero(Buses[BusIndex].GetData(), PaddedFrames * sizeof(float));
+        }
+    }
+
+    for (FVoice& Voice : Voices)
+    {
+        float* Bus = Buses[Voice.Channel + 1].GetData();
+        switch (Voice.Type)
+        {
+        case EVoiceType::Sine:  RenderSine(Voice, Bus, PaddedFrames); break;
+        case EVoiceType::Sweep: RenderSweep(Voice, Bus, NumFrames, PaddedFrames); break;
+        case EVoiceType::Noise: RenderNoise(Voice, Bus, NumFrames); break;
+        }
+    }
+
+    // Intercala: cada canal recebe o barramento compartilhado mais o seu próprio
+    const float* SharedBus = BusUsed[0] ? Buses[0].GetData() : nullptr;
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+    {
+        const float* ChannelBus = BusUsed[Channel + 1] ? Buses[Channel + 1].GetData() : nullptr;
+        float* Out = OutInterleaved + Channel;
+        if (SharedBus && ChannelBus)
+        {
+            for (int32 i = 0; i < NumFrames; ++i) { Out[i * NumChannels] = SharedBus[i] + ChannelBus[i]; }
+        }
+        else if (SharedBus || ChannelBus)
+        {
+            const float* Source = SharedBus ? SharedBus : ChannelBus;
+            for (int32 i = 0; i < NumFrames; ++i) { Out[i * NumChannels] = Source[i]; }
+        }
+        else
+        {
+            for (int32 i = 0; i < NumFrames; ++i) { Out[i * NumChannels] = 0.0f; }
+        }
+    }
+
+    FramePosition += NumFrames;
+}
+
+void FIARSignalGeneratorBank::RenderSine(const FVoice& Voice, float* Bus, int32 NumFrames) const
+{
+    using namespace IARSignalGeneratorPrivate;
+
+    const VectorRegister4Float Amplitude = VectorSetFloat1(Voice.Amplitude);
+    const double StepRadians = (double)(uint64)(Voice.PhaseIncrement * 4) * PhaseToRadians;
+    const VectorRegister4Float StepCos = VectorSetFloat1((float)FMath::Cos(StepRadians));
+    const VectorRegister4Float StepSin = VectorSetFloat1((float)FMath::Sin(StepRadians));
+
+    for (int32 Start = 0; Start < NumFrames; Start += ReseedIntervalFrames)
+    {
+        const int32 Count = FMath::Min(ReseedIntervalFrames, NumFrames - Start);
+
+        // Ressincroniza as 4 lanes com a fase exata (posição x incremento, módulo 2^64)
+        const uint64 StartPhase = (uint64)(FramePosition + Start) * Voice.PhaseIncrement;
+        alignas(16) float LaneCos[4];
+        alignas(16) float LaneSin[4];
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            const double Radians = (double)(StartPhase + Voice.PhaseIncrement * Lane) * PhaseToRadians;
+            LaneCos[Lane] = (float)FMath::Cos(Radians);
+            LaneSin[Lane] = (float)FMath::Sin(Radians);
+        }
+        VectorRegister4Float Cos = VectorLoadAligned(LaneCos);
+        VectorRegister4Float Sin = VectorLoadAligned(LaneSin);
+
+        // Cada passo gira as 4 lanes em 4 frames: (cos, sin) x (StepCos, StepSin)
+        float* Dest = Bus + Start;
+        for (int32 i = 0; i < Count; i += 4)
+        {
+            VectorStoreAligned(VectorMultiplyAdd(Sin, Amplitude, VectorLoadAligned(Dest + i)), Dest + i);
+            const VectorRegister4Float NextCos = VectorNegateMultiplyAdd(Sin, StepSin, VectorMultiply(Cos, StepCos));
+            Sin = VectorMultiplyAdd(Cos, StepSin, VectorMultiply(Sin, StepCos));
+            Cos = NextCos;
+        }
+    }
+}
+
+void FIARSignalGeneratorBank::RenderSweep(FVoice& Voice, float* Bus, int32 NumFrames, int32 PaddedFrames) const
+{
+    using namespace IARSignalGeneratorPrivate;
+
+    const VectorRegister4Float Amplitude = VectorSetFloat1(Voice.Amplitude);
+    uint64 Phase = Voice.Phase;
+    int64 Position = Voice.SweepPosition;
+    alignas(16) float Radians[4];
+
+    for (int32 i = 0; i < PaddedFrames; i += 4)
+    {
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            if (i + Lane == NumFrames)
+            {
+                // Fim do bloco pedido: os frames de preenchimento não avançam o estado
+                Voice.Phase = Phase;
+                Voice.SweepPosition = Position;
+            }
+            Radians[Lane] = PhaseToRadiansFast(Phase);
+            Phase += Voice.PhaseIncrement + (uint64)(Position * Voice.PhaseIncrementDelta);
+            Position = (Position + 1 < Voice.SweepLengthFrames) ? Position + 1 : 0;
+        }
+        VectorStoreAligned(VectorMultiplyAdd(VectorSin(VectorLoadAligned(Radians)), Amplitude, VectorLoadAligned(Bus + i)), Bus + i);
+    }
+
+    if (NumFrames == PaddedFrames)
+    {
+        Voice.Phase = Phase;
+        Voice.SweepPosition = Position;
+    }
+}
+
+void FIARSignalGeneratorBank::RenderNoise(FVoice& Voice, float* Bus, int32 NumFrames) const
+{
+    const float Scale = Voice.Amplitude * (2.0f / 16777216.0f);
+    uint32 State = Voice.NoiseState;
+    for (int32 i = 0; i < NumFrames; ++i)
+    {
+        State ^= State << 13;
+        State ^= State >> 17;
+        State ^= State << 5;
+        Bus[i] += (float)(State >> 8) * Scale - Voice.Amplitude;
+    }
+    Voice.NoiseState = State;
+}
@@ -7,6 +7,13 @@
 // -------------------------------------------------------------------------------
 #include "FFmpegLogReader.h"
 #include "../IAR.h"
+#include "Core/IARIOReactor.h"
+
+#if PLATFORM_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
 
 FFMpegLogReader::FFMpegLogReader(void* InReadPipe, const FString& InDisplayName, TArray<uint8>* InOutCapturedData)
     : ReadPipe(InReadPipe)
@@ -14,12 +21,15 @@ FFMpegLogReader::FFMpegLogReader(void* InReadPipe, const FString& InDisplayName,
     , WorkerThread(nullptr)
     , bShouldStop(false)
     , OutCapturedData(InOutCapturedData)
+    , ReactorRegistrationId(0)
+    , ReadDescriptor(-1)
+    , bReachedEndOfStream(false)
 {
 }
 
 FFMpegLogReader::~FFMpegLogReader()
 {
-    EnsureCompletion(); // Garante que a thread terminou antes de destruir o objeto
+    EnsureCompletion(); // Garante que a leitura terminou antes de destruir o objeto
 }
 
 bool FFMpegLogReader::Init()
@@ -43,25 +53,32 @@ uint32 FFMpegLogReader::Run()
 
         if (BytesRead > 0)
         {
-            FString LogOutput = FString(BytesRead, (ANSICHAR*)Buffer.GetData());
-            UE_LOG(LogIAR, Log, TEXT(" %s  %s"), *DisplayName, *LogOutput.TrimEnd());
-
-            if (OutCapturedData)
-            {
-                OutCapturedData->Append(Buffer.GetData(), BytesRead);
-            }
+            ConsumeOutput(Buffer.GetData(), BytesRead);
         }
         else // BytesRead é 0
         {
             if (!bReadSuccess) // O pipe foi fechado ou um erro ocorreu
             {
                 UE_LOG(LogIAR, Log, TEXT("FFMpegLogReader: Pipe %s closed. Exiting thread."), *DisplayName);
+                bReachedEndOfStream.AtomicSet(true);
                 break; // Sai do loop, o pipe está fechado
             }
             // Se bReadSuccess é true mas BytesRead é 0, o pipe está aberto mas vazio.
             FPlatformProcess::Sleep(0.01f); // Pequena pausa para evitar busy-waiting
         }
     }
+
+    // Parada solicitada: o que o processo já escreveu no pipe ainda é entregue
+    while (!bReachedEndOfStream)
+    {
+        Buffer.Reset();
+        if (!FPlatformProcess::ReadPipeToArray(ReadPipe, Buffer) || Buffer.Num() == 0)
+        {
+            break;
+        }
+        ConsumeOutput(Buffer.GetData(), Buffer.Num());
+    }
+    FlushPendingLine();
     return 0;
 }
 
@@ -77,6 +94,32 @@ void FFMpegLogReader::Exit()
 
 void FFMpegLogReader::Start()
 {
+    if (WorkerThread || ReactorRegistrationId != 0)
+    {
+        return;
+    }
+
+#if PLATFORM_LINUX
+    // Sem thread própria: o reator avisa quando há dados e a leitura roda no pool de background
+    if (FIARIOReactor* Reactor = FIARIOReactor::Get())
+    {
+        ReadDescriptor = ReadPipe ? static_cast<FPipeHandle*>(ReadPipe)->GetHandle() : -1;
+        const int Flags = (ReadDescriptor != -1) ? fcntl(ReadDescriptor, F_GETFL, 0) : -1;
+        if (Flags != -1 && fcntl(ReadDescriptor, F_SETFL, Flags | O_NONBLOCK) != -1)
+        {
+            ReadBuffer.SetNumUninitialized(ReadChunkSize);
+            ReactorRegistrationId = Reactor->Register(ReadDescriptor, [this](uint32 ReadyEvents) { OnPipeReadable(); });
+            if (ReactorRegistrationId != 0 && Reactor->Arm(ReactorRegistrationId, FIARIOReactor::Readable))
+            {
+                return;
+            }
+            Reactor->Unregister(ReactorRegistrationId);
+            ReactorRegistrationId = 0;
+        }
+        UE_LOG(LogIAR, Warning, TEXT("FFMpegLogReader: Falha ao registrar o pipe %s no reator. Usando uma thread de leitura."), *DisplayName);
+    }
+#endif
+
     if (!WorkerThread)
     {
         WorkerThread = FRunnableThread::Create(this, *FString::Printf(TEXT("FFmpegLogReaderThread_%s"), *DisplayName), 0, TPri_BelowNormal);
@@ -86,6 +129,20 @@ void FFMpegLogReader::Start()
 void FFMpegLogReader::EnsureCompletion()
 {
     Stop(); // Sinaliza para parar
+    if (ReactorRegistrationId != 0)
+    {
+        // Depois do Unregister nenhum callback roda: o restante do pipe é lido aqui mesmo
+        if (FIARIOReactor* Reactor = FIARIOReactor::Get())
+        {
+            Reactor->Unregister(ReactorRegistrationId);
+        }
+        ReactorRegistrationId = 0;
+        if (!bReachedEndOfStream)
+        {
+            ReadAvailable(INDEX_NONE);
+        }
+        FlushPendingLine();
+    }
     if (WorkerThread)
     {
         WorkerThread->WaitForCompletion(); // Espera a thread terminar
@@ -93,3 +150,80 @@ void FFMpegLogReader::EnsureCompletion()
         WorkerThread = nullptr;
     }
 }
+
+bool FFMpegLogReader::ReadAvailable(int32 MaxReads)
+{
+#if PLATFORM_LINUX
+    for (int32 NumReads = 0; MaxReads == INDEX_NONE || NumReads < MaxReads; )
+    {
+        const ssize_t BytesRead = read(ReadDescriptor, ReadBuffer.GetData(), ReadBuffer.Num());
+        if (BytesRead > 0)
+        {
+            ConsumeOutput(ReadBuffer.GetData(), (int32)BytesRead);
+            ++NumReads;
+            continue;
+        }
+        if (BytesRead == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        // 0 é EOF (o processo fechou o pipe); EAGAIN significa que não há mais nada por enquanto
+        return BytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FFMpegLogReader::OnPipeReadable()
+{
+    if (!ReadAvailable(MaxReadsPerEvent))
+    {
+        // EOF: o registro fica desarmado até o EnsureCompletion removê-lo
+        bReachedEndOfStream.AtomicSet(true);
+        UE_LOG(LogIAR, Log, TEXT("FFMpegLogReader: Pipe %s closed."), *DisplayName);
+        return;
+    }
+    // Se o Arm falhar (registro já removido pelo EnsureCompletion), o restante é lido lá
+    if (FIARIOReactor* Reactor = FIARIOReactor::Get())
+    {
+        Reactor->Arm(ReactorRegistrationId, FIARIOReactor::Readable);
+    }
+}
+
+void FFMpegLogReader::ConsumeOutput(const uint8* Data, int32 NumBytes)
+{
+    if (OutCapturedData)
+    {
+        // Saída capturada pode ser binária (o PCM de um decode): apenas acumula, sem converter nem logar
+        OutCapturedData->Append(Data, NumBytes);
+        return;
+    }
+
+    // Loga linha a linha (o FFmpeg termina as linhas de progresso com '\r'), sem partir uma linha entre duas leituras
+    for (int32 Index = 0; Index < NumBytes; ++Index)
+    {
+        const uint8 Byte = Data[Index];
+        if (Byte == '\n' || Byte == '\r')
+        {
+            FlushPendingLine();
+        }
+        else
+        {
+            PendingLine.Add(Byte);
+        }
+    }
+}
+
+void FFMpegLogReader::FlushPendingLine()
+{
+    if (PendingLine.Num() == 0)
+    {
+        return;
+    }
+    const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(PendingLine.GetData()), PendingLine.Num());
+    const FString Line(Converted.Length(), Converted.Get());
+    UE_LOG(LogIAR, Log, TEXT(" %s  %s"), *DisplayName, *Line);
+    PendingLine.Reset();
+}
@@ -7,6 +7,8 @@
 // -------------------------------------------------------------------------------
 #include "IAR.h"
 #include "Core/IARMIDITable.h" // Inclui a tabela MIDI para inicialização
+#include "Core/IARIOReactor.h" // Reator de I/O compartilhado pelos encoders
+#include "Core/IARClockedProducer.h" // Thread produtora das fontes sem dispositivo
 
 // Define a categoria de log para ser usada nas implementações
 DEFINE_LOG_CATEGORY(LogIAR);
@@ -29,6 +31,10 @@ void IARModule::ShutdownModule()
 {
     // Esta função pode ser chamada durante o desligamento para limpar o módulo.
     // Para módulos que suportam recarregamento dinâmico, chamamos esta função antes de descarregar o módulo.
+    // Encerra a thread do reator de I/O (iniciada sob demanda pelo primeiro encoder)
+    FIARIOReactor::Shutdown();
+    // Encerra a thread produtora das fontes de arquivo/simuladas (iniciada sob demanda)
+    FIARClockedProducer::Shutdown();
     UE_LOG(LogIAR, Log, TEXT("Módulo IAR Desligado"));
 }
 
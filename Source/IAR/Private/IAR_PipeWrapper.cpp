@@ -10,6 +10,8 @@
 #include "GlobalStatics.h" // Para tratamento de erros (e.g., GetLastSystemErrorDetails)
 #include "Misc/Guid.h"     // Para geração de IDs únicos
 #include "Misc/FileHelper.h" // Para FFileHelper::DeleteFile (usado para limpeza de FIFO POSIX)
+#include "HAL/PlatformProcess.h" // Para FPlatformProcess::Sleep (espera em pipes Windows não-bloqueantes)
+#include "HAL/PlatformTime.h"    // Para o timeout de Connect() em POSIX
 
 // Definição da Categoria de Log
 DEFINE_LOG_CATEGORY(LogIARPipeWrapper);
@@ -37,7 +39,7 @@ IAR_PipeWrapper::~IAR_PipeWrapper()
 // Criar Pipe
 bool IAR_PipeWrapper::Create(const FIAR_PipeSettings& Settings, const FString& SessionID)
 {
-    if (IsValid())
+    if (IsValid() || !FullPipePath.IsEmpty())
     {
         UE_LOG(LogIARPipeWrapper, Warning, TEXT("Pipe '%s' já criado. Fechando e recriando."), *FullPipePath);
         Close();
@@ -128,23 +130,23 @@ bool IAR_PipeWrapper::Create(const FIAR_PipeSettings& Settings, const FString& S
             return false;
         }
     }
-    
-    // Abre o FIFO para escrita. O_WRONLY para escrita (UE escreve), O_NONBLOCK para não bloquear no open.
-    // Se bBlockingMode for true, o O_NONBLOCK será removido, o que fará open() bloquear até um leitor se conectar.
-    int OpenFlags = O_WRONLY; // Padrão para saída (UE escreve)
-    if (Settings.bDuplexAccess)
+
+    // Em modo bloqueante o open() só retornaria quando o leitor abrisse o FIFO, e o FFmpeg ainda não foi lançado
+    // neste ponto: a abertura fica para Connect(), chamado depois do lançamento (como o ConnectNamedPipe no Windows).
+    if (Settings.bBlockingMode)
     {
-        OpenFlags = O_RDWR; // Para acesso duplex (leitura e escrita)
+        UE_LOG(LogIARPipeWrapper, Log, TEXT("FIFO '%s' criado. A abertura para escrita acontece em Connect()."), *FullPipePath);
+        return true;
     }
 
-    if (!Settings.bBlockingMode)
+    // Abre o FIFO para escrita. O_WRONLY para escrita (UE escreve), O_NONBLOCK para não bloquear no open.
+    int OpenFlags = O_WRONLY | O_NONBLOCK; // Padrão para saída (UE escreve)
+    if (Settings.bDuplexAccess)
     {
-        OpenFlags |= O_NONBLOCK; // Opera em modo não-bloqueante
+        OpenFlags = O_RDWR | O_NONBLOCK; // Para acesso duplex (leitura e escrita)
     }
 
-    // Abre o FIFO. Isso pode bloquear se bBlockingMode for true e não houver leitor ainda.
-    // O ideal é que o Connect() seja chamado logo após o lançamento do processo FFmpeg.
-    UE_LOG(LogIARPipeWrapper, Log, TEXT("Abrindo FIFO '%s' para escrita... (pode bloquear se não houver leitor e em modo bloqueante)"), *FullPipePath);
+    UE_LOG(LogIARPipeWrapper, Log, TEXT("Abrindo FIFO '%s' para escrita..."), *FullPipePath);
     FileDescriptor = open(TCHAR_TO_UTF8(*FullPipePath), OpenFlags);
 
     if (FileDescriptor == -1)
@@ -164,8 +166,8 @@ bool IAR_PipeWrapper::Create(const FIAR_PipeSettings& Settings, const FString& S
     return bIsCreatedAndConnected;
 }
 
-// NOVO MÉTODO DE CONEXÃO (Específico para Windows, FIFOs POSIX gerenciam a conexão via open)
-bool IAR_PipeWrapper::Connect()
+// NOVO MÉTODO DE CONEXÃO (ConnectNamedPipe no Windows, open() adiado do FIFO em POSIX)
+bool IAR_PipeWrapper::Connect(const FThreadSafeBool* bAbortRequested)
 {
 #if PLATFORM_WINDOWS
     if (!IsValid())
@@ -195,10 +197,67 @@ bool IAR_PipeWrapper::Connect()
 
     UE_LOG(LogIARPipeWrapper, Log, TEXT("Named Pipe '%s' conectado com sucesso."), *FullPipePath);
     return true;
-#else // Para POSIX, a conexão é implicitamente gerenciada pelo 'open' em 'Create'.
-    UE_LOG(LogIARPipeWrapper, Log, TEXT("Connect() não é explicitamente necessário para plataformas não-Windows (FIFOs POSIX conectam via open())."));
-    // Se chegamos aqui, implica que o pipe já foi aberto com sucesso em Create().
-    return true;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    if (!IsValid() && !FullPipePath.IsEmpty())
+    {
+        UE_LOG(LogIARPipeWrapper, Log, TEXT("Aguardando o leitor abrir o FIFO: %s"), *FullPipePath);
+    }
+
+    // Tenta de novo até o FFmpeg abrir o FIFO. Diferente do open() bloqueante, a espera tem limite e pode ser cancelada.
+    const double Deadline = FPlatformTime::Seconds() + ConnectTimeoutSeconds;
+    for (;;)
+    {
+        const EIAR_PipeConnectResult Result = TryConnect();
+        if (Result != EIAR_PipeConnectResult::Pending)
+        {
+            return Result == EIAR_PipeConnectResult::Connected;
+        }
+        if ((bAbortRequested && *bAbortRequested) || FPlatformTime::Seconds() > Deadline)
+        {
+            UE_LOG(LogIARPipeWrapper, Error, TEXT("Nenhum leitor abriu o FIFO '%s' (cancelado ou timeout de %.0f s)."), *FullPipePath, ConnectTimeoutSeconds);
+            return false;
+        }
+        FPlatformProcess::Sleep(0.005f);
+    }
+#else // Outras plataformas
+    return false;
+#endif
+}
+
+EIAR_PipeConnectResult IAR_PipeWrapper::TryConnect()
+{
+#if PLATFORM_WINDOWS
+    return Connect() ? EIAR_PipeConnectResult::Connected : EIAR_PipeConnectResult::Failed;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    if (IsValid())
+    {
+        return EIAR_PipeConnectResult::Connected; // Aberto em Create() (modo não-bloqueante) ou em uma chamada anterior
+    }
+    if (FullPipePath.IsEmpty())
+    {
+        UE_LOG(LogIARPipeWrapper, Error, TEXT("Não é possível conectar. O FIFO não foi criado."));
+        return EIAR_PipeConnectResult::Failed;
+    }
+
+    // Com O_NONBLOCK o open() de escrita falha com ENXIO enquanto não há leitor
+    const int OpenFlags = (PipeSettings.bDuplexAccess ? O_RDWR : O_WRONLY) | O_NONBLOCK;
+    FileDescriptor = open(TCHAR_TO_UTF8(*FullPipePath), OpenFlags);
+    if (FileDescriptor == -1)
+    {
+        if (errno == ENXIO || errno == EINTR)
+        {
+            return EIAR_PipeConnectResult::Pending;
+        }
+        UE_LOG(LogIARPipeWrapper, Error, TEXT("Falha ao abrir FIFO '%s' para escrita. Erro: %s"), *FullPipePath, UTF8_TO_TCHAR(strerror(errno)));
+        return EIAR_PipeConnectResult::Failed;
+    }
+    bIsCreatedAndConnected = true;
+    SetNonBlocking(false); // Modo bloqueante pedido em Create(); o chamador pode trocar com SetNonBlocking(true)
+
+    UE_LOG(LogIARPipeWrapper, Log, TEXT("FIFO '%s' aberto com sucesso para escrita."), *FullPipePath);
+    return EIAR_PipeConnectResult::Connected;
+#else // Outras plataformas
+    return EIAR_PipeConnectResult::Failed;
 #endif
 }
 
@@ -257,10 +316,141 @@ int32 IAR_PipeWrapper::Write(const uint8* Data, int32 NumBytes)
 #endif
 }
 
+// Escrever vários trechos no Pipe
+int64 IAR_PipeWrapper::WriteGather(const FIAR_PipeWriteSegment* Segments, int32 NumSegments)
+{
+    if (!IsValid())
+    {
+        UE_LOG(LogIARPipeWrapper, Error, TEXT("Tentativa de escrever em um pipe inválido ou não inicializado. (%s)"), *FullPipePath);
+        return -1; // Indica erro
+    }
+    if (!Segments || NumSegments <= 0)
+    {
+        return 0;
+    }
+
+#if PLATFORM_WINDOWS
+    // Named Pipes não têm escrita vetorial: escreve em sequência e para na primeira escrita incompleta
+    int64 TotalWritten = 0;
+    for (int32 Index = 0; Index < NumSegments; ++Index)
+    {
+        const FIAR_PipeWriteSegment& Segment = Segments[Index];
+        DWORD BytesWritten = 0;
+        if (!WriteFile(PipeHandle, Segment.Data, (DWORD)Segment.NumBytes, &BytesWritten, NULL))
+        {
+            const DWORD ErrorCode = GetLastError();
+            if (ErrorCode == ERROR_NO_DATA || ErrorCode == ERROR_PIPE_BUSY)
+            {
+                return TotalWritten; // Pipe cheio: o chamador reenvia o restante
+            }
+            if (TotalWritten > 0)
+            {
+                return TotalWritten; // Reporta o que foi escrito; o erro reaparece na próxima chamada
+            }
+            FIAR_SystemErrorDetails Det = UIARGlobalStatics::GetLastSystemErrorDetails();
+            UE_LOG(LogIARPipeWrapper, Error, TEXT("Falha ao escrever no Named Pipe Windows '%s'. Erro: %d Descrição: %s"), *FullPipePath, Det.ErrorCode, *Det.ErrorDescription);
+            return -1;
+        }
+        TotalWritten += BytesWritten;
+        if ((int32)BytesWritten < Segment.NumBytes)
+        {
+            break;
+        }
+    }
+    return TotalWritten;
+
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    iovec IoVectors[IOV_MAX < 64 ? IOV_MAX : 64];
+    const int32 NumVectors = FMath::Min(NumSegments, (int32)UE_ARRAY_COUNT(IoVectors));
+    for (int32 Index = 0; Index < NumVectors; ++Index)
+    {
+        IoVectors[Index].iov_base = const_cast<uint8*>(Segments[Index].Data);
+        IoVectors[Index].iov_len = (size_t)Segments[Index].NumBytes;
+    }
+
+    ssize_t BytesWritten;
+    do
+    {
+        BytesWritten = writev(FileDescriptor, IoVectors, NumVectors);
+    } while (BytesWritten == -1 && errno == EINTR);
+
+    if (BytesWritten == -1)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return 0; // Pipe cheio: nada foi escrito
+        }
+        UE_LOG(LogIARPipeWrapper, Error, TEXT("Falha ao escrever no FIFO '%s'. Erro: %s"), *FullPipePath, UTF8_TO_TCHAR(strerror(errno)));
+        return -1;
+    }
+    return (int64)BytesWritten;
+
+#else // Outras plataformas
+    UE_LOG(LogIARPipeWrapper, Error, TEXT("IAR_PipeWrapper::WriteGather não implementado para esta plataforma."));
+    return -1;
+#endif
+}
+
+bool IAR_PipeWrapper::WaitForWritable(int32 TimeoutMs)
+{
+    if (!IsValid())
+    {
+        return true; // A próxima escrita reporta o erro
+    }
+
+#if PLATFORM_WINDOWS
+    if (!PipeSettings.bBlockingMode)
+    {
+        FPlatformProcess::Sleep(FMath::Min(TimeoutMs, 1) / 1000.0f);
+    }
+    return true;
+
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    pollfd PollDescriptor;
+    PollDescriptor.fd = FileDescriptor;
+    PollDescriptor.events = POLLOUT;
+    PollDescriptor.revents = 0;
+
+    int Result;
+    do
+    {
+        Result = poll(&PollDescriptor, 1, TimeoutMs);
+    } while (Result == -1 && errno == EINTR);
+
+    // POLLERR/POLLHUP também retornam > 0: a próxima escrita reporta o erro
+    return Result != 0;
+
+#else // Outras plataformas
+    return true;
+#endif
+}
+
+bool IAR_PipeWrapper::SetNonBlocking(bool bNonBlocking)
+{
+    if (!IsValid())
+    {
+        return false;
+    }
+
+#if PLATFORM_LINUX || PLATFORM_MAC
+    const int Flags = fcntl(FileDescriptor, F_GETFL, 0);
+    if (Flags == -1 || fcntl(FileDescriptor, F_SETFL, bNonBlocking ? (Flags | O_NONBLOCK) : (Flags & ~O_NONBLOCK)) == -1)
+    {
+        UE_LOG(LogIARPipeWrapper, Warning, TEXT("Falha ao alterar o modo não-bloqueante do FIFO '%s'. Erro: %s"), *FullPipePath, UTF8_TO_TCHAR(strerror(errno)));
+        return false;
+    }
+    return true;
+#else
+    // Windows: sem espera por prontidão em Named Pipes, então o modo escolhido em Create() é mantido
+    return false;
+#endif
+}
+
 // Fechar Pipe
 void IAR_PipeWrapper::Close()
 {
-    if (!IsValid())
+    // Um FIFO criado e ainda não aberto (Connect() não chamado) também precisa ser removido do disco
+    if (!IsValid() && FullPipePath.IsEmpty())
     {
         return; // Já fechado ou nunca foi válido
     }
@@ -309,4 +499,15 @@ FString IAR_PipeWrapper::GetFullPipeName() const
 {
     return FullPipePath;
 }
+
+IAR_NativePipeHandle IAR_PipeWrapper::GetNativeHandle() const
+{
+#if PLATFORM_WINDOWS
+    return IsValid() ? (IAR_NativePipeHandle)PipeHandle : IAR_INVALID_NATIVE_PIPE_HANDLE;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    return IsValid() ? FileDescriptor : IAR_INVALID_NATIVE_PIPE_HANDLE;
+#else
+    return IAR_INVALID_NATIVE_PIPE_HANDLE;
+#endif
+}
 // --- FIM DO ARQUIVO: D:\william\UnrealProjects\IACSWorld\Plugins\IAR\Source\IAR\Private\IAR_PipeWrapper.cpp ---
@@ -0,0 +1,302 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Recording/IARAudioAggregateSource.h"
+#include "../IAR.h"
+#include "AudioCapture.h"       
+#include "AudioCaptureDeviceInterface.h" 
+#include "HAL/PlatformTime.h"
+
+namespace IARAggregateSourcePrivate
+{
+    /** Intervalo entre os registros da deriva estimada no log. */
+    constexpr double DriftLogIntervalSeconds = 60.0;
+}
+
+UIARAudioAggregateSource::UIARAudioAggregateSource()
+    : UIARAudioSource() 
+{
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioAggregateSource: Construtor chamado."));
+}
+
+UIARAudioAggregateSource::~UIARAudioAggregateSource()
+{
+    Shutdown(); 
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioAggregateSource: Destrutor chamado."));
+}
+
+void UIARAudioAggregateSource::Initialize(FIAR_AudioStreamSettings& StreamSettings, UIARFramePool* InFramePool)
+{
+    Super::Initialize(StreamSettings, InFramePool); 
+    CloseDevices();
+
+    if (!FramePool || !IsValid(FramePool))
+    {
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioAggregateSource: FramePool inválido. Não é possível inicializar a fonte."));
+        return;
+    }
+
+    const TArray<FIAR_AggregateInputDevice>& DeviceSettings = StreamSettings.AggregateInputDevices;
+    int32 TotalChannels = 0;
+    for (const FIAR_AggregateInputDevice& Device : DeviceSettings)
+    {
+        TotalChannels += FMath::Max(1, Device.NumChannels);
+    }
+    if (DeviceSettings.Num() == 0 || TotalChannels != StreamSettings.NumChannels)
+    {
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioAggregateSource: Configuração inválida: %d dispositivos com %d canais no total (NumChannels: %d)."),
+            DeviceSettings.Num(), TotalChannels, StreamSettings.NumChannels);
+        return;
+    }
+
+    // Mesma regra da UIARAudioMixerSource: sobreposição só na análise em tempo real
+    const float Overlap = StreamSettings.bEnableRTFeatures ? StreamSettings.AnalysisWindowOverlap : 0.0f;
+    if (!Reblocker.ConfigureWithOverlap(FMath::Max(64, StreamSettings.AnalysisWindowFrames), Overlap))
+    {
+        return;
+    }
+    const uint32 DesiredFramesPerBuffer = Reblocker.GetHopFrames();
+
+    int32 ChannelOffset = 0;
+    for (int32 Slot = 0; Slot < DeviceSettings.Num(); ++Slot)
+    {
+        TUniquePtr<FDeviceStream> Device = MakeUnique<FDeviceStream>();
+        Device->Capture = MakeUnique<Audio::FAudioCapture>();
+        Device->DeviceIndex = DeviceSettings[Slot].DeviceIndex;
+        Device->NumChannels = FMath::Max(1, DeviceSettings[Slot].NumChannels);
+        Device->ChannelOffset = ChannelOffset;
+        ChannelOffset += Device->NumChannels;
+
+        Audio::FAudioCaptureDeviceParams Params;
+        Params.DeviceIndex = Device->DeviceIndex;
+        Params.NumInputChannels = Device->NumChannels;
+        Params.SampleRate = StreamSettings.SampleRate;
+
+        Audio::FOnAudioCaptureFunction OnAudioCaptureCallback;
+        if (Slot == 0)
+        {
+            OnAudioCaptureCallback = [this](const void* InAudio, int32 NumFrames, int32 NumChannels, int32 SampleRate, double StreamTime, bool bOverFlow)
+            {
+                OnMasterAudioCapture(InAudio, NumFrames, NumChannels, SampleRate, bOverFlow);
+            };
+        }
+        else
+        {
+            Device->Compensator = MakeUnique<FIARDriftCompensator>();
+            FIARDriftCompensator* Compensator = Device->Compensator.Get();
+            OnAudioCaptureCallback = [Compensator](const void* InAudio, int32 NumFrames, int32 NumChannels, int32 SampleRate, double StreamTime, bool bOverFlow)
+            {
+                Compensator->Push(static_cast<const float*>(InAudio), NumFrames, NumChannels, FPlatformTime::Seconds());
+            };
+        }
+
+        if (!Device->Capture->OpenAudioCaptureStream(Params, MoveTemp(OnAudioCaptureCallback), DesiredFramesPerBuffer))
+        {
+            UE_LOG(LogIAR, Error, TEXT("UIARAudioAggregateSource: Falha ao abrir o dispositivo %d (posição %d, SR: %d, Ch: %d)."),
+                Device->DeviceIndex, Slot, Params.SampleRate, Params.NumInputChannels);
+            Devices.Add(MoveTemp(Device)); // Fechado junto com os demais
+            CloseDevices();
+            return;
+        }
+        Devices.Add(MoveTemp(Device));
+    }
+
+    // Os secundários são convertidos para o relógio (e a taxa) do mestre
+    const int32 MasterSampleRate = Devices[0]->Capture->GetSampleRate();
+    for (int32 Slot = 1; Slot < Devices.Num(); ++Slot)
+    {
+        FDeviceStream& Device = *Devices[Slot];
+        const int32 DeviceSampleRate = Device.Capture->GetSampleRate();
+        const int32 TargetLatencyFrames = FMath::Max(1, (int32)((int64)DeviceSampleRate * FMath::Max(5, StreamSettings.AggregateTargetLatencyMs) / 1000));
+        // Os dois lados pedem DesiredFramesPerBuffer por callback; o compensador eleva o alvo para cobrir esses blocos
+        if (!Device.Compensator->Initialize(Device.NumChannels, DeviceSampleRate, MasterSampleRate, TargetLatencyFrames, (int32)DesiredFramesPerBuffer, (int32)DesiredFramesPerBuffer))
+        {
+            CloseDevices();
+            return;
+        }
+        UE_LOG(LogIAR, Log, TEXT("UIARAudioAggregateSource: Dispositivo %d aberto como secundário (SR: %d -> %d, canais %d-%d, latência alvo %d frames)."),
+            Device.DeviceIndex, DeviceSampleRate, MasterSampleRate, Device.ChannelOffset, Device.ChannelOffset + Device.NumChannels - 1,
+            Device.Compensator->GetTargetLatencyFrames());
+    }
+
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioAggregateSource: %d dispositivos abertos. Mestre: %d (SR: %d), %d canais no total."),
+        Devices.Num(), Devices[0]->DeviceIndex, MasterSampleRate, TotalChannels);
+}
+
+void UIARAudioAggregateSource::StartCapture()
+{
+    if (bIsCapturing) 
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioAggregateSource: Captura já está ativa."));
+        return;
+    }
+    if (Devices.Num() == 0)
+    {
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioAggregateSource: Nenhum dispositivo aberto. Não é possível iniciar a captura."));
+        return;
+    }
+
+    // A contagem de frames recomeça a cada captura; o formato real é conhecido no primeiro callback do mestre
+    Reblocker.Reset(0, 0);
+    FramesSinceDriftLog = 0;
+
+    for (int32 Slot = Devices.Num() - 1; Slot >= 0; --Slot)
+    {
+        FDeviceStream& Device = *Devices[Slot];
+        if (Device.Compensator)
+        {
+            Device.Compensator->Reset();
+        }
+        if (!Device.Capture->StartStream())
+        {
+            UE_LOG(LogIAR, Error, TEXT("UIARAudioAggregateSource: Falha ao iniciar o dispositivo %d."), Device.DeviceIndex);
+            for (int32 StartedSlot = Slot + 1; StartedSlot < Devices.Num(); ++StartedSlot)
+            {
+                Devices[StartedSlot]->Capture->StopStream();
+            }
+            return;
+        }
+    }
+
+    Super::StartCapture(); 
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioAggregateSource: Captura agregada iniciada."));
+}
+
+void UIARAudioAggregateSource::StopCapture()
+{
+    if (!bIsCapturing) 
+    {
+        return;
+    }
+
+    // O mestre primeiro: nenhum frame combinado é emitido depois daqui
+    for (TUniquePtr<FDeviceStream>& Device : Devices)
+    {
+        Device->Capture->StopStream();
+    }
+
+    // Com o mestre parado o Reblocker não é mais tocado pela thread dele: entrega o fim que não formou uma janela
+    if (FramePool && IsValid(FramePool) && Reblocker.GetPendingFrames() > 0)
+    {
+        const int32 SampleRate = Reblocker.GetSampleRate();
+        const int32 TotalChannels = Reblocker.GetNumChannels();
+        Reblocker.Flush([this, SampleRate, TotalChannels](const float* WindowData, int32 NumFrames, int64 StartFrameIndex, int32 OverlapFrames)
+        {
+            EmitWindow(WindowData, NumFrames, StartFrameIndex, OverlapFrames, SampleRate, TotalChannels);
+        });
+    }
+    Super::StopCapture(); 
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioAggregateSource: Captura agregada parada."));
+}
+
+void UIARAudioAggregateSource::Shutdown()
+{
+    StopCapture();
+    Super::Shutdown(); 
+    CloseDevices();
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioAggregateSource: Desligado e recursos liberados."));
+}
+
+float UIARAudioAggregateSource::GetEstimatedDriftPPM(int32 DeviceSlot) const
+{
+    if (!Devices.IsValidIndex(DeviceSlot) || !Devices[DeviceSlot]->Compensator)
+    {
+        return 0.0f; // O mestre é a referência
+    }
+    return (float)Devices[DeviceSlot]->Compensator->GetEstimatedDriftPPM();
+}
+
+void UIARAudioAggregateSource::CloseDevices()
+{
+    for (TUniquePtr<FDeviceStream>& Device : Devices)
+    {
+        if (Device->Capture.IsValid())
+        {
+            Device->Capture->CloseStream();
+        }
+    }
+    Devices.Reset();
+}
+
+void UIARAudioAggregateSource::OnMasterAudioCapture(const void* InAudio, int32 NumFrames, int32 NumChannels, int32 SampleRate, bool bOverFlow)
+{
+    if (!FramePool || !IsValid(FramePool) || Devices.Num() == 0)
+    {
+        return;
+    }
+    if (bOverFlow)
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioAggregateSource: Overflow no dispositivo mestre. Algumas amostras podem ter sido perdidas."));
+    }
+
+    const double CaptureTimeSeconds = FPlatformTime::Seconds();
+    const int32 TotalChannels = CurrentStreamSettings.NumChannels;
+    if (!Reblocker.MatchesFormat(SampleRate, TotalChannels))
+    {
+        Reblocker.Reset(SampleRate, TotalChannels);
+    }
+
+    // Mestre: canais copiados como chegam (completados com silêncio se o dispositivo abriu com menos canais)
+    CombinedSamples.SetNumUninitialized(NumFrames * TotalChannels, EAllowShrinking::No);
+    const FDeviceStream& Master = *Devices[0];
+    const float* MasterSamples = static_cast<const float*>(InAudio);
+    const int32 CopyChannels = FMath::Min(NumChannels, Master.NumChannels);
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+    {
+        float* Dest = CombinedSamples.GetData() + Frame * TotalChannels;
+        FMemory::Memcpy(Dest, MasterSamples + Frame * NumChannels, CopyChannels * sizeof(float));
+        if (CopyChannels < Master.NumChannels)
+        {
+            FMemory::Memzero(Dest + CopyChannels, (Master.NumChannels - CopyChannels) * sizeof(float));
+        }
+    }
+
+    // Secundários: exatamente NumFrames frames no relógio do mestre
+    for (int32 Slot = 1; Slot < Devices.Num(); ++Slot)
+    {
+        const FDeviceStream& Device = *Devices[Slot];
+        Device.Compensator->Pull(CombinedSamples.GetData(), TotalChannels, Device.ChannelOffset, NumFrames, CaptureTimeSeconds);
+    }
+
+    Reblocker.Push(CombinedSamples.GetData(), NumFrames, [this, SampleRate, TotalChannels](const float* WindowData, int32 WindowFrames, int64 StartFrameIndex, int32 OverlapFrames)
+    {
+        EmitWindow(WindowData, WindowFrames, StartFrameIndex, OverlapFrames, SampleRate, TotalChannels);
+    });
+
+    FramesSinceDriftLog += NumFrames;
+    if (FramesSinceDriftLog >= (int64)(IARAggregateSourcePrivate::DriftLogIntervalSeconds * SampleRate))
+    {
+        FramesSinceDriftLog = 0;
+        for (int32 Slot = 1; Slot < Devices.Num(); ++Slot)
+        {
+            UE_LOG(LogIAR, Log, TEXT("UIARAudioAggregateSource: Dispositivo %d: deriva estimada %.1f ppm, %d underruns."),
+                Devices[Slot]->DeviceIndex, Devices[Slot]->Compensator->GetEstimatedDriftPPM(), Devices[Slot]->Compensator->GetUnderrunCount());
+        }
+    }
+}
+
+void UIARAudioAggregateSource::EmitWindow(const float* WindowData, int32 NumFrames, int64 StartFrameIndex, int32 OverlapFrames, int32 SampleRate, int32 NumChannels)
+{
+    TSharedPtr<FIAR_AudioFrameData> AudioFrame = FramePool->AcquireFrame();
+    if (!AudioFrame.IsValid())
+    {
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioAggregateSource: Falha ao adquirir frame do pool. Janela descartada."));
+        return;
+    }
+
+    const int32 WindowSamples = NumFrames * NumChannels;
+    AudioFrame->RawSamplesPtr->SetNumUninitialized(WindowSamples, EAllowShrinking::No);
+    FMemory::Memcpy(AudioFrame->RawSamplesPtr->GetData(), WindowData, WindowSamples * sizeof(float));
+
+    AudioFrame->SampleRate = SampleRate; 
+    AudioFrame->NumChannels = NumChannels; 
+    AudioFrame->StartFrameIndex = StartFrameIndex;
+    AudioFrame->OverlapFrames = OverlapFrames;
+    AudioFrame->Timestamp = (float)((double)StartFrameIndex / SampleRate); 
+
+    OnAudioFrameAcquired.Broadcast(AudioFrame); 
+}
@@ -7,6 +7,7 @@
 // -------------------------------------------------------------------------------
 #include "Recording/IARAudioCaptureSession.h"
 #include "../IAR.h"
+#include "Recording/IARWavConcatenator.h"
 #include "Misc/Guid.h"
 #include "Misc/DateTime.h"
 #include "Misc/Paths.h"
@@ -16,7 +17,7 @@
 #include "Engine/World.h"
 
 UIARAudioCaptureSession::UIARAudioCaptureSession()
-    : CurrentTakeEncoder(nullptr)
+    : RecordingEncoder(nullptr)
     , bIsOverallRecordingActive(false)
     , AudioSourceRef(nullptr)
     , CurrentTakeNumber(0)
@@ -57,14 +58,12 @@ void UIARAudioCaptureSession::StartOverallRecording(const FIAR_AudioStreamSettin
     CompletedTakeFilePaths.Empty();
     CurrentTakeNumber = RecordingSettings.InitialTakeNumber;
 
-    bIsOverallRecordingActive = true;
-    StartNewTakeInternal();
-
-    if (UWorld* World = GetWorld())
+    if (!StartRecordingEncoderInternal())
     {
-        World->GetTimerManager().SetTimer(TakeRotationTimerHandle, this, &UIARAudioCaptureSession::RotateCurrentTake, RecordingSettings.TakeDurationSeconds, true);
-        UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Timer de rotação de takes iniciado (%.2f segundos)."), RecordingSettings.TakeDurationSeconds);
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioCaptureSession: Falha ao iniciar o encoder da gravação '%s'."), *CurrentOverallSessionName);
+        return;
     }
+    bIsOverallRecordingActive = true;
 
     if (AudioSourceRef && !AudioSourceRef->IsCapturing())
     {
@@ -80,22 +79,26 @@ void UIARAudioCaptureSession::StopOverallRecording()
 {
     if (!bIsOverallRecordingActive) { UE_LOG(LogIAR, Warning, TEXT("UIARAudioCaptureSession: Nenhuma gravação global ativa para parar.")); return; }
 
-    if (UWorld* World = GetWorld())
-    {
-        World->GetTimerManager().ClearTimer(TakeRotationTimerHandle);
-        UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Timer de rotação de takes parado."));
-    }
-
     if (AudioSourceRef && AudioSourceRef->IsCapturing())
     {
         AudioSourceRef->StopCapture(); // Para a captura da fonte
         UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Captura da fonte de áudio parada."));
     }
 
-    StopCurrentTakeInternal();
     bIsOverallRecordingActive = false;
 
-    FString MasterFilePath = GenerateOutputFilePath(RecordingSettings.MasterRecordingPrefix, CurrentOverallSessionName, -1);
+    // O encoder termina de escrever em background; a montagem do Master começa quando ele avisar
+    const FString MasterFilePath = GenerateOutputFilePath(RecordingSettings.MasterRecordingPrefix, CurrentOverallSessionName, -1);
+    if (!StopRecordingEncoderInternal(MasterFilePath))
+    {
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioCaptureSession: Falha ao finalizar o encoder da gravação '%s'."), *CurrentOverallSessionName);
+        OnFileRecordingStopped.Broadcast(TEXT("")); // Indica falha
+    }
+}
+
+void UIARAudioCaptureSession::StartMasterAssembly(const FString& MasterFilePath, const TArray<FString>& TakeFilePaths)
+{
+    CompletedTakeFilePaths = TakeFilePaths;
     UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Iniciando concatenação para o arquivo master: %s"), *MasterFilePath);
     
     OnFileMasterRecordingStarted.Broadcast(MasterFilePath); // Broadcast com o delegate renomeado
@@ -125,11 +128,21 @@ bool UIARAudioCaptureSession::IsAnyRecordingActive() const
     return bIsOverallRecordingActive;
 }
 
+bool UIARAudioCaptureSession::HasEncoderCapacity() const
+{
+    if (!RecordingEncoder)
+    {
+        return true;
+    }
+    const FIAR_EncoderQueueStats Stats = RecordingEncoder->GetQueueStats();
+    return Stats.MemoryQueuedBytes + Stats.SpillPendingBytes < MaxOfflineEncoderBacklogBytes;
+}
+
 void UIARAudioCaptureSession::OnAudioFrameReceived(TSharedPtr<FIAR_AudioFrameData> AudioFrame)
 {
-    if (CurrentTakeEncoder && CurrentTakeEncoder->IsEncodingActive())
+    if (RecordingEncoder && RecordingEncoder->IsEncodingActive())
     {
-        CurrentTakeEncoder->EncodeFrame(AudioFrame);
+        RecordingEncoder->EncodeFrame(AudioFrame);
     }
 }
 
@@ -140,97 +153,182 @@ void UIARAudioCaptureSession::ShutdownSession()
         StopOverallRecording();
     }
     
-    if (CurrentTakeEncoder)
+    if (RecordingEncoder)
     {
-        CurrentTakeEncoder->ShutdownEncoder();
-        CurrentTakeEncoder = nullptr;
+        ReleaseEncoder(RecordingEncoder);
+        RecordingEncoder = nullptr;
+    }
+
+    // Gravações ainda finalizando: aguarda os arquivos fecharem (ShutdownEncoder bloqueia), mas o Master não é montado
+    for (UIARAudioEncoder* Encoder : FinalizingEncoders)
+    {
+        if (Encoder)
+        {
+            UE_LOG(LogIAR, Warning, TEXT("UIARAudioCaptureSession: Sessão desligada durante a finalização. Takes mantidos sem Master: '%s'."), *Encoder->GetCurrentOutputFilePath());
+            ReleaseEncoder(Encoder);
+        }
     }
+    FinalizingEncoders.Empty();
 
     bIsSessionInitialized = false;
 
     UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Sessão '%s' desligada."), *SessionID);
 }
 
-void UIARAudioCaptureSession::StartNewTakeInternal()
+bool UIARAudioCaptureSession::StartRecordingEncoderInternal()
 {
-    StopCurrentTakeInternal();
+    if (RecordingEncoder)
+    {
+        ReleaseEncoder(RecordingEncoder);
+        RecordingEncoder = nullptr;
+    }
+
+    // Um único padrão de caminho para todos os takes: o encoder troca o marcador pelo índice de cada segmento
+    const FString TakeFileName = FString::Printf(TEXT("%s_%s_%s"), *RecordingSettings.TakeRecordingPrefix, *CurrentOverallSessionName, UIARAudioEncoder::SegmentIndexToken);
+    const FString TakePathPattern = GenerateOutputFilePath(TakeFileName, TEXT(""), -1);
+    const int64 TakeFrames = FMath::Max<int64>(1, FMath::RoundToInt64((double)RecordingSettings.TakeDurationSeconds * CurrentSessionStreamSettings.SampleRate));
 
-    FString TakeFileName = FString::Printf(TEXT("%s_%s"), *RecordingSettings.TakeRecordingPrefix, *CurrentOverallSessionName);
-    FString OutputFilePath = GenerateOutputFilePath(TakeFileName, TEXT(""), CurrentTakeNumber);
+    UIARAudioEncoder* NewEncoder = NewObject<UIARAudioEncoder>(this);
+    if (!NewEncoder)
+    {
+        return false;
+    }
+
+    NewEncoder->OnAudioEncodingError.AddDynamic(this, &UIARAudioCaptureSession::OnEncoderErrorReceived);
+    NewEncoder->OnAudioPipeCongested.AddDynamic(this, &UIARAudioCaptureSession::OnPipeCongested);
+    NewEncoder->OnAudioPipeCleared.AddDynamic(this, &UIARAudioCaptureSession::OnPipeCleared);
+    NewEncoder->OnAudioSegmentStarted.AddDynamic(this, &UIARAudioCaptureSession::OnEncoderSegmentStarted);
+    NewEncoder->OnAudioSegmentFinished.AddDynamic(this, &UIARAudioCaptureSession::OnEncoderSegmentFinished);
+
+    if (!NewEncoder->Initialize(CurrentSessionStreamSettings, TEXT(""), 0, 0, FramePool))
+    {
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioCaptureSession: Falha ao inicializar o encoder da gravação."));
+        return false;
+    }
 
-    UIARAudioEncoder* NewTakeEncoder = NewObject<UIARAudioEncoder>(this);
-    if (NewTakeEncoder)
+    RecordingEncoder = NewEncoder; // Antes de LaunchEncoder: o evento do primeiro take é disparado durante o lançamento
+    NewEncoder->SetSegmentation(TakeFrames, RecordingSettings.InitialTakeNumber);
+    if (!NewEncoder->LaunchEncoder(TakePathPattern))
     {
-        NewTakeEncoder->OnAudioEncodingError.AddDynamic(this, &UIARAudioCaptureSession::OnEncoderErrorReceived);
-        NewTakeEncoder->OnAudioPipeCongested.AddDynamic(this, &UIARAudioCaptureSession::OnPipeCongested);
-        NewTakeEncoder->OnAudioPipeCleared.AddDynamic(this, &UIARAudioCaptureSession::OnPipeCleared);
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioCaptureSession: Falha ao lançar o encoder da gravação ('%s')."), *TakePathPattern);
+        NewEncoder->ShutdownEncoder();
+        RecordingEncoder = nullptr;
+        return false;
+    }
+
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Encoder da gravação lançado. Takes de %lld frames em '%s'."), TakeFrames, *TakePathPattern);
+    return true;
+}
+
+bool UIARAudioCaptureSession::StopRecordingEncoderInternal(const FString& MasterFilePath)
+{
+    if (!RecordingEncoder)
+    {
+        return false;
+    }
+
+    // A partir daqui nenhum frame chega a este encoder
+    UIARAudioEncoder* Encoder = RecordingEncoder;
+    RecordingEncoder = nullptr;
 
-        if (NewTakeEncoder->Initialize(CurrentSessionStreamSettings, TEXT(""), 0, 0, FramePool))
+    if (!Encoder->IsEncodingActive())
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioCaptureSession: Encoder da gravação inativo, limpando referência."));
+        ReleaseEncoder(Encoder);
+        return false;
+    }
+
+    FinalizingEncoders.Add(Encoder);
+    TWeakObjectPtr<UIARAudioCaptureSession> WeakThis(this);
+    TWeakObjectPtr<UIARAudioEncoder> WeakEncoder(Encoder);
+    if (!Encoder->FinishEncodingAsync([WeakThis, WeakEncoder, MasterFilePath](bool bSuccess)
         {
-            if (NewTakeEncoder->LaunchEncoder(OutputFilePath))
+            if (WeakThis.IsValid())
             {
-                CurrentTakeEncoder = NewTakeEncoder;
-                UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Novo take %d iniciado em '%s'."), CurrentTakeNumber, *CurrentTakeEncoder->GetCurrentOutputFilePath());
-                OnFileRecordingTakeStarted.Broadcast(CurrentTakeNumber, CurrentTakeEncoder->GetCurrentOutputFilePath()); // Broadcast do delegate renomeado
-                CurrentTakeNumber++;
+                WeakThis->OnRecordingEncoderFinalized(WeakEncoder.Get(), bSuccess, MasterFilePath);
             }
-            else
-            {
-                UE_LOG(LogIAR, Error, TEXT("UIARAudioCaptureSession: Falha ao lançar encoder para o take %d."), CurrentTakeNumber);
-                NewTakeEncoder->ShutdownEncoder();
-            }
-        }
-        else
-        {
-            UE_LOG(LogIAR, Error, TEXT("UIARAudioCaptureSession: Falha ao inicializar encoder para o take %d."), CurrentTakeNumber);
-        }
+        }))
+    {
+        FinalizingEncoders.Remove(Encoder);
+        ReleaseEncoder(Encoder);
+        return false;
     }
+
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Encoder da gravação finalizando em background."));
+    return true;
 }
 
-bool UIARAudioCaptureSession::StopCurrentTakeInternal()
+void UIARAudioCaptureSession::OnRecordingEncoderFinalized(UIARAudioEncoder* Encoder, bool bSuccess, const FString& MasterFilePath)
 {
-    if (CurrentTakeEncoder && CurrentTakeEncoder->IsEncodingActive())
+    if (!Encoder || FinalizingEncoders.Remove(Encoder) == 0)
     {
-        CurrentTakeEncoder->FinishEncoding();
-        FString CompletedTakePath = CurrentTakeEncoder->GetCurrentOutputFilePath();
-        CompletedTakeFilePaths.Add(CompletedTakePath);
-
-        UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Take %d parado. Arquivo: '%s'"), CurrentTakeNumber -1, *CompletedTakePath);
-        OnFileRecordingTakeStopped.Broadcast(CurrentTakeNumber - 1, CompletedTakePath); // Broadcast do delegate renomeado
-        
-        CurrentTakeEncoder->OnAudioEncodingError.RemoveDynamic(this, &UIARAudioCaptureSession::OnEncoderErrorReceived);
-        CurrentTakeEncoder->OnAudioPipeCongested.RemoveDynamic(this, &UIARAudioCaptureSession::OnPipeCongested);
-        CurrentTakeEncoder->OnAudioPipeCleared.RemoveDynamic(this, &UIARAudioCaptureSession::OnPipeCleared);
-        CurrentTakeEncoder->ShutdownEncoder();
-        CurrentTakeEncoder = nullptr;
-        return true;
+        return; // Já liberado por ShutdownSession
     }
-    else if (CurrentTakeEncoder)
+
+    // O encoder já esvaziou as filas e fechou os arquivos: o desligamento aqui não bloqueia
+    const TArray<FString> TakeFilePaths = Encoder->GetCompletedSegmentFilePaths();
+    ReleaseEncoder(Encoder);
+
+    if (!bSuccess)
     {
-        UE_LOG(LogIAR, Warning, TEXT("UIARAudioCaptureSession: Tentativa de parar take inativo ou inválido, limpando referência."));
-        CurrentTakeEncoder->ShutdownEncoder();
-        CurrentTakeEncoder = nullptr;
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioCaptureSession: O encoder reportou falha na finalização; tentando montar o Master com %d takes."), TakeFilePaths.Num());
     }
-    return false;
+    StartMasterAssembly(MasterFilePath, TakeFilePaths);
 }
 
-void UIARAudioCaptureSession::RotateCurrentTake()
+void UIARAudioCaptureSession::ReleaseEncoder(UIARAudioEncoder* Encoder)
 {
-    if (bIsOverallRecordingActive)
-    {
-        UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Rotacionando take..."));
-        StartNewTakeInternal();
-    }
+    Encoder->OnAudioEncodingError.RemoveDynamic(this, &UIARAudioCaptureSession::OnEncoderErrorReceived);
+    Encoder->OnAudioPipeCongested.RemoveDynamic(this, &UIARAudioCaptureSession::OnPipeCongested);
+    Encoder->OnAudioPipeCleared.RemoveDynamic(this, &UIARAudioCaptureSession::OnPipeCleared);
+    Encoder->OnAudioSegmentStarted.RemoveDynamic(this, &UIARAudioCaptureSession::OnEncoderSegmentStarted);
+    Encoder->OnAudioSegmentFinished.RemoveDynamic(this, &UIARAudioCaptureSession::OnEncoderSegmentFinished);
+    Encoder->ShutdownEncoder();
+}
+
+UFUNCTION()
+void UIARAudioCaptureSession::OnEncoderSegmentStarted(int32 SegmentIndex, const FString& FilePath)
+{
+    CurrentTakeNumber = SegmentIndex;
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Take %d iniciado em '%s'."), SegmentIndex, *FilePath);
+    OnFileRecordingTakeStarted.Broadcast(SegmentIndex, FilePath);
+}
+
+UFUNCTION()
+void UIARAudioCaptureSession::OnEncoderSegmentFinished(int32 SegmentIndex, const FString& FilePath)
+{
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Take %d concluído. Arquivo: '%s'"), SegmentIndex, *FilePath);
+    OnFileRecordingTakeStopped.Broadcast(SegmentIndex, FilePath);
 }
 
 bool UIARAudioCaptureSession::ConcatenateTakesToMaster(const FString& MasterFilePath, const TArray<FString>& TakeFilePaths)
 {
     if (TakeFilePaths.Num() == 0) { UE_LOG(LogIAR, Warning, TEXT("UIARAudioCaptureSession: Nenhuns takes para concatenar. Não foi criado arquivo master.")); return false; }
 
-    FString TempDirPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("IAR_Temp"));
-    FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*TempDirPath);
+    // Diretório de trabalho exclusivo desta montagem: sessões (ou gravações) simultâneas não disputam arquivos temporários
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    const FString WorkDirPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("IAR_Temp"), FString::Printf(TEXT("%s_%s"), *SessionID, *FGuid::NewGuid().ToString(EGuidFormats::Digits)));
+    PlatformFile.CreateDirectoryTree(*WorkDirPath);
+    PlatformFile.CreateDirectoryTree(*FPaths::GetPath(MasterFilePath));
 
-    FString TempListFilePath = FPaths::Combine(TempDirPath, TEXT("concat_list.txt"));
+    bool bSuccess = false;
+    if (FIARWavConcatenator::CanConcatenate(TakeFilePaths))
+    {
+        // Takes PCM no mesmo formato: só os dados são copiados, sob um novo cabeçalho
+        bSuccess = FIARWavConcatenator::Concatenate(TakeFilePaths, MasterFilePath, WorkDirPath);
+    }
+    else
+    {
+        bSuccess = ConcatenateTakesWithFFmpeg(MasterFilePath, TakeFilePaths, WorkDirPath);
+    }
+
+    PlatformFile.DeleteDirectoryRecursively(*WorkDirPath);
+    return bSuccess;
+}
+
+bool UIARAudioCaptureSession::ConcatenateTakesWithFFmpeg(const FString& MasterFilePath, const TArray<FString>& TakeFilePaths, const FString& WorkDirPath)
+{
+    FString TempListFilePath = FPaths::Combine(WorkDirPath, TEXT("concat_list.txt"));
     FPaths::NormalizeFilename(TempListFilePath);
 
     FString ConcatListContent;
@@ -244,7 +342,6 @@ bool UIARAudioCaptureSession::ConcatenateTakesToMaster(const FString& MasterFile
     if (!FFileHelper::SaveStringToFile(ConcatListContent, *TempListFilePath))
     {
         UE_LOG(LogIAR, Error, TEXT("UIARAudioCaptureSession: Falha ao criar arquivo de lista de concatenação: %s"), *TempListFilePath);
-        FPlatformFileManager::Get().GetPlatformFile().DeleteDirectory(*TempDirPath);
         return false;
     }
     UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Arquivo de lista de concatenação criado: %s"), *TempListFilePath);
@@ -253,13 +350,9 @@ bool UIARAudioCaptureSession::ConcatenateTakesToMaster(const FString& MasterFile
     if (FFmpegExecPath.IsEmpty() || !FPlatformFileManager::Get().GetPlatformFile().FileExists(*FFmpegExecPath))
     {
         UE_LOG(LogIAR, Error, TEXT("UIARAudioCaptureSession: FFmpeg executável não encontrado para concatenação: %s"), *FFmpegExecPath);
-        FPlatformFileManager::Get().GetPlatformFile().DeleteDirectory(*TempDirPath);
         return false;
     }
 
-    FString MasterOutputDir = FPaths::GetPath(MasterFilePath);
-    FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*MasterOutputDir);
-
     FString NormalizedMasterFilePath = FPaths::ConvertRelativePathToFull(MasterFilePath);
     NormalizedMasterFilePath.ReplaceInline(TEXT(""), TEXT("/"), ESearchCase::CaseSensitive);
     FString ConcatArguments = FString::Printf(TEXT("-f concat -safe 0 -i %s -c copy %s"), *TempListFilePath, *NormalizedMasterFilePath);
@@ -267,9 +360,6 @@ bool UIARAudioCaptureSession::ConcatenateTakesToMaster(const FString& MasterFile
     UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Executando FFmpeg para concatenação. Exec: %s Args: %s"), *FFmpegExecPath, *ConcatArguments);
 
     bool bSuccess = UIARAudioEncoder::LaunchBlockingFFmpegProcess(FFmpegExecPath, ConcatArguments);
-
-    FPlatformFileManager::Get().GetPlatformFile().DeleteDirectory(*TempDirPath);
-
     if (!bSuccess)
     {
         UE_LOG(LogIAR, Error, TEXT("UIARAudioCaptureSession: FFmpeg falhou ao concatenar arquivos de take para o master."));
@@ -297,7 +387,7 @@ FString UIARAudioCaptureSession::GenerateOutputFilePath(const FString& Prefix, c
     if (Index != -1) { FileName += FString::Printf(TEXT("_%03d"), Index); }
     if (!Suffix.IsEmpty()) { FileName += TEXT("_") + Suffix; }
     if (RecordingSettings.bAppendTimestamp) { FileName += TEXT("_") + FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S")); }
-    FileName += TEXT(".wav"); 
+    FileName += CurrentSessionStreamSettings.GetDefaultExtension(); // Contêiner do codec da gravação
 
     FString OutputDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), RecordingSettings.BaseOutputFolder);
     FPaths::NormalizeDirectoryName(OutputDirectory);
@@ -316,13 +406,13 @@ void UIARAudioCaptureSession::OnEncoderErrorReceived(const FString& ErrorMessage
 UFUNCTION()
 void UIARAudioCaptureSession::OnPipeCongested(const FString& OutputFilePath)
 {
-    UE_LOG(LogIAR, Warning, TEXT("UIARAudioCaptureSession: Pipe de encoder '%s' congestionado. Pausando fonte de áudio."), *OutputFilePath);
-    if (AudioSourceRef && AudioSourceRef->IsCapturing()) { AudioSourceRef->StopCapture(); }
+    // A captura não é pausada: o encoder absorve o congestionamento na fila em memória e no journal em disco
+    UE_LOG(LogIAR, Warning, TEXT("UIARAudioCaptureSession: Pipe de encoder '%s' congestionado. Blocos retidos na fila do encoder."), *OutputFilePath);
 }
 
 UFUNCTION()
 void UIARAudioCaptureSession::OnPipeCleared(const FString& OutputFilePath)
 {
-    UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Pipe de encoder '%s' liberado. Retomando fonte de áudio."), *OutputFilePath);
-    if (AudioSourceRef && !AudioSourceRef->IsCapturing()) { AudioSourceRef->StartCapture(); }
+    const FIAR_EncoderQueueStats Stats = RecordingEncoder ? RecordingEncoder->GetQueueStats() : FIAR_EncoderQueueStats();
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioCaptureSession: Pipe de encoder '%s' liberado (%lld bytes no journal, %lld descartados)."), *OutputFilePath, Stats.SpillPendingBytes, Stats.DroppedBytes);
 }
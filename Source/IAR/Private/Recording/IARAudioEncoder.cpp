@@ -13,6 +13,8 @@
 #include "HAL/PlatformFileManager.h" // Para IPlatformFileManager
 #include "Async/Async.h" // Para AsyncTask
 #include "FFmpegLogReader.h"     // ADICIONADO: Include para FFMpegLogReader
+#include "Core/IARIOReactor.h"   // Reator de I/O compartilhado (escrita do pipe sem thread dedicada no Linux)
+#include "Core/IARClockedProducer.h" // Acorda produtores offline parados por backpressure
 #include "Engine/World.h"
 #include "dr_wav.h" // Inclua o cabeçalho do dr_wav SEM A MACRO!!!
 
@@ -25,13 +27,43 @@ DEFINE_LOG_CATEGORY(LogIARAudioEncoder);
 // ==============================================================================
 
 // Construtor do worker
-FIARAudioEncoderWorker::FIARAudioEncoderWorker(IAR_PipeWrapper& InPipeWrapper, TQueue<TArray<uint8>, EQueueMode::Mpsc>& InDataQueue, FEvent* InDataAvailableEvent, FThreadSafeBool& InShouldStop)
+FIARAudioEncoderWorker::FIARAudioEncoderWorker(IAR_PipeWrapper& InPipeWrapper, TQueue<TArray<uint8>, EQueueMode::Mpsc>& InDataQueue, FEvent* InDataAvailableEvent, FThreadSafeBool& InShouldStop, FIARByteBlockPool* InBlockPool,
+                                               int64 InMemoryBudgetBytes, int64 InSpillLimitBytes, const FString& InSpillFilePath)
     : PipeWrapper(InPipeWrapper) // Membro de referência: inicialização direta
     , DataQueue(InDataQueue)     // Membro de referência: inicialização direta
     , bShouldStop(InShouldStop)  // Membro de referência: inicialização direta
     , DataAvailableEvent(InDataAvailableEvent) // Membro de ponteiro: inicialização direta
+    , BlockPool(InBlockPool)
     , bIsPipeCurrentlyCongested(false) // Inicializa a flag de congestionamento
+    , MemoryBudgetBytes(FMath::Max<int64>(InMemoryBudgetBytes, 0))
+    // Blocos a caminho do disco ficam em memória até a thread do journal gravá-los: no máximo mais um orçamento
+    , SpillJournal(InSpillFilePath, InSpillLimitBytes, FMath::Max<int64>(InMemoryBudgetBytes, 0), InBlockPool)
+    , bIsSpilling(false)
+    , SpillStartTime(0.0)
+    , SpillEventCount(0)
+    , LastRecoverySeconds(0.0f)
+    , MaxRecoverySeconds(0.0f)
+    , PendingOffset(0)
+    , PendingBytes(0)
+    , bIsPipeConnected(false)
+    , bReactiveMode(false)
+    , ReactorRegistrationId(0)
+    , ReactiveConnectDeadline(0.0)
+    , bDrainScheduled(false)
+    , DrainTasksDoneEvent(FPlatformProcess::GetSynchEventFromPool(true))
 {
+    // A thread do journal é criada aqui, fora da captura; cada gravação concluída acorda quem esvazia o pipe
+    SpillJournal.SetOnBlockWritten([this](bool bWritten, int64 NumBytes)
+    {
+        if (!bWritten)
+        {
+            // Bloco perdido no disco: não vai mais chegar ao pipe
+            UnsentBytes.Subtract(NumBytes);
+            DroppedBytes.Add(NumBytes);
+        }
+        WakeConsumer();
+    });
+    SpillJournal.Start();
 }
 
 // Destrutor do worker
@@ -41,6 +73,8 @@ FIARAudioEncoderWorker::~FIARAudioEncoderWorker()
     // e será retornado no ShutdownEncoder.
     // Apenas garante que a thread não está esperando antes de destruir o objeto.
     if (DataAvailableEvent) { DataAvailableEvent->Trigger(); } 
+    FPlatformProcess::ReturnSynchEventToPool(DrainTasksDoneEvent);
+    DrainTasksDoneEvent = nullptr;
     UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Destrutor chamado."));
 }
 
@@ -50,70 +84,334 @@ bool FIARAudioEncoderWorker::Init()
     return true;
 }
 
-uint32 FIARAudioEncoderWorker::Run()
+bool FIARAudioEncoderWorker::ConnectPipe()
 {
-    UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Iniciando loop de thread."));
-
-    // A chamada para conectar o pipe agora acontece na thread do worker, não na Game Thread.
+    // A chamada para conectar o pipe acontece fora da Game Thread (thread do worker ou tarefa do reator).
     UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Aguardando conexão do FFmpeg com o pipe de entrada de áudio..."));
-    if (!PipeWrapper.Connect())
+    if (!PipeWrapper.Connect(&bShouldStop))
     {
-        // Se a conexão falhar, loga o erro e sinaliza para a thread parar imediatamente.
-        UE_LOG(LogIAR, Error, TEXT("FIARAudioEncoderWorker: Falha ao conectar Audio Named Pipe ao FFmpeg na thread do worker. Abortando codificação."));
+        // Se a conexão falhar, loga o erro e sinaliza para o worker parar imediatamente.
+        UE_LOG(LogIAR, Error, TEXT("FIARAudioEncoderWorker: Falha ao conectar Audio Named Pipe ao FFmpeg. Abortando codificação."));
         bShouldStop.AtomicSet(true); // Sinaliza para parar imediatamente
+        return false;
+    }
+    OnPipeConnected();
+    return true;
+}
+
+EIAR_PipeConnectResult FIARAudioEncoderWorker::TryConnectPipe()
+{
+    EIAR_PipeConnectResult Result = bShouldStop ? EIAR_PipeConnectResult::Failed : PipeWrapper.TryConnect();
+    if (Result == EIAR_PipeConnectResult::Pending && FPlatformTime::Seconds() > ReactiveConnectDeadline)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARAudioEncoderWorker: O FFmpeg não abriu o pipe '%s' em %.0f s."), *PipeWrapper.GetFullPipeName(), IAR_PipeWrapper::ConnectTimeoutSeconds);
+        Result = EIAR_PipeConnectResult::Failed;
+    }
+    if (Result == EIAR_PipeConnectResult::Failed)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARAudioEncoderWorker: Falha ao conectar Audio Named Pipe ao FFmpeg. Abortando codificação."));
+        bShouldStop.AtomicSet(true);
+    }
+    else if (Result == EIAR_PipeConnectResult::Connected)
+    {
+        OnPipeConnected();
+    }
+    return Result;
+}
+
+void FIARAudioEncoderWorker::OnPipeConnected()
+{
+    UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Pipe de entrada de áudio conectado com sucesso."));
+    // Em POSIX o FIFO passa a não-bloqueante: com o pipe cheio, a espera por espaço é feita com poll() (WaitForWritable) ou pelo reator
+    PipeWrapper.SetNonBlocking(true);
+    bIsPipeConnected = true;
+}
+
+uint32 FIARAudioEncoderWorker::Run()
+{
+    UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Iniciando loop de thread."));
+    if (!ConnectPipe())
+    {
         return 0; // Sai da função Run(), terminando a thread do worker.
     }
-    UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Pipe de entrada de áudio conectado com sucesso na thread do worker."));
-// O loop principal da worker thread (onde os dados são escritos no pipe) começa aqui.
+
+    // O loop principal da worker thread (onde os dados são escritos no pipe) começa aqui.
+    for (;;)
+    {
+        const EPumpResult Result = Pump();
+        if (Result == EPumpResult::Stopped)
+        {
+            break;
+        }
+        if (Result == EPumpResult::Idle)
+        {
+            // Se a fila está vazia e a thread não deve parar, espera por novos dados.
+            DataAvailableEvent->Wait(100); // Espera por 100ms, ou até ser sinalizado
+        }
+        else
+        {
+            // O lote continua intacto: espera o FFmpeg consumir e tenta de novo a partir do mesmo cursor
+            PipeWrapper.WaitForWritable(100);
+        }
+    }
+
+    // Parada forçada (ShutdownEncoder ou erro): o que não foi enviado volta ao pool
+    ReleasePendingBlocks();
+    UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Loop de thread encerrado."));
+    return 0;
+}
+
+FIARAudioEncoderWorker::EPumpResult FIARAudioEncoderWorker::Pump()
+{
+    // Nenhum byte é descartado: uma escrita parcial ou com o pipe cheio apenas avança (ou mantém) o cursor.
     while (!bShouldStop) // FThreadSafeBool implicitamente conversível para bool
     {
-        TArray<uint8> DataToSend;
-        // Tenta dequeuar dados da fila. Se não houver, espera pelo evento.
-        if (DataQueue.Dequeue(DataToSend))
+        // Completa o lote com o que já estiver na fila (ou no journal), para escrever vários blocos em uma só chamada
+        FPendingBlock Block;
+        while (PendingBlocks.Num() < MaxGatherBlocks && PendingBytes < MaxGatherBytes && DequeueNextBlock(Block, MaxGatherBytes - PendingBytes))
+        {
+            PendingBytes += Block.Bytes.Num();
+            PendingBlocks.Add(MoveTemp(Block));
+        }
+
+        if (PendingBlocks.Num() == 0)
+        {
+            return EPumpResult::Idle;
+        }
+
+        if (!PipeWrapper.IsValid())
+        {
+            UE_LOG(LogIAR, Warning, TEXT("FIARAudioEncoderWorker: Pipe inválido. Encerrando worker com %lld bytes não enviados."), UnsentBytes.GetValue());
+            bShouldStop.AtomicSet(true); // Se o pipe não é válido, não adianta continuar
+            break;
+        }
+
+        Segments.Reset();
+        for (int32 Index = 0; Index < PendingBlocks.Num(); ++Index)
+        {
+            const TArray<uint8>& Bytes = PendingBlocks[Index].Bytes;
+            const int32 Offset = (Index == 0) ? PendingOffset : 0;
+            Segments.Add({ Bytes.GetData() + Offset, Bytes.Num() - Offset });
+        }
+
+        const int64 BytesToWrite = PendingBytes - PendingOffset;
+        const int64 BytesWritten = PipeWrapper.WriteGather(Segments.GetData(), Segments.Num());
+        if (BytesWritten < 0) // Erro fatal
+        {
+            UE_LOG(LogIAR, Error, TEXT("FIARAudioEncoderWorker: Erro fatal ao escrever no pipe '%s'. Encerrando worker."), *PipeWrapper.GetFullPipeName());
+            bShouldStop.AtomicSet(true); // Usar AtomicSet() para modificar FThreadSafeBool
+            break;
+        }
+
+        if (BytesWritten == 0) // Pipe cheio/ocupado
         {
-            if (PipeWrapper.IsValid())
+            if (!bIsPipeCurrentlyCongested) // Se acabou de ficar congestionado
             {
-                int32 BytesWritten = PipeWrapper.Write(DataToSend.GetData(), DataToSend.Num());
-                if (BytesWritten == 0) // Pipe cheio/ocupado
-                {
-                    if (!bIsPipeCurrentlyCongested) // Se acabou de ficar congestionado
-                    {
-                        bIsPipeCurrentlyCongested.AtomicSet(true);
-                        UE_LOG(LogIAR, Warning, TEXT("FIARAudioEncoderWorker: Pipe '%s' cheio/ocupado. Pausando escrita e sinalizando congestionamento."), *PipeWrapper.GetFullPipeName());
-                    }
-                    FPlatformProcess::Sleep(0.001f); // Pequena pausa antes de re-tentar
-                }
-                else if (BytesWritten > 0) // Dados escritos com sucesso
-                {
-                    if (bIsPipeCurrentlyCongested) // Se estava congestionado e agora conseguiu escrever
-                    {
-                        bIsPipeCurrentlyCongested.AtomicSet(false);
-                        UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Pipe '%s' liberado. Retomando escrita e sinalizando liberação."), *PipeWrapper.GetFullPipeName());
-                    }
-                }
-                else if (BytesWritten == -1) // Erro fatal
-                {
-                    UE_LOG(LogIAR, Error, TEXT("FIARAudioEncoderWorker: Erro fatal ao escrever no pipe '%s'. Encerrando worker."), *PipeWrapper.GetFullPipeName());
-                    bShouldStop.AtomicSet(true); // Usar AtomicSet() para modificar FThreadSafeBool
-                }
+                bIsPipeCurrentlyCongested.AtomicSet(true);
+                UE_LOG(LogIAR, Warning, TEXT("FIARAudioEncoderWorker: Pipe '%s' cheio/ocupado. Aguardando espaço e sinalizando congestionamento."), *PipeWrapper.GetFullPipeName());
             }
-            else
+            return EPumpResult::WouldBlock;
+        }
+
+        if (bIsPipeCurrentlyCongested) // Se estava congestionado e agora conseguiu escrever
+        {
+            bIsPipeCurrentlyCongested.AtomicSet(false);
+            UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Pipe '%s' liberado. Retomando escrita e sinalizando liberação."), *PipeWrapper.GetFullPipeName());
+        }
+        UnsentBytes.Subtract(BytesWritten);
+
+        // Avança o cursor e devolve ao pool os blocos escritos por inteiro
+        int64 Remaining = BytesWritten;
+        int32 NumCompletedBlocks = 0;
+        while (Remaining > 0)
+        {
+            FPendingBlock& Completed = PendingBlocks[NumCompletedBlocks];
+            const int64 LeftInBlock = Completed.Bytes.Num() - PendingOffset;
+            if (Remaining < LeftInBlock)
             {
-                UE_LOG(LogIAR, Warning, TEXT("FIARAudioEncoderWorker: Pipe inválido. Descartando dados e encerrando worker."));
-                bShouldStop.AtomicSet(true); // Se o pipe não é válido, não adianta continuar
+                PendingOffset += (int32)Remaining;
+                break;
             }
+            Remaining -= LeftInBlock;
+            PendingOffset = 0;
+            PendingBytes -= Completed.Bytes.Num();
+            if (!Completed.bFromJournal)
+            {
+                MemoryQueuedBytes.Subtract(Completed.Bytes.Num());
+                ReleaseBlock(MoveTemp(Completed.Bytes));
+            }
+            ++NumCompletedBlocks;
         }
-        else
+        PendingBlocks.RemoveAt(0, NumCompletedBlocks, EAllowShrinking::No);
+        if (NumCompletedBlocks > 0)
         {
-            // Se a fila está vazia e a thread não deve parar, espera por novos dados.
-            if (!bShouldStop) // FThreadSafeBool implicitamente conversível para bool
+            FIARClockedProducer::NotifyCapacityAvailable();
+        }
+
+        // Escrita parcial: o pipe encheu no meio do lote, então espera espaço antes de enviar o restante
+        if (BytesWritten < BytesToWrite)
+        {
+            return EPumpResult::WouldBlock;
+        }
+    }
+    return EPumpResult::Stopped;
+}
+
+void FIARAudioEncoderWorker::ReleasePendingBlocks()
+{
+    for (FPendingBlock& PendingBlock : PendingBlocks)
+    {
+        if (!PendingBlock.bFromJournal)
+        {
+            ReleaseBlock(MoveTemp(PendingBlock.Bytes));
+        }
+    }
+    PendingBlocks.Reset();
+    PendingOffset = 0;
+    PendingBytes = 0;
+}
+
+bool FIARAudioEncoderWorker::StartReactive()
+{
+    if (!FIARIOReactor::Get())
+    {
+        return false;
+    }
+    bReactiveMode = true;
+    // Referência do próprio modo reator: enquanto ela existir, o contador não chega a 0 entre uma tarefa e outra
+    DrainTasksDoneEvent->Reset();
+    OutstandingDrainTasks.Set(1);
+    UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Escrita do pipe pelo reator de I/O compartilhado (sem thread dedicada)."));
+    // A primeira tarefa conecta o pipe; enquanto o FFmpeg não o abre, as novas tentativas vêm do timer do reator
+    ReactiveConnectDeadline = FPlatformTime::Seconds() + IAR_PipeWrapper::ConnectTimeoutSeconds;
+    ScheduleDrain();
+    return true;
+}
+
+void FIARAudioEncoderWorker::StopReactive()
+{
+    if (!bReactiveMode)
+    {
+        return;
+    }
+    bShouldStop.AtomicSet(true);
+
+    // As tarefas já despachadas (e as tentativas de conexão no timer do reator) veem bShouldStop e saem;
+    // a última delas (ou este FinishDrainTask, se não houver nenhuma) sinaliza o evento
+    FinishDrainTask();
+    while (!DrainTasksDoneEvent->Wait(StopWaitWarningMs))
+    {
+        // As tarefas usam este worker: não dá para seguir antes de elas terminarem
+        UE_LOG(LogIAR, Warning, TEXT("FIARAudioEncoderWorker: StopReactive aguardando há mais de %u ms por %d tarefa(s) de escrita."),
+            StopWaitWarningMs, OutstandingDrainTasks.GetValue());
+    }
+    // Depois do Unregister o reator não chama mais DrainReactive
+    if (ReactorRegistrationId != 0)
+    {
+        if (FIARIOReactor* Reactor = FIARIOReactor::Get())
+        {
+            Reactor->Unregister(ReactorRegistrationId);
+        }
+        ReactorRegistrationId = 0;
+    }
+
+    ReleasePendingBlocks();
+    bReactiveMode = false;
+    UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Modo reator encerrado."));
+}
+
+void FIARAudioEncoderWorker::ScheduleDrain()
+{
+    // Contada antes de checar bShouldStop: o StopReactive, que liga a flag e depois espera o contador, não perde esta tarefa
+    OutstandingDrainTasks.Increment();
+    // Uma tarefa por vez: se já existe uma agendada (ou aguardando espaço no pipe), ela vai ver os novos dados
+    if (bShouldStop || bDrainScheduled.AtomicSet(true))
+    {
+        FinishDrainTask();
+        return;
+    }
+    FIARIOReactor::Dispatch([this]()
+    {
+        DrainReactive();
+        FinishDrainTask();
+    });
+}
+
+void FIARAudioEncoderWorker::FinishDrainTask()
+{
+    // Depois do Trigger o StopReactive pode retornar e o worker ser destruído: nada de this depois dele
+    if (OutstandingDrainTasks.Decrement() == 0)
+    {
+        DrainTasksDoneEvent->Trigger();
+    }
+}
+
+void FIARAudioEncoderWorker::DrainReactive()
+{
+    // Chamado com bDrainScheduled ligado: esta é a única execução de Pump em andamento
+    if (!bIsPipeConnected)
+    {
+        FIARIOReactor* Reactor = FIARIOReactor::Get();
+        const EIAR_PipeConnectResult ConnectResult = Reactor ? TryConnectPipe() : EIAR_PipeConnectResult::Failed;
+        if (ConnectResult == EIAR_PipeConnectResult::Pending)
+        {
+            // O FFmpeg ainda não abriu o FIFO: a próxima tentativa vem do timer do reator, sem dormir numa thread do pool.
+            // bDrainScheduled continua ligado; a tentativa agendada conta como tarefa pendente para o StopReactive.
+            OutstandingDrainTasks.Increment();
+            Reactor->DispatchAfter(ReactiveConnectRetrySeconds, [this]()
+            {
+                DrainReactive();
+                FinishDrainTask();
+            });
+            return;
+        }
+        if (ConnectResult != EIAR_PipeConnectResult::Connected)
+        {
+            bDrainScheduled.AtomicSet(false);
+            return;
+        }
+        ReactorRegistrationId = Reactor->Register(PipeWrapper.GetNativeHandle(), [this](uint32 ReadyEvents) { DrainReactive(); });
+        if (ReactorRegistrationId == 0)
+        {
+            UE_LOG(LogIAR, Error, TEXT("FIARAudioEncoderWorker: Falha ao registrar o pipe '%s' no reator. Abortando codificação."), *PipeWrapper.GetFullPipeName());
+            bShouldStop.AtomicSet(true);
+            bDrainScheduled.AtomicSet(false);
+            return;
+        }
+    }
+
+    for (;;)
+    {
+        switch (Pump())
+        {
+        case EPumpResult::WouldBlock:
+            // Pipe cheio: bDrainScheduled continua ligado e o reator chama DrainReactive quando houver espaço
+            if (FIARIOReactor* Reactor = FIARIOReactor::Get())
             {
-                DataAvailableEvent->Wait(100); // Espera por 100ms, ou até ser sinalizado
+                if (Reactor->Arm(ReactorRegistrationId, FIARIOReactor::Writable))
+                {
+                    return;
+                }
+            }
+            bShouldStop.AtomicSet(true);
+            bDrainScheduled.AtomicSet(false);
+            return;
+
+        case EPumpResult::Stopped:
+            bDrainScheduled.AtomicSet(false);
+            return;
+
+        case EPumpResult::Idle:
+            bDrainScheduled.AtomicSet(false);
+            // Um EnqueueData (ou gravação do journal) entre o fim do Pump e a linha acima não agendou tarefa: confere aqui.
+            // Bytes ainda a caminho do disco não contam: a thread do journal agenda a tarefa quando os gravar.
+            if ((DataQueue.IsEmpty() && SpillJournal.GetReadableBytes() == 0) || bShouldStop || bDrainScheduled.AtomicSet(true))
+            {
+                return;
             }
+            break;
         }
     }
-    UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Loop de thread encerrado."));
-    return 0;
 }
 
 void FIARAudioEncoderWorker::Stop()
@@ -131,14 +429,142 @@ void FIARAudioEncoderWorker::Exit()
         TArray<uint8> RemainingData;
         DataQueue.Dequeue(RemainingData);
         UE_LOG(LogIAR, Warning, TEXT("FIARAudioEncoderWorker: Descartando %d bytes de dados restantes na fila ao sair."), RemainingData.Num());
+        ReleaseBlock(MoveTemp(RemainingData));
     }
+    SpillJournal.Close();
+    UnsentBytes.Reset();
+    MemoryQueuedBytes.Reset();
     UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Exit chamado."));
 }
 
 void FIARAudioEncoderWorker::EnqueueData(TArray<uint8>&& Data)
 {
-    DataQueue.Enqueue(MoveTemp(Data));
-    if (DataAvailableEvent) { DataAvailableEvent->Trigger(); } // Sinaliza que novos dados estão disponíveis
+    const int64 NumBytes = Data.Num();
+    if (NumBytes == 0)
+    {
+        ReleaseBlock(MoveTemp(Data));
+        return;
+    }
+
+    {
+        FScopeLock Lock(&SpillLock);
+        // Durante um transbordo tudo vai para o journal, mesmo com memória livre, para não inverter a ordem dos bytes
+        if (bIsSpilling || MemoryQueuedBytes.GetValue() + NumBytes > MemoryBudgetBytes)
+        {
+            if (!bIsSpilling)
+            {
+                bIsSpilling = true;
+                SpillStartTime = FPlatformTime::Seconds();
+                ++SpillEventCount;
+                UE_LOG(LogIAR, Warning, TEXT("FIARAudioEncoderWorker: Fila em memória no limite (%lld bytes). Transbordando para '%s'."), MemoryQueuedBytes.GetValue(), *SpillJournal.GetFilePath());
+            }
+
+            // Apenas enfileira: a gravação em disco é feita pela thread do journal
+            if (SpillJournal.Append(MoveTemp(Data)))
+            {
+                UnsentBytes.Add(NumBytes);
+                TotalSpilledBytes.Add(NumBytes);
+            }
+            else
+            {
+                // Memória e disco no limite: a captura continua, o bloco é perdido e contado
+                if (DroppedBytes.GetValue() == 0)
+                {
+                    UE_LOG(LogIAR, Error, TEXT("FIARAudioEncoderWorker: Journal '%s' no limite ou com erro. Descartando blocos até o pipe se recuperar."), *SpillJournal.GetFilePath());
+                }
+                DroppedBytes.Add(NumBytes);
+                ReleaseBlock(MoveTemp(Data));
+            }
+        }
+        else
+        {
+            MemoryQueuedBytes.Add(NumBytes);
+            UnsentBytes.Add(NumBytes);
+            DataQueue.Enqueue(MoveTemp(Data));
+        }
+    }
+
+    WakeConsumer();
+}
+
+void FIARAudioEncoderWorker::WakeConsumer()
+{
+    if (bReactiveMode)
+    {
+        ScheduleDrain();
+    }
+    else if (DataAvailableEvent)
+    {
+        DataAvailableEvent->Trigger(); // Sinaliza que novos dados estão disponíveis
+    }
+}
+
+bool FIARAudioEncoderWorker::DequeueNextBlock(FPendingBlock& OutBlock, int64 MaxJournalBytes)
+{
+    OutBlock.bFromJournal = false;
+    if (DataQueue.Dequeue(OutBlock.Bytes))
+    {
+        return true;
+    }
+
+    {
+        FScopeLock Lock(&SpillLock);
+        // Confere de novo sob o lock: blocos enfileirados em memória antes do transbordo começar vêm antes do journal
+        if (DataQueue.Dequeue(OutBlock.Bytes))
+        {
+            return true;
+        }
+        if (!bIsSpilling)
+        {
+            return false;
+        }
+    }
+
+    // Lido sem o SpillLock: a captura continua enfileirando enquanto o disco responde.
+    // Só o consumidor desliga bIsSpilling, então o transbordo não termina durante a leitura.
+    OutBlock.Bytes.SetNumUninitialized(FMath::Min(MaxJournalBytes, SpillReadChunkBytes), EAllowShrinking::No);
+    const int64 BytesRead = SpillJournal.Read(OutBlock.Bytes.GetData(), OutBlock.Bytes.Num());
+    if (BytesRead > 0)
+    {
+        OutBlock.Bytes.SetNum((int32)BytesRead, EAllowShrinking::No);
+        OutBlock.bFromJournal = true;
+        return true;
+    }
+
+    OutBlock.Bytes.Reset();
+    if (BytesRead < 0)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARAudioEncoderWorker: Falha ao ler o journal. Encerrando worker."));
+        bShouldStop.AtomicSet(true);
+        return false;
+    }
+
+    FScopeLock Lock(&SpillLock);
+    if (SpillJournal.GetPendingBytes() > 0)
+    {
+        return false; // Blocos ainda a caminho do disco: a thread do journal acorda o consumidor quando gravar
+    }
+    // Journal vazio: a recuperação terminou e os próximos blocos voltam para a memória
+    bIsSpilling = false;
+    LastRecoverySeconds = (float)(FPlatformTime::Seconds() - SpillStartTime);
+    MaxRecoverySeconds = FMath::Max(MaxRecoverySeconds, LastRecoverySeconds);
+    UE_LOG(LogIAR, Log, TEXT("FIARAudioEncoderWorker: Journal esvaziado em %.2f s (%lld bytes transbordados no total)."), LastRecoverySeconds, TotalSpilledBytes.GetValue());
+    return false;
+}
+
+FIAR_EncoderQueueStats FIARAudioEncoderWorker::GetQueueStats() const
+{
+    FScopeLock Lock(&SpillLock);
+    FIAR_EncoderQueueStats Stats;
+    Stats.MemoryQueuedBytes = MemoryQueuedBytes.GetValue();
+    Stats.SpillPendingBytes = SpillJournal.GetPendingBytes();
+    Stats.TotalSpilledBytes = TotalSpilledBytes.GetValue();
+    Stats.DroppedBytes = DroppedBytes.GetValue();
+    Stats.SpillEventCount = SpillEventCount;
+    Stats.bIsSpilling = bIsSpilling;
+    Stats.LastRecoverySeconds = LastRecoverySeconds;
+    Stats.MaxRecoverySeconds = MaxRecoverySeconds;
+    return Stats;
 }
 
 void FIARAudioEncoderWorker::StopProcessing()
@@ -151,6 +577,15 @@ bool FIARAudioEncoderWorker::IsPipeCurrentlyCongested() const
     return bIsPipeCurrentlyCongested;
 }
 
+void FIARAudioEncoderWorker::ReleaseBlock(TArray<uint8>&& Block)
+{
+    // Devolve o bloco ao pool do encoder para a próxima conversão
+    if (BlockPool)
+    {
+        BlockPool->Release(MoveTemp(Block));
+    }
+}
+
 // ==============================================================================
 // UIARAudioEncoder Implementation (Implementações dos métodos da classe UObject)
 // ==============================================================================
@@ -169,9 +604,18 @@ UIARAudioEncoder::UIARAudioEncoder()
     , bIsEncodingActive(false)
     , bStopWorkerThread(false) // Inicialização explícita para FThreadSafeBool
     , bNoMoreFramesToEncode(false) // Inicialização explícita para FThreadSafeBool
+    , bAcceptingFrames(false)
     , bIsInitialized(false) // Inicialização explícita para FThreadSafeBool
     , bIsPipeCurrentlyCongestedInternal(false) // NOVO: Inicialização da flag interna do encoder
     , FramePool(nullptr) // Inicialização explícita
+    , bUseNativeWavWriter(false)
+    , bNativeWriterErrorReported(false)
+    , ExpectedRecordingDurationSeconds(0.0f)
+    , EncodedBlockPool(64 * 1024, 64)
+    , SegmentFrames(0)
+    , CurrentSegmentIndex(0)
+    , FramesInCurrentSegment(0)
+    , bSegmentCloseFailed(false)
 {
     NewFrameEvent = FPlatformProcess::GetSynchEventFromPool(false); // false para auto-reset
 
@@ -211,6 +655,13 @@ void UIARAudioEncoder::BeginDestroy()
     Super::BeginDestroy();
 }
 
+bool UIARAudioEncoder::CanUseNativeWavWriter(const FIAR_AudioStreamSettings& Settings)
+{
+    // Para PCM o FFmpeg só copiaria as amostras para um WAV; isso o escritor nativo faz sem processo externo.
+    // Codecs comprimidos (FLAC, OPUS, AAC, MP3) são codificados pelo FFmpeg direto do pipe.
+    return Settings.GetDefaultExtension().Equals(TEXT(".wav"));
+}
+
 // Implementação da função static GetFFmpegExecutablePathInternal()
 FString UIARAudioEncoder::GetFFmpegExecutablePathInternal()
 {
@@ -261,6 +712,23 @@ bool UIARAudioEncoder::Initialize(const FIAR_AudioStreamSettings& Settings, cons
         return false;
     }
 
+    // Formato das amostras gravadas (vale para o escritor nativo e para o pipe do FFmpeg)
+    EIARSampleFormat SampleFormat = EIARSampleFormat::S16;
+    if (!FIARSampleFormatConverter::FormatFromBitDepth(Settings.BitDepth, Settings.bUseFloatSamples, SampleFormat))
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioEncoder: BitDepth %d (float: %s) não suportado. Gravando em 16 bits."), Settings.BitDepth, Settings.bUseFloatSamples ? TEXT("sim") : TEXT("não"));
+    }
+    SampleConverter = FIARSampleFormatConverter(SampleFormat, Settings.bApplyDither);
+
+    // PCM não precisa do FFmpeg: sem pipe nem worker, o escritor nativo é aberto em LaunchEncoder
+    bUseNativeWavWriter = CanUseNativeWavWriter(Settings);
+    if (bUseNativeWavWriter)
+    {
+        bIsInitialized.AtomicSet(true);
+        UE_LOG(LogIAR, Log, TEXT("UIARAudioEncoder initialized successfully (escritor WAV nativo, sem FFmpeg)."));
+        return true;
+    }
+
     // A factory já foi criada no construtor. Apenas verifica se é válida.
     if (!EncoderCommandFactory)
     {
@@ -292,10 +760,17 @@ bool UIARAudioEncoder::Initialize(const FIAR_AudioStreamSettings& Settings, cons
     // NOTE: A interface FRunnableThread::Create espera um FRunnable*.
     // EncoderWorker é do tipo FIARAudioEncoderWorker*, que herda de FRunnable.
     // A conversão implícita de um tipo derivado para um tipo base é permitida aqui.
-    EncoderWorker = new FIARAudioEncoderWorker(AudioPipe, DataQueue, NewFrameEvent, bStopWorkerThread);
-    EncoderWorkerThread = FRunnableThread::Create(EncoderWorker, TEXT("IARAudioEncoderWorkerThread"), 0, TPri_Normal);
+    // Orçamento da fila em memória; o excedente transborda para um journal em Saved/IAR/Spill
+    const FString SpillFilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("IAR"), TEXT("Spill"), FString::Printf(TEXT("%s.spill"), *AudioPipeBaseName));
+    EncoderWorker = new FIARAudioEncoderWorker(AudioPipe, DataQueue, NewFrameEvent, bStopWorkerThread, &EncodedBlockPool,
+                                               (int64)Settings.EncoderQueueMemoryMB * 1024 * 1024, (int64)Settings.EncoderSpillLimitMB * 1024 * 1024, SpillFilePath);
+    // No Linux o pipe é esvaziado pelo reator de I/O compartilhado; nas demais plataformas, por uma thread dedicada
+    if (!EncoderWorker->StartReactive())
+    {
+        EncoderWorkerThread = FRunnableThread::Create(EncoderWorker, TEXT("IARAudioEncoderWorkerThread"), 0, TPri_Normal);
+    }
 
-    if (!EncoderWorkerThread)
+    if (!EncoderWorkerThread && !EncoderWorker->IsReactive())
     {
         UE_LOG(LogIAR, Error, TEXT("Failed to create audio encoder worker thread. Cleaning up."));
         InternalCleanupEncoderResources(); // Cleanup the pipe
@@ -322,8 +797,21 @@ bool UIARAudioEncoder::LaunchEncoder(const FString& LiveOutputFilePath)
         return false;
     }
 
-    // Setta o caminho de saída do áudio ao vivo
-    CurrentOutputFilePath = LiveOutputFilePath; // Atualiza o caminho de saída
+    // Setta o caminho de saída do áudio ao vivo (com segmentação, LiveOutputFilePath é o padrão dos segmentos)
+    if (SegmentFrames > 0 && !LiveOutputFilePath.Contains(SegmentIndexToken))
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioEncoder: Caminho '%s' sem '%s'. Segmentação desativada."), *LiveOutputFilePath, SegmentIndexToken);
+        SegmentFrames = 0;
+    }
+    {
+        FScopeLock Lock(&SegmentLock);
+        SegmentPathPattern = LiveOutputFilePath;
+        CurrentOutputFilePath = (SegmentFrames > 0) ? GetSegmentFilePath(CurrentSegmentIndex) : LiveOutputFilePath; // Atualiza o caminho de saída
+        CompletedSegmentPaths.Reset();
+        UnconfirmedSegments.Reset();
+    }
+    FramesInCurrentSegment = 0;
+    bSegmentCloseFailed.AtomicSet(false);
 
     // NOVO CÓDIGO: Verificar e criar o diretório de saída
     FString OutputDirectory = FPaths::GetPath(CurrentOutputFilePath);
@@ -336,6 +824,26 @@ bool UIARAudioEncoder::LaunchEncoder(const FString& LiveOutputFilePath)
     }
     UE_LOG(LogIAR, Log, TEXT("Diretório de saída garantido: %s"), *OutputDirectory);
 
+    if (bUseNativeWavWriter)
+    {
+        if (!OpenNativeWavWriter(CurrentOutputFilePath, NativeWavWriter))
+        {
+            return false;
+        }
+
+        bIsEncodingActive = true;
+        bNativeWriterErrorReported = false;
+        bStopWorkerThread.AtomicSet(false);
+        bNoMoreFramesToEncode.AtomicSet(false);
+        bAcceptingFrames.AtomicSet(true);
+        if (SegmentFrames > 0)
+        {
+            BroadcastSegmentEvent(true, CurrentSegmentIndex, CurrentOutputFilePath);
+            PrepareNextSegmentWriter(CurrentSegmentIndex + 1);
+        }
+        return true;
+    }
+
 
     // Pega Executavel FFmpeg (agora usando a função static)
     FString ExecPath = UIARAudioEncoder::GetFFmpegExecutablePathInternal();
@@ -346,7 +854,7 @@ bool UIARAudioEncoder::LaunchEncoder(const FString& LiveOutputFilePath)
     }
 
     // Constrói o Comando FFmpeg para a gravação ao vivo (agora para WAV/PCM S16LE)
-    FString Arguments = EncoderCommandFactory->BuildAudioEncodeCommand(CurrentStreamSettings, AudioPipe.GetFullPipeName(), CurrentOutputFilePath);
+    FString Arguments = EncoderCommandFactory->BuildAudioEncodeCommand(CurrentStreamSettings, AudioPipe.GetFullPipeName(), (SegmentFrames > 0) ? SegmentPathPattern : CurrentOutputFilePath, SegmentFrames, CurrentSegmentIndex);
     
     UE_LOG(LogIAR, Log, TEXT("Launching FFmpeg. Executable: %s , Arguments: %s"), *ExecPath, *Arguments);
 
@@ -399,6 +907,7 @@ bool UIARAudioEncoder::LaunchEncoder(const FString& LiveOutputFilePath)
     // Reseta as flags de worker thread
     bStopWorkerThread.AtomicSet(false);
     bNoMoreFramesToEncode.AtomicSet(false);
+    bAcceptingFrames.AtomicSet(true);
 
     // NOVO: Inicia o timer para verificar o status de congestionamento do pipe.
     if (UWorld* World = GetWorld())
@@ -413,20 +922,318 @@ bool UIARAudioEncoder::LaunchEncoder(const FString& LiveOutputFilePath)
     }
     bIsPipeCurrentlyCongestedInternal.AtomicSet(false); // Reinicia o estado interno do encoder
 
+    if (SegmentFrames > 0)
+    {
+        BroadcastSegmentEvent(true, CurrentSegmentIndex, CurrentOutputFilePath);
+    }
+    return true;
+}
+
+void UIARAudioEncoder::SetSegmentation(int64 InSegmentFrames, int32 InFirstSegmentIndex)
+{
+    if (bIsEncodingActive)
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioEncoder: SetSegmentation deve ser chamada antes de LaunchEncoder. Ignorando."));
+        return;
+    }
+    SegmentFrames = FMath::Max<int64>(0, InSegmentFrames);
+    CurrentSegmentIndex = InFirstSegmentIndex;
+
+    // O segment muxer corta em fronteiras de pacote: alinha o take aos pacotes fixos do comando, em vez de pacotes minúsculos
+    constexpr int64 PacketFrames = UIARECFactory::SegmentPacketFrames;
+    if (!bUseNativeWavWriter && SegmentFrames > 0 && SegmentFrames % PacketFrames != 0)
+    {
+        const int64 RoundedFrames = FMath::Max<int64>(PacketFrames, ((SegmentFrames + PacketFrames / 2) / PacketFrames) * PacketFrames);
+        UE_LOG(LogIAR, Log, TEXT("UIARAudioEncoder: Segmento ajustado de %lld para %lld frames (múltiplo de %lld)."), SegmentFrames, RoundedFrames, PacketFrames);
+        SegmentFrames = RoundedFrames;
+    }
+}
+
+FString UIARAudioEncoder::GetSegmentFilePath(int32 SegmentIndex) const
+{
+    return SegmentPathPattern.Replace(SegmentIndexToken, *FString::Printf(TEXT("%03d"), SegmentIndex));
+}
+
+TArray<FString> UIARAudioEncoder::GetCompletedSegmentFilePaths() const
+{
+    FScopeLock Lock(&SegmentLock);
+    return CompletedSegmentPaths;
+}
+
+FString UIARAudioEncoder::GetCurrentOutputFilePath() const
+{
+    FScopeLock Lock(&SegmentLock);
+    return CurrentOutputFilePath;
+}
+
+bool UIARAudioEncoder::OpenNativeWavWriter(const FString& FilePath, TUniquePtr<FIARWavStreamWriter>& OutWriter)
+{
+    // Com segmentação o tamanho de cada arquivo é exato; sem ela, vem da duração esperada
+    const int64 BytesPerFrame = (int64)CurrentStreamSettings.NumChannels * SampleConverter.GetBytesPerSample();
+    const int64 ExpectedDataBytes = (SegmentFrames > 0) ? SegmentFrames * BytesPerFrame
+                                                        : (int64)(ExpectedRecordingDurationSeconds * CurrentStreamSettings.SampleRate) * BytesPerFrame;
+
+    OutWriter = MakeUnique<FIARWavStreamWriter>();
+    OutWriter->SetBlockPool(&EncodedBlockPool);
+    if (!OutWriter->Open(FilePath, CurrentStreamSettings.SampleRate, CurrentStreamSettings.NumChannels, SampleConverter.GetFormat(), ExpectedDataBytes))
+    {
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioEncoder: Falha ao abrir o escritor WAV nativo para '%s'."), *FilePath);
+        OutWriter.Reset();
+        return false;
+    }
+    return true;
+}
+
+void UIARAudioEncoder::PrepareNextSegmentWriter(int32 SegmentIndex)
+{
+    // ShutdownEncoder/FinishEncoding aguardam esta tarefa (DiscardPreparedSegmentWriter), então o encoder sobrevive a ela
+    PreparedSegmentWriter = Async(EAsyncExecution::ThreadPool, [this, FilePath = GetSegmentFilePath(SegmentIndex)]()
+    {
+        TUniquePtr<FIARWavStreamWriter> Writer;
+        OpenNativeWavWriter(FilePath, Writer);
+        return Writer;
+    });
+}
+
+TUniquePtr<FIARWavStreamWriter> UIARAudioEncoder::TakePreparedSegmentWriter(const FString& NextPath)
+{
+    TUniquePtr<FIARWavStreamWriter> Writer;
+    if (!PreparedSegmentWriter.IsValid())
+    {
+        OpenNativeWavWriter(NextPath, Writer);
+        return Writer;
+    }
+    if (!PreparedSegmentWriter.IsReady())
+    {
+        // A abertura levou mais que um take inteiro (disco muito lento): só aqui a captura espera
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioEncoder: Abertura de '%s' ainda em andamento na fronteira do segmento. Aguardando."), *NextPath);
+    }
+    Writer = PreparedSegmentWriter.Consume();
+    PreparedSegmentWriter.Reset();
+    return Writer;
+}
+
+void UIARAudioEncoder::DiscardPreparedSegmentWriter()
+{
+    if (!PreparedSegmentWriter.IsValid())
+    {
+        return;
+    }
+    TUniquePtr<FIARWavStreamWriter> Writer = PreparedSegmentWriter.Consume();
+    PreparedSegmentWriter.Reset();
+    if (Writer)
+    {
+        const FString UnusedPath = Writer->GetFilePath();
+        Writer->Close();
+        Writer.Reset();
+        FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*UnusedPath);
+    }
+}
+
+bool UIARAudioEncoder::BeginNextSegment()
+{
+    int32 FinishedIndex;
+    FString FinishedPath;
+    FString NextPath;
+    {
+        FScopeLock Lock(&SegmentLock);
+        FinishedIndex = CurrentSegmentIndex;
+        FinishedPath = CurrentOutputFilePath;
+        CompletedSegmentPaths.Add(FinishedPath);
+        ++CurrentSegmentIndex;
+        NextPath = GetSegmentFilePath(CurrentSegmentIndex);
+        CurrentOutputFilePath = NextPath;
+    }
+    FramesInCurrentSegment = 0;
+
+    if (bUseNativeWavWriter)
+    {
+        // Troca de arquivo no escritor nativo: o próximo foi aberto em background durante o take que terminou
+        TUniquePtr<FIARWavStreamWriter> FinishedWriter = MoveTemp(NativeWavWriter);
+        NativeWavWriter = TakePreparedSegmentWriter(NextPath);
+        const bool bNextOpened = NativeWavWriter.IsValid();
+        if (bNextOpened)
+        {
+            PrepareNextSegmentWriter(FinishedIndex + 2);
+        }
+        if (FinishedWriter)
+        {
+            // O anterior esvazia a fila e corrige o cabeçalho em background, fora da thread que entrega os frames.
+            // ShutdownEncoder/FinishEncoding aguardam estas tarefas, então o encoder sobrevive a elas.
+            TFuture<bool> CloseTask = Async(EAsyncExecution::ThreadPool, [this, Writer = MoveTemp(FinishedWriter), FinishedIndex, FinishedPath]() mutable
+            {
+                const bool bClosed = Writer->Close();
+                Writer.Reset();
+                if (!bClosed)
+                {
+                    bSegmentCloseFailed.AtomicSet(true);
+                }
+                UE_LOG(LogIAR, Log, TEXT("UIARAudioEncoder: Segmento %d finalizado ('%s')."), FinishedIndex, *FinishedPath);
+                BroadcastSegmentEvent(false, FinishedIndex, FinishedPath);
+                return bClosed;
+            });
+
+            FScopeLock Lock(&SegmentLock);
+            PendingSegmentCloses.RemoveAll([](const TFuture<bool>& Task) { return Task.IsReady(); });
+            PendingSegmentCloses.Add(MoveTemp(CloseTask));
+        }
+
+        if (!bNextOpened)
+        {
+            // Sem arquivo para o próximo take: encerra a gravação em vez de descartar amostras em silêncio.
+            // Estamos dentro de EncodeFrame, então só baixa a flag (StopAcceptingFrames esperaria por esta chamada).
+            UE_LOG(LogIAR, Error, TEXT("UIARAudioEncoder: Segmento %d não pôde ser aberto ('%s'). Gravação interrompida."), FinishedIndex + 1, *NextPath);
+            bAcceptingFrames.AtomicSet(false);
+            bNoMoreFramesToEncode.AtomicSet(true);
+            ReportNativeWriterError();
+            return false;
+        }
+    }
+    else
+    {
+        // No FFmpeg o segment muxer corta no mesmo frame, mas o arquivo só fecha quando ele chega lá:
+        // o evento de conclusão sai em ConfirmClosedSegments, quando o próximo arquivo aparecer
+        FScopeLock Lock(&SegmentLock);
+        UnconfirmedSegments.Add({ FinishedIndex, FinishedPath, NextPath });
+    }
+
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioEncoder: Segmento %d concluído ('%s'); iniciando '%s'."), FinishedIndex, *FinishedPath, *NextPath);
+    BroadcastSegmentEvent(true, FinishedIndex + 1, NextPath);
     return true;
 }
 
+void UIARAudioEncoder::ConfirmClosedSegments(bool bProcessExited)
+{
+    TArray<FUnconfirmedSegment> Confirmed;
+    {
+        FScopeLock Lock(&SegmentLock);
+        IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+        int32 NumConfirmed = 0;
+        // Em ordem: um segmento só fecha depois do anterior
+        while (NumConfirmed < UnconfirmedSegments.Num())
+        {
+            const FUnconfirmedSegment& Segment = UnconfirmedSegments[NumConfirmed];
+            if (!bProcessExited && (Segment.NextPath.IsEmpty() || !PlatformFile.FileExists(*Segment.NextPath)))
+            {
+                break;
+            }
+            Confirmed.Add(Segment);
+            ++NumConfirmed;
+        }
+        UnconfirmedSegments.RemoveAt(0, NumConfirmed);
+    }
+
+    for (const FUnconfirmedSegment& Segment : Confirmed)
+    {
+        BroadcastSegmentEvent(false, Segment.Index, Segment.Path);
+    }
+}
+
+bool UIARAudioEncoder::WaitForPendingSegmentCloses()
+{
+    TArray<TFuture<bool>> Tasks;
+    {
+        FScopeLock Lock(&SegmentLock);
+        Tasks = MoveTemp(PendingSegmentCloses);
+        PendingSegmentCloses.Reset();
+    }
+    for (TFuture<bool>& Task : Tasks)
+    {
+        Task.Wait();
+    }
+    return !bSegmentCloseFailed;
+}
+
+void UIARAudioEncoder::CompleteFinalSegment()
+{
+    int32 FinalIndex;
+    FString FinalPath;
+    {
+        FScopeLock Lock(&SegmentLock);
+        if (CurrentOutputFilePath.IsEmpty() || CompletedSegmentPaths.Contains(CurrentOutputFilePath))
+        {
+            return;
+        }
+        CompletedSegmentPaths.Add(CurrentOutputFilePath);
+        FinalIndex = CurrentSegmentIndex;
+        FinalPath = CurrentOutputFilePath;
+    }
+
+    if (SegmentFrames > 0)
+    {
+        if (bUseNativeWavWriter)
+        {
+            // O escritor nativo já fechou o arquivo
+            BroadcastSegmentEvent(false, FinalIndex, FinalPath);
+        }
+        else
+        {
+            // O FFmpeg ainda está processando o EOF: confirmado quando o processo terminar
+            FScopeLock Lock(&SegmentLock);
+            UnconfirmedSegments.Add({ FinalIndex, FinalPath, FString() });
+        }
+    }
+}
+
+void UIARAudioEncoder::BroadcastSegmentEvent(bool bStarted, int32 SegmentIndex, const FString& FilePath)
+{
+    auto Broadcast = [WeakThis = TWeakObjectPtr<UIARAudioEncoder>(this), bStarted, SegmentIndex, FilePath]()
+    {
+        UIARAudioEncoder* Encoder = WeakThis.Get();
+        if (!Encoder)
+        {
+            return;
+        }
+        if (bStarted) { Encoder->OnAudioSegmentStarted.Broadcast(SegmentIndex, FilePath); }
+        else { Encoder->OnAudioSegmentFinished.Broadcast(SegmentIndex, FilePath); }
+    };
+
+    // EncodeFrame pode rodar na thread da fonte de áudio: os delegates são sempre disparados na Game Thread
+    if (IsInGameThread())
+    {
+        Broadcast();
+    }
+    else
+    {
+        AsyncTask(ENamedThreads::GameThread, MoveTemp(Broadcast));
+    }
+}
+
+void UIARAudioEncoder::ReportNativeWriterError()
+{
+    if (bNativeWriterErrorReported)
+    {
+        return;
+    }
+    bNativeWriterErrorReported = true;
+    const FString ErrorMessage = FString::Printf(TEXT("Falha no escritor WAV nativo: %s"), *GetCurrentOutputFilePath());
+    AsyncTask(ENamedThreads::GameThread, [WeakThis = TWeakObjectPtr<UIARAudioEncoder>(this), ErrorMessage]()
+    {
+        if (WeakThis.IsValid()) { WeakThis->OnAudioEncodingError.Broadcast(ErrorMessage); }
+    });
+}
+
 void UIARAudioEncoder::ShutdownEncoder()
 {
     // Usar FThreadSafeBool implicitamente conversível para bool
     // Verificar se bIsInitialized ou se algum dos ponteiros de recurso existe para evitar warnings desnecessários.
-    if (!bIsInitialized && !FFmpegProcessHandle.IsValid() && !EncoderWorkerThread && !FFmpegStdoutLogReader && !FFmpegStderrLogReader) 
+    if (!bIsInitialized && !FFmpegProcessHandle.IsValid() && !EncoderWorker && !FFmpegStdoutLogReader && !FFmpegStderrLogReader && !NativeWavWriter) 
     {
         UE_LOG(LogIAR, Warning, TEXT("UIARAudioEncoder is not initialized or already shut down."));
         return;
     }
 
     UE_LOG(LogIAR, Log, TEXT("Shutting down UIARAudioEncoder..."));
+    StopAcceptingFrames();
+
+    // 0. Uma finalização em background ainda usa os recursos abaixo: aguarda (só bloqueia em desligamentos forçados)
+    if (FinishTask.IsValid())
+    {
+        FinishTask.Wait();
+        FinishTask.Reset();
+    }
+    DiscardPreparedSegmentWriter();
+    WaitForPendingSegmentCloses();
 
     // 1. Sinaliza à worker thread para parar
     bStopWorkerThread.AtomicSet(true); 
@@ -441,10 +1248,24 @@ void UIARAudioEncoder::ShutdownEncoder()
         // O EncoderWorker será deletado aqui, pois ele é "propriedade" do EncoderWorkerThread
         if (EncoderWorker) { delete EncoderWorker; EncoderWorker = nullptr; }
     }
+    else if (EncoderWorker) // Modo reator: não há thread, então o Exit() é chamado aqui
+    {
+        EncoderWorker->StopReactive();
+        EncoderWorker->Exit();
+        delete EncoderWorker;
+        EncoderWorker = nullptr;
+    }
 
     // 3. Limpa os recursos internos (pipes de entrada) e processo FFmpeg
     InternalCleanupEncoderResources();
 
+    // Fecha o escritor nativo, se FinishEncoding não o fez
+    if (NativeWavWriter)
+    {
+        NativeWavWriter->Close();
+        NativeWavWriter.Reset();
+    }
+
     // NOVO: Limpa o timer de verificação de congestionamento
     if (UWorld* World = GetWorld())
     {
@@ -470,8 +1291,12 @@ bool UIARAudioEncoder::EncodeFrame(TSharedPtr<FIAR_AudioFrameData> Frame)
         return false;
     }
     
-    if (bNoMoreFramesToEncode) 
+    // Conta a chamada antes de conferir a flag: a finalização baixa a flag e depois espera o contador zerar,
+    // então ou este frame é recusado aqui ou a finalização espera ele sair de SubmitSamples/BeginNextSegment
+    FramesInFlight.Increment();
+    if (!bAcceptingFrames || bNoMoreFramesToEncode) 
     {
+        FramesInFlight.Decrement();
         UE_LOG(LogIAR, Warning, TEXT("UIARAudioEncoder has been signaled that no more frames are coming. Frame dropped."));
         // Libera o frame para o pool (se não houver mais frames, ele não será enfileirado)
         if (Frame.IsValid() && FramePool)
@@ -481,21 +1306,29 @@ bool UIARAudioEncoder::EncodeFrame(TSharedPtr<FIAR_AudioFrameData> Frame)
         return false;
     }
 
-    // Converte os dados float do FIAR_AudioFrameData para uint8 (bytes s16le)
-    TArray<uint8> RawBytes;
-    RawBytes.Reserve(Frame->RawSamplesPtr->Num() * sizeof(int16)); 
-
-    for (float Sample : *(Frame->RawSamplesPtr)) 
+    // Divide o frame nas fronteiras de segmento: cada parte vai para o arquivo do seu take
+    const TArray<float>& Samples = *(Frame->RawSamplesPtr);
+    const int32 NumChannels = FMath::Max(1, CurrentStreamSettings.NumChannels);
+    // Frames sobrepostos (janelas de análise) já foram gravados com o frame anterior: só a parte nova vai para o arquivo
+    int32 SampleOffset = FMath::Clamp(Frame->OverlapFrames * NumChannels, 0, Samples.Num());
+    while (SampleOffset < Samples.Num())
     {
-        int16 ConvertedSample = FMath::Clamp(Sample, -1.0f, 1.0f) * 32767.0f;
-        RawBytes.Add(static_cast<uint8>(ConvertedSample & 0xFF));        // Low byte
-        RawBytes.Add(static_cast<uint8>((ConvertedSample >> 8) & 0xFF)); // High byte
+        int32 ChunkSamples = Samples.Num() - SampleOffset;
+        if (SegmentFrames > 0)
+        {
+            // Segmento cheio e ainda há amostras: troca antes de escrever (nunca cria um segmento vazio)
+            if (FramesInCurrentSegment >= SegmentFrames && !BeginNextSegment())
+            {
+                break; // Próximo take não abriu: o restante do frame é descartado
+            }
+            ChunkSamples = (int32)FMath::Min<int64>(ChunkSamples, (SegmentFrames - FramesInCurrentSegment) * NumChannels);
+        }
+
+        SubmitSamples(Samples.GetData() + SampleOffset, ChunkSamples);
+        FramesInCurrentSegment += ChunkSamples / NumChannels;
+        SampleOffset += ChunkSamples;
     }
-    
-    // Enfileira os bytes brutos para o worker thread escrever no pipe
-    DataQueue.Enqueue(MoveTemp(RawBytes));
-    
-    if (NewFrameEvent) { NewFrameEvent->Trigger(); } 
+    FramesInFlight.Decrement();
 
     // *********************************************************************************
     // CORREÇÃO CRÍTICA: LIBERAR O FIAR_AudioFrameData DE VOLTA PARA O POOL
@@ -513,6 +1346,51 @@ bool UIARAudioEncoder::EncodeFrame(TSharedPtr<FIAR_AudioFrameData> Frame)
     return true;
 }
 
+FIAR_EncoderQueueStats UIARAudioEncoder::GetQueueStats() const
+{
+    if (bUseNativeWavWriter)
+    {
+        // Sem pipe nem journal: a fila é a do escritor de WAV
+        FIAR_EncoderQueueStats Stats;
+        Stats.MemoryQueuedBytes = NativeWavWriter ? NativeWavWriter->GetQueuedBytes() : 0;
+        return Stats;
+    }
+    return EncoderWorker ? EncoderWorker->GetQueueStats() : FIAR_EncoderQueueStats();
+}
+
+void UIARAudioEncoder::SubmitSamples(const float* Samples, int32 NumSamples)
+{
+    // Converte os dados float para o formato de gravação (BitDepth),
+    // direto em um bloco reaproveitado do pool (devolvido pelo worker/escritor após a escrita)
+    TArray<uint8> RawBytes = EncodedBlockPool.Acquire(NumSamples * SampleConverter.GetBytesPerSample());
+    SampleConverter.Convert(Samples, NumSamples, RawBytes.GetData());
+
+    if (bUseNativeWavWriter)
+    {
+        // Escrita em processo: a thread de I/O do escritor grava os bytes no arquivo
+        if (!NativeWavWriter || (!NativeWavWriter->EnqueueSamples(MoveTemp(RawBytes)) && NativeWavWriter->HasFailed()))
+        {
+            ReportNativeWriterError();
+        }
+    }
+    else if (EncoderWorker)
+    {
+        // Enfileira os bytes brutos para o worker thread escrever no pipe (o worker contabiliza os bytes não enviados)
+        EncoderWorker->EnqueueData(MoveTemp(RawBytes));
+    }
+}
+
+void UIARAudioEncoder::StopAcceptingFrames()
+{
+    bAcceptingFrames.AtomicSet(false);
+    bNoMoreFramesToEncode.AtomicSet(true);
+    // Um frame que passou pela checagem antes da flag ainda pode estar convertendo ou trocando de segmento
+    while (FramesInFlight.GetValue() > 0)
+    {
+        FPlatformProcess::YieldThread();
+    }
+}
+
 bool UIARAudioEncoder::FinishEncoding()
 {
      if (!bIsInitialized) // FThreadSafeBool implicitamente conversível para bool
@@ -523,15 +1401,33 @@ bool UIARAudioEncoder::FinishEncoding()
 
     UE_LOG(LogIAR, Log, TEXT("Signaling UIARAudioEncoder to finish encoding..."));
 
-    // Sinaliza que não haverá mais frames para codificar
-    bNoMoreFramesToEncode.AtomicSet(true);
+    // Sinaliza que não haverá mais frames para codificar e espera os que já estão dentro de EncodeFrame
+    StopAcceptingFrames();
+    DiscardPreparedSegmentWriter();
+
+    if (NativeWavWriter)
+    {
+        // Esvazia a fila do escritor, corrige o cabeçalho e fecha o arquivo
+        const bool bClosed = NativeWavWriter->Close();
+        const bool bSegmentsClosed = WaitForPendingSegmentCloses();
+        UE_LOG(LogIAR, Log, TEXT("UIARAudioEncoder: Escritor WAV nativo finalizado para '%s'."), *GetCurrentOutputFilePath());
+        CompleteFinalSegment();
+        return bClosed && bSegmentsClosed;
+    }
+
     if (NewFrameEvent) NewFrameEvent->Trigger(); // Acorda a thread para processar quaisquer frames remanescentes na fila
-    // Aguarda ativamente a fila esvaziar para garantir que todos os frames sejam escritos no pipe
-    while (!DataQueue.IsEmpty() && !bStopWorkerThread) // FThreadSafeBool implicitamente conversível para bool
+    // Aguarda até o último byte chegar ao pipe: a fila vazia não basta, o worker pode ter um lote em trânsito
+    while (EncoderWorker && EncoderWorker->GetUnsentBytes() > 0 && !bStopWorkerThread) // FThreadSafeBool implicitamente conversível para bool
     {
         FPlatformProcess::Sleep(0.01f); // Pequena pausa para permitir que o worker processe
     }
 
+    // Modo reator: o registro sai do reator antes do close (o número do descritor pode ser reutilizado por outro pipe)
+    if (EncoderWorker)
+    {
+        EncoderWorker->StopReactive();
+    }
+
     // Fecha o pipe de entrada para sinalizar EOF ao FFmpeg.
     // É crucial fechar o pipe APENAS depois que todos os dados foram escritos.
     if (AudioPipe.IsValid())
@@ -541,6 +1437,48 @@ bool UIARAudioEncoder::FinishEncoding()
     }
     
     UE_LOG(LogIAR, Log, TEXT("UIARAudioEncoder finished sending audio data."));
+    CompleteFinalSegment();
+    return true;
+}
+
+bool UIARAudioEncoder::FinishEncodingAsync(TFunction<void(bool bSuccess)> OnFinished)
+{
+    if (!bIsInitialized || FinishTask.IsValid())
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioEncoder: FinishEncodingAsync ignorado (encoder não inicializado ou já finalizando)."));
+        return false;
+    }
+
+    // Recusa frames novos já nesta chamada: o que chegar depois não entra em nenhum arquivo.
+    // A espera pelos frames em andamento fica com FinishEncoding, na tarefa, para não bloquear quem chamou.
+    bAcceptingFrames.AtomicSet(false);
+    bNoMoreFramesToEncode.AtomicSet(true);
+
+    // ShutdownEncoder aguarda esta tarefa, então o encoder sobrevive a ela
+    FinishTask = Async(EAsyncExecution::ThreadPool, [this, OnFinished = MoveTemp(OnFinished)]() mutable
+    {
+        bool bSuccess = FinishEncoding();
+        if (!bUseNativeWavWriter)
+        {
+            // Os arquivos só estão completos quando o FFmpeg termina de processar o EOF
+            InternalCleanupEncoderResources();
+        }
+
+        const FString OutputFilePath = GetCurrentOutputFilePath();
+        AsyncTask(ENamedThreads::GameThread, [WeakThis = TWeakObjectPtr<UIARAudioEncoder>(this), OnFinished = MoveTemp(OnFinished), bSuccess, OutputFilePath]()
+        {
+            if (!WeakThis.IsValid())
+            {
+                return;
+            }
+            if (OnFinished)
+            {
+                OnFinished(bSuccess);
+            }
+            WeakThis->OnAudioEncodingFinished.Broadcast(OutputFilePath);
+        });
+        return bSuccess;
+    });
     return true;
 }
 
@@ -740,7 +1678,7 @@ bool UIARAudioEncoder::DecodeWaveFileToRawPCM_DrWav(const FString& InputFilePath
 }
 
 // NOVO: Implementação da função estática para codificação de PCM bruto para WAV usando dr_wav
-bool UIARAudioEncoder::EncodeRawPCMToFile(const TArray<float>& RawPCMData, int32 SampleRate, int32 NumChannels, const FString& OutputFilePath, int32 BitDepth)
+bool UIARAudioEncoder::EncodeRawPCMToFile(const TArray<float>& RawPCMData, int32 SampleRate, int32 NumChannels, const FString& OutputFilePath, int32 BitDepth, bool bApplyDither)
 {
     if (RawPCMData.Num() == 0)
     {
@@ -753,11 +1691,11 @@ bool UIARAudioEncoder::EncodeRawPCMToFile(const TArray<float>& RawPCMData, int32
         return false;
     }
 
-    // Atualmente, esta implementação foca em 16-bit PCM para WAV.
-    // Expansão para outras profundidades de bit ou formatos exigiria mais lógica.
-    if (BitDepth != 16)
+    // PCM inteiro de 16, 24 ou 32 bits
+    EIARSampleFormat SampleFormat;
+    if (!FIARSampleFormatConverter::FormatFromBitDepth(BitDepth, false, SampleFormat))
     {
-        UE_LOG(LogIARAudioEncoder, Error, TEXT("EncodeRawPCMToFile: A profundidade de bits suportada para dr_wav é atualmente apenas 16-bit para esta função."));
+        UE_LOG(LogIARAudioEncoder, Error, TEXT("EncodeRawPCMToFile: Profundidade de bits %d não suportada (use 16, 24 ou 32)."), BitDepth);
         return false;
     }
 
@@ -772,14 +1710,12 @@ bool UIARAudioEncoder::EncodeRawPCMToFile(const TArray<float>& RawPCMData, int32
     // Converte FString para std::string, necessário para dr_wav
     std::string OutputFilePathStd = TCHAR_TO_UTF8(*OutputFilePath);
 
-    // Prepara os dados: dr_wav espera int16 para PCM_S16LE. Converte de float (-1.0 a 1.0) para int16.
-    TArray<drwav_int16> PCM16BitAudio;
-    PCM16BitAudio.SetNumUninitialized(RawPCMData.Num());
-    for (int32 i = 0; i < RawPCMData.Num(); ++i)
-    {
-        // Clampa o float para o range de -1.0 a 1.0 e converte para int16
-        PCM16BitAudio[i] = FMath::Clamp(RawPCMData[i], -1.0f, 1.0f) * 32767.0f;
-    }
+    // Prepara os dados: converte de float (-1.0 a 1.0) para o PCM inteiro little-endian da profundidade pedida
+    FIARSampleFormatConverter Converter(SampleFormat, bApplyDither);
+    TArray<uint8> PCMBytes;
+    PCMBytes.SetNumUninitialized(RawPCMData.Num() * Converter.GetBytesPerSample());
+    Converter.Convert(RawPCMData.GetData(), RawPCMData.Num(), PCMBytes.GetData());
+    const drwav_uint64 NumFrames = (drwav_uint64)(RawPCMData.Num() / NumChannels);
 
     // Inicializa o escritor de arquivos WAV
     if (!drwav_init_file_write(&WavWriter, OutputFilePathStd.c_str(), &Format, NULL))
@@ -789,11 +1725,11 @@ bool UIARAudioEncoder::EncodeRawPCMToFile(const TArray<float>& RawPCMData, int32
     }
 
     // Escreve os frames PCM no arquivo
-    drwav_uint64 FramesWritten = drwav_write_pcm_frames(&WavWriter, PCM16BitAudio.Num() / Format.channels, PCM16BitAudio.GetData());
+    drwav_uint64 FramesWritten = drwav_write_pcm_frames(&WavWriter, NumFrames, PCMBytes.GetData());
     drwav_uninit(&WavWriter); // Libera os recursos do dr_wav
 
     // Verifica se todos os frames foram escritos com sucesso
-    if (FramesWritten != (drwav_uint64)PCM16BitAudio.Num() / Format.channels)
+    if (FramesWritten != NumFrames)
     {
         UE_LOG(LogIARAudioEncoder, Error, TEXT("EncodeRawPCMToFile: Falha ao escrever todos os frames de áudio para o arquivo WAV: %s"), *OutputFilePath);
         return false;
@@ -808,12 +1744,12 @@ void UIARAudioEncoder::InternalCleanupEncoderResources()
 {
     UE_LOG(LogIAR, Log, TEXT("Cleaning up audio encoder internal resources..."));
 
-    // Apenas fecha o pipe se ele ainda estiver aberto (FinishEncoding já o faz).
+    // Fecha o pipe se ele ainda estiver aberto (FinishEncoding já o faz) e remove o FIFO, mesmo se o FFmpeg nunca o abriu.
     if (AudioPipe.IsValid())
     {
-        AudioPipe.Close();
         UE_LOG(LogIAR, Log, TEXT("Audio input pipe explicitly closed during cleanup. "));
     }
+    AudioPipe.Close();
 
     // Limpa e deleta os leitores de log do FFmpeg (stdout e stderr)
     if (FFmpegStdoutLogReader)
@@ -855,6 +1791,9 @@ void UIARAudioEncoder::InternalCleanupEncoderResources()
         FFmpegProcessHandle.Reset();
     }
 
+    // Com o processo encerrado todos os arquivos de segmento estão fechados
+    ConfirmClosedSegments(true);
+
     // Garante que os handles de escrita dos pipes sejam nulos após o processo FFmpeg ter sido terminado
     FFmpegWritePipeStdout = nullptr;
     FFmpegWritePipeStderr = nullptr;
@@ -874,6 +1813,9 @@ void UIARAudioEncoder::CheckPipeCongestionStatus()
         return;
     }
 
+    // Aproveita o timer para confirmar os segmentos que o FFmpeg já fechou
+    ConfirmClosedSegments(false);
+
     bool bWorkerCongested = EncoderWorker->IsPipeCurrentlyCongested();
 
     // Usamos a flag interna do encoder para evitar broadcast excessivo
@@ -881,11 +1823,11 @@ void UIARAudioEncoder::CheckPipeCongestionStatus()
     if (bWorkerCongested && !bIsPipeCurrentlyCongestedInternal)
     {
         bIsPipeCurrentlyCongestedInternal.AtomicSet(true);
-        OnAudioPipeCongested.Broadcast(CurrentOutputFilePath);
+        OnAudioPipeCongested.Broadcast(GetCurrentOutputFilePath());
     }
     else if (!bWorkerCongested && bIsPipeCurrentlyCongestedInternal)
     {
         bIsPipeCurrentlyCongestedInternal.AtomicSet(false);
-        OnAudioPipeCleared.Broadcast(CurrentOutputFilePath);
+        OnAudioPipeCleared.Broadcast(GetCurrentOutputFilePath());
     }
 }
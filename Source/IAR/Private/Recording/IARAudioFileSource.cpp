@@ -13,14 +13,15 @@
 #include "HAL/PlatformFileManager.h" // ADICIONADO: Para verificar existência de arquivo
 #include "../GlobalStatics.h" // ADICIONADO: Para obter o caminho raiz de gravações
 #include "Async/Async.h" // Para AsyncTask (se fosse necessário para o LoadFileAsync)
+#include "Core/IARClockedProducer.h" // Thread produtora que substitui o timer da Game Thread
 #include "Engine/World.h"
 
 UIARAudioFileSource::UIARAudioFileSource()
     : UIARAudioSource()
     // , LoadedSoundWave(nullptr) // Removido
-    , CurrentSampleIndex(0)
     , NumSamplesPerFrame(0)
     , bIsFileLoaded(false)
+    , bCancelWaveformSummary(false)
 {
     UE_LOG(LogIAR, Log, TEXT("UIARAudioFileSource: Construtor chamado."));
 }
@@ -54,8 +55,7 @@ void UIARAudioFileSource::Initialize(FIAR_AudioStreamSettings& StreamSettings, U
 
     // O carregamento real do arquivo será feito de forma assíncrona ou no StartCapture, não no Initialize
     bIsFileLoaded = false;
-    RawAudioSamples.Empty(); // Garante que esteja limpo
-    CurrentSampleIndex = 0;
+    WavReader.Close(); // Garante que esteja limpo
 
     UE_LOG(LogIAR, Log, TEXT("UIARAudioFileSource: Inicializado para carregar arquivo '%s' (PATH: %s)."), *CurrentStreamSettings.FilePath, *FullDiskFilePathInternal);
 }
@@ -79,22 +79,37 @@ void UIARAudioFileSource::StartCapture()
         return;
     }
 
-    if (RawAudioSamples.Num() == 0 || !GetWorld())
+    FIARClockedProducer* Producer = FIARClockedProducer::Get();
+    if (!WavReader.IsOpen() || !Producer)
     {
-        UE_LOG(LogIAR, Error, TEXT("UIARAudioFileSource: Dados de audio vazios ou World inválido. Não é possível iniciar a captura."));
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioFileSource: Dados de audio vazios ou thread produtora indisponível. Não é possível iniciar a captura."));
         return;
     }
 
     Super::StartCapture();
 
-    // Inicia o timer para processar o arquivo em chunks
-    GetWorld()->GetTimerManager().SetTimer(
-        AudioFileProcessTimerHandle,
-        this,
-        &UIARAudioFileSource::ProcessFileFrame,
-        0.02f, // Intervalo de 20ms para processar frames
-        true // Repetir
-    );
+    // Blocos de 20ms produzidos fora da Game Thread (hitches do jogo não atrasam nem agrupam frames).
+    // O timestamp vem sempre do relógio de amostras do arquivo, qualquer que seja o ritmo de entrega.
+    const int32 SampleRate = CurrentStreamSettings.SampleRate;
+    const int32 FramesPerBlock = NumSamplesPerFrame / CurrentStreamSettings.NumChannels;
+    auto ProduceBlock = [this, SampleRate, FramesPerBlock](int64 BlockIndex, double StreamTimeSeconds)
+    {
+        ProcessFileFrame((double)BlockIndex * FramesPerBlock / SampleRate);
+    };
+
+    int32 RegistrationId = 0;
+    if (CurrentStreamSettings.bProcessAsFastAsPossible)
+    {
+        // Offline: sem relógio, um frame a cada vez que o pipeline tem capacidade
+        RegistrationId = Producer->RegisterUnpaced(SampleRate, FramesPerBlock, [this]() { return !DownstreamCapacityQuery || DownstreamCapacityQuery(); }, MoveTemp(ProduceBlock));
+    }
+    else
+    {
+        // PlaybackSpeed acelera/desacelera o relógio de entrega (o conteúdo e os timestamps não mudam)
+        const int32 PacedSampleRate = FMath::Max(1, FMath::RoundToInt(SampleRate * FMath::Max(CurrentStreamSettings.PlaybackSpeed, 0.01f)));
+        RegistrationId = Producer->Register(PacedSampleRate, FramesPerBlock, MoveTemp(ProduceBlock));
+    }
+    ProducerRegistrationId.Set(RegistrationId);
     UE_LOG(LogIAR, Log, TEXT("UIARAudioFileSource: Captura de áudio de arquivo iniciada."));
 }
 
@@ -106,9 +121,11 @@ void UIARAudioFileSource::StopCapture()
         return;
     }
 
-    if (GetWorld())
+    // Set(0) devolve o id anterior: só uma chamada remove o registro (StopCapture pode vir da thread produtora no fim do arquivo)
+    const int32 RegistrationId = ProducerRegistrationId.Set(0);
+    if (RegistrationId != 0)
     {
-        GetWorld()->GetTimerManager().ClearTimer(AudioFileProcessTimerHandle);
+        FIARClockedProducer::Get()->Unregister(RegistrationId);
     }
 
     Super::StopCapture();
@@ -125,9 +142,18 @@ void UIARAudioFileSource::Shutdown()
 
 void UIARAudioFileSource::ResetFileSource()
 {
-    RawAudioSamples.Empty();
-    CurrentSampleIndex = 0;
+    // O resumo em construção usa este objeto: interrompe e espera antes de limpar
+    if (WaveformSummaryTask.IsValid())
+    {
+        bCancelWaveformSummary.AtomicSet(true);
+        WaveformSummaryTask.Wait();
+        WaveformSummaryTask = TFuture<void>();
+    }
+    bCancelWaveformSummary.AtomicSet(false);
+
+    WavReader.Close();
     bIsFileLoaded = false;
+    WaveformSummary.Reset(0, 0);
     // LoadedSoundWave = nullptr; // Removido
     FullDiskFilePathInternal = TEXT("");
     UE_LOG(LogIAR, Log, TEXT("UIARAudioFileSource: Fonte de arquivo resetada."));
@@ -155,15 +181,15 @@ bool UIARAudioFileSource::Internal_LoadAudioFileBlocking()
         return false;
     }
 
-    int32 ActualSampleRate = 0;
-    int32 ActualNumChannels = 0;
-    // *** NOVA CHAMADA COM DR_WAV ***
-    if (!UIARAudioEncoder::DecodeWaveFileToRawPCM_DrWav(FullDiskFilePathInternal, RawAudioSamples, ActualSampleRate, ActualNumChannels))
+    // Apenas o cabeçalho é lido aqui: as amostras são convertidas sob demanda durante a reprodução
+    if (!WavReader.Open(FullDiskFilePathInternal))
     {
-        UE_LOG(LogIAR, Error, TEXT("UIARAudioFileSource: Falha ao decodificar o arquivo de audio '%s' usando DrWav."), *FullDiskFilePathInternal);
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioFileSource: Falha ao abrir o arquivo de audio '%s' usando DrWav."), *FullDiskFilePathInternal);
         bIsFileLoaded = false;
         return false;
     }
+    const int32 ActualSampleRate = WavReader.GetSampleRate();
+    const int32 ActualNumChannels = WavReader.GetNumChannels();
 
     // Opcional: Validar se as configurações do stream correspondem ao arquivo
     // Se o arquivo WAV tiver uma taxa de amostragem ou número de canais diferente do esperado,
@@ -176,24 +202,54 @@ bool UIARAudioFileSource::Internal_LoadAudioFileBlocking()
         CurrentStreamSettings.NumChannels = ActualNumChannels;
     }
     
-    // Define o número de samples por frame a serem lidos por iteração.
+    // Define o número de samples por frame a serem lidos por iteração (frames inteiros, 20ms).
     // Garanta que seja baseado nas configurações ATUALIZADAS.
-    NumSamplesPerFrame = FMath::RoundToInt(CurrentStreamSettings.SampleRate * CurrentStreamSettings.NumChannels * 0.02f); 
-    if (NumSamplesPerFrame <= 0) NumSamplesPerFrame = 4096; // Garante um valor mínimo
+    const int32 FramesPerBlock = FMath::Max(1, FMath::RoundToInt(CurrentStreamSettings.SampleRate * 0.02f));
+    NumSamplesPerFrame = FramesPerBlock * CurrentStreamSettings.NumChannels;
+
+    // O resumo da waveform é construído em background, com um leitor próprio sobre o mesmo mapeamento:
+    // a reprodução não espera a leitura do arquivo inteiro
+    WaveformSummary.Reset(CurrentStreamSettings.SampleRate, CurrentStreamSettings.NumChannels);
+    bCancelWaveformSummary.AtomicSet(false);
+    WaveformSummaryTask = Async(EAsyncExecution::ThreadPool, [this, FilePath = FullDiskFilePathInternal]()
+    {
+        BuildWaveformSummary(FilePath);
+    });
 
-    CurrentSampleIndex = 0; // Começa do início do arquivo
     bIsFileLoaded = true;
 
-    UE_LOG(LogIAR, Log, TEXT("UIARAudioFileSource: Arquivo de áudio '%s' carregado do disco com sucesso usando DrWav. SR: %d, Ch: %d, Samples Total: %d."),
-        *FullDiskFilePathInternal, CurrentStreamSettings.SampleRate, CurrentStreamSettings.NumChannels, RawAudioSamples.Num());
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioFileSource: Arquivo de áudio '%s' aberto com sucesso usando DrWav (%s). SR: %d, Ch: %d, Frames Total: %lld."),
+        *FullDiskFilePathInternal, WavReader.IsMapped() ? TEXT("mapeado") : TEXT("E/S sob demanda"), CurrentStreamSettings.SampleRate, CurrentStreamSettings.NumChannels, WavReader.GetNumFrames());
     return true;
 }
 
+void UIARAudioFileSource::BuildWaveformSummary(const FString& FilePath)
+{
+    FIARMappedWavReader SummaryReader;
+    if (!SummaryReader.Open(FilePath))
+    {
+        return;
+    }
 
-void UIARAudioFileSource::ProcessFileFrame()
+    constexpr int64 BlockFrames = 65536;
+    TArray<float> Block;
+    Block.SetNumUninitialized(BlockFrames * SummaryReader.GetNumChannels());
+    while (!bCancelWaveformSummary)
+    {
+        const int64 FramesRead = SummaryReader.ReadFrames(Block.GetData(), BlockFrames);
+        if (FramesRead <= 0)
+        {
+            break;
+        }
+        WaveformSummary.AppendInterleaved(Block.GetData(), FramesRead * SummaryReader.GetNumChannels());
+    }
+}
+
+
+void UIARAudioFileSource::ProcessFileFrame(double StreamTimeSeconds)
 {
     // NOVO: Adicionado 'this->' para garantir que os membros da classe sejam acessados corretamente
-    if (!this->bIsCapturing || this->RawAudioSamples.Num() == 0 || !this->FramePool || !this->FramePool->IsValidLowLevelFast())
+    if (!this->bIsCapturing || !this->WavReader.IsOpen() || !this->FramePool || !this->FramePool->IsValidLowLevelFast())
     {
         this->StopCapture(); // Para a captura se não houver mais dados ou FramePool for inválido
         return;
@@ -206,48 +262,42 @@ void UIARAudioFileSource::ProcessFileFrame()
         return;
     }
 
-    TArray<float>& FrameSamples = *(AudioFrame->RawSamplesPtr);
-    FrameSamples.SetNum(this->NumSamplesPerFrame);
-
-    int32 SamplesToRead = this->NumSamplesPerFrame;
+    const int32 NumChannels = this->CurrentStreamSettings.NumChannels;
+    const int64 FramesPerBlock = this->NumSamplesPerFrame / NumChannels;
     bool bLooping = this->CurrentStreamSettings.bLoopPlayback; // Assume a propriedade bLoopPlayback das settings
-    // Copia os samples do arquivo para o frame
-    for (int32 i = 0; i < SamplesToRead; ++i)
+
+    // Converte direto do arquivo mapeado para o frame; em loop, volta ao início quando o arquivo acaba
+    TArray<float>& FrameSamples = *(AudioFrame->RawSamplesPtr);
+    FrameSamples.SetNumUninitialized(this->NumSamplesPerFrame, EAllowShrinking::No);
+    int64 FramesFilled = 0;
+    bool bReachedEnd = false;
+    while (FramesFilled < FramesPerBlock)
     {
-        int32 SourceIndex = (this->CurrentSampleIndex + i);
-        if (SourceIndex >= this->RawAudioSamples.Num())
+        FramesFilled += this->WavReader.ReadFrames(FrameSamples.GetData() + FramesFilled * NumChannels, FramesPerBlock - FramesFilled);
+        if (FramesFilled < FramesPerBlock && (!bLooping || !this->WavReader.SeekToFrame(0)))
         {
-            if (bLooping)
-            {
-                // Loop: reseta o índice e continua lendo
-                this->CurrentSampleIndex = 0;
-                SourceIndex = 0;
-            }
-            else
-            {
-                // Não há mais dados e não está em loop, preenche com zero e para
-                FrameSamples[i] = 0.0f;
-                SamplesToRead = i; // Ajusta o tamanho do frame para o que foi realmente lido
-                break;
-            }
+            bReachedEnd = true;
+            break;
         }
-        FrameSamples[i] = this->RawAudioSamples[SourceIndex];
     }
     
     // Ajusta o tamanho do frame para o que foi realmente preenchido
-    FrameSamples.SetNum(SamplesToRead);
-
-    this->CurrentSampleIndex += SamplesToRead; // Avança o índice para a próxima leitura
+    FrameSamples.SetNum(FramesFilled * NumChannels, EAllowShrinking::No);
 
-    // Se o índice atingiu o final do arquivo e não está em loop, para a captura
-    if (this->CurrentSampleIndex >= this->RawAudioSamples.Num() && !bLooping)
+    // Se o arquivo acabou e não está em loop, para a captura
+    if (bReachedEnd || (!bLooping && this->WavReader.GetCursorFrame() >= this->WavReader.GetNumFrames()))
     {
         this->StopCapture();
     }
+    if (FramesFilled == 0)
+    {
+        this->FramePool->ReleaseFrame(AudioFrame);
+        return;
+    }
 
     AudioFrame->SampleRate = this->CurrentStreamSettings.SampleRate;
     AudioFrame->NumChannels = this->CurrentStreamSettings.NumChannels;
-    AudioFrame->Timestamp = UGameplayStatics::GetTimeSeconds(this);
+    AudioFrame->Timestamp = (float)StreamTimeSeconds;
     AudioFrame->CurrentStreamSettings = this->CurrentStreamSettings;
 
     this->OnAudioFrameAcquired.Broadcast(AudioFrame);
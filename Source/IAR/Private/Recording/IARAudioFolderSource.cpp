@@ -8,12 +8,17 @@
 #include "Recording/IARAudioFolderSource.h"
 #include "Misc/Paths.h"
 #include "HAL/PlatformFileManager.h"
-#include "HAL/FileManager.h" // <<-- ADICIONADO: Necessário para IFileManager::Get().FindFilesRecursive
+#include "HAL/PlatformProcess.h"
 #include "Async/Async.h" // Para AsyncTask e TAtomic
+#include "Misc/ScopeLock.h"
 #include "Kismet/GameplayStatics.h" // Para GetWorld() em contextos UObject (se necessário)
 
 // Inclusões dos componentes do IAR necessários para as conversões
-#include "Recording/IARAudioEncoder.h"       // Para decodificação/codificação de áudio (dr_wav, FFmpeg)
+#include "Recording/IARStreamingAudioDecoder.h" // Para decodificação em streaming (áudio -> frames do pool)
+#include "Recording/IARMappedWavReader.h"     // Para ler WAV em blocos quando o FFmpeg não está disponível
+#include "Recording/IARWavStreamWriter.h"     // Para escrever o áudio sintetizado em streaming
+#include "Core/IARSampleFormatConverter.h"
+#include "Core/IARByteBlockPool.h"
 #include "AudioAnalysis/IARAudioToMIDITranscriber.h" // Para transcrição de Áudio para MIDI
 #include "AudioAnalysis/IARMIDIToAudioSynthesizer.h" // Para síntese de MIDI para Áudio
 #include "Recording/IARMIDIFileSource.h"     // Para carregar arquivos MIDI (.mid)
@@ -31,9 +36,42 @@ DEFINE_LOG_CATEGORY_STATIC(LogIARFolderSource, Log, All);
 // Define o namespace smf para evitar a necessidade de prefixar tudo com smf::
 using namespace smf; // <<-- ADICIONADO
 
+namespace IARFolderSourcePrivate
+{
+    // Formato em que o FFmpeg entrega o áudio para a transcrição (estéreo; mixado para mono na análise)
+    constexpr int32 DecodeSampleRate = 44100;
+    constexpr int32 DecodeNumChannels = 2;
+    // Formato do áudio sintetizado na conversão MIDI -> Áudio
+    constexpr int32 SynthSampleRate = 48000;
+    constexpr int32 SynthNumChannels = 2;
+
+    // Arquivo do manifesto de conversões, na pasta de saída
+    const TCHAR* const ManifestFileName = TEXT("IAR_ConversionManifest.tsv");
+    // Intervalo mínimo entre gravações do manifesto durante o lote (ele é sempre gravado no fim)
+    constexpr double ManifestSaveIntervalSeconds = 30.0;
+    // Incrementar quando a lógica de conversão mudar: invalida todas as saídas registradas
+    // (v2: WAV analisado no formato de decodificação, como o MP3)
+    constexpr int32 ConversionLogicVersion = 2;
+
+    // Pipeline MIDI -> Áudio: blocos PCM de tamanho fixo e limite de bytes esperando a thread de escrita
+    constexpr int32 SynthWriteBlockBytes = 64 * 1024;
+    constexpr int64 SynthMaxQueuedWriteBytes = 16 * SynthWriteBlockBytes;
+    constexpr int32 SynthOutputBitDepth = 16;
+    // Espera máxima de um worker ocioso entre verificações da varredura
+    constexpr uint32 DiscoveryWaitMs = 5;
+
+    // Classifica pela extensão: áudio (.wav/.mp3) vira MIDI, MIDI (.mid) vira áudio
+    bool ClassifyInputFile(const FString& FilePath, bool& bOutIsAudioFile)
+    {
+        const FString FileExtension = FPaths::GetExtension(FilePath).ToLower();
+        bOutIsAudioFile = (FileExtension == TEXT("wav") || FileExtension == TEXT("mp3"));
+        return bOutIsAudioFile || FileExtension == TEXT("mid");
+    }
+}
+
 UIARFolderSource::UIARFolderSource()
     : UIARMediaSource()
-    , CurrentFileIndex(0)
+    , NextFileIndex(0)
     , bProcessingActive(false)
 {
     // Define caminhos padrão que podem ser sobrescritos via Blueprint ou API
@@ -54,8 +92,7 @@ void UIARFolderSource::Initialize(FIAR_AudioStreamSettings& StreamSettings, UIAR
     FPaths::NormalizeDirectoryName(InputFolderPath);
     FPaths::NormalizeDirectoryName(OutputFolderPath);
 
-    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile(); // Não é usado diretamente para FindFilesRecursive
-    IFileManager& FileManager = IFileManager::Get(); // <<-- ADICIONADO
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 
     // Cria o diretório de saída se ele não existir
     if (!PlatformFile.CreateDirectoryTree(*OutputFolderPath))
@@ -65,57 +102,16 @@ void UIARFolderSource::Initialize(FIAR_AudioStreamSettings& StreamSettings, UIAR
         return; // A inicialização falha se não conseguir criar o diretório de saída
     }
 
-    // NOVO: Inicializa o Transcriber e o Feature Processor AQUI na Game Thread
-    if (!Transcriber)
-    {
-        Transcriber = NewObject<UIARAudioToMIDITranscriber>(this);
-        if (Transcriber)
-        {
-            Transcriber->Initialize(StreamSettings.SampleRate); // Use SampleRate da StreamSettings de UIARFolderSource
-        }
-        else
-        {
-            UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao criar UIARAudioToMIDITranscriber na inicialização."));
-        }
-    }
-    else // Já existe, apenas reinicialize se necessário
-    {
-        Transcriber->Initialize(StreamSettings.SampleRate);
-    }
-
-    if (!FeatureProcessor)
-    {
-        // Instancie o Feature Processor específico que você quer usar
-        FeatureProcessor = NewObject<UIARBasicAudioFeatureProcessor>(this); // Ou UIARAdvancedAudioFeatureProcessor
-        if (FeatureProcessor)
-        {
-            FeatureProcessor->Initialize();
-        }
-        else
-        {
-            UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao criar FeatureProcessor na inicialização."));
-        }
-    }
-    else // Já existe, apenas reinicialize
+    if (!PlatformFile.DirectoryExists(*InputFolderPath))
     {
-        FeatureProcessor->Initialize();
+        UE_LOG(LogIARFolderSource, Warning, TEXT("Diretório de entrada não encontrado: %s"), *InputFolderPath);
+        OnFolderProcessingError.Broadcast(FString::Printf(TEXT("Diretório de entrada não encontrado: %s"), *InputFolderPath));
     }
 
-    // Escaneia o diretório de entrada para listar todos os arquivos suportados
-    FilesToProcess.Empty();
-    // Suporte para áudio WAV e MP3
-    FileManager.FindFilesRecursive(FilesToProcess, *InputFolderPath, TEXT("*.wav"), true, false,false); // <<-- CORRIGIDO
-    FileManager.FindFilesRecursive(FilesToProcess, *InputFolderPath, TEXT("*.mp3"), true, false,false); // <<-- CORRIGIDO
-    // Suporte para MIDI
-    FileManager.FindFilesRecursive(FilesToProcess, *InputFolderPath, TEXT("*.mid"), true, false,false); // <<-- CORRIGIDO
-
-    if (FilesToProcess.Num() == 0)
-    {
-        UE_LOG(LogIARFolderSource, Warning, TEXT("Nenhum arquivo de áudio/MIDI suportado encontrado no diretório de entrada: %s"), *InputFolderPath);
-        OnFolderProcessingError.Broadcast(FString::Printf(TEXT("Nenhum arquivo de mídia suportado encontrado em: %s"), *InputFolderPath));
-    }
-    
-    UE_LOG(LogIARFolderSource, Log, TEXT("Inicializado. Encontrados %d arquivos para processar em: %s."), FilesToProcess.Num(), *InputFolderPath);
+    // Os contextos dos workers (transcritor, processador de features e pool) são criados em StartCapture,
+    // quando o número de workers do lote é conhecido. A varredura da pasta de entrada também é feita lá,
+    // em paralelo com as conversões.
+    UE_LOG(LogIARFolderSource, Log, TEXT("Inicializado. Entrada: %s, saída: %s."), *InputFolderPath, *OutputFolderPath);
 }
 
 void UIARFolderSource::StartCapture()
@@ -127,32 +123,98 @@ void UIARFolderSource::StartCapture()
         return;
     }
 
-    // Se não houver arquivos para processar, sinaliza conclusão imediatamente
-    if (FilesToProcess.Num() == 0)
+    // Um lote anterior interrompido pode ainda estar terminando o arquivo em andamento
+    if (BatchTask.IsValid())
+    {
+        BatchTask.Wait();
+    }
+
+    // Número de workers: automático (um por thread de trabalho) ou o limite configurado.
+    // O número de arquivos só é conhecido no fim da varredura: workers sem arquivo terminam quando ela acaba.
+    const int32 RequestedWorkers = (MaxConcurrentConversions > 0) ? MaxConcurrentConversions : FPlatformMisc::NumberOfWorkerThreadsToSpawn();
+    const int32 NumWorkers = FMath::Max(RequestedWorkers, 1);
+    if (!EnsureWorkerContexts(NumWorkers))
     {
-        UE_LOG(LogIARFolderSource, Log, TEXT("Nenhum arquivo para processar. Concluindo imediatamente."));
-        OnFolderProcessingCompleted.Broadcast(OutputFolderPath);
+        OnFolderProcessingError.Broadcast(TEXT("Falha ao criar os contextos de conversão do processamento em lote."));
         return;
     }
 
+    if (bUseConversionManifest)
+    {
+        ConversionManifest.Load(OutputFolderPath / IARFolderSourcePrivate::ManifestFileName, InputFolderPath, OutputFolderPath);
+    }
+    BuildSettingsKeys();
+
     // Define o estado do processamento como ativo
     bProcessingActive.AtomicSet(true);
-    // Reinicia o índice do arquivo atual
-    CurrentFileIndex.Set(0);
+    // Reinicia a fila de arquivos e o progresso ordenado (a lista é preenchida pela varredura)
+    NextFileIndex.Set(0);
+    {
+        FScopeLock Lock(&FileListLock);
+        FilesToProcess.Reset();
+        ClaimedOutputPaths.Reset();
+        bScanComplete = false;
+        FileFinished.Reset();
+        FileErrors.Reset();
+        NextFileToReport = 0;
+    }
+    if (!FilesDiscoveredEvent)
+    {
+        FilesDiscoveredEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    }
     
     Super::StartCapture(); // Chama o método base, que define bIsCapturing = true
 
-    UE_LOG(LogIARFolderSource, Log, TEXT("Iniciando processamento em lote de %d arquivos."), FilesToProcess.Num());
+    UE_LOG(LogIARFolderSource, Log, TEXT("Iniciando processamento em lote de %s com %d workers."), *InputFolderPath, NumWorkers);
     
     // Inicia a tarefa de processamento em uma thread de background para não bloquear a Game Thread
-    // O `[this]` na lambda captura a instância atual de UIARFolderSource para uso na AsyncTask.
-    AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [this]()
+    // O `[this]` na lambda captura a instância atual de UIARFolderSource para uso na tarefa.
+    BatchTask = Async(EAsyncExecution::ThreadPool, [this]()
     {
-        // Chama o método que contém a lógica de processamento síncrona/em lote
+        // Chama o método que dispara os workers e espera o lote terminar
         ProcessFileConversionAsyncTask();
     });
 }
 
+bool UIARFolderSource::EnsureWorkerContexts(int32 NumWorkers)
+{
+    // NewObject só é seguro na Game Thread: os workers apenas usam os objetos criados aqui
+    check(IsInGameThread());
+
+    while (WorkerTranscribers.Num() < NumWorkers)
+    {
+        UIARAudioToMIDITranscriber* NewTranscriber = NewObject<UIARAudioToMIDITranscriber>(this);
+        UIARFeatureProcessor* NewFeatureProcessor = NewObject<UIARBasicAudioFeatureProcessor>(this); // Ou UIARAdvancedAudioFeatureProcessor
+        UIARFramePool* NewDecodeFramePool = NewObject<UIARFramePool>(this);
+        UIARMIDIFileSource* NewMIDIFileSource = NewObject<UIARMIDIFileSource>(this);
+        UIARMIDIToAudioSynthesizer* NewSynthesizer = NewObject<UIARMIDIToAudioSynthesizer>(this);
+        if (!NewTranscriber || !NewFeatureProcessor || !NewDecodeFramePool || !NewMIDIFileSource || !NewSynthesizer)
+        {
+            UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao criar o contexto de conversão do worker %d."), WorkerTranscribers.Num());
+            return false;
+        }
+
+        // Pool próprio para os frames do decodificador em streaming: AcquireFrame tem um único consumidor,
+        // então não pode dividir o FramePool da sessão nem o de outro worker. Frames de 100ms, como os chunks da transcrição.
+        NewDecodeFramePool->InitializePool(FIARStreamingAudioDecoder::DefaultMaxQueuedFrames + 2, IARFolderSourcePrivate::DecodeSampleRate,
+            IARFolderSourcePrivate::DecodeNumChannels, IARFolderSourcePrivate::DecodeSampleRate / 10);
+
+        WorkerTranscribers.Add(NewTranscriber);
+        WorkerFeatureProcessors.Add(NewFeatureProcessor);
+        WorkerDecodeFramePools.Add(NewDecodeFramePool);
+        WorkerMIDIFileSources.Add(NewMIDIFileSource);
+        WorkerSynthesizers.Add(NewSynthesizer);
+    }
+
+    // Aqui o sintetizador cria (e enraíza) o seu USoundWaveProcedural, também depois de um Shutdown anterior;
+    // nos workers, Initialize encontra o SoundWave pronto e só zera as vozes
+    for (UIARMIDIToAudioSynthesizer* WorkerSynthesizer : WorkerSynthesizers)
+    {
+        WorkerSynthesizer->Initialize(IARFolderSourcePrivate::SynthSampleRate, IARFolderSourcePrivate::SynthNumChannels);
+    }
+    return true;
+}
+
 void UIARFolderSource::StopCapture()
 {
     // Verifica se há um processamento ativo para interromper
@@ -171,21 +233,42 @@ void UIARFolderSource::StopCapture()
 
 void UIARFolderSource::Shutdown()
 {
-    StopCapture(); // Garante que qualquer processamento em andamento seja interrompido
-    
-    // NOVO: Desliga e limpa o Transcriber e o Feature Processor AQUI
-    if (Transcriber)
+    if (bProcessingActive)
     {
-        Transcriber->Shutdown();
-        // Não defina Transcriber = nullptr; pois é UPROPERTY() e será limpo pelo GC
+        StopCapture(); // Garante que qualquer processamento em andamento seja interrompido
     }
-    if (FeatureProcessor)
+    // Os workers terminam o arquivo em andamento antes de largar os contextos
+    if (BatchTask.IsValid())
     {
-        FeatureProcessor->Shutdown();
-        // Não defina FeatureProcessor = nullptr; pois é UPROPERTY() e será limpo pelo GC
+        BatchTask.Wait();
+        BatchTask.Reset();
+    }
+
+    // Desliga os contextos dos workers (os objetos são UPROPERTY() e serão limpos pelo GC)
+    for (UIARAudioToMIDITranscriber* WorkerTranscriber : WorkerTranscribers)
+    {
+        if (WorkerTranscriber) { WorkerTranscriber->Shutdown(); }
+    }
+    for (UIARFeatureProcessor* WorkerFeatureProcessor : WorkerFeatureProcessors)
+    {
+        if (WorkerFeatureProcessor) { WorkerFeatureProcessor->Shutdown(); }
+    }
+    for (UIARMIDIFileSource* WorkerMIDIFileSource : WorkerMIDIFileSources)
+    {
+        if (WorkerMIDIFileSource) { WorkerMIDIFileSource->Shutdown(); }
+    }
+    for (UIARMIDIToAudioSynthesizer* WorkerSynthesizer : WorkerSynthesizers)
+    {
+        if (WorkerSynthesizer) { WorkerSynthesizer->Shutdown(); }
     }
     
-    
+
+    if (FilesDiscoveredEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(FilesDiscoveredEvent);
+        FilesDiscoveredEvent = nullptr;
+    }
+
     FilesToProcess.Empty(); // Limpa a lista de arquivos para processamento
     Super::Shutdown(); // Chama o método base para liberar recursos comuns
     UE_LOG(LogIARFolderSource, Log, TEXT("Desligado e recursos liberados."));
@@ -212,92 +295,288 @@ void UIARFolderSource::HandleFolderProcessingProgress(const FString& InCurrentFi
 
 /**
  * @brief Método principal da tarefa assíncrona.
- * Itera sobre os arquivos, determina o tipo de conversão e a executa.
+ * Dispara a varredura (em uma thread própria, pois bloqueia em I/O) e os workers (o primeiro roda nesta
+ * própria tarefa), espera todos e sinaliza a conclusão.
  * Esta função é executada em um thread de background.
  */
 void UIARFolderSource::ProcessFileConversionAsyncTask()
 {
-    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    const int32 NumWorkers = WorkerTranscribers.Num();
 
-    for (int32 i = 0; i < FilesToProcess.Num(); ++i)
+    // Os workers começam assim que o primeiro arquivo é encontrado, sem esperar a varredura terminar
+    TFuture<void> ScanTask = Async(EAsyncExecution::Thread, [this]()
     {
-        // Verifica a flag de interrupção em cada iteração para permitir que StopCapture() funcione
-        if (!bProcessingActive)
+        EnumerateInputFiles();
+    });
+
+    // Auto-escalonamento: cada worker pega o próximo arquivo livre do contador compartilhado,
+    // então arquivos longos não atrasam os curtos que estão atrás deles na lista
+    TArray<TFuture<void>> WorkerTasks;
+    for (int32 WorkerIndex = 1; WorkerIndex < NumWorkers; ++WorkerIndex)
+    {
+        WorkerTasks.Add(Async(EAsyncExecution::ThreadPool, [this, WorkerIndex]()
         {
-            UE_LOG(LogIARFolderSource, Log, TEXT("Processamento interrompido pela requisição do usuário."));
-            break; // Sai do loop se for solicitada a interrupção
-        }
+            RunConversionWorker(WorkerIndex);
+        }));
+    }
+    RunConversionWorker(0);
 
-        FString InputFilePath = FilesToProcess[i];
-        FString CurrentFileName = FPaths::GetBaseFilename(InputFilePath);
-        float ProgressRatio = (float)(i + 1) / FilesToProcess.Num();
+    for (TFuture<void>& WorkerTask : WorkerTasks)
+    {
+        WorkerTask.Wait();
+    }
+    ScanTask.Wait();
 
-        // Broadcast do progresso para a Game Thread (UI, logs, etc.)
-        AsyncTask(ENamedThreads::GameThread, [this, CurrentFileName, ProgressRatio]()
+    int32 NumFiles = 0;
+    {
+        FScopeLock Lock(&FileListLock);
+        NumFiles = FilesToProcess.Num();
+    }
+    if (NumFiles == 0 && bProcessingActive)
+    {
+        UE_LOG(LogIARFolderSource, Warning, TEXT("Nenhum arquivo de áudio/MIDI suportado encontrado no diretório de entrada: %s"), *InputFolderPath);
+        AsyncTask(ENamedThreads::GameThread, [this]()
         {
-            OnFolderProcessingProgress.Broadcast(CurrentFileName, ProgressRatio);
+            OnFolderProcessingError.Broadcast(FString::Printf(TEXT("Nenhum arquivo de mídia suportado encontrado em: %s"), *InputFolderPath));
         });
+    }
+
+    if (!bProcessingActive)
+    {
+        UE_LOG(LogIARFolderSource, Log, TEXT("Processamento interrompido pela requisição do usuário."));
+    }
 
-        UE_LOG(LogIARFolderSource, Log, TEXT("Processando arquivo: %s (%d/%d)"), *InputFilePath, i + 1, FilesToProcess.Num());
+    // Mesmo um lote interrompido guarda as conversões concluídas até aqui
+    if (bUseConversionManifest)
+    {
+        ConversionManifest.Save();
+    }
 
-        // Determina o tipo de arquivo com base na extensão
-        FString FileExtension = FPaths::GetExtension(InputFilePath).ToLower();
-        bool bIsAudioFile = (FileExtension == TEXT("wav") || FileExtension == TEXT("mp3"));
-        bool bIsMIDIFile = (FileExtension == TEXT("mid"));
+    // Sinaliza o término do processamento na Game Thread, independentemente de ter sido concluído ou interrompido
+    AsyncTask(ENamedThreads::GameThread, [this]()
+    {
+        bProcessingActive.AtomicSet(false); // Define o estado como inativo
+        Super::StopCapture(); // Chama o método base para finalizar (define bIsCapturing = false)
+        OnFolderProcessingCompleted.Broadcast(OutputFolderPath); // Dispara o delegate de conclusão
+        UE_LOG(LogIARFolderSource, Log, TEXT("Processamento em lote concluído (ou interrompido)."));
+    });
+}
+
+void UIARFolderSource::EnumerateInputFiles()
+{
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    const double ScanStartTime = FPlatformTime::Seconds();
 
-        if (bIsAudioFile)
+    // A pasta de saída dentro da de entrada não é percorrida: os arquivos gerados pelo lote não são entradas
+    const bool bSkipOutputFolder = !FPaths::IsSamePath(OutputFolderPath, InputFolderPath) && FPaths::IsUnderDirectory(OutputFolderPath, InputFolderPath);
+
+    // Uma única passada: cada diretório é listado uma vez e as entradas são classificadas pela extensão na hora
+    TArray<FString> PendingDirectories;
+    PendingDirectories.Add(InputFolderPath);
+    while (PendingDirectories.Num() > 0 && bProcessingActive)
+    {
+        const FString Directory = PendingDirectories.Pop(EAllowShrinking::No);
+        PlatformFile.IterateDirectory(*Directory, [this, &PendingDirectories, bSkipOutputFolder](const TCHAR* FilenameOrDirectory, bool bIsDirectory)
         {
-            FString MIDIOutputFilePath = GetOutputFilePath(InputFilePath, true); // True para áudio -> MIDI
-            if (!PlatformFile.FileExists(*MIDIOutputFilePath) || bOverwriteExistingFiles)
+            if (bIsDirectory)
             {
-                if (!ConvertAudioToMIDI(InputFilePath, MIDIOutputFilePath))
+                if (!bSkipOutputFolder || !FPaths::IsSamePath(FilenameOrDirectory, OutputFolderPath))
                 {
-                    // Reporta o erro para a Game Thread
-                    AsyncTask(ENamedThreads::GameThread, [this, InputFilePath]()
-                    {
-                        OnFolderProcessingError.Broadcast(FString::Printf(TEXT("Falha ao converter Áudio para MIDI para: %s"), *InputFilePath));
-                    });
+                    PendingDirectories.Emplace(FilenameOrDirectory);
                 }
             }
             else
             {
-                UE_LOG(LogIARFolderSource, Warning, TEXT("Pulando %s: arquivo MIDI de saída já existe e sobrescrita desabilitada."), *InputFilePath);
+                bool bIsAudioFile = false;
+                const FString FilePath(FilenameOrDirectory);
+                if (IARFolderSourcePrivate::ClassifyInputFile(FilePath, bIsAudioFile))
+                {
+                    AddDiscoveredFile(FilePath, bIsAudioFile);
+                }
             }
+            return (bool)bProcessingActive; // Interrompe a listagem junto com o lote
+        });
+    }
+
+    int32 NumFiles = 0;
+    {
+        FScopeLock Lock(&FileListLock);
+        bScanComplete = true;
+        NumFiles = FilesToProcess.Num();
+    }
+    FilesDiscoveredEvent->Trigger();
+
+    UE_LOG(LogIARFolderSource, Log, TEXT("Varredura de %s concluída: %d arquivos em %.2f s."), *InputFolderPath, NumFiles, FPlatformTime::Seconds() - ScanStartTime);
+}
+
+void UIARFolderSource::AddDiscoveredFile(const FString& InputFilePath, bool bIsAudioFile)
+{
+    {
+        FScopeLock Lock(&FileListLock);
+        // Com entrada e saída na mesma pasta, uma saída recém-gerada pode aparecer na listagem em andamento
+        if (ClaimedOutputPaths.Contains(InputFilePath))
+        {
+            return;
         }
-        else if (bIsMIDIFile)
+        // As saídas vão todas para OutputFolderPath pelo nome base: a/x.wav e b/x.wav (ou x.wav e x.mp3) gerariam o mesmo
+        // arquivo, escrito por dois workers ao mesmo tempo e registrado no manifesto para duas entradas. Só a primeira é convertida.
+        FString OutputFilePath = GetOutputFilePath(InputFilePath, bIsAudioFile);
+        if (ClaimedOutputPaths.Contains(OutputFilePath))
         {
-            FString AudioOutputFilePath = GetOutputFilePath(InputFilePath, false); // False para MIDI -> Áudio (será .wav)
-            if (!PlatformFile.FileExists(*AudioOutputFilePath) || bOverwriteExistingFiles)
+            FString ErrorMessage = FString::Printf(TEXT("'%s' ignorado: a saída '%s' já pertence a outro arquivo de entrada."), *InputFilePath, *OutputFilePath);
+            UE_LOG(LogIARFolderSource, Error, TEXT("%s"), *ErrorMessage);
+            AsyncTask(ENamedThreads::GameThread, [this, ErrorMessage = MoveTemp(ErrorMessage)]()
             {
-                if (!ConvertMIDIToAudio(InputFilePath, AudioOutputFilePath))
-                {
-                    // Reporta o erro para a Game Thread
-                    AsyncTask(ENamedThreads::GameThread, [this, InputFilePath]()
-                    {
-                        OnFolderProcessingError.Broadcast(FString::Printf(TEXT("Falha ao converter MIDI para Áudio para: %s"), *InputFilePath));
-                    });
-                }
+                OnFolderProcessingError.Broadcast(ErrorMessage);
+            });
+            return;
+        }
+        ClaimedOutputPaths.Add(MoveTemp(OutputFilePath));
+        FilesToProcess.Add(InputFilePath);
+        FileFinished.Add(false);
+        FileErrors.AddDefaulted();
+    }
+    FilesDiscoveredEvent->Trigger();
+}
+
+bool UIARFolderSource::WaitForDiscoveredFile(int32 FileIndex, FString& OutFilePath)
+{
+    for (;;)
+    {
+        {
+            FScopeLock Lock(&FileListLock);
+            if (FilesToProcess.IsValidIndex(FileIndex))
+            {
+                OutFilePath = FilesToProcess[FileIndex];
+                return true;
             }
-            else
+            if (bScanComplete)
             {
-                 UE_LOG(LogIARFolderSource, Warning, TEXT("Pulando %s: arquivo de Áudio de saída já existe e sobrescrita desabilitada."), *InputFilePath);
+                return false;
             }
         }
+        if (!bProcessingActive)
+        {
+            return false;
+        }
+        // O evento acorda um worker por arquivo encontrado; os demais voltam a verificar pelo timeout
+        FilesDiscoveredEvent->Wait(IARFolderSourcePrivate::DiscoveryWaitMs);
+    }
+}
+
+void UIARFolderSource::RunConversionWorker(int32 WorkerIndex)
+{
+    // Verifica a flag de interrupção antes de cada arquivo para permitir que StopCapture() funcione
+    while (bProcessingActive)
+    {
+        // Increment retorna o novo valor. O índice pode estar à frente da varredura: o worker espera o arquivo ser encontrado.
+        const int32 FileIndex = NextFileIndex.Increment() - 1;
+        FString InputFilePath;
+        if (!WaitForDiscoveredFile(FileIndex, InputFilePath))
+        {
+            break;
+        }
+
+        UE_LOG(LogIARFolderSource, Log, TEXT("Worker %d processando arquivo: %s (#%d)"), WorkerIndex, *InputFilePath, FileIndex + 1);
+        ReportFileFinished(FileIndex, ProcessSingleFile(InputFilePath, WorkerIndex));
+    }
+}
+
+FString UIARFolderSource::ProcessSingleFile(const FString& InputFilePath, int32 WorkerIndex)
+{
+    // Determina o tipo de arquivo com base na extensão
+    bool bIsAudioFile = false;
+    if (!IARFolderSourcePrivate::ClassifyInputFile(InputFilePath, bIsAudioFile))
+    {
+        UE_LOG(LogIARFolderSource, Warning, TEXT("Tipo de arquivo não suportado para conversão: %s"), *InputFilePath);
+        return FString();
+    }
+
+    // True para áudio -> MIDI (.mid); false para MIDI -> Áudio (será .wav)
+    const FString OutputFilePath = GetOutputFilePath(InputFilePath, bIsAudioFile);
+    const FString& SettingsKey = bIsAudioFile ? AudioToMIDISettingsKey : MIDIToAudioSettingsKey;
+    if (!NeedsConversion(InputFilePath, OutputFilePath, SettingsKey))
+    {
+        UE_LOG(LogIARFolderSource, Log, TEXT("Pulando %s: saída '%s' já está atualizada."), *InputFilePath, *OutputFilePath);
+        return FString();
+    }
+
+    const bool bSucceeded = bIsAudioFile ? ConvertAudioToMIDI(InputFilePath, OutputFilePath, WorkerIndex)
+                                         : ConvertMIDIToAudio(InputFilePath, OutputFilePath, WorkerIndex);
+
+    if (bUseConversionManifest)
+    {
+        // Só uma conversão concluída entra no manifesto: uma saída parcial (falha ou crash) é refeita no próximo lote
+        if (bSucceeded)
+        {
+            ConversionManifest.Record(InputFilePath, OutputFilePath, SettingsKey);
+        }
         else
         {
-            UE_LOG(LogIARFolderSource, Warning, TEXT("Tipo de arquivo não suportado para conversão: %s"), *InputFilePath);
+            ConversionManifest.Invalidate(InputFilePath);
         }
-        CurrentFileIndex.Add(1); // <<-- CORRIGIDO: Usando TAtomic::Add(1)
+        ConversionManifest.SaveIfDue(IARFolderSourcePrivate::ManifestSaveIntervalSeconds);
     }
 
-    // Sinaliza o término do processamento na Game Thread, independentemente de ter sido concluído ou interrompido
-    AsyncTask(ENamedThreads::GameThread, [this]()
+    if (!bSucceeded)
     {
-        bProcessingActive.AtomicSet(false); // Define o estado como inativo
-        Super::StopCapture(); // Chama o método base para finalizar (define bIsCapturing = false)
-        OnFolderProcessingCompleted.Broadcast(OutputFolderPath); // Dispara o delegate de conclusão
-        UE_LOG(LogIARFolderSource, Log, TEXT("Processamento em lote concluído (ou interrompido)."));
-    });
+        return bIsAudioFile ? FString::Printf(TEXT("Falha ao converter Áudio para MIDI para: %s"), *InputFilePath)
+                            : FString::Printf(TEXT("Falha ao converter MIDI para Áudio para: %s"), *InputFilePath);
+    }
+    return FString();
+}
+
+bool UIARFolderSource::NeedsConversion(const FString& InputFilePath, const FString& OutputFilePath, const FString& SettingsKey)
+{
+    if (bOverwriteExistingFiles)
+    {
+        return true;
+    }
+    if (!bUseConversionManifest)
+    {
+        return !FPlatformFileManager::Get().GetPlatformFile().FileExists(*OutputFilePath);
+    }
+    return !ConversionManifest.IsUpToDate(InputFilePath, OutputFilePath, SettingsKey);
+}
+
+void UIARFolderSource::BuildSettingsKeys()
+{
+    using namespace IARFolderSourcePrivate;
+
+    // Tudo o que muda o conteúdo das saídas entra na chave; qualquer diferença invalida a entrada do manifesto.
+    // Os parâmetros do transcritor são os padrões da classe: mudanças neles exigem incrementar ConversionLogicVersion.
+    const UIARFeatureProcessor* FeatureProcessor = WorkerFeatureProcessors.Num() > 0 ? WorkerFeatureProcessors[0].Get() : nullptr;
+    AudioToMIDISettingsKey = FString::Printf(TEXT("A2M;v%d;%s;SR=%d;Decode=%dx%d"), ConversionLogicVersion,
+        FeatureProcessor ? *FeatureProcessor->GetClass()->GetName() : TEXT("None"), CurrentStreamSettings.SampleRate, DecodeSampleRate, DecodeNumChannels);
+    MIDIToAudioSettingsKey = FString::Printf(TEXT("M2A;v%d;SR=%d;CH=%d"), ConversionLogicVersion, SynthSampleRate, SynthNumChannels);
+}
+
+void UIARFolderSource::ReportFileFinished(int32 FileIndex, FString&& ErrorMessage)
+{
+    FScopeLock Lock(&FileListLock);
+    FileFinished[FileIndex] = true;
+    FileErrors[FileIndex] = MoveTemp(ErrorMessage);
+
+    // Os arquivos terminam fora de ordem: só avança enquanto o próximo da lista já estiver concluído,
+    // para que a Game Thread receba o progresso (e os erros) na mesma ordem do processamento serial
+    while (NextFileToReport < FilesToProcess.Num() && FileFinished[NextFileToReport])
+    {
+        const int32 ReportIndex = NextFileToReport++;
+        FString CurrentFileName = FPaths::GetBaseFilename(FilesToProcess[ReportIndex]);
+        // Enquanto a varredura não termina, a proporção é relativa aos arquivos encontrados até o momento
+        float ProgressRatio = (float)(ReportIndex + 1) / FilesToProcess.Num();
+        FString FileError = MoveTemp(FileErrors[ReportIndex]);
+
+        // Os AsyncTask postados sob o lock chegam à Game Thread na ordem em que foram postados
+        AsyncTask(ENamedThreads::GameThread, [this, CurrentFileName = MoveTemp(CurrentFileName), ProgressRatio, FileError = MoveTemp(FileError)]()
+        {
+            if (!FileError.IsEmpty())
+            {
+                OnFolderProcessingError.Broadcast(FileError);
+            }
+            OnFolderProcessingProgress.Broadcast(CurrentFileName, ProgressRatio);
+        });
+    }
 }
 
 /**
@@ -316,71 +595,35 @@ FString UIARFolderSource::GetOutputFilePath(const FString& InputFilePath, bool b
 
 /**
  * @brief Implementa a lógica para converter um arquivo de áudio (.wav ou .mp3) para MIDI (.mid).
- * Utiliza UIARAudioEncoder para decodificação e UIARAudioToMIDITranscriber + smf::MidiFile para transcrição e salvamento.
+ * Pipeline em dois estágios com fila limitada: FIARStreamingAudioDecoder decodifica blocos de 100ms em sua thread
+ * enquanto este worker analisa o bloco anterior (UIARAudioToMIDITranscriber); smf::MidiFile salva o resultado.
+ * A memória por worker é fixa: a fila do decodificador (DefaultMaxQueuedFrames frames) e um frame mono reutilizado.
  */
-bool UIARFolderSource::ConvertAudioToMIDI(const FString& AudioFilePath, const FString& MIDIOutputFilePath)
+bool UIARFolderSource::ConvertAudioToMIDI(const FString& AudioFilePath, const FString& MIDIOutputFilePath, int32 WorkerIndex)
 {
     UE_LOG(LogIARFolderSource, Log, TEXT("Iniciando conversão Áudio para MIDI: %s -> %s"), *AudioFilePath, *MIDIOutputFilePath);
 
-    // --- 1. Decodificar o arquivo de audio para PCM bruto (float) ---
-    TArray<float> RawAudioSamples;
-    int32 ActualSampleRate = 0;
-    int32 ActualNumChannels = 0;
-
     FString FileExtension = FPaths::GetExtension(AudioFilePath).ToLower();
-    if (FileExtension == TEXT("wav"))
-    {
-        // Decodificação otimizada para WAV usando dr_wav
-        if (!UIARAudioEncoder::DecodeWaveFileToRawPCM_DrWav(AudioFilePath, RawAudioSamples, ActualSampleRate, ActualNumChannels))
-        {
-            UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao decodificar arquivo WAV com DrWav: %s"), *AudioFilePath);
-            return false;
-        }
-    }
-    else if (FileExtension == TEXT("mp3"))
-    {
-        // Decodificação para MP3 (ou outros formatos que o FFmpeg suporta) via FFmpeg
-        // FFmpeg decodifica para s16le (int16), que precisa ser convertido para float.
-        TArray<uint8> RawPCMUint8;
-        // Taxa de amostragem e canais alvo para a decodificação (pode ser ajustado se o FFmpeg tiver preferência)
-        int32 TargetSR = 44100;
-        int32 TargetCH = 2; // Estéreo por padrão, se o source tiver mais de 2, será mixado
-        if (!UIARAudioEncoder::DecodeAudioFileToRawPCM(AudioFilePath, TargetSR, TargetCH, RawPCMUint8))
-        {
-            UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao decodificar arquivo MP3 com FFmpeg: %s"), *AudioFilePath);
-            return false;
-        }
-
-        // Converte o PCM s16le (uint8) para float (TArray<float>)
-        RawAudioSamples.SetNumUninitialized(RawPCMUint8.Num() / sizeof(int16));
-        for (int32 i = 0; i < RawAudioSamples.Num(); ++i)
-        {
-            int16 SampleS16 = (int16)((RawPCMUint8[i * 2 + 1] << 8) | RawPCMUint8[i * 2]); // Reconstitui int16 (little-endian)
-            RawAudioSamples[i] = SampleS16 / 32768.0f; // Normaliza para float entre -1.0 e 1.0
-        }
-        ActualSampleRate = TargetSR;
-        ActualNumChannels = TargetCH;
-    }
-    else
+    if (FileExtension != TEXT("wav") && FileExtension != TEXT("mp3"))
     {
         UE_LOG(LogIARFolderSource, Error, TEXT("Formato de áudio de entrada não suportado para conversão para MIDI: %s"), *FileExtension);
         return false;
     }
 
-    if (RawAudioSamples.Num() == 0 || ActualSampleRate == 0 || ActualNumChannels == 0)
-    {
-        UE_LOG(LogIARFolderSource, Error, TEXT("Amostras de áudio decodificadas vazias ou metadados inválidos para %s."), *AudioFilePath);
-        return false;
-    }
-
-    // --- 2. Transcrição de Áudio para MIDI ---
-    // Transcriber e FeatureProcessor devem ser membros da classe e inicializados em UIARFolderSource::Initialize()
+    // Contexto exclusivo deste worker, criado em EnsureWorkerContexts() na Game Thread
+    UIARAudioToMIDITranscriber* Transcriber = WorkerTranscribers.IsValidIndex(WorkerIndex) ? WorkerTranscribers[WorkerIndex].Get() : nullptr;
+    UIARFeatureProcessor* FeatureProcessor = WorkerFeatureProcessors.IsValidIndex(WorkerIndex) ? WorkerFeatureProcessors[WorkerIndex].Get() : nullptr;
+    UIARFramePool* DecodeFramePool = WorkerDecodeFramePools.IsValidIndex(WorkerIndex) ? WorkerDecodeFramePools[WorkerIndex].Get() : nullptr;
     if (!Transcriber || !FeatureProcessor)
     {
         UE_LOG(LogIARFolderSource, Error, TEXT("Transcriber ou FeatureProcessor não inicializados. Conversão Áudio para MIDI falhou."));
         return false;
     }
 
+    // Reinicia o estado a cada arquivo: as notas e as features de um arquivo não vazam para o próximo do mesmo worker
+    Transcriber->Initialize(CurrentStreamSettings.SampleRate);
+    FeatureProcessor->Initialize();
+
     // Vetor para coletar os eventos MIDI transcritos
     TArray<FIAR_MIDIEvent> TranscribedMIDIEvents;
     
@@ -391,48 +634,95 @@ bool UIARFolderSource::ConvertAudioToMIDI(const FString& AudioFilePath, const FS
         TranscribedMIDIEvents.Add(MIDIEvent);
     });
 
-    // Simular o processamento frame a frame para o transcritor (chunks de 100ms)
-    int32 FrameSizeSamples = ActualSampleRate / 10; 
-    for (int32 i = 0; i < RawAudioSamples.Num(); i += FrameSizeSamples * ActualNumChannels) 
-    {
-        int32 CurrentChunkNumSamples = FMath::Min(FrameSizeSamples * ActualNumChannels, RawAudioSamples.Num() - i);
-        TArray<float> CurrentChunkSamples;
-        CurrentChunkSamples.SetNumUninitialized(CurrentChunkNumSamples);
-        FMemory::Memcpy(CurrentChunkSamples.GetData(), RawAudioSamples.GetData() + i, CurrentChunkNumSamples * sizeof(float));
+    // Frame mono reutilizado por todos os blocos do arquivo (o FeatureProcessor só lê o frame recebido)
+    TSharedPtr<FIAR_AudioFrameData> MonoFrame = MakeShared<FIAR_AudioFrameData>();
+    MonoFrame->RawSamplesPtr->Reserve(IARFolderSourcePrivate::DecodeSampleRate / 10);
 
-        // Mixer para mono (se necessário)
-        TArray<float> MonoSamples;
-        if (ActualNumChannels > 1)
+    // Analisa um bloco de amostras intercaladas (mixado para mono) e passa as features para o transcritor
+    auto AnalyzeChunk = [Transcriber, FeatureProcessor, &MonoFrame](const float* InterleavedSamples, int32 NumSampleFrames, int32 NumChannels, int32 SampleRate, float Timestamp)
+    {
+        TArray<float>& MonoSamples = *(MonoFrame->RawSamplesPtr);
+        MonoSamples.SetNumUninitialized(NumSampleFrames, EAllowShrinking::No);
+        for (int32 k = 0; k < NumSampleFrames; ++k)
         {
-            MonoSamples.SetNumUninitialized(CurrentChunkNumSamples / ActualNumChannels);
-            for (int32 k = 0; k < MonoSamples.Num(); ++k)
+            float Sum = 0.0f;
+            for (int32 c = 0; c < NumChannels; ++c)
             {
-                float Sum = 0.0f;
-                for (int32 c = 0; c < ActualNumChannels; ++c)
-                {
-                    Sum += CurrentChunkSamples[k * ActualNumChannels + c];
-                }
-                MonoSamples[k] = Sum / ActualNumChannels;
+                Sum += InterleavedSamples[k * NumChannels + c];
             }
+            MonoSamples[k] = Sum / NumChannels;
         }
-        else
-        {
-            MonoSamples = CurrentChunkSamples;
-        }
-
-        // Cria um FIAR_AudioFrameData para o FeatureProcessor
-        TSharedPtr<FIAR_AudioFrameData> CurrentAudioFrame = MakeShared<FIAR_AudioFrameData>();
-        *(CurrentAudioFrame->RawSamplesPtr) = MonoSamples; 
-        CurrentAudioFrame->SampleRate = ActualSampleRate;
-        CurrentAudioFrame->NumChannels = 1; // O FeatureProcessor trabalha com mono
-        CurrentAudioFrame->Timestamp = (float)i / ActualSampleRate; 
+        MonoFrame->SampleRate = SampleRate;
+        MonoFrame->NumChannels = 1;
+        MonoFrame->Timestamp = Timestamp;
 
         UTexture2D* DummySpectrogramTexture = nullptr; // Necessário para a assinatura, mesmo que não usado aqui
-        FIAR_AudioFeatures ExtractedFeatures = FeatureProcessor->ProcessFrame(CurrentAudioFrame, DummySpectrogramTexture);
+        FIAR_AudioFeatures ExtractedFeatures = FeatureProcessor->ProcessFrame(MonoFrame, DummySpectrogramTexture);
         
         // Passa as features completas para o transcritor
-        float FrameDuration = (float)MonoSamples.Num() / ActualSampleRate; 
-        Transcriber->ProcessAudioFeatures(ExtractedFeatures, CurrentAudioFrame->Timestamp, FrameDuration);
+        float FrameDuration = (float)NumSampleFrames / SampleRate; 
+        Transcriber->ProcessAudioFeatures(ExtractedFeatures, Timestamp, FrameDuration);
+    };
+
+    // --- 1. Decodificação e transcrição (chunks de 100ms) ---
+    // WAV e MP3 (ou outros formatos que o FFmpeg suporta) são decodificados em streaming para f32le, frame a frame,
+    // enquanto o chunk anterior é analisado. A memória usada não depende da duração do arquivo.
+    bool bDecodeSucceeded = true;
+    FIARStreamingAudioDecoder Decoder;
+    if (DecodeFramePool && Decoder.Open(AudioFilePath, IARFolderSourcePrivate::DecodeSampleRate, IARFolderSourcePrivate::DecodeNumChannels, DecodeFramePool))
+    {
+        int64 DecodedSampleFrames = 0;
+        while (TSharedPtr<FIAR_AudioFrameData> Frame = Decoder.ReadFrame())
+        {
+            const int32 NumSampleFrames = Frame->RawSamplesPtr->Num() / Frame->NumChannels;
+            AnalyzeChunk(Frame->RawSamplesPtr->GetData(), NumSampleFrames, Frame->NumChannels, Frame->SampleRate, Frame->Timestamp);
+            DecodedSampleFrames += NumSampleFrames;
+            Decoder.ReleaseFrame(Frame);
+        }
+        Decoder.Close();
+
+        if (Decoder.HasFailed() || DecodedSampleFrames == 0)
+        {
+            UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao decodificar arquivo de áudio com FFmpeg: %s"), *AudioFilePath);
+            bDecodeSucceeded = false;
+        }
+    }
+    else if (FileExtension == TEXT("wav"))
+    {
+        // Sem FFmpeg: o WAV é lido sob demanda pelo dr_wav em blocos de 100ms no formato original do arquivo
+        FIARMappedWavReader WavReader;
+        if (!WavReader.Open(AudioFilePath))
+        {
+            UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao abrir arquivo WAV com DrWav: %s"), *AudioFilePath);
+            bDecodeSucceeded = false;
+        }
+        else
+        {
+            const int32 ActualSampleRate = WavReader.GetSampleRate();
+            const int32 ActualNumChannels = WavReader.GetNumChannels();
+            const int32 FrameSizeSamples = FMath::Max(1, ActualSampleRate / 10);
+            TArray<float> BlockSamples;
+            BlockSamples.SetNumUninitialized(FrameSizeSamples * ActualNumChannels);
+
+            int64 FrameIndex = 0;
+            for (;;)
+            {
+                const int32 NumSampleFrames = (int32)WavReader.ReadFrames(BlockSamples.GetData(), FrameSizeSamples);
+                if (NumSampleFrames <= 0)
+                {
+                    break;
+                }
+                AnalyzeChunk(BlockSamples.GetData(), NumSampleFrames, ActualNumChannels, ActualSampleRate, (float)((double)FrameIndex / ActualSampleRate));
+                FrameIndex += NumSampleFrames;
+            }
+            WavReader.Close();
+            bDecodeSucceeded = (FrameIndex > 0);
+        }
+    }
+    else
+    {
+        UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao iniciar a decodificação do arquivo MP3 com FFmpeg: %s"), *AudioFilePath);
+        bDecodeSucceeded = false;
     }
 
     // Desliga e garante que as notas pendentes sejam finalizadas pelos processadores
@@ -442,6 +732,12 @@ bool UIARFolderSource::ConvertAudioToMIDI(const FString& AudioFilePath, const FS
     // Remove o bind do delegate. MUITO IMPORTANTE para evitar múltiplos binds em futuras conversões.
     Transcriber->OnMIDITranscriptionEventGenerated.Remove(TranscriberDelegateHandle);
 
+    if (!bDecodeSucceeded)
+    {
+        return false;
+    }
+
+
 
     if (TranscribedMIDIEvents.Num() == 0)
     {
@@ -449,7 +745,7 @@ bool UIARFolderSource::ConvertAudioToMIDI(const FString& AudioFilePath, const FS
         return false;
     }
 
-    // --- 3. Salvar Eventos MIDI Transcritos para Arquivo (.mid) ---
+    // --- 2. Salvar Eventos MIDI Transcritos para Arquivo (.mid) ---
     smf::MidiFile MidiFile; 
     MidiFile.addTrack(1); 
     int32 TicksPerQuarterNote = 480; 
@@ -480,26 +776,30 @@ bool UIARFolderSource::ConvertAudioToMIDI(const FString& AudioFilePath, const FS
 /**
  * @brief Implementa a lógica para converter um arquivo MIDI (.mid) para áudio (.wav).
  * Utiliza UIARMIDIFileSource para carregar MIDI e UIARMIDIToAudioSynthesizer para sintetizar,
- * salvando o resultado como WAV usando UIARAudioEncoder.
+ * escrevendo o resultado em streaming com FIARWavStreamWriter (síntese e escrita em disco se sobrepõem).
  */
-bool UIARFolderSource::ConvertMIDIToAudio(const FString& MIDIFilePath, const FString& AudioOutputFilePath)
+bool UIARFolderSource::ConvertMIDIToAudio(const FString& MIDIFilePath, const FString& AudioOutputFilePath, int32 WorkerIndex)
 {
     UE_LOG(LogIARFolderSource, Log, TEXT("Iniciando conversão MIDI para Áudio: %s -> %s"), *MIDIFilePath, *AudioOutputFilePath);
 
-    // --- 1. Carregar Eventos MIDI do Arquivo ---
-    UIARMIDIFileSource* MIDIFileSource = NewObject<UIARMIDIFileSource>();
-    if (!MIDIFileSource)
+    // Contexto exclusivo deste worker, criado e mantido vivo (UPROPERTY) em EnsureWorkerContexts() na Game Thread
+    UIARMIDIFileSource* MIDIFileSource = WorkerMIDIFileSources.IsValidIndex(WorkerIndex) ? WorkerMIDIFileSources[WorkerIndex].Get() : nullptr;
+    UIARMIDIToAudioSynthesizer* Synthesizer = WorkerSynthesizers.IsValidIndex(WorkerIndex) ? WorkerSynthesizers[WorkerIndex].Get() : nullptr;
+    UIARFramePool* WorkerFramePool = WorkerDecodeFramePools.IsValidIndex(WorkerIndex) ? WorkerDecodeFramePools[WorkerIndex].Get() : nullptr;
+    if (!MIDIFileSource || !Synthesizer)
     {
-        UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao criar UIARMIDIFileSource."));
+        UE_LOG(LogIARFolderSource, Error, TEXT("Contexto de conversão do worker %d indisponível."), WorkerIndex);
         return false;
     }
+
+    // --- 1. Carregar Eventos MIDI do Arquivo ---
     
     // Configurações para o stream MIDI (importante para SampleRate e NumChannels da síntese)
     FIAR_AudioStreamSettings SynthSettings; 
     SynthSettings.FilePath = MIDIFilePath; // Define o caminho do arquivo MIDI
-    SynthSettings.SampleRate = 48000;      // Taxa de amostragem alvo para a síntese
-    SynthSettings.NumChannels = 2;         // Canais alvo para a síntese (estéreo)
-    MIDIFileSource->Initialize(SynthSettings, this->FramePool); // Inicializa o MIDIFileSource (sem FramePool pois não é áudio)
+    SynthSettings.SampleRate = IARFolderSourcePrivate::SynthSampleRate;   // Taxa de amostragem alvo para a síntese
+    SynthSettings.NumChannels = IARFolderSourcePrivate::SynthNumChannels; // Canais alvo para a síntese (estéreo)
+    MIDIFileSource->Initialize(SynthSettings, WorkerFramePool); // Reinicializa o leitor do worker para este arquivo (o pool não é usado na leitura)
 
     // Carrega o arquivo MIDI de forma bloqueante (método síncrono para background thread)
     if (!MIDIFileSource->Internal_LoadMIDIFileBlocking())
@@ -509,32 +809,83 @@ bool UIARFolderSource::ConvertMIDIToAudio(const FString& MIDIFilePath, const FSt
     }
 
     // --- 2. Sintetizar Áudio a partir de Eventos MIDI ---
-    UIARMIDIToAudioSynthesizer* Synthesizer = NewObject<UIARMIDIToAudioSynthesizer>();
-    if (!Synthesizer)
-    {
-        UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao criar UIARMIDIToAudioSynthesizer."));
-        return false;
-    }
-    // Inicializa o sintetizador com as configurações de saída de áudio
+    // Zera as vozes e o tempo do sintetizador do worker (o SoundWave já foi criado na Game Thread)
     Synthesizer->Initialize(SynthSettings.SampleRate, SynthSettings.NumChannels);
 
-    // Vetor para coletar os samples de áudio sintetizados
-    TArray<float> SynthesizedRawAudio;
-    // Adiciona uma lambda ao delegate do sintetizador para coletar os frames de áudio gerados
-    Synthesizer->OnSynthesizedAudioFrameReady.AddLambda([&](const TArray<float>& AudioBuffer)
-    {
-        SynthesizedRawAudio.Append(AudioBuffer);
-    });
-
     // Obtém os eventos MIDI carregados do MIDIFileSource
     const TArray<FIAR_MIDIEvent> LoadedEventsPtr = MIDIFileSource->GetLoadedMIDIEvents();
     if (LoadedEventsPtr.Num() == 0)
     {
         UE_LOG(LogIARFolderSource, Warning, TEXT("Nenhum evento MIDI carregado para sintetizar de %s."), *MIDIFilePath);
-        Synthesizer->Shutdown(); // Limpa recursos do sintetizador
         return false;
     }
 
+    // --- 3. Pipeline síntese -> escrita ---
+    // Cada buffer sintetizado é convertido para PCM direto em blocos de tamanho fixo, que a thread de I/O
+    // do FIARWavStreamWriter escreve enquanto este worker continua sintetizando. Nada do áudio fica
+    // acumulado em memória: com SynthMaxQueuedWriteBytes esperando a escrita, a síntese aguarda o disco.
+    using namespace IARFolderSourcePrivate;
+
+    EIARSampleFormat OutputFormat = EIARSampleFormat::S16;
+    FIARSampleFormatConverter::FormatFromBitDepth(SynthOutputBitDepth, false, OutputFormat);
+    const int32 BytesPerSample = FIARSampleFormatConverter::GetBytesPerSample(OutputFormat);
+    FIARSampleFormatConverter Converter(OutputFormat, SynthOutputBitDepth < 32);
+
+    // Estimativa do tamanho (último evento + cauda) só para escolher RIFF ou RF64 e pré-alocar o arquivo
+    const float TailDurationSeconds = 2.0f; // Áudio adicional no final para capturar as "caudas" de release de notas
+    const double EstimatedSeconds = LoadedEventsPtr.Last().Timestamp + TailDurationSeconds + Synthesizer->GetAudioBufferInterval();
+    const int64 ExpectedDataBytes = (int64)(EstimatedSeconds * SynthSettings.SampleRate) * SynthSettings.NumChannels * BytesPerSample;
+
+    FIARByteBlockPool WriteBlockPool(SynthWriteBlockBytes, (int32)(SynthMaxQueuedWriteBytes / SynthWriteBlockBytes) + 2);
+    FIARWavStreamWriter Writer;
+    Writer.SetBlockPool(&WriteBlockPool);
+    if (!Writer.Open(AudioOutputFilePath, SynthSettings.SampleRate, SynthSettings.NumChannels, OutputFormat, ExpectedDataBytes))
+    {
+        UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao abrir o arquivo WAV de saída: %s"), *AudioOutputFilePath);
+        return false;
+    }
+
+    TArray<uint8> PendingBlock = WriteBlockPool.Acquire(SynthWriteBlockBytes);
+    int32 PendingBlockFill = 0;
+    int64 SynthesizedSamples = 0;
+    bool bWriteFailed = false;
+
+    // Entrega o bloco atual à thread de escrita, esperando enquanto a fila estiver no limite
+    auto FlushPendingBlock = [&]()
+    {
+        if (PendingBlockFill == 0 || bWriteFailed)
+        {
+            return;
+        }
+        while (Writer.GetQueuedBytes() >= SynthMaxQueuedWriteBytes && !Writer.HasFailed())
+        {
+            FPlatformProcess::Sleep(0.001f);
+        }
+        PendingBlock.SetNum(PendingBlockFill, EAllowShrinking::No);
+        bWriteFailed = !Writer.EnqueueSamples(MoveTemp(PendingBlock));
+        PendingBlock = WriteBlockPool.Acquire(SynthWriteBlockBytes);
+        PendingBlockFill = 0;
+    };
+
+    Synthesizer->OnSynthesizedAudioFrameReady.AddLambda([&](const TArray<float>& AudioBuffer)
+    {
+        // Converte em pedaços que cabem no bloco atual (múltiplos do número de canais)
+        const int32 SamplesPerBlock = (SynthWriteBlockBytes / BytesPerSample) / SynthSettings.NumChannels * SynthSettings.NumChannels;
+        for (int32 Offset = 0; Offset < AudioBuffer.Num() && !bWriteFailed; )
+        {
+            const int32 FreeSamples = SamplesPerBlock - PendingBlockFill / BytesPerSample;
+            const int32 Count = FMath::Min(FreeSamples, AudioBuffer.Num() - Offset);
+            Converter.Convert(AudioBuffer.GetData() + Offset, Count, PendingBlock.GetData() + PendingBlockFill);
+            PendingBlockFill += Count * BytesPerSample;
+            Offset += Count;
+            if (PendingBlockFill / BytesPerSample >= SamplesPerBlock)
+            {
+                FlushPendingBlock();
+            }
+        }
+        SynthesizedSamples += AudioBuffer.Num();
+    });
+
     // Processa eventos MIDI sequencialmente através do sintetizador, simulando a passagem do tempo.
     // O sintetizador gera áudio em chunks periódicos (AudioBufferInterval).
     // Precisamos garantir que o sintetizador processe os eventos no "tempo" correto.
@@ -561,26 +912,31 @@ bool UIARFolderSource::ConvertMIDIToAudio(const FString& MIDIFilePath, const FSt
     }
 
     // Gera áudio adicional no final para capturar as "caudas" de release de notas
-    float TailDurationSeconds = 2.0f; // Adiciona 2 segundos de áudio no final
     int32 FramesForTail = FMath::CeilToInt(TailDurationSeconds / SynthesizerProcessingInterval);
     for (int32 i = 0; i < FramesForTail; ++i)
     {
         Synthesizer->GenerateAudioBuffer(); // Continua gerando áudio
     }
 
-    Synthesizer->Shutdown(); // Finaliza o sintetizador e libera seus recursos
+    // O sintetizador continua vivo para o próximo arquivo do worker (Shutdown só na Game Thread, em UIARFolderSource::Shutdown)
+    Synthesizer->OnSynthesizedAudioFrameReady.Clear(); // A lambda referencia variáveis locais desta função
 
-    if (SynthesizedRawAudio.Num() == 0)
-    {
-        UE_LOG(LogIARFolderSource, Warning, TEXT("Nenhum áudio sintetizado foi gerado para %s."), *MIDIFilePath);
-        return false;
-    }
+    // Escreve o último bloco e espera a thread de I/O finalizar o cabeçalho
+    FlushPendingBlock();
+    const bool bWriterSucceeded = Writer.Close() && !bWriteFailed;
 
-    // --- 3. Salvar Áudio Sintetizado para Arquivo (.wav) ---
-    // Conforme a diretriz, a saída de áudio será sempre em .wav (PCM 16-bit).
-    if (!UIARAudioEncoder::EncodeRawPCMToFile(SynthesizedRawAudio, SynthSettings.SampleRate, SynthSettings.NumChannels, AudioOutputFilePath, 16))
+    if (SynthesizedSamples == 0 || !bWriterSucceeded)
     {
-        UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao codificar áudio sintetizado para WAV: %s"), *AudioOutputFilePath);
+        if (SynthesizedSamples == 0)
+        {
+            UE_LOG(LogIARFolderSource, Warning, TEXT("Nenhum áudio sintetizado foi gerado para %s."), *MIDIFilePath);
+        }
+        else
+        {
+            UE_LOG(LogIARFolderSource, Error, TEXT("Falha ao escrever o áudio sintetizado em WAV: %s"), *AudioOutputFilePath);
+        }
+        // Um WAV incompleto não pode ficar na pasta de saída, onde passaria por uma conversão já feita
+        FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*AudioOutputFilePath);
         return false;
     }
 
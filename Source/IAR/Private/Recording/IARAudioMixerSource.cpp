@@ -33,6 +33,14 @@ void UIARAudioMixerSource::Initialize(FIAR_AudioStreamSettings& StreamSettings,
         return;
     }
 
+    // Sobreposição só na análise em tempo real (os frames marcam a parte repetida em OverlapFrames)
+    const float Overlap = StreamSettings.bEnableRTFeatures ? StreamSettings.AnalysisWindowOverlap : 0.0f;
+    if (!Reblocker.ConfigureWithOverlap(FMath::Max(64, StreamSettings.AnalysisWindowFrames), Overlap))
+    {
+        return;
+    }
+    const int32 HopFrames = Reblocker.GetHopFrames();
+
     if (!AudioCapture.IsValid())
     {
         AudioCapture = MakeUnique<FAudioCapture>();
@@ -51,7 +59,8 @@ void UIARAudioMixerSource::Initialize(FIAR_AudioStreamSettings& StreamSettings,
             this->OnAudioCapture(InAudio, NumFrames, NumChannels, SampleRate, StreamTime, bOverFlow);
         };
 
-        uint32 DesiredFramesPerBuffer = 1024; 
+        // Apenas um pedido: o driver pode entregar outro tamanho, que o Reblocker absorve
+        uint32 DesiredFramesPerBuffer = HopFrames; 
         if (AudioCapture->OpenAudioCaptureStream(Params, OnAudioCaptureCallback, DesiredFramesPerBuffer))
         {
             UE_LOG(LogIAR, Log, TEXT("UIARAudioMixerSource: Dispositivo de audio aberto com sucesso. Solicitado SR: %d, Cap. SR: %d, Solicitado Ch: %d, Cap. Ch: %d."),
@@ -93,6 +102,8 @@ void UIARAudioMixerSource::StartCapture()
         return;
     }
 
+    // A contagem de frames recomeça a cada captura; o formato real é conhecido no primeiro callback
+    Reblocker.Reset(0, 0);
     if (AudioCapture.IsValid() && AudioCapture->StartStream())
     {
         Super::StartCapture(); 
@@ -116,6 +127,16 @@ void UIARAudioMixerSource::StopCapture()
 
     if (AudioCapture.IsValid() && AudioCapture->StopStream())
     {
+        // Com o stream parado o callback não roda mais: entrega o fim do áudio que não chegou a formar uma janela
+        if (FramePool && IsValid(FramePool) && Reblocker.GetPendingFrames() > 0)
+        {
+            const int32 SampleRate = Reblocker.GetSampleRate();
+            const int32 NumChannels = Reblocker.GetNumChannels();
+            Reblocker.Flush([this, SampleRate, NumChannels](const float* WindowData, int32 NumFrames, int64 StartFrameIndex, int32 OverlapFrames)
+            {
+                EmitWindow(WindowData, NumFrames, StartFrameIndex, OverlapFrames, SampleRate, NumChannels);
+            });
+        }
         Super::StopCapture(); 
         UE_LOG(LogIAR, Log, TEXT("UIARAudioMixerSource: Captura de audio do Audio Mixer parada."));
     }
@@ -146,6 +167,25 @@ void UIARAudioMixerSource::OnAudioCapture(const void* InAudio, int32 NumFrames,
         return;
     }
 
+    if (bOverFlow)
+    {
+        UE_LOG(LogIAR, Warning, TEXT("UIARAudioMixerSource: Audio capture overflow detected. Some audio data may have been lost."));
+    }
+
+    if (!Reblocker.MatchesFormat(SampleRate, NumChannels))
+    {
+        // Primeiro callback da captura (ou o dispositivo mudou de formato): recomeça as janelas
+        Reblocker.Reset(SampleRate, NumChannels);
+    }
+
+    Reblocker.Push(static_cast<const float*>(InAudio), NumFrames, [this, SampleRate, NumChannels](const float* WindowData, int32 WindowFrames, int64 StartFrameIndex, int32 OverlapFrames)
+    {
+        EmitWindow(WindowData, WindowFrames, StartFrameIndex, OverlapFrames, SampleRate, NumChannels);
+    });
+}
+
+void UIARAudioMixerSource::EmitWindow(const float* WindowData, int32 NumFrames, int64 StartFrameIndex, int32 OverlapFrames, int32 SampleRate, int32 NumChannels)
+{
     TSharedPtr<FIAR_AudioFrameData> AudioFrame = FramePool->AcquireFrame();
     if (!AudioFrame.IsValid())
     {
@@ -153,19 +193,15 @@ void UIARAudioMixerSource::OnAudioCapture(const void* InAudio, int32 NumFrames,
         return;
     }
 
-    const float* AudioDataFloat = static_cast<const float*>(InAudio);
-    
-    AudioFrame->RawSamplesPtr->SetNumUninitialized(NumFrames * NumChannels);
-    FMemory::Memcpy(AudioFrame->RawSamplesPtr->GetData(), AudioDataFloat, NumFrames * NumChannels * sizeof(float));
+    const int32 WindowSamples = NumFrames * NumChannels;
+    AudioFrame->RawSamplesPtr->SetNumUninitialized(WindowSamples, EAllowShrinking::No);
+    FMemory::Memcpy(AudioFrame->RawSamplesPtr->GetData(), WindowData, WindowSamples * sizeof(float));
 
     AudioFrame->SampleRate = SampleRate; 
     AudioFrame->NumChannels = NumChannels; 
-    AudioFrame->Timestamp = (float)StreamTime; 
-
-    if (bOverFlow)
-    {
-        UE_LOG(LogIAR, Warning, TEXT("UIARAudioMixerSource: Audio capture overflow detected. Some audio data may have been lost."));
-    }
+    AudioFrame->StartFrameIndex = StartFrameIndex;
+    AudioFrame->OverlapFrames = OverlapFrames;
+    AudioFrame->Timestamp = (float)((double)StartFrameIndex / SampleRate); 
 
     OnAudioFrameAcquired.Broadcast(AudioFrame); 
 }
@@ -9,14 +9,12 @@
 #include "../IAR.h"
 #include "Kismet/GameplayStatics.h" 
 #include "Engine/World.h"
+#include "Core/IARClockedProducer.h" // Thread produtora que substitui o timer da Game Thread
 
 UIARAudioSimulatedSource::UIARAudioSimulatedSource()
     : UIARAudioSource() 
-    , CurrentTimeAccumulator(0.0f)
-    , SineWaveFrequencyHz(440.0f) 
     , SamplesPerFrame(0)
     , FrameDurationSeconds(0.0f)
-    , AmplitudeModulationTime(0.0f) 
 {
     UE_LOG(LogIAR, Log, TEXT("UIARAudioSimulatedSource: Construtor chamado."));
 }
@@ -41,41 +39,87 @@ void UIARAudioSimulatedSource::Initialize(FIAR_AudioStreamSettings& StreamSettin
     SamplesPerFrame = 4096; 
     FrameDurationSeconds = (float)SamplesPerFrame / CurrentStreamSettings.SampleRate;
 
+    if (!ConfigureSignalBank())
+    {
+        SamplesPerFrame = 0; // Impede StartCapture com um sinal inválido
+        return;
+    }
+
     if (!FramePool)
     {
         UE_LOG(LogIAR, Error, TEXT("UIARAudioSimulatedSource: FramePool é nulo após inicialização. "));
         return;
     }
 
-    UE_LOG(LogIAR, Log, TEXT("UIARAudioSimulatedSource: Inicializado com %d amostras por frame (%.4f segundos/frame)."), SamplesPerFrame, FrameDurationSeconds);
+    UE_LOG(LogIAR, Log, TEXT("UIARAudioSimulatedSource: Inicializado com %d amostras por frame (%.4f segundos/frame), %d vozes."), SamplesPerFrame, FrameDurationSeconds, SignalBank.GetNumVoices());
+}
+
+bool UIARAudioSimulatedSource::ConfigureSignalBank()
+{
+    if (!SignalBank.Configure(CurrentStreamSettings.SampleRate, CurrentStreamSettings.NumChannels))
+    {
+        return false;
+    }
+
+    const EIARTestSignalType SignalType = CurrentStreamSettings.TestSignalType;
+    const float Amplitude = FMath::Clamp(CurrentStreamSettings.TestSignalAmplitude, 0.0f, 1.0f);
+    const float DetuneHz = CurrentStreamSettings.TestSignalChannelDetuneHz;
+    static const TArray<float> MajorTriadRatios = { 1.0f, 1.25f, 1.5f };
+
+    // Uma voz por canal quando os canais devem diferir (detune ou ruído descorrelacionado); senão uma voz para todos
+    const int32 NumChannels = CurrentStreamSettings.NumChannels;
+    const bool bPerChannel = NumChannels > 1 && (SignalType == EIARTestSignalType::WhiteNoise || !FMath::IsNearlyZero(DetuneHz));
+    const int32 NumTargets = bPerChannel ? NumChannels : 1;
+
+    bool bSuccess = true;
+    for (int32 Target = 0; Target < NumTargets && bSuccess; ++Target)
+    {
+        const int32 Channel = bPerChannel ? Target : INDEX_NONE;
+        const float ChannelOffsetHz = Target * DetuneHz;
+        switch (SignalType)
+        {
+        case EIARTestSignalType::Sine:
+            bSuccess = SignalBank.AddSine(CurrentStreamSettings.TestSignalFrequencyHz + ChannelOffsetHz, Amplitude, Channel);
+            break;
+        case EIARTestSignalType::Chord:
+            bSuccess = SignalBank.AddChord(CurrentStreamSettings.TestSignalFrequencyHz + ChannelOffsetHz, MajorTriadRatios, Amplitude, Channel);
+            break;
+        case EIARTestSignalType::Sweep:
+            bSuccess = SignalBank.AddSweep(CurrentStreamSettings.TestSignalFrequencyHz + ChannelOffsetHz, CurrentStreamSettings.TestSignalSweepEndHz + ChannelOffsetHz,
+                CurrentStreamSettings.TestSignalSweepSeconds, Amplitude, Channel);
+            break;
+        case EIARTestSignalType::WhiteNoise:
+            bSuccess = SignalBank.AddNoise((uint32)CurrentStreamSettings.TestSignalSeed + Target, Amplitude, Channel);
+            break;
+        }
+    }
+
+    if (!bSuccess)
+    {
+        UE_LOG(LogIAR, Error, TEXT("UIARAudioSimulatedSource: Parâmetros do sinal de teste inválidos para %d Hz."), CurrentStreamSettings.SampleRate);
+    }
+    return bSuccess;
 }
 
 void UIARAudioSimulatedSource::StartCapture()
 {
     if (!bIsCapturing) 
     {
-        if (UWorld* World = GetWorld())
+        FIARClockedProducer* Producer = FIARClockedProducer::Get();
+        if (FramePool && FramePool->IsValidLowLevelFast() && Producer && SamplesPerFrame > 0) 
         {
-            if (FramePool && FramePool->IsValidLowLevelFast()) 
-            {
-                World->GetTimerManager().SetTimer(
-                    AudioGenerationTimerHandle,
-                    this,
-                    &UIARAudioSimulatedSource::FillSimulatedFrame,
-                    FrameDurationSeconds, 
-                    true 
-                );
-                Super::StartCapture(); 
-                UE_LOG(LogIAR, Log, TEXT("UIARAudioSimulatedSource: Captura de áudio simulada iniciada."));
-            }
-            else
+            Super::StartCapture(); 
+            SignalBank.Reset(); // Cada captura começa do frame 0 do sinal
+            // Blocos de SamplesPerFrame frames no ritmo do relógio, fora da Game Thread
+            ProducerRegistrationId.Set(Producer->Register(CurrentStreamSettings.SampleRate, SamplesPerFrame, [this](int64 BlockIndex, double StreamTimeSeconds)
             {
-                UE_LOG(LogIAR, Error, TEXT("UIARAudioSimulatedSource: Não foi possível iniciar a captura. FramePool é inválido ou não inicializado."));
-            }
+                FillSimulatedFrame(StreamTimeSeconds);
+            }));
+            UE_LOG(LogIAR, Log, TEXT("UIARAudioSimulatedSource: Captura de áudio simulada iniciada."));
         }
         else
         {
-            UE_LOG(LogIAR, Error, TEXT("UIARAudioSimulatedSource: Não foi possível obter o World para iniciar o timer."));
+            UE_LOG(LogIAR, Error, TEXT("UIARAudioSimulatedSource: Não foi possível iniciar a captura. FramePool inválido, fonte não inicializada ou thread produtora indisponível."));
         }
     }
 }
@@ -84,14 +128,11 @@ void UIARAudioSimulatedSource::StopCapture()
 {
     if (bIsCapturing) 
     {
-        if (UWorld* World = GetWorld())
+        const int32 RegistrationId = ProducerRegistrationId.Set(0);
+        if (RegistrationId != 0)
         {
-            World->GetTimerManager().ClearTimer(AudioGenerationTimerHandle);
-            UE_LOG(LogIAR, Log, TEXT("UIARAudioSimulatedSource: Timer de geração de áudio limpo."));
-        }
-        else
-        {
-            UE_LOG(LogIAR, Warning, TEXT("UIARAudioSimulatedSource: World é nulo ao tentar parar a captura. O timer será interrompido naturalmente."));
+            FIARClockedProducer::Get()->Unregister(RegistrationId);
+            UE_LOG(LogIAR, Log, TEXT("UIARAudioSimulatedSource: Geração de áudio removida da thread produtora."));
         }
         Super::StopCapture(); 
         UE_LOG(LogIAR, Log, TEXT("UIARAudioSimulatedSource: Captura de áudio simulada parada."));
@@ -105,20 +146,8 @@ void UIARAudioSimulatedSource::Shutdown()
     UE_LOG(LogIAR, Log, TEXT("UIARAudioSimulatedSource: Desligado e recursos liberados."));
 }
 
-void UIARAudioSimulatedSource::FillSimulatedFrame() 
+void UIARAudioSimulatedSource::FillSimulatedFrame(double StreamTimeSeconds) 
 {
-    UWorld* World = GetWorld();
-    if (!World)
-    {
-        UE_LOG(LogIAR, Warning, TEXT("UIARAudioSimulatedSource: FillSimulatedFrame chamada com World inválido. Interrompendo a geração de frames."));
-        if (AudioGenerationTimerHandle.IsValid())
-        {
-            World->GetTimerManager().ClearTimer(AudioGenerationTimerHandle);
-        }
-        Super::StopCapture(); 
-        return; 
-    }
-
     if (!FramePool || !FramePool->IsValidLowLevelFast()) 
     {
         UE_LOG(LogIAR, Error, TEXT("UIARAudioSimulatedSource: Falha ao adquirir frame. FramePool é inválido ou nulo."));
@@ -134,36 +163,14 @@ void UIARAudioSimulatedSource::FillSimulatedFrame()
 
     TArray<float>& RawSamples = *(AudioFrame->RawSamplesPtr);
     
+    // O gerador sobrescreve o frame inteiro
     const int32 TotalSamples = SamplesPerFrame * CurrentStreamSettings.NumChannels;
-    if (RawSamples.Num() != TotalSamples)
-    {
-        RawSamples.SetNumZeroed(TotalSamples);
-    }
-
-    float CurrentAmplitude = 0.0f;
-    CurrentAmplitude = (FMath::Sin(AmplitudeModulationTime * PI * 0.4f) * 0.5f + 0.5f) * 0.5f; 
-    CurrentAmplitude = FMath::Max(0.0f, CurrentAmplitude - 0.1f); 
-    CurrentAmplitude *= 2.0f; 
-    CurrentAmplitude = FMath::Min(CurrentAmplitude, 1.0f);
-
-
-    for (int32 i = 0; i < SamplesPerFrame; ++i)
-    {
-        float SampleValue = FMath::Sin(2.0f * PI * SineWaveFrequencyHz * CurrentTimeAccumulator) * CurrentAmplitude;
-        RawSamples[i * CurrentStreamSettings.NumChannels] = SampleValue; 
-
-        for (int32 Channel = 1; Channel < CurrentStreamSettings.NumChannels; ++Channel)
-        {
-            RawSamples[(i * CurrentStreamSettings.NumChannels) + Channel] = RawSamples[i * CurrentStreamSettings.NumChannels];
-        }
-
-        CurrentTimeAccumulator += 1.0f / CurrentStreamSettings.SampleRate;
-    }
-    AmplitudeModulationTime += FrameDurationSeconds; 
+    RawSamples.SetNumUninitialized(TotalSamples, EAllowShrinking::No);
+    SignalBank.Render(RawSamples.GetData(), SamplesPerFrame);
 
     AudioFrame->SampleRate = CurrentStreamSettings.SampleRate;
     AudioFrame->NumChannels = CurrentStreamSettings.NumChannels;
-    AudioFrame->Timestamp = UGameplayStatics::GetTimeSeconds(this); 
+    AudioFrame->Timestamp = (float)StreamTimeSeconds; 
 
     OnAudioFrameAcquired.Broadcast(AudioFrame); // BROADCAST DO DELEGATE DA CLASSE BASE
 }
@@ -0,0 +1,299 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Recording/IARConversionManifest.h"
+#include "../IAR.h" // Para logging
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+
+namespace IARConversionManifestPrivate
+{
+    // Primeira linha do arquivo: muda quando o formato das linhas muda (manifestos antigos são ignorados)
+    const TCHAR* const FileHeader = TEXT("# IAR conversion manifest v1");
+    // Entrada \t Tamanho \t Data \t Hash \t Configurações \t Saída \t Tamanho \t Data \t Hash
+    constexpr int32 NumFields = 9;
+    // Tamanho das leituras ao calcular o hash
+    constexpr int64 HashReadSize = 1024 * 1024;
+}
+
+FIARConversionManifest::FIARConversionManifest()
+    : bDirty(false)
+    , LastSaveTime(0.0)
+{
+}
+
+bool FIARConversionManifest::Load(const FString& InManifestPath, const FString& InInputRoot, const FString& InOutputRoot)
+{
+    using namespace IARConversionManifestPrivate;
+
+    FScopeLock Lock(&ManifestLock);
+    ManifestPath = InManifestPath;
+    InputRoot = InInputRoot;
+    OutputRoot = InOutputRoot;
+    Entries.Reset();
+    bDirty = false;
+    LastSaveTime = FPlatformTime::Seconds();
+
+    if (!FPaths::FileExists(ManifestPath))
+    {
+        return true;
+    }
+
+    TArray<FString> Lines;
+    if (!FFileHelper::LoadFileToStringArray(Lines, *ManifestPath))
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARConversionManifest: Falha ao ler o manifesto '%s'. Todos os arquivos serão reprocessados."), *ManifestPath);
+        return false;
+    }
+    if (Lines.Num() == 0 || Lines[0] != FileHeader)
+    {
+        UE_LOG(LogIAR, Warning, TEXT("FIARConversionManifest: Manifesto '%s' em formato desconhecido; ignorado."), *ManifestPath);
+        return true;
+    }
+
+    TArray<FString> Fields;
+    for (int32 LineIndex = 1; LineIndex < Lines.Num(); ++LineIndex)
+    {
+        Lines[LineIndex].ParseIntoArray(Fields, TEXT("\t"), false);
+        if (Fields.Num() != NumFields)
+        {
+            continue; // Linha truncada (ex.: gravação interrompida): a entrada é simplesmente refeita
+        }
+
+        FEntry Entry;
+        LexFromString(Entry.Input.Size, *Fields[1]);
+        LexFromString(Entry.Input.ModificationTicks, *Fields[2]);
+        Entry.Input.Hash = Fields[3];
+        Entry.SettingsKey = Fields[4];
+        Entry.OutputPath = Fields[5];
+        LexFromString(Entry.Output.Size, *Fields[6]);
+        LexFromString(Entry.Output.ModificationTicks, *Fields[7]);
+        Entry.Output.Hash = Fields[8];
+        Entries.Add(Fields[0], MoveTemp(Entry));
+    }
+
+    UE_LOG(LogIAR, Log, TEXT("FIARConversionManifest: %d conversões registradas em '%s'."), Entries.Num(), *ManifestPath);
+    return true;
+}
+
+bool FIARConversionManifest::Save()
+{
+    using namespace IARConversionManifestPrivate;
+
+    // Serializa as gravações: duas chamadas concorrentes não podem intercalar escritas no .tmp
+    FScopeLock SaveScope(&SaveLock);
+
+    FString Content;
+    {
+        FScopeLock Lock(&ManifestLock);
+        if (!bDirty || ManifestPath.IsEmpty())
+        {
+            return true;
+        }
+
+        Content.Reserve(Entries.Num() * 160);
+        Content += FileHeader;
+        Content += TEXT("\n");
+        for (const TPair<FString, FEntry>& Pair : Entries)
+        {
+            const FEntry& Entry = Pair.Value;
+            Content += FString::Printf(TEXT("%s\t%lld\t%lld\t%s\t%s\t%s\t%lld\t%lld\t%s\n"),
+                *Pair.Key, Entry.Input.Size, Entry.Input.ModificationTicks, *Entry.Input.Hash, *Entry.SettingsKey,
+                *Entry.OutputPath, Entry.Output.Size, Entry.Output.ModificationTicks, *Entry.Output.Hash);
+        }
+        bDirty = false;
+        LastSaveTime = FPlatformTime::Seconds();
+    }
+
+    // Grava ao lado e renomeia: uma interrupção no meio da gravação não corrompe o manifesto anterior
+    const FString TempPath = ManifestPath + TEXT(".tmp");
+    if (!FFileHelper::SaveStringToFile(Content, *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARConversionManifest: Falha ao gravar o manifesto '%s'."), *TempPath);
+        FScopeLock Lock(&ManifestLock);
+        bDirty = true;
+        return false;
+    }
+    // Substitui em uma única operação; apagar antes deixaria uma janela sem manifesto em disco
+    if (!IFileManager::Get().Move(*ManifestPath, *TempPath, /*bReplace*/ true, /*bEvenIfReadOnly*/ false, /*bAttributes*/ false, /*bDoNotRetryOrError*/ true))
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARConversionManifest: Falha ao substituir o manifesto '%s'."), *ManifestPath);
+        FScopeLock Lock(&ManifestLock);
+        bDirty = true;
+        return false;
+    }
+    return true;
+}
+
+bool FIARConversionManifest::SaveIfDue(double MinIntervalSeconds)
+{
+    {
+        FScopeLock Lock(&ManifestLock);
+        if (!bDirty || FPlatformTime::Seconds() - LastSaveTime < MinIntervalSeconds)
+        {
+            return true;
+        }
+    }
+    return Save();
+}
+
+bool FIARConversionManifest::IsUpToDate(const FString& InputFilePath, const FString& OutputFilePath, const FString& SettingsKey)
+{
+    const FString InputKey = MakeRelative(InputFilePath, InputRoot);
+    const FString OutputKey = MakeRelative(OutputFilePath, OutputRoot);
+
+    FEntry Entry;
+    {
+        FScopeLock Lock(&ManifestLock);
+        const FEntry* Found = Entries.Find(InputKey);
+        if (!Found || Found->SettingsKey != SettingsKey || Found->OutputPath != OutputKey)
+        {
+            return false;
+        }
+        Entry = *Found;
+    }
+
+    // Os hashes (se necessários) são calculados fora do lock, em paralelo entre os workers
+    bool bInputRefreshed = false;
+    bool bOutputRefreshed = false;
+    if (!MatchesRecordedState(InputFilePath, Entry.Input, bInputRefreshed)
+        || !MatchesRecordedState(OutputFilePath, Entry.Output, bOutputRefreshed))
+    {
+        return false;
+    }
+
+    // Conteúdo igual com data nova (ex.: arquivo copiado): guarda a data para não recalcular o hash na próxima vez
+    if (bInputRefreshed || bOutputRefreshed)
+    {
+        FScopeLock Lock(&ManifestLock);
+        Entries.Add(InputKey, MoveTemp(Entry));
+        bDirty = true;
+    }
+    return true;
+}
+
+bool FIARConversionManifest::Record(const FString& InputFilePath, const FString& OutputFilePath, const FString& SettingsKey)
+{
+    FEntry Entry;
+    Entry.SettingsKey = SettingsKey;
+    Entry.OutputPath = MakeRelative(OutputFilePath, OutputRoot);
+    if (!ReadFileState(InputFilePath, Entry.Input) || !ReadFileState(OutputFilePath, Entry.Output))
+    {
+        Invalidate(InputFilePath);
+        return false;
+    }
+    Entry.Input.Hash = HashFile(InputFilePath);
+    Entry.Output.Hash = HashFile(OutputFilePath);
+    if (Entry.Input.Hash.IsEmpty() || Entry.Output.Hash.IsEmpty())
+    {
+        Invalidate(InputFilePath);
+        return false;
+    }
+
+    FScopeLock Lock(&ManifestLock);
+    Entries.Add(MakeRelative(InputFilePath, InputRoot), MoveTemp(Entry));
+    bDirty = true;
+    return true;
+}
+
+void FIARConversionManifest::Invalidate(const FString& InputFilePath)
+{
+    const FString InputKey = MakeRelative(InputFilePath, InputRoot);
+    FScopeLock Lock(&ManifestLock);
+    if (Entries.Remove(InputKey) > 0)
+    {
+        bDirty = true;
+    }
+}
+
+int32 FIARConversionManifest::Num() const
+{
+    FScopeLock Lock(&ManifestLock);
+    return Entries.Num();
+}
+
+FString FIARConversionManifest::HashFile(const FString& FilePath)
+{
+    using namespace IARConversionManifestPrivate;
+
+    TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FilePath));
+    if (!FileHandle)
+    {
+        return FString();
+    }
+
+    FMD5 Md5;
+    TArray<uint8> Buffer;
+    Buffer.SetNumUninitialized(HashReadSize);
+    for (int64 Remaining = FileHandle->Size(); Remaining > 0; )
+    {
+        const int64 Count = FMath::Min(Remaining, HashReadSize);
+        if (!FileHandle->Read(Buffer.GetData(), Count))
+        {
+            return FString();
+        }
+        Md5.Update(Buffer.GetData(), (uint64)Count);
+        Remaining -= Count;
+    }
+
+    uint8 Digest[16];
+    Md5.Final(Digest);
+    return BytesToHex(Digest, UE_ARRAY_COUNT(Digest));
+}
+
+bool FIARConversionManifest::ReadFileState(const FString& FilePath, FFileState& OutState)
+{
+    const FFileStatData StatData = FPlatformFileManager::Get().GetPlatformFile().GetStatData(*FilePath);
+    if (!StatData.bIsValid || StatData.bIsDirectory)
+    {
+        return false;
+    }
+    OutState.Size = StatData.FileSize;
+    OutState.ModificationTicks = StatData.ModificationTime.GetTicks();
+    return true;
+}
+
+bool FIARConversionManifest::MatchesRecordedState(const FString& FilePath, FFileState& Recorded, bool& bOutRefreshed)
+{
+    FFileState Current;
+    if (!ReadFileState(FilePath, Current) || Current.Size != Recorded.Size)
+    {
+        return false;
+    }
+    if (Current.ModificationTicks == Recorded.ModificationTicks)
+    {
+        return true;
+    }
+
+    // A data mudou mas o tamanho não: só o conteúdo decide
+    if (HashFile(FilePath) != Recorded.Hash)
+    {
+        return false;
+    }
+    Recorded.ModificationTicks = Current.ModificationTicks;
+    bOutRefreshed = true;
+    return true;
+}
+
+FString FIARConversionManifest::MakeRelative(const FString& FilePath, const FString& Root)
+{
+    FString RelativePath = FilePath;
+    FPaths::NormalizeFilename(RelativePath);
+    FString RootDirectory = Root;
+    FPaths::NormalizeDirectoryName(RootDirectory);
+    // Fora da pasta base (ou em outro volume) o caminho absoluto é mantido
+    if (!RootDirectory.IsEmpty() && RelativePath.StartsWith(RootDirectory + TEXT("/")))
+    {
+        RelativePath.RightChopInline(RootDirectory.Len() + 1);
+    }
+    return RelativePath;
+}
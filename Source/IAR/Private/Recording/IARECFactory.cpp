@@ -10,6 +10,7 @@
 #include "../IAR.h"
 #include "HAL/PlatformProcess.h" // Para FPlatformProcess::IsWindows() etc.
 #include "Misc/Paths.h"          // Para FPaths::ConvertRelativePathToFull
+#include "Core/IARSampleFormatConverter.h" // Para o formato das amostras enviadas pelo encoder
 
 UIARECFactory::UIARECFactory()
 {
@@ -35,7 +36,60 @@ void UIARECFactory::Shutdown()
     UE_LOG(LogIAR, Log, TEXT("IARECFactory: Desligado."));
 }
 
-FString UIARECFactory::BuildAudioEncodeCommand(const FIAR_AudioStreamSettings& StreamSettings, const FString& InputPipeName, const FString& OutputFilePath)
+namespace IARECFactoryPrivate
+{
+    // Taxas aceitas pelo libopus; as demais são reamostradas para 48kHz
+    bool IsOpusSampleRate(int32 SampleRate)
+    {
+        return SampleRate == 48000 || SampleRate == 24000 || SampleRate == 16000 || SampleRate == 12000 || SampleRate == 8000;
+    }
+
+    /**
+     * Argumentos do codec de saída da gravação ao vivo e o muxer correspondente à extensão de GetDefaultExtension().
+     * O contêiner de cada codec pode ser finalizado segmento a segmento e aberto mesmo se o processo for interrompido.
+     */
+    void GetLiveCodecArguments(const FIAR_AudioStreamSettings& StreamSettings, const TCHAR* RawFormatName, FString& OutCodecArgs, FString& OutMuxerName, FString& OutMuxerOptions)
+    {
+        const int32 Bitrate = FMath::Max(StreamSettings.Bitrate, 8000);
+        if (StreamSettings.Codec.Equals(TEXT("FLAC"), ESearchCase::IgnoreCase))
+        {
+            OutCodecArgs = TEXT("-c:a flac"); // Sem perdas: o bitrate não se aplica
+            OutMuxerName = TEXT("flac");
+        }
+        else if (StreamSettings.Codec.Equals(TEXT("OPUS"), ESearchCase::IgnoreCase))
+        {
+            OutCodecArgs = FString::Printf(TEXT("-c:a libopus -b:a %d"), Bitrate);
+            if (!IsOpusSampleRate(StreamSettings.SampleRate))
+            {
+                OutCodecArgs += TEXT(" -ar 48000");
+            }
+            OutMuxerName = TEXT("ogg");
+        }
+        else if (StreamSettings.Codec.Equals(TEXT("AAC"), ESearchCase::IgnoreCase))
+        {
+            OutCodecArgs = FString::Printf(TEXT("-c:a aac -b:a %d"), Bitrate);
+            OutMuxerName = TEXT("ipod");
+            // MP4 fragmentado: o índice vai junto dos dados, então o arquivo é legível mesmo sem a finalização
+            OutMuxerOptions = TEXT("movflags=+frag_keyframe+empty_moov+default_base_moof");
+        }
+        else if (StreamSettings.Codec.Equals(TEXT("MP3"), ESearchCase::IgnoreCase))
+        {
+            OutCodecArgs = FString::Printf(TEXT("-c:a libmp3lame -b:a %d"), Bitrate);
+            OutMuxerName = TEXT("mp3");
+        }
+        else
+        {
+            if (!StreamSettings.Codec.Equals(TEXT("PCM"), ESearchCase::IgnoreCase) && !StreamSettings.Codec.Equals(TEXT("WAV"), ESearchCase::IgnoreCase))
+            {
+                UE_LOG(LogIAR, Warning, TEXT("UIARECFactory: Codec de gravação '%s' não suportado. Gravando em PCM."), *StreamSettings.Codec);
+            }
+            OutCodecArgs = FString::Printf(TEXT("-c:a pcm_%s"), RawFormatName);
+            OutMuxerName = TEXT("wav");
+        }
+    }
+}
+
+FString UIARECFactory::BuildAudioEncodeCommand(const FIAR_AudioStreamSettings& StreamSettings, const FString& InputPipeName, const FString& OutputFilePath, int64 SegmentFrames, int32 FirstSegmentIndex)
 {
     FString QuotedInputPipeName;
 #if PLATFORM_WINDOWS
@@ -46,13 +100,49 @@ FString UIARECFactory::BuildAudioEncodeCommand(const FIAR_AudioStreamSettings& S
     QuotedInputPipeName = FString::Printf(TEXT(""%s""), *FPaths::ConvertRelativePathToFull(InputPipeName));
 #endif
 
+    // O encoder envia as amostras no formato definido por BitDepth (s16le se não suportado)
+    EIARSampleFormat SampleFormat = EIARSampleFormat::S16;
+    FIARSampleFormatConverter::FormatFromBitDepth(StreamSettings.BitDepth, StreamSettings.bUseFloatSamples, SampleFormat);
+    const TCHAR* RawFormatName = FIARSampleFormatConverter::GetRawFormatName(SampleFormat);
+
     // Constrói a linha de comando parte a parte
     // Adicionados -probesize e -analyzeduration para otimizar entrada de stream
-    FString CommandLine = FString::Printf(TEXT("-f s16le -ar %d -ac %d -probesize 32 -analyzeduration 0 -thread_queue_size 8192 -i %s"), 
-        StreamSettings.SampleRate, StreamSettings.NumChannels, *QuotedInputPipeName);
+    FString CommandLine = FString::Printf(TEXT("-f %s -ar %d -ac %d -probesize 32 -analyzeduration 0 -thread_queue_size 8192 -i %s"), 
+        RawFormatName, StreamSettings.SampleRate, StreamSettings.NumChannels, *QuotedInputPipeName);
+
+    // Adiciona codec de saída (e bitrate, para os codecs com perdas)
+    FString CodecArgs, MuxerName, MuxerOptions;
+    IARECFactoryPrivate::GetLiveCodecArguments(StreamSettings, RawFormatName, CodecArgs, MuxerName, MuxerOptions);
+    CommandLine += TEXT(" ") + CodecArgs; // Espaço antes de -c:a
 
-    // Adiciona codec de saída
-    CommandLine += TEXT(" -c:a pcm_s16le"); // Espaço antes de -c:a
+    // Segmentação: um único processo grava todos os takes, trocando de arquivo a cada SegmentFrames frames
+    if (SegmentFrames > 0 && StreamSettings.SampleRate > 0)
+    {
+        // Pacotes de tamanho fixo: com o segmento múltiplo deles (UIARAudioEncoder::SetSegmentation arredonda),
+        // o corte do segment muxer cai exatamente no frame SegmentFrames. Fora disso o corte fica dentro da tolerância.
+        // Nos codecs comprimidos o corte cai no primeiro pacote do encoder depois da fronteira.
+        const int32 PacketFrames = (int32)FMath::Min<int64>(SegmentFrames, SegmentPacketFrames);
+        if (SegmentFrames % PacketFrames != 0)
+        {
+            UE_LOG(LogIAR, Warning, TEXT("UIARECFactory: Segmento de %lld frames não é múltiplo de %d; o corte pode variar até meio pacote."), SegmentFrames, PacketFrames);
+        }
+        const double SegmentSeconds = (double)SegmentFrames / StreamSettings.SampleRate;
+        const double CutToleranceSeconds = 0.5 * PacketFrames / StreamSettings.SampleRate;
+        CommandLine += FString::Printf(TEXT(" -af asetnsamples=n=%d:p=0 -f segment -segment_format %s -segment_time %.6f -segment_time_delta %.6f -segment_start_number %d -reset_timestamps 1"),
+            PacketFrames, *MuxerName, SegmentSeconds, CutToleranceSeconds, FirstSegmentIndex);
+        if (!MuxerOptions.IsEmpty())
+        {
+            CommandLine += FString::Printf(TEXT(" -segment_format_options %s"), *MuxerOptions);
+        }
+    }
+    else
+    {
+        CommandLine += FString::Printf(TEXT(" -f %s"), *MuxerName);
+        if (!MuxerOptions.IsEmpty())
+        {
+            CommandLine += TEXT(" -") + MuxerOptions.Replace(TEXT("="), TEXT(" "));
+        }
+    }
 
     // Caminho do arquivo de saída (entre aspas para segurança)
     CommandLine += FString::Printf(TEXT(" %s"), *FPaths::ConvertRelativePathToFull(OutputFilePath)); 
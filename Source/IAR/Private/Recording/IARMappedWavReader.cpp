@@ -0,0 +1,176 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Recording/IARMappedWavReader.h"
+#include "../IAR.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/ScopeLock.h"
+#include "dr_wav.h" // Inclua o cabeçalho do dr_wav SEM A MACRO!!!
+
+// Estado do dr_wav, mantido fora do .h para não expor o dr_wav.h
+struct FIARMappedWavReader::FDrWavState
+{
+    drwav Wav;
+};
+
+// Arquivo mapeado, compartilhado pelos leitores do mesmo caminho
+struct FIARMappedWavReader::FMappedFile
+{
+    TUniquePtr<IMappedFileHandle> Handle;
+    TUniquePtr<IMappedFileRegion> Region;
+    int64 FileSize = 0;
+    FDateTime TimeStamp;
+};
+
+FIARMappedWavReader::FIARMappedWavReader()
+    : WavState(nullptr)
+    , SampleRate(0)
+    , NumChannels(0)
+    , NumFrames(0)
+    , CursorFrame(0)
+{
+}
+
+FIARMappedWavReader::~FIARMappedWavReader()
+{
+    Close();
+}
+
+TSharedPtr<FIARMappedWavReader::FMappedFile, ESPMode::ThreadSafe> FIARMappedWavReader::AcquireMapping(const FString& InFilePath)
+{
+    // Mapeamentos abertos, por caminho. Entradas expiradas são removidas na próxima abertura.
+    static FCriticalSection CacheLock;
+    static TMap<FString, TWeakPtr<FMappedFile, ESPMode::ThreadSafe>> Cache;
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    const FFileStatData StatData = PlatformFile.GetStatData(*InFilePath);
+    if (!StatData.bIsValid || StatData.bIsDirectory || StatData.FileSize <= 0)
+    {
+        return nullptr;
+    }
+
+    FScopeLock Lock(&CacheLock);
+    for (auto It = Cache.CreateIterator(); It; ++It)
+    {
+        if (!It.Value().IsValid())
+        {
+            It.RemoveCurrent();
+        }
+    }
+
+    // Um arquivo regravado desde o mapeamento anterior ganha um mapeamento novo; o antigo segue válido para quem o usa
+    if (TSharedPtr<FMappedFile, ESPMode::ThreadSafe> Existing = Cache.FindRef(InFilePath).Pin())
+    {
+        if (Existing->FileSize == StatData.FileSize && Existing->TimeStamp == StatData.ModificationTime)
+        {
+            return Existing;
+        }
+    }
+
+    FOpenMappedResult OpenResult = PlatformFile.OpenMappedEx(*InFilePath);
+    if (OpenResult.HasError())
+    {
+        return nullptr;
+    }
+
+    TSharedPtr<FMappedFile, ESPMode::ThreadSafe> Mapping = MakeShared<FMappedFile, ESPMode::ThreadSafe>();
+    Mapping->Handle = OpenResult.StealValue();
+    Mapping->Region.Reset(Mapping->Handle->MapRegion(0, StatData.FileSize));
+    if (!Mapping->Region.IsValid() || Mapping->Region->GetMappedSize() != StatData.FileSize)
+    {
+        return nullptr;
+    }
+    Mapping->FileSize = StatData.FileSize;
+    Mapping->TimeStamp = StatData.ModificationTime;
+
+    Cache.Add(InFilePath, Mapping);
+    return Mapping;
+}
+
+bool FIARMappedWavReader::Open(const FString& InFilePath)
+{
+    Close();
+    FilePath = InFilePath;
+    WavState = new FDrWavState();
+
+    // O dr_wav lê o cabeçalho direto do mapeamento: só as páginas do cabeçalho são tocadas aqui
+    Mapping = AcquireMapping(FilePath);
+    bool bInitialized = false;
+    if (Mapping.IsValid())
+    {
+        bInitialized = drwav_init_memory(&WavState->Wav, Mapping->Region->GetMappedPtr(), (size_t)Mapping->Region->GetMappedSize(), nullptr);
+    }
+    else
+    {
+        UE_LOG(LogIAR, Warning, TEXT("FIARMappedWavReader: Não foi possível mapear '%s'. Lendo do arquivo sob demanda."), *FilePath);
+        bInitialized = drwav_init_file(&WavState->Wav, TCHAR_TO_UTF8(*FilePath), nullptr);
+    }
+
+    if (!bInitialized)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARMappedWavReader: Falha ao abrir ou ler o cabeçalho do arquivo WAV '%s'."), *FilePath);
+        delete WavState;
+        WavState = nullptr;
+        Mapping.Reset();
+        return false;
+    }
+
+    SampleRate = (int32)WavState->Wav.sampleRate;
+    NumChannels = (int32)WavState->Wav.channels;
+    NumFrames = (int64)WavState->Wav.totalPCMFrameCount;
+    CursorFrame = 0;
+    if (SampleRate <= 0 || NumChannels <= 0 || NumFrames <= 0)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARMappedWavReader: Arquivo WAV '%s' sem áudio ou com formato inválido. SR: %d, CH: %d, Frames: %lld"), *FilePath, SampleRate, NumChannels, NumFrames);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void FIARMappedWavReader::Close()
+{
+    if (WavState)
+    {
+        drwav_uninit(&WavState->Wav);
+        delete WavState;
+        WavState = nullptr;
+    }
+    Mapping.Reset();
+    SampleRate = 0;
+    NumChannels = 0;
+    NumFrames = 0;
+    CursorFrame = 0;
+}
+
+int64 FIARMappedWavReader::ReadFrames(float* OutSamples, int64 InNumFrames)
+{
+    if (!WavState || !OutSamples || InNumFrames <= 0)
+    {
+        return 0;
+    }
+
+    // Conversão apenas dos frames pedidos: o dr_wav copia do mapeamento e converte para float em pequenos blocos
+    const int64 FramesRead = (int64)drwav_read_pcm_frames_f32(&WavState->Wav, (drwav_uint64)InNumFrames, OutSamples);
+    CursorFrame += FramesRead;
+    return FramesRead;
+}
+
+bool FIARMappedWavReader::SeekToFrame(int64 FrameIndex)
+{
+    if (!WavState || FrameIndex < 0 || FrameIndex > NumFrames)
+    {
+        return false;
+    }
+    if (!drwav_seek_to_pcm_frame(&WavState->Wav, (drwav_uint64)FrameIndex))
+    {
+        return false;
+    }
+    CursorFrame = FrameIndex;
+    return true;
+}
@@ -0,0 +1,231 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Recording/IARSpillJournal.h"
+#include "../IAR.h" // Para logging
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+FIARSpillJournal::FIARSpillJournal(const FString& InFilePath, int64 InMaxBytes, int64 InMaxStagedBytes, FIARByteBlockPool* InBlockPool)
+    : FilePath(InFilePath)
+    , MaxBytes(FMath::Max<int64>(0, InMaxBytes))
+    , MaxStagedBytes(FMath::Max<int64>(0, InMaxStagedBytes))
+    , BlockPool(InBlockPool)
+    , WriterThread(nullptr)
+    , DataAvailableEvent(nullptr)
+    , bStopRequested(false)
+    , WriteHandle(nullptr)
+    , ReadHandle(nullptr)
+    , StagedBytes(0)
+    , ReadOffset(0)
+    , WriteOffset(0)
+{
+}
+
+FIARSpillJournal::~FIARSpillJournal()
+{
+    Close();
+}
+
+bool FIARSpillJournal::Start()
+{
+    if (WriterThread || MaxBytes == 0)
+    {
+        return WriterThread != nullptr;
+    }
+    bStopRequested.AtomicSet(false);
+    DataAvailableEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    WriterThread = FRunnableThread::Create(this, TEXT("IARSpillJournalThread"), 0, TPri_BelowNormal);
+    if (!WriterThread)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARSpillJournal: Falha ao criar a thread de escrita do journal '%s'. Transbordo desativado."), *FilePath);
+        FPlatformProcess::ReturnSynchEventToPool(DataAvailableEvent);
+        DataAvailableEvent = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool FIARSpillJournal::Append(TArray<uint8>&& Block)
+{
+    const int64 NumBytes = Block.Num();
+    if (NumBytes <= 0)
+    {
+        return true;
+    }
+    if (!WriterThread || bStopRequested)
+    {
+        return false;
+    }
+
+    {
+        FScopeLock Lock(&JournalLock);
+        if (StagedBytes + NumBytes > MaxStagedBytes || StagedBytes + (WriteOffset - ReadOffset) + NumBytes > MaxBytes)
+        {
+            return false;
+        }
+        StagedBytes += NumBytes;
+    }
+    StagedBlocks.Enqueue(MoveTemp(Block));
+    DataAvailableEvent->Trigger();
+    return true;
+}
+
+uint32 FIARSpillJournal::Run()
+{
+    while (!bStopRequested)
+    {
+        WriteStagedBlocks();
+        DataAvailableEvent->Wait(100);
+    }
+    return 0;
+}
+
+void FIARSpillJournal::Stop()
+{
+    bStopRequested.AtomicSet(true);
+    if (DataAvailableEvent) { DataAvailableEvent->Trigger(); }
+}
+
+void FIARSpillJournal::WriteStagedBlocks()
+{
+    TArray<uint8> Block;
+    while (!bStopRequested && StagedBlocks.Dequeue(Block))
+    {
+        const int64 NumBytes = Block.Num();
+        if (!WriteHandle)
+        {
+            // Criado apenas no primeiro transbordo: gravações sem congestionamento nunca tocam o disco aqui
+            IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+            PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+            WriteHandle = PlatformFile.OpenWrite(*FilePath, false, true);
+            if (!WriteHandle)
+            {
+                UE_LOG(LogIAR, Error, TEXT("FIARSpillJournal: Falha ao criar o journal '%s'."), *FilePath);
+            }
+        }
+
+        int64 Offset = 0;
+        {
+            FScopeLock Lock(&JournalLock);
+            // Consumidor alcançou o produtor: reaproveita o arquivo desde o início (nenhuma leitura em andamento)
+            if (ReadOffset == WriteOffset)
+            {
+                ReadOffset = 0;
+                WriteOffset = 0;
+            }
+            Offset = WriteOffset;
+        }
+
+        const bool bWritten = WriteHandle && WriteHandle->Seek(Offset) && WriteHandle->Write(Block.GetData(), NumBytes);
+        {
+            FScopeLock Lock(&JournalLock);
+            StagedBytes -= NumBytes;
+            if (bWritten)
+            {
+                WriteOffset += NumBytes;
+            }
+        }
+        if (!bWritten && WriteHandle)
+        {
+            UE_LOG(LogIAR, Error, TEXT("FIARSpillJournal: Falha ao escrever %lld bytes no journal '%s'."), NumBytes, *FilePath);
+        }
+
+        if (BlockPool)
+        {
+            BlockPool->Release(MoveTemp(Block));
+        }
+        if (OnBlockWritten)
+        {
+            OnBlockWritten(bWritten, NumBytes);
+        }
+    }
+}
+
+int64 FIARSpillJournal::Read(uint8* OutData, int64 InMaxBytes)
+{
+    int64 Offset = 0;
+    int64 Count = 0;
+    {
+        FScopeLock Lock(&JournalLock);
+        Offset = ReadOffset;
+        Count = FMath::Min(InMaxBytes, WriteOffset - ReadOffset);
+    }
+    if (!OutData || Count <= 0)
+    {
+        return 0;
+    }
+
+    // A leitura acontece sem o lock: o produtor (e a thread de escrita) seguem enquanto o disco responde
+    if (!ReadHandle)
+    {
+        ReadHandle = FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FilePath, true);
+    }
+    if (!ReadHandle || !ReadHandle->Seek(Offset) || !ReadHandle->Read(OutData, Count))
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARSpillJournal: Falha ao ler %lld bytes do journal '%s'."), Count, *FilePath);
+        return -1;
+    }
+
+    FScopeLock Lock(&JournalLock);
+    ReadOffset += Count;
+    return Count;
+}
+
+int64 FIARSpillJournal::GetPendingBytes() const
+{
+    FScopeLock Lock(&JournalLock);
+    return StagedBytes + (WriteOffset - ReadOffset);
+}
+
+int64 FIARSpillJournal::GetReadableBytes() const
+{
+    FScopeLock Lock(&JournalLock);
+    return WriteOffset - ReadOffset;
+}
+
+void FIARSpillJournal::Close()
+{
+    if (WriterThread)
+    {
+        Stop();
+        WriterThread->WaitForCompletion();
+        delete WriterThread;
+        WriterThread = nullptr;
+        FPlatformProcess::ReturnSynchEventToPool(DataAvailableEvent);
+        DataAvailableEvent = nullptr;
+    }
+
+    // Blocos que a thread não chegou a gravar voltam ao pool
+    TArray<uint8> Block;
+    while (StagedBlocks.Dequeue(Block))
+    {
+        if (BlockPool)
+        {
+            BlockPool->Release(MoveTemp(Block));
+        }
+    }
+
+    if (ReadHandle)
+    {
+        delete ReadHandle;
+        ReadHandle = nullptr;
+    }
+    if (WriteHandle)
+    {
+        delete WriteHandle;
+        WriteHandle = nullptr;
+        FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*FilePath);
+    }
+
+    FScopeLock Lock(&JournalLock);
+    StagedBytes = 0;
+    ReadOffset = 0;
+    WriteOffset = 0;
+}
@@ -0,0 +1,375 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Recording/IARStreamingAudioDecoder.h"
+#include "../IAR.h"
+#include "Recording/IARAudioEncoder.h" // Para GetFFmpegExecutablePathInternal
+#include "FFmpegLogReader.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_LINUX
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#endif
+
+FIARStreamingAudioDecoder::FIARStreamingAudioDecoder()
+    : SampleRate(0)
+    , NumChannels(0)
+    , MaxQueuedFrames(DefaultMaxQueuedFrames)
+    , FramePool(nullptr)
+    , ReadPipeStdout(nullptr)
+    , ReadPipeStderr(nullptr)
+    , StderrReader(nullptr)
+    , ReaderThread(nullptr)
+    , FrameAvailableEvent(nullptr)
+    , SpaceAvailableEvent(nullptr)
+    , bStopRequested(false)
+    , bEndOfStream(false)
+    , bHasFailed(false)
+    , DecodedSampleFrames(0)
+    , StagingOffset(0)
+{
+}
+
+FIARStreamingAudioDecoder::~FIARStreamingAudioDecoder()
+{
+    Close();
+}
+
+bool FIARStreamingAudioDecoder::Open(const FString& InputFilePath, int32 InSampleRate, int32 InNumChannels, UIARFramePool* InFramePool, int32 InMaxQueuedFrames)
+{
+    if (IsOpen())
+    {
+        UE_LOG(LogIAR, Warning, TEXT("FIARStreamingAudioDecoder: Já existe uma decodificação aberta ('%s'). Chame Close() primeiro."), *InputPath);
+        return false;
+    }
+    if (!InFramePool || InSampleRate <= 0 || InNumChannels <= 0)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARStreamingAudioDecoder: Parâmetros inválidos para '%s'. SR: %d, CH: %d, Pool: %s"), *InputFilePath, InSampleRate, InNumChannels, InFramePool ? TEXT("ok") : TEXT("nulo"));
+        return false;
+    }
+
+    const FString FFmpegExecPath = UIARAudioEncoder::GetFFmpegExecutablePathInternal();
+    if (FFmpegExecPath.IsEmpty() || !FPlatformFileManager::Get().GetPlatformFile().FileExists(*FFmpegExecPath))
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARStreamingAudioDecoder: FFmpeg não encontrado em '%s'."), *FFmpegExecPath);
+        return false;
+    }
+
+    InputPath = InputFilePath;
+    SampleRate = InSampleRate;
+    NumChannels = InNumChannels;
+    MaxQueuedFrames = FMath::Max(1, InMaxQueuedFrames);
+    FramePool = InFramePool;
+    DecodedSampleFrames = 0;
+    NumQueuedFrames.Reset();
+    StagingBytes.Reset();
+    StagingOffset = 0;
+    StderrOutput.Reset();
+    bStopRequested.AtomicSet(false);
+    bEndOfStream.AtomicSet(false);
+    bHasFailed.AtomicSet(false);
+
+    // f32le: as amostras chegam prontas para o analisador, sem conversão por amostra do lado do UE
+    const FString Arguments = FString::Printf(TEXT("-nostdin -hide_banner -nostats -loglevel error -i \"%s\" -vn -f f32le -acodec pcm_f32le -ar %d -ac %d -"),
+        *FPaths::ConvertRelativePathToFull(InputFilePath), SampleRate, NumChannels);
+
+    void* WritePipeStdout = nullptr;
+    void* WritePipeStderr = nullptr;
+    FPlatformProcess::CreatePipe(ReadPipeStdout, WritePipeStdout);
+    FPlatformProcess::CreatePipe(ReadPipeStderr, WritePipeStderr);
+
+    FString WorkingDirectory = FPaths::GetPath(FFmpegExecPath);
+    FPaths::NormalizeDirectoryName(WorkingDirectory);
+    ProcessHandle = FPlatformProcess::CreateProc(*FFmpegExecPath, *Arguments, false, true, true, nullptr, -1, *WorkingDirectory, WritePipeStdout, WritePipeStderr);
+
+    // O FFmpeg herdou as extremidades de escrita
+    FPlatformProcess::ClosePipe(nullptr, WritePipeStdout);
+    FPlatformProcess::ClosePipe(nullptr, WritePipeStderr);
+
+    if (!ProcessHandle.IsValid())
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARStreamingAudioDecoder: Falha ao lançar o FFmpeg para '%s'."), *InputFilePath);
+        FPlatformProcess::ClosePipe(ReadPipeStdout, nullptr);
+        FPlatformProcess::ClosePipe(ReadPipeStderr, nullptr);
+        ReadPipeStdout = nullptr;
+        ReadPipeStderr = nullptr;
+        return false;
+    }
+
+    // Com -loglevel error o stderr é pequeno: guardado para o relatório de erro
+    StderrReader = new FFMpegLogReader(ReadPipeStderr, TEXT("FFmpeg STREAM DECODE STDERR"), &StderrOutput);
+    StderrReader->Start();
+
+    FrameAvailableEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    SpaceAvailableEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    ReaderThread = FRunnableThread::Create(this, TEXT("IARStreamingAudioDecoderThread"), 0, TPri_BelowNormal);
+    if (!ReaderThread)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARStreamingAudioDecoder: Falha ao criar a thread de leitura para '%s'."), *InputFilePath);
+        Close();
+        return false;
+    }
+
+    UE_LOG(LogIAR, Log, TEXT("FIARStreamingAudioDecoder: Decodificando '%s' (%d Hz, %d canais, fila de %d frames)."), *InputFilePath, SampleRate, NumChannels, MaxQueuedFrames);
+    return true;
+}
+
+uint32 FIARStreamingAudioDecoder::Run()
+{
+    while (!bStopRequested)
+    {
+        if (NumQueuedFrames.GetValue() >= MaxQueuedFrames)
+        {
+            // Fila cheia: sem leitura o pipe enche e o FFmpeg espera junto
+            SpaceAvailableEvent->Wait(100);
+            continue;
+        }
+
+        TSharedPtr<FIAR_AudioFrameData> Frame = FramePool->AcquireFrame();
+        TArray<float>& Samples = *Frame->RawSamplesPtr;
+        if (Samples.Num() < NumChannels)
+        {
+            Samples.SetNumUninitialized(NumChannels * FMath::Max(1, SampleRate / 10));
+        }
+
+        // Leitura direto no buffer do frame, sem cópia intermediária
+        int64 BytesRead = 0;
+        const bool bStreamOpen = ReadBlock(reinterpret_cast<uint8*>(Samples.GetData()), (int64)Samples.Num() * sizeof(float), BytesRead);
+
+        const int32 NumSampleFrames = (int32)(BytesRead / ((int64)sizeof(float) * NumChannels));
+        if (NumSampleFrames > 0)
+        {
+            Samples.SetNum(NumSampleFrames * NumChannels, EAllowShrinking::No); // Último frame pode ser menor
+            Frame->SampleRate = SampleRate;
+            Frame->NumChannels = NumChannels;
+            Frame->Timestamp = (float)((double)DecodedSampleFrames / SampleRate);
+            DecodedSampleFrames += NumSampleFrames;
+
+            DecodedFrames.Enqueue(Frame);
+            NumQueuedFrames.Increment();
+            FrameAvailableEvent->Trigger();
+        }
+        else
+        {
+            FramePool->ReleaseFrame(Frame);
+        }
+
+        if (!bStreamOpen)
+        {
+            break;
+        }
+    }
+
+    if (!bStopRequested)
+    {
+        // Fim do stream: o código de saída diz se o arquivo foi decodificado até o fim
+        FPlatformProcess::WaitForProc(ProcessHandle);
+        int32 ReturnCode = -1;
+        FPlatformProcess::GetProcReturnCode(ProcessHandle, &ReturnCode);
+        if (ReturnCode != 0)
+        {
+            bHasFailed.AtomicSet(true);
+            UE_LOG(LogIAR, Error, TEXT("FIARStreamingAudioDecoder: FFmpeg terminou com código %d ao decodificar '%s'."), ReturnCode, *InputPath);
+        }
+        else
+        {
+            UE_LOG(LogIAR, Log, TEXT("FIARStreamingAudioDecoder: '%s' decodificado (%lld amostras por canal)."), *InputPath, DecodedSampleFrames);
+        }
+    }
+
+    bEndOfStream.AtomicSet(true);
+    FrameAvailableEvent->Trigger();
+    return 0;
+}
+
+bool FIARStreamingAudioDecoder::ReadBlock(uint8* Dest, int64 NumBytes, int64& OutBytesRead)
+{
+    OutBytesRead = 0;
+
+#if PLATFORM_LINUX
+    const int Descriptor = static_cast<FPipeHandle*>(ReadPipeStdout)->GetHandle();
+    while (OutBytesRead < NumBytes)
+    {
+        if (bStopRequested)
+        {
+            return false;
+        }
+
+        const ssize_t Count = read(Descriptor, Dest + OutBytesRead, (size_t)(NumBytes - OutBytesRead));
+        if (Count > 0)
+        {
+            OutBytesRead += Count;
+            continue;
+        }
+        if (Count == 0)
+        {
+            return false; // EOF: o FFmpeg terminou
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            // O pipe do UE é não-bloqueante: espera dados com poll (com timeout, para observar bStopRequested)
+            pollfd PollDescriptor;
+            PollDescriptor.fd = Descriptor;
+            PollDescriptor.events = POLLIN;
+            PollDescriptor.revents = 0;
+            poll(&PollDescriptor, 1, 100);
+            continue;
+        }
+        UE_LOG(LogIAR, Error, TEXT("FIARStreamingAudioDecoder: Erro ao ler o stdout do FFmpeg para '%s': %s"), *InputPath, UTF8_TO_TCHAR(strerror(errno)));
+        bHasFailed.AtomicSet(true);
+        return false;
+    }
+    return true;
+#else
+    // ReadPipeToArray lê o que estiver disponível: o que não couber no bloco fica em StagingBytes para o próximo
+    while (OutBytesRead < NumBytes)
+    {
+        if (bStopRequested)
+        {
+            return false;
+        }
+
+        if (StagingOffset >= StagingBytes.Num())
+        {
+            StagingBytes.Reset();
+            StagingOffset = 0;
+            FPlatformProcess::ReadPipeToArray(ReadPipeStdout, StagingBytes);
+            if (StagingBytes.Num() == 0)
+            {
+                if (!FPlatformProcess::IsProcRunning(ProcessHandle))
+                {
+                    // Processo encerrado: uma última leitura pega o que ficou no pipe
+                    FPlatformProcess::ReadPipeToArray(ReadPipeStdout, StagingBytes);
+                    if (StagingBytes.Num() == 0)
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    FPlatformProcess::Sleep(0.001f);
+                    continue;
+                }
+            }
+        }
+
+        const int64 Count = FMath::Min<int64>(NumBytes - OutBytesRead, StagingBytes.Num() - StagingOffset);
+        FMemory::Memcpy(Dest + OutBytesRead, StagingBytes.GetData() + StagingOffset, Count);
+        StagingOffset += (int32)Count;
+        OutBytesRead += Count;
+    }
+    return true;
+#endif
+}
+
+TSharedPtr<FIAR_AudioFrameData> FIARStreamingAudioDecoder::ReadFrame()
+{
+    while (IsOpen())
+    {
+        // bEndOfStream é lido antes da fila: o último frame é enfileirado antes de a flag ser ligada
+        const bool bFinished = bEndOfStream;
+        TSharedPtr<FIAR_AudioFrameData> Frame;
+        if (DecodedFrames.Dequeue(Frame))
+        {
+            NumQueuedFrames.Decrement();
+            SpaceAvailableEvent->Trigger();
+            return Frame;
+        }
+        if (bFinished)
+        {
+            break;
+        }
+        FrameAvailableEvent->Wait(100);
+    }
+    return nullptr;
+}
+
+void FIARStreamingAudioDecoder::ReleaseFrame(TSharedPtr<FIAR_AudioFrameData> Frame)
+{
+    if (Frame.IsValid() && FramePool)
+    {
+        FramePool->ReleaseFrame(Frame);
+    }
+}
+
+void FIARStreamingAudioDecoder::Stop()
+{
+    bStopRequested.AtomicSet(true);
+    if (SpaceAvailableEvent) { SpaceAvailableEvent->Trigger(); }
+}
+
+void FIARStreamingAudioDecoder::Close()
+{
+    if (ReaderThread)
+    {
+        // Fechamento antes do fim do arquivo: o FFmpeg é encerrado para não ficar bloqueado no pipe
+        if (!bEndOfStream)
+        {
+            Stop();
+            if (ProcessHandle.IsValid() && FPlatformProcess::IsProcRunning(ProcessHandle))
+            {
+                FPlatformProcess::TerminateProc(ProcessHandle, true);
+            }
+        }
+        ReaderThread->WaitForCompletion();
+        delete ReaderThread;
+        ReaderThread = nullptr;
+    }
+
+    if (StderrReader)
+    {
+        StderrReader->EnsureCompletion();
+        delete StderrReader;
+        StderrReader = nullptr;
+        if (bHasFailed && StderrOutput.Num() > 0)
+        {
+            const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(StderrOutput.GetData()), StderrOutput.Num());
+            UE_LOG(LogIAR, Error, TEXT("FIARStreamingAudioDecoder: Saída de erro do FFmpeg para '%s':\n%s"), *InputPath, *FString(Converted.Length(), Converted.Get()));
+        }
+    }
+
+    if (ReadPipeStdout || ReadPipeStderr)
+    {
+        FPlatformProcess::ClosePipe(ReadPipeStdout, nullptr);
+        FPlatformProcess::ClosePipe(ReadPipeStderr, nullptr);
+        ReadPipeStdout = nullptr;
+        ReadPipeStderr = nullptr;
+    }
+    if (ProcessHandle.IsValid())
+    {
+        FPlatformProcess::CloseProc(ProcessHandle);
+    }
+
+    // Frames não consumidos voltam ao pool
+    TSharedPtr<FIAR_AudioFrameData> Frame;
+    while (DecodedFrames.Dequeue(Frame))
+    {
+        ReleaseFrame(Frame);
+    }
+    NumQueuedFrames.Reset();
+
+    if (FrameAvailableEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(FrameAvailableEvent);
+        FrameAvailableEvent = nullptr;
+    }
+    if (SpaceAvailableEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(SpaceAvailableEvent);
+        SpaceAvailableEvent = nullptr;
+    }
+    StagingBytes.Empty();
+    StagingOffset = 0;
+    FramePool = nullptr;
+}
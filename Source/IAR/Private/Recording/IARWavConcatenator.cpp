@@ -0,0 +1,278 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Recording/IARWavConcatenator.h"
+#include "../IAR.h" // Para logging
+#include "Recording/IARWavStreamWriter.h" // Para RIFFMaxDataBytes
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+
+namespace IARWavConcatenatorPrivate
+{
+    constexpr uint16 WaveFormatPCM = 1;
+    constexpr uint16 WaveFormatIEEEFloat = 3;
+    constexpr uint16 WaveFormatExtensible = 0xFFFE;
+
+    FORCEINLINE bool HasTag(const uint8* Bytes, const char* Tag)
+    {
+        return FMemory::Memcmp(Bytes, Tag, 4) == 0;
+    }
+
+    FORCEINLINE uint32 ReadU32(const uint8* Bytes)
+    {
+        return (uint32)Bytes[0] | ((uint32)Bytes[1] << 8) | ((uint32)Bytes[2] << 16) | ((uint32)Bytes[3] << 24);
+    }
+
+    FORCEINLINE uint64 ReadU64(const uint8* Bytes)
+    {
+        return (uint64)ReadU32(Bytes) | ((uint64)ReadU32(Bytes + 4) << 32);
+    }
+
+    void AppendTag(TArray<uint8>& Out, const char* Tag)
+    {
+        Out.Append(reinterpret_cast<const uint8*>(Tag), 4);
+    }
+
+    void AppendU32(TArray<uint8>& Out, uint32 Value)
+    {
+        for (int32 i = 0; i < 4; ++i) { Out.Add((uint8)(Value >> (8 * i))); }
+    }
+
+    void AppendU64(TArray<uint8>& Out, uint64 Value)
+    {
+        AppendU32(Out, (uint32)Value);
+        AppendU32(Out, (uint32)(Value >> 32));
+    }
+}
+
+bool FIARWavConcatenator::ReadLayout(const FString& FilePath, FWavLayout& OutLayout)
+{
+    using namespace IARWavConcatenatorPrivate;
+
+    TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FilePath));
+    if (!File)
+    {
+        return false;
+    }
+
+    const int64 FileSize = File->Size();
+    uint8 Header[12];
+    if (FileSize < 12 || !File->Read(Header, sizeof(Header)) || !HasTag(Header + 8, "WAVE"))
+    {
+        return false;
+    }
+    const bool bIsRF64 = HasTag(Header, "RF64");
+    if (!bIsRF64 && !HasTag(Header, "RIFF"))
+    {
+        return false;
+    }
+
+    OutLayout = FWavLayout();
+    int64 RF64DataBytes = -1;
+    int64 ChunkOffset = 12;
+    while (ChunkOffset + 8 <= FileSize)
+    {
+        uint8 ChunkHeader[8];
+        if (!File->Seek(ChunkOffset) || !File->Read(ChunkHeader, sizeof(ChunkHeader)))
+        {
+            return false;
+        }
+        const uint32 ChunkSize = ReadU32(ChunkHeader + 4);
+
+        if (HasTag(ChunkHeader, "ds64"))
+        {
+            // ds64: tamanho RIFF (64), tamanho dos dados (64), número de frames (64), ...
+            uint8 Ds64[16];
+            if (ChunkSize < sizeof(Ds64) || !File->Read(Ds64, sizeof(Ds64)))
+            {
+                return false;
+            }
+            RF64DataBytes = (int64)ReadU64(Ds64 + 8);
+        }
+        else if (HasTag(ChunkHeader, "fmt "))
+        {
+            if (ChunkSize < 16 || ChunkSize > 1024)
+            {
+                return false;
+            }
+            OutLayout.FormatChunk.SetNumUninitialized(ChunkSize);
+            if (!File->Read(OutLayout.FormatChunk.GetData(), ChunkSize))
+            {
+                return false;
+            }
+        }
+        else if (HasTag(ChunkHeader, "data"))
+        {
+            OutLayout.DataOffset = ChunkOffset + 8;
+            OutLayout.DataBytes = (bIsRF64 && ChunkSize == 0xFFFFFFFFu && RF64DataBytes >= 0) ? RF64DataBytes : (int64)ChunkSize;
+            // Arquivos escritos em streaming (tamanho 0xFFFFFFFF ou não corrigido) terminam no fim do arquivo
+            OutLayout.DataBytes = FMath::Min(OutLayout.DataBytes, FileSize - OutLayout.DataOffset);
+            if (OutLayout.FormatChunk.Num() == 0)
+            {
+                return false;
+            }
+            // Um arquivo truncado pode terminar no meio de um quadro; descarta o quadro parcial
+            // para não desalinhar os canais dos arquivos seguintes na concatenação
+            const int64 BlockAlign = (int64)(OutLayout.FormatChunk[12] | (OutLayout.FormatChunk[13] << 8));
+            if (BlockAlign > 0)
+            {
+                OutLayout.DataBytes -= OutLayout.DataBytes % BlockAlign;
+            }
+            return true;
+        }
+
+        ChunkOffset += 8 + (int64)ChunkSize + (ChunkSize & 1); // Chunks são alinhados em 2 bytes
+    }
+    return false;
+}
+
+bool FIARWavConcatenator::CanConcatenate(const TArray<FString>& InputPaths)
+{
+    using namespace IARWavConcatenatorPrivate;
+
+    TArray<uint8> ReferenceFormat;
+    for (const FString& InputPath : InputPaths)
+    {
+        FWavLayout Layout;
+        if (!ReadLayout(InputPath, Layout))
+        {
+            return false;
+        }
+
+        const uint16 FormatTag = (uint16)(Layout.FormatChunk[0] | (Layout.FormatChunk[1] << 8));
+        if (FormatTag != WaveFormatPCM && FormatTag != WaveFormatIEEEFloat && FormatTag != WaveFormatExtensible)
+        {
+            return false;
+        }
+        if (ReferenceFormat.Num() == 0)
+        {
+            ReferenceFormat = MoveTemp(Layout.FormatChunk);
+        }
+        else if (Layout.FormatChunk != ReferenceFormat)
+        {
+            return false;
+        }
+    }
+    return ReferenceFormat.Num() > 0;
+}
+
+bool FIARWavConcatenator::Concatenate(const TArray<FString>& InputPaths, const FString& OutputPath, const FString& WorkDirectory)
+{
+    using namespace IARWavConcatenatorPrivate;
+
+    const double StartTime = FPlatformTime::Seconds();
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+    TArray<FWavLayout> Layouts;
+    Layouts.SetNum(InputPaths.Num());
+    int64 TotalDataBytes = 0;
+    for (int32 i = 0; i < InputPaths.Num(); ++i)
+    {
+        if (!ReadLayout(InputPaths[i], Layouts[i]) || Layouts[i].FormatChunk != Layouts[0].FormatChunk)
+        {
+            UE_LOG(LogIAR, Error, TEXT("FIARWavConcatenator: '%s' não é um WAV compatível com as demais entradas."), *InputPaths[i]);
+            return false;
+        }
+        TotalDataBytes += Layouts[i].DataBytes;
+    }
+    if (Layouts.Num() == 0)
+    {
+        return false;
+    }
+
+    // Cabeçalho único: RIFF quando cabe em 32 bits, RF64 (com ds64) acima disso
+    const TArray<uint8>& FormatChunk = Layouts[0].FormatChunk;
+    const int64 PaddedFormatBytes = FormatChunk.Num() + (FormatChunk.Num() & 1);
+    const int64 DataPadBytes = TotalDataBytes & 1;
+    const bool bUseRF64 = TotalDataBytes > FIARWavStreamWriter::RIFFMaxDataBytes - PaddedFormatBytes;
+    const int64 HeaderBytes = 12 + (bUseRF64 ? 36 : 0) + 8 + PaddedFormatBytes + 8;
+    const int64 OutputFileBytes = HeaderBytes + TotalDataBytes + DataPadBytes;
+    const uint16 BlockAlign = (uint16)(FormatChunk[12] | (FormatChunk[13] << 8));
+
+    TArray<uint8> Header;
+    Header.Reserve(HeaderBytes);
+    AppendTag(Header, bUseRF64 ? "RF64" : "RIFF");
+    AppendU32(Header, bUseRF64 ? 0xFFFFFFFFu : (uint32)(OutputFileBytes - 8));
+    AppendTag(Header, "WAVE");
+    if (bUseRF64)
+    {
+        AppendTag(Header, "ds64");
+        AppendU32(Header, 28);
+        AppendU64(Header, (uint64)(OutputFileBytes - 8));
+        AppendU64(Header, (uint64)TotalDataBytes);
+        AppendU64(Header, BlockAlign > 0 ? (uint64)(TotalDataBytes / BlockAlign) : 0);
+        AppendU32(Header, 0); // Sem tabela de chunks extras
+    }
+    AppendTag(Header, "fmt ");
+    AppendU32(Header, (uint32)FormatChunk.Num());
+    Header.Append(FormatChunk);
+    if (FormatChunk.Num() & 1) { Header.Add(0); }
+    AppendTag(Header, "data");
+    AppendU32(Header, bUseRF64 ? 0xFFFFFFFFu : (uint32)TotalDataBytes);
+    check(Header.Num() == HeaderBytes);
+
+    // Monta no diretório de trabalho e só publica o arquivo completo
+    PlatformFile.CreateDirectoryTree(*WorkDirectory);
+    const FString PartialPath = FPaths::Combine(WorkDirectory, FPaths::GetCleanFilename(OutputPath) + TEXT(".partial"));
+    TUniquePtr<IFileHandle> Output(PlatformFile.OpenWrite(*PartialPath, false, false));
+    if (!Output)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARWavConcatenator: Falha ao criar '%s'."), *PartialPath);
+        return false;
+    }
+
+    // Pré-aloca o tamanho final para o sistema de arquivos reservar blocos contíguos
+    Output->Truncate(OutputFileBytes);
+    bool bSuccess = Output->Seek(0) && Output->Write(Header.GetData(), Header.Num());
+
+    uint8* CopyBuffer = static_cast<uint8*>(FMemory::Malloc(CopyBlockSize, FIARWavStreamWriter::WriteBlockAlignment));
+    for (int32 i = 0; i < InputPaths.Num() && bSuccess; ++i)
+    {
+        TUniquePtr<IFileHandle> Input(PlatformFile.OpenRead(*InputPaths[i]));
+        bSuccess = Input && Input->Seek(Layouts[i].DataOffset);
+
+        int64 Remaining = Layouts[i].DataBytes;
+        while (bSuccess && Remaining > 0)
+        {
+            const int64 Count = FMath::Min(Remaining, CopyBlockSize);
+            bSuccess = Input->Read(CopyBuffer, Count) && Output->Write(CopyBuffer, Count);
+            Remaining -= Count;
+        }
+        if (!bSuccess)
+        {
+            UE_LOG(LogIAR, Error, TEXT("FIARWavConcatenator: Falha ao copiar os dados de '%s'."), *InputPaths[i]);
+        }
+    }
+    FMemory::Free(CopyBuffer);
+
+    if (bSuccess && DataPadBytes > 0)
+    {
+        const uint8 PadByte = 0;
+        bSuccess = Output->Write(&PadByte, 1);
+    }
+    bSuccess = bSuccess && Output->Flush();
+    Output.Reset();
+
+    if (bSuccess)
+    {
+        PlatformFile.DeleteFile(*OutputPath);
+        // Renomear é instantâneo no mesmo volume; a cópia cobre diretórios de trabalho em outro volume
+        bSuccess = PlatformFile.MoveFile(*OutputPath, *PartialPath) || PlatformFile.CopyFile(*OutputPath, *PartialPath);
+    }
+    PlatformFile.DeleteFile(*PartialPath);
+
+    if (!bSuccess)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARWavConcatenator: Falha ao montar '%s'."), *OutputPath);
+        return false;
+    }
+
+    UE_LOG(LogIAR, Log, TEXT("FIARWavConcatenator: '%s' montado a partir de %d arquivos (%lld bytes de áudio, %s) em %.2f s."),
+        *OutputPath, InputPaths.Num(), TotalDataBytes, bUseRF64 ? TEXT("RF64") : TEXT("RIFF"), FPlatformTime::Seconds() - StartTime);
+    return true;
+}
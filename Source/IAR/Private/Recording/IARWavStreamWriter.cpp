@@ -0,0 +1,372 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Recording/IARWavStreamWriter.h"
+#include "../IAR.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+#include "Core/IARClockedProducer.h"
+#include "dr_wav.h" // Inclua o cabeçalho do dr_wav SEM A MACRO!!!
+
+// Estado do dr_wav, mantido fora do .h para não expor o dr_wav.h
+struct FIARWavStreamWriter::FDrWavState
+{
+    drwav Wav;
+    bool bIsInitialized = false;
+
+    static size_t OnWrite(void* UserData, const void* Data, size_t BytesToWrite)
+    {
+        FIARWavStreamWriter* Writer = static_cast<FIARWavStreamWriter*>(UserData);
+        return Writer->BufferedWrite(static_cast<const uint8*>(Data), (int64)BytesToWrite) ? BytesToWrite : 0;
+    }
+
+    static drwav_bool32 OnSeek(void* UserData, int Offset, drwav_seek_origin Origin)
+    {
+        FIARWavStreamWriter* Writer = static_cast<FIARWavStreamWriter*>(UserData);
+        // O dr_wav só volta ao cabeçalho (posições absolutas) para corrigir os tamanhos dos chunks
+        const int64 Target = (Origin == DRWAV_SEEK_SET) ? (int64)Offset
+                           : (Origin == DRWAV_SEEK_CUR) ? Writer->WriteBufferFileOffset + Writer->WriteBufferFill + Offset
+                           : Writer->FileEndOffset + Offset;
+        return Writer->BufferedSeek(Target) ? DRWAV_TRUE : DRWAV_FALSE;
+    }
+};
+
+FIARWavStreamWriter::FIARWavStreamWriter()
+    : FileHandle(nullptr)
+    , WavState(nullptr)
+    , WriterThread(nullptr)
+    , BlockPool(nullptr)
+    , DataAvailableEvent(nullptr)
+    , bStopRequested(false)
+    , bHasFailed(false)
+    , bUseRF64(false)
+    , bDeferContainerChoice(false)
+    , WriteBuffer(nullptr)
+    , WriteBufferFill(0)
+    , WriteBufferFileOffset(0)
+    , FileEndOffset(0)
+    , PreallocatedSize(0)
+{
+}
+
+FIARWavStreamWriter::~FIARWavStreamWriter()
+{
+    Close();
+}
+
+bool FIARWavStreamWriter::Open(const FString& InFilePath, int32 SampleRate, int32 NumChannels, EIARSampleFormat SampleFormat, int64 ExpectedDataBytes)
+{
+    if (IsOpen())
+    {
+        UE_LOG(LogIAR, Warning, TEXT("FIARWavStreamWriter: Já existe um arquivo aberto ('%s'). Chame Close() primeiro."), *FilePath);
+        return false;
+    }
+    const int32 BitsPerSample = FIARSampleFormatConverter::GetBitsPerSample(SampleFormat);
+    if (SampleRate <= 0 || NumChannels <= 0)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARWavStreamWriter: Formato inválido. SR: %d, CH: %d"), SampleRate, NumChannels);
+        return false;
+    }
+
+    FilePath = InFilePath;
+    bStopRequested.AtomicSet(false);
+    bHasFailed.AtomicSet(false);
+    DataBytesWritten.Reset();
+    QueuedBytes.Reset();
+    WriteBufferFill = 0;
+    WriteBufferFileOffset = 0;
+    FileEndOffset = 0;
+    PreallocatedSize = 0;
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+    FileHandle = PlatformFile.OpenWrite(*FilePath, false, false);
+    if (!FileHandle)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARWavStreamWriter: Falha ao criar o arquivo '%s'."), *FilePath);
+        return false;
+    }
+
+    WriteBuffer = static_cast<uint8*>(FMemory::Malloc(WriteBlockSize, WriteBlockAlignment));
+
+    // Pré-aloca a primeira extensão já com o tamanho esperado do take (limitado a algumas extensões)
+    const int64 InitialExtent = FMath::Clamp<int64>(Align(FMath::Max<int64>(ExpectedDataBytes, 0) + WriteBlockSize, WriteBlockSize), PreallocationExtentSize, PreallocationExtentSize * 8);
+    if (FileHandle->Truncate(InitialExtent) && FileHandle->Seek(0))
+    {
+        PreallocatedSize = InitialExtent;
+    }
+
+    // RIFF é o mais compatível; RF64 apenas quando o take não cabe em 4GB. Sem estimativa, o cabeçalho RF64
+    // (ds64 no lugar de um JUNK) reserva o espaço e é rebaixado para RIFF ao fechar se os dados couberem.
+    bDeferContainerChoice = (ExpectedDataBytes <= 0);
+    bUseRF64 = (bDeferContainerChoice || ExpectedDataBytes > RIFFMaxDataBytes);
+
+    drwav_data_format Format;
+    Format.container = bUseRF64 ? drwav_container_rf64 : drwav_container_riff;
+    Format.format = FIARSampleFormatConverter::IsFloatFormat(SampleFormat) ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    Format.channels = NumChannels;
+    Format.sampleRate = SampleRate;
+    Format.bitsPerSample = BitsPerSample;
+
+    WavState = new FDrWavState();
+    if (!drwav_init_write(&WavState->Wav, &Format, &FDrWavState::OnWrite, &FDrWavState::OnSeek, this, nullptr))
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARWavStreamWriter: Falha ao inicializar o dr_wav para '%s'."), *FilePath);
+        FinalizeFile();
+        PlatformFile.DeleteFile(*FilePath);
+        return false;
+    }
+    WavState->bIsInitialized = true;
+
+    DataAvailableEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    WriterThread = FRunnableThread::Create(this, TEXT("IARWavStreamWriterThread"), 0, TPri_AboveNormal);
+    if (!WriterThread)
+    {
+        UE_LOG(LogIAR, Error, TEXT("FIARWavStreamWriter: Falha ao criar a thread de I/O para '%s'."), *FilePath);
+        FinalizeFile();
+        FPlatformProcess::ReturnSynchEventToPool(DataAvailableEvent);
+        DataAvailableEvent = nullptr;
+        return false;
+    }
+
+    UE_LOG(LogIAR, Log, TEXT("FIARWavStreamWriter: Gravando '%s' (%s, %d Hz, %d canais, %d bits)."), *FilePath,
+        bDeferContainerChoice ? TEXT("RIFF/RF64 decidido ao fechar") : (bUseRF64 ? TEXT("RF64") : TEXT("RIFF")), SampleRate, NumChannels, BitsPerSample);
+    return true;
+}
+
+bool FIARWavStreamWriter::EnqueueSamples(TArray<uint8>&& SampleBytes)
+{
+    if (!IsOpen() || bStopRequested || bHasFailed)
+    {
+        return false;
+    }
+    if (SampleBytes.Num() > 0)
+    {
+        QueuedBytes.Add(SampleBytes.Num());
+        PendingBlocks.Enqueue(MoveTemp(SampleBytes));
+        DataAvailableEvent->Trigger();
+    }
+    return true;
+}
+
+bool FIARWavStreamWriter::Close()
+{
+    if (!WriterThread)
+    {
+        return !bHasFailed;
+    }
+
+    Stop();
+    WriterThread->WaitForCompletion();
+    delete WriterThread;
+    WriterThread = nullptr;
+
+    FPlatformProcess::ReturnSynchEventToPool(DataAvailableEvent);
+    DataAvailableEvent = nullptr;
+
+    UE_LOG(LogIAR, Log, TEXT("FIARWavStreamWriter: Arquivo '%s' finalizado (%lld bytes de áudio)."), *FilePath, DataBytesWritten.GetValue());
+    return !bHasFailed;
+}
+
+uint32 FIARWavStreamWriter::Run()
+{
+    for (;;)
+    {
+        TArray<uint8> Block;
+        if (PendingBlocks.Dequeue(Block))
+        {
+            QueuedBytes.Subtract(Block.Num());
+            FIARClockedProducer::NotifyCapacityAvailable();
+            if (bHasFailed)
+            {
+                // Esvazia a fila sem escrever
+            }
+            else if (!bUseRF64 && DataBytesWritten.GetValue() + Block.Num() > RIFFMaxDataBytes)
+            {
+                // O cabeçalho já foi escrito como RIFF: o arquivo é finalizado válido, mas sem o excedente
+                FailWithError(TEXT("limite de 4GB do RIFF atingido; amostras excedentes descartadas"));
+            }
+            else
+            {
+                const size_t BytesWritten = drwav_write_raw(&WavState->Wav, Block.Num(), Block.GetData());
+                DataBytesWritten.Add((int64)BytesWritten);
+                if (BytesWritten != (size_t)Block.Num())
+                {
+                    FailWithError(TEXT("escrita incompleta no disco"));
+                }
+            }
+
+            if (BlockPool)
+            {
+                BlockPool->Release(MoveTemp(Block));
+            }
+        }
+        else if (bStopRequested)
+        {
+            break; // Fila vazia e nenhum bloco novo virá
+        }
+        else
+        {
+            DataAvailableEvent->Wait(100);
+        }
+    }
+
+    FinalizeFile();
+    return 0;
+}
+
+void FIARWavStreamWriter::Stop()
+{
+    bStopRequested.AtomicSet(true);
+    if (DataAvailableEvent) { DataAvailableEvent->Trigger(); }
+}
+
+bool FIARWavStreamWriter::BufferedWrite(const uint8* Data, int64 NumBytes)
+{
+    while (NumBytes > 0)
+    {
+        const int64 Count = FMath::Min(NumBytes, WriteBlockSize - WriteBufferFill);
+        FMemory::Memcpy(WriteBuffer + WriteBufferFill, Data, Count);
+        WriteBufferFill += Count;
+        Data += Count;
+        NumBytes -= Count;
+
+        if (WriteBufferFill == WriteBlockSize && !FlushWriteBuffer())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FIARWavStreamWriter::BufferedSeek(int64 Offset)
+{
+    if (!FlushWriteBuffer() || !FileHandle->Seek(Offset))
+    {
+        return false;
+    }
+    WriteBufferFileOffset = Offset;
+    return true;
+}
+
+bool FIARWavStreamWriter::FlushWriteBuffer()
+{
+    if (WriteBufferFill == 0)
+    {
+        return true;
+    }
+
+    const int64 EndOffset = WriteBufferFileOffset + WriteBufferFill;
+    if (EndOffset > PreallocatedSize)
+    {
+        // Estende o arquivo uma extensão inteira à frente, para o sistema de arquivos alocar blocos contíguos
+        const int64 NewSize = Align(EndOffset, PreallocationExtentSize) + PreallocationExtentSize;
+        if (FileHandle->Truncate(NewSize))
+        {
+            PreallocatedSize = NewSize;
+        }
+        FileHandle->Seek(WriteBufferFileOffset);
+    }
+
+    if (!FileHandle->Write(WriteBuffer, WriteBufferFill))
+    {
+        FailWithError(TEXT("falha ao escrever no arquivo"));
+        return false;
+    }
+
+    FileEndOffset = FMath::Max(FileEndOffset, EndOffset);
+    WriteBufferFileOffset = EndOffset;
+    WriteBufferFill = 0;
+    return true;
+}
+
+void FIARWavStreamWriter::FinalizeFile()
+{
+    if (WavState)
+    {
+        // drwav_uninit escreve o padding e volta ao cabeçalho (via OnSeek) para corrigir os tamanhos
+        if (WavState->bIsInitialized)
+        {
+            const bool bUninitialized = (drwav_uninit(&WavState->Wav) == DRWAV_SUCCESS);
+            const int64 DataBytes = (int64)WavState->Wav.dataChunkDataSize;
+            if (bUninitialized && bDeferContainerChoice && FileHandle && DataBytes <= RIFFMaxDataBytes)
+            {
+                if (RewriteHeaderAsRIFF((int64)WavState->Wav.dataChunkDataPos, DataBytes))
+                {
+                    bUseRF64 = false;
+                }
+                else
+                {
+                    // O cabeçalho RF64 escrito pelo dr_wav continua válido
+                    UE_LOG(LogIAR, Warning, TEXT("FIARWavStreamWriter: Não foi possível reescrever '%s' como RIFF; mantido como RF64."), *FilePath);
+                }
+            }
+        }
+        delete WavState;
+        WavState = nullptr;
+    }
+
+    if (FileHandle)
+    {
+        FlushWriteBuffer();
+        // Descarta a parte pré-alocada e não usada
+        if (PreallocatedSize > FileEndOffset && !FileHandle->Truncate(FileEndOffset))
+        {
+            FailWithError(TEXT("falha ao cortar a pré-alocação"));
+        }
+        FileHandle->Flush();
+        delete FileHandle;
+        FileHandle = nullptr;
+    }
+
+    if (WriteBuffer)
+    {
+        FMemory::Free(WriteBuffer);
+        WriteBuffer = nullptr;
+    }
+    WriteBufferFill = 0;
+}
+
+bool FIARWavStreamWriter::RewriteHeaderAsRIFF(int64 DataChunkDataPos, int64 DataBytes)
+{
+    // O cursor está depois do padding final: o tamanho do arquivo é o maior offset escrito ou bufferizado
+    const int64 FileSize = FMath::Max(FileEndOffset, WriteBufferFileOffset + WriteBufferFill);
+    if (DataChunkDataPos < 12 + 36 + 8 || FileSize - 8 > 0xFFFFFFFFll)
+    {
+        return false;
+    }
+
+    auto AppendU32 = [](TArray<uint8>& Bytes, uint32 Value)
+    {
+        for (int32 Shift = 0; Shift < 32; Shift += 8)
+        {
+            Bytes.Add((uint8)(Value >> Shift));
+        }
+    };
+
+    // "RIFF" <tamanho> "WAVE" "JUNK" <28> <28 bytes zerados>: mesmo layout do "RF64" ... "ds64" que está no disco
+    TArray<uint8> Header;
+    Header.Append(reinterpret_cast<const uint8*>("RIFF"), 4);
+    AppendU32(Header, (uint32)(FileSize - 8));
+    Header.Append(reinterpret_cast<const uint8*>("WAVEJUNK"), 8);
+    AppendU32(Header, 28);
+    Header.AddZeroed(28);
+
+    TArray<uint8> DataSize;
+    AppendU32(DataSize, (uint32)DataBytes);
+
+    return BufferedSeek(0) && BufferedWrite(Header.GetData(), Header.Num())
+        && BufferedSeek(DataChunkDataPos - 4) && BufferedWrite(DataSize.GetData(), DataSize.Num())
+        && BufferedSeek(FileSize) && FlushWriteBuffer();
+}
+
+void FIARWavStreamWriter::FailWithError(const FString& ErrorMessage)
+{
+    bHasFailed.AtomicSet(true);
+    UE_LOG(LogIAR, Error, TEXT("FIARWavStreamWriter: Erro em '%s': %s."), *FilePath, *ErrorMessage);
+}
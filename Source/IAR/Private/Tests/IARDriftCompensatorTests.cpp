@@ -0,0 +1,134 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#include "Misc/AutomationTest.h"
+#include "Core/IARDriftCompensator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace IARDriftCompensatorTestsPrivate
+{
+    /** Um cenário: relógio do secundário com deriva conhecida e os blocos entregues pelos dois drivers. */
+    struct FDriftScenario
+    {
+        double DriftPPM;
+        int32 MasterSampleRate;
+        int32 MasterBlockFrames;
+        int32 SecondarySampleRate;
+        int32 SecondaryBlockFrames;
+        int32 TargetLatencyMs;
+    };
+
+    struct FDriftResult
+    {
+        double EstimatedDriftPPM = 0.0;
+        int32 UnderrunCount = 0;
+        int32 FailedPullsAfterPriming = 0;
+        int32 TargetLatencyFrames = 0;
+    };
+
+    /**
+     * Intercala os callbacks dos dois dispositivos pelo horário simulado: o mestre a cada MasterBlockFrames na taxa nominal,
+     * o secundário a cada SecondaryBlockFrames na taxa nominal corrigida pela deriva.
+     */
+    FDriftResult RunScenario(const FDriftScenario& Scenario, double SimulatedSeconds)
+    {
+        FIARDriftCompensator Compensator;
+        const int32 TargetLatencyFrames = Scenario.SecondarySampleRate * Scenario.TargetLatencyMs / 1000;
+        Compensator.Initialize(1, Scenario.SecondarySampleRate, Scenario.MasterSampleRate, TargetLatencyFrames,
+            Scenario.MasterBlockFrames, Scenario.SecondaryBlockFrames);
+
+        TArray<float> SecondaryBlock;
+        SecondaryBlock.Init(0.25f, Scenario.SecondaryBlockFrames);
+        TArray<float> MasterBlock;
+        MasterBlock.SetNumZeroed(Scenario.MasterBlockFrames);
+
+        const double SecondaryClockRate = Scenario.SecondarySampleRate * (1.0 + Scenario.DriftPPM * 1.0e-6);
+        int64 MasterCallbacks = 0;
+        int64 SecondaryCallbacks = 0;
+        bool bPrimed = false;
+
+        FDriftResult Result;
+        for (;;)
+        {
+            const double MasterTime = (double)MasterCallbacks * Scenario.MasterBlockFrames / Scenario.MasterSampleRate;
+            if (MasterTime >= SimulatedSeconds)
+            {
+                break;
+            }
+            const double SecondaryTime = (double)SecondaryCallbacks * Scenario.SecondaryBlockFrames / SecondaryClockRate;
+            if (SecondaryTime <= MasterTime)
+            {
+                Compensator.Push(SecondaryBlock.GetData(), Scenario.SecondaryBlockFrames, 1, SecondaryTime);
+                ++SecondaryCallbacks;
+                continue;
+            }
+
+            const bool bPulled = Compensator.Pull(MasterBlock.GetData(), 1, 0, Scenario.MasterBlockFrames, MasterTime);
+            if (bPulled)
+            {
+                bPrimed = true;
+            }
+            else if (bPrimed)
+            {
+                ++Result.FailedPullsAfterPriming;
+            }
+            ++MasterCallbacks;
+        }
+
+        Result.EstimatedDriftPPM = Compensator.GetEstimatedDriftPPM();
+        Result.UnderrunCount = Compensator.GetUnderrunCount();
+        Result.TargetLatencyFrames = Compensator.GetTargetLatencyFrames();
+        return Result;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIARDriftCompensatorConvergenceTest, "IAR.Core.DriftCompensator.Convergence",
+    EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FIARDriftCompensatorConvergenceTest::RunTest(const FString& Parameters)
+{
+    using namespace IARDriftCompensatorTestsPrivate;
+
+    // Dez minutos cobrem a acomodação do controlador (constante de tempo de pouco mais de um minuto)
+    constexpr double SimulatedSeconds = 600.0;
+    constexpr double TolerancePPM = 5.0;
+
+    const double DriftsPPM[] = { 100.0, -250.0, 1000.0, -1000.0 };
+    const FDriftScenario BlockLayouts[] = {
+        // Janela de análise de 4096 frames: o bloco do mestre (85 ms) é maior que a latência padrão de 40 ms
+        { 0.0, 48000, 4096, 48000, 4096, 40 },
+        { 0.0, 48000, 480, 48000, 480, 40 },
+        { 0.0, 48000, 4096, 48000, 480, 40 },
+        // Secundário em outra taxa, com blocos que não dividem os do mestre
+        { 0.0, 48000, 1024, 44100, 441, 40 },
+    };
+
+    for (const FDriftScenario& Layout : BlockLayouts)
+    {
+        for (const double DriftPPM : DriftsPPM)
+        {
+            FDriftScenario Scenario = Layout;
+            Scenario.DriftPPM = DriftPPM;
+            const FDriftResult Result = RunScenario(Scenario, SimulatedSeconds);
+
+            const FString Context = FString::Printf(TEXT("%+.0f ppm, mestre %d@%d, secundário %d@%d"),
+                DriftPPM, Scenario.MasterBlockFrames, Scenario.MasterSampleRate, Scenario.SecondaryBlockFrames, Scenario.SecondarySampleRate);
+            TestTrue(FString::Printf(TEXT("%s: latência alvo (%d) cobre os blocos"), *Context, Result.TargetLatencyFrames),
+                Result.TargetLatencyFrames >= FIARDriftCompensator::GetMinimumTargetFrames(
+                    (double)Scenario.SecondarySampleRate / Scenario.MasterSampleRate, Scenario.SecondarySampleRate,
+                    Scenario.MasterBlockFrames, Scenario.SecondaryBlockFrames));
+            TestEqual(FString::Printf(TEXT("%s: underruns"), *Context), Result.UnderrunCount, 0);
+            TestEqual(FString::Printf(TEXT("%s: Pulls sem dados depois do enchimento"), *Context), Result.FailedPullsAfterPriming, 0);
+            TestTrue(FString::Printf(TEXT("%s: deriva estimada %.2f ppm"), *Context, Result.EstimatedDriftPPM),
+                FMath::Abs(Result.EstimatedDriftPPM - DriftPPM) <= TolerancePPM);
+        }
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -129,6 +129,7 @@ void UIARDisplayWidget::OnRealTimeFrameReadyHandler(const FIAR_JustRTFrame& Fram
     CurrentSpectrogramTexture = FrameData.SpectrogramTexture;
     CurrentWaveFormTexture = FrameData.WaveformTexture;
     CurrentFilterTexture = FrameData.FilteredSpectrogramTexture;
+    CurrentSpectrogramScrollOffset = FrameData.SpectrogramScrollOffset;
     // IMPORTANTE: O UMG detecta automaticamente que a textura para a qual CurrentLiveTexture
     // aponta foi atualizada (pois o UIVRCaptureComponent escreve novos pixels nela) e redesenha o Image.
     // Não é necessário fazer mais nada aqui para que a imagem no UMG se atualize.
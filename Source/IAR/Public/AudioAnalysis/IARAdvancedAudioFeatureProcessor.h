@@ -90,14 +90,26 @@ public: // As propriedades p�blicas restantes, que s�o inicializadas depois
      */
     const TArray<FColor>& GetFilteredSpectrogramPixels(int32& OutWidth, int32& OutHeight) const;
 
+    /**
+     * @brief Retorna o total de colunas escritas nos espectrogramas desde o Initialize.
+     * Os pixels dos espectrogramas são um buffer circular: a coluna (Total % Largura) é a próxima a ser escrita
+     * (e portanto a mais antiga). Consumidores usam este contador para enviar à GPU apenas as colunas novas.
+     */
+    uint64 GetSpectrogramColumnsWritten() const { return SpectrogramColumnsWritten; }
+
+    virtual TConstArrayView<float> GetLastSpectrum() const override { return LastSpectrum; }
+
 private:
-    // Hist�rico de espectros para construir um espectrograma visual (UTexture2D)
-    TArray<TArray<float>> SpectrogramDataHistory; // Armazena espectros de frames recentes (N�O FILTRADO)
-    TArray<TArray<float>> FilteredSpectrogramDataHistory; // NOVO: Armazena espectros de frames recentes (FILTRADO)
-    
-    // Buffer de pixels gerado na Audio Thread, pronto para ser copiado para a UTexture2D na Game Thread
+    // Buffer de pixels gerado na Audio Thread, pronto para ser copiado para a UTexture2D na Game Thread.
+    // Os espectrogramas são buffers circulares de colunas: cada frame escreve apenas uma coluna nova.
     TArray<FColor> CurrentSpectrogramPixels; // N�O FILTRADO
     TArray<FColor> CurrentFilteredSpectrogramPixels; // NOVO: FILTRADO
+
+    // Total de colunas escritas (a coluna de escrita atual é SpectrogramColumnsWritten % MaxSpectrogramHistoryFrames)
+    uint64 SpectrogramColumnsWritten = 0;
+
+    // Espectro (não filtrado) do último frame processado, reutilizado entre frames e exposto via GetLastSpectrum
+    TArray<float> LastSpectrum;
     
     // NOVO: Buffer de pixels para a waveform
     TArray<FColor> CurrentWaveformPixels;
@@ -128,13 +140,17 @@ private:
     TArray<FIAR_AudioNoteFeature> FindTopFrequencyNotes(const TArray<float>& Spectrum, int32 SampleRate, int32 NumPeaks = 3);
     
     /**
-     * @brief Gera os pixels para o espectrograma a partir do hist�rico.
-     * @param OutPixels A TArray<FColor> para armazenar os pixels gerados.
-     * @param Width Largura desejada da imagem.
-     * @param Height Altura desejada da imagem.
-     * @param InHistory O hist�rico de espectros a ser usado (filtrado ou n�o filtrado).
+     * @brief Escreve uma única coluna do espectrograma circular a partir do espectro do frame atual.
+     * @param InOutPixels A TArray<FColor> do espectrograma (Width * Height), alocada se necessário.
+     * @param Width Largura da imagem (número de colunas do histórico).
+     * @param Height Altura da imagem (bins de frequência).
+     * @param Column A coluna a ser escrita.
+     * @param Spectrum O espectro (filtrado ou não filtrado) do frame atual.
      */
-    void GenerateSpectrogramPixels(TArray<FColor>& OutPixels, int32 Width, int32 Height, const TArray<TArray<float>>& InHistory);
+    void WriteSpectrogramColumn(TArray<FColor>& InOutPixels, int32 Width, int32 Height, int32 Column, const TArray<float>& Spectrum);
+
+    /** @brief Converte a magnitude normalizada de um bin em cor do espectrograma. */
+    static FColor SpectrogramValueToColor(float Value);
 
     /**
      * @brief Gera os pixels para a waveform a partir das amostras de �udio.
@@ -0,0 +1,72 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/IAR_Types.h"
+
+/**
+ * @brief Acumula as features de vários frames analisados para entregá-las a uma taxa menor (ex: 30Hz para Blueprint).
+ * - Métricas instantâneas (RMS, Peak, ZCR, espectrais, Pitch, MFCCs): agregadas conforme EIARFeatureAggregationMode.
+ * - Métricas do Attitude-Gram (já cumulativas no processador): sempre o último valor.
+ * - DetectedNotes: união por nota MIDI (mantém a maior velocidade); ProcessedMIDIEvents: os eventos em ordem,
+ *   limitados a MaxMIDIEvents (os mais antigos são descartados e contados em GetNumDroppedMIDIEvents).
+ * Não é thread-safe, deve ser usado por uma única thread.
+ */
+struct IAR_API FIARFeatureAggregator
+{
+public:
+    /** Limite padrão de eventos MIDI retidos (segundos de notas densas; evita crescimento sem fim sem consumidor). */
+    static constexpr int32 DefaultMaxMIDIEvents = 1024;
+
+    explicit FIARFeatureAggregator(int32 InMaxMIDIEvents = DefaultMaxMIDIEvents);
+
+    /**
+     * @brief Adiciona as features de um frame analisado.
+     */
+    void Accumulate(const FIAR_AudioFeatures& Features);
+
+    /**
+     * @brief Incorpora o conteúdo de outro agregador.
+     * Other deve conter frames mais recentes que os já acumulados aqui (o "último valor" passa a ser o de Other).
+     */
+    void Merge(const FIARFeatureAggregator& Other);
+
+    /**
+     * @brief Produz as features agregadas.
+     * @param Mode O modo de agregação das métricas instantâneas.
+     * @param OutFeatures Estrutura de saída (seus arrays são reaproveitados).
+     */
+    void Finalize(EIARFeatureAggregationMode Mode, FIAR_AudioFeatures& OutFeatures) const;
+
+    /** @brief Descarta tudo o que foi acumulado (mantém a memória reservada). */
+    void Reset();
+
+    /** @brief Número de frames acumulados. */
+    int32 GetNumFrames() const { return NumFrames; }
+
+    /** @brief Altera o limite de eventos MIDI retidos (o excesso atual é descartado imediatamente). */
+    void SetMaxMIDIEvents(int32 InMaxMIDIEvents);
+
+    /** @brief Eventos MIDI descartados por exceder o limite desde o último Reset (inclui os dos agregadores incorporados). */
+    int32 GetNumDroppedMIDIEvents() const { return NumDroppedMIDIEvents; }
+
+private:
+    int32 NumFrames;
+    int32 MaxMIDIEvents;
+    int32 NumDroppedMIDIEvents;
+    FIAR_AudioFeatures SumFeatures;  // Somatório das métricas instantâneas
+    FIAR_AudioFeatures MaxFeatures;  // Máximo das métricas instantâneas
+    FIAR_AudioFeatures LastFeatures; // Último frame (inclui Attitude-Gram)
+
+    TArray<FIAR_AudioNoteFeature> UnionNotes;
+    TArray<FIAR_MIDIEvent> AllMIDIEvents;
+
+    void AddNote(const FIAR_AudioNoteFeature& Note);
+    void TrimMIDIEvents();
+};
@@ -45,6 +45,12 @@ public:
      */
     virtual FIAR_AudioFeatures ProcessFrame(const TSharedPtr<FIAR_AudioFrameData>& AudioFrame, UTexture2D*& OutSpectrogramTexture);
 
+    /**
+     * @brief Retorna uma visão somente-leitura do espectro de magnitude calculado no último ProcessFrame.
+     * A visão é válida apenas até a próxima chamada de ProcessFrame (na mesma thread). Vazia se o processador não calcula espectro.
+     */
+    virtual TConstArrayView<float> GetLastSpectrum() const { return TConstArrayView<float>(); }
+
     /**
      * @brief Aplica um Noise Gate aos samples de áudio.
      * @param Samples Array de samples de áudio a serem processados.
@@ -0,0 +1,99 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * @brief Resumo (Min/Max/RMS) de uma coluna da waveform.
+ */
+struct IAR_API FIAR_WaveformColumn
+{
+    float Min = 0.0f;
+    float Max = 0.0f;
+    float RMS = 0.0f;
+    bool bHasData = false;
+};
+
+/**
+ * @brief Pirâmide de resumo de waveform (Min/Max/RMS), construída de forma incremental enquanto o áudio é capturado ou carregado.
+ * O nível 0 resume blocos de BaseBlockFrames frames; cada nível acima une dois blocos do nível anterior.
+ * Consultas escolhem o nível mais grosso que ainda tem resolução suficiente, então renderizar custa O(pixels),
+ * independente da duração do áudio (horas de gravação não exigem reler o PCM).
+ * Memória limitada: quando o nível mais fino retido passa de MaxFinestBuckets blocos, ele é descartado e o nível
+ * acima passa a ser o mais fino. A pirâmide nunca guarda mais que ~2x MaxFinestBuckets blocos; em capturas longas
+ * a resolução máxima diminui com o tempo em vez de a memória crescer.
+ * Thread-safe: um produtor (captura/carregamento) e consultas de qualquer thread.
+ */
+class IAR_API FIARWaveformSummary
+{
+public:
+    /** Limite padrão do nível mais fino: 256K blocos (~22 min a 48 kHz em resolução total, ~12 MB no total). */
+    static constexpr int32 DefaultMaxFinestBuckets = 256 * 1024;
+
+    explicit FIARWaveformSummary(int32 InBaseBlockFrames = 256, int32 InMaxFinestBuckets = DefaultMaxFinestBuckets);
+
+    /**
+     * @brief Descarta o resumo e define o formato do áudio que será adicionado.
+     */
+    void Reset(int32 InSampleRate, int32 InNumChannels);
+
+    /**
+     * @brief Adiciona amostras intercaladas ao resumo. Frames parciais são mantidos para a próxima chamada.
+     * Min/Max/RMS são calculados sobre todos os canais.
+     */
+    void AppendInterleaved(const float* Samples, int64 NumSamples);
+
+    /**
+     * @brief Calcula NumColumns colunas cobrindo o intervalo [StartSeconds, EndSeconds).
+     * @return false se o resumo estiver vazio ou os parâmetros forem inválidos.
+     */
+    bool GetColumns(double StartSeconds, double EndSeconds, int32 NumColumns, TArray<FIAR_WaveformColumn>& OutColumns) const;
+
+    /**
+     * @brief Renderiza o intervalo [StartSeconds, EndSeconds) em uma imagem Width x Height (Min/Max + faixa de RMS).
+     */
+    void RenderPixels(double StartSeconds, double EndSeconds, int32 Width, int32 Height, TArray<FColor>& OutPixels) const;
+
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+    int64 GetNumFrames() const;
+    double GetDurationSeconds() const;
+    bool IsEmpty() const { return GetNumFrames() == 0; }
+
+private:
+    struct FBucket
+    {
+        float Min = 0.0f;
+        float Max = 0.0f;
+        double SumSquares = 0.0;
+        int64 NumSamples = 0;
+
+        void Merge(const FBucket& Other);
+    };
+
+    mutable FCriticalSection SummaryLock;
+
+    int32 BaseBlockFrames;
+    int32 MaxFinestBuckets;
+    int32 FinestLevel;          // Níveis abaixo deste foram descartados pelo limite de memória
+    int32 SampleRate;
+    int32 NumChannels;
+
+    int64 TotalFrames;          // Frames completos adicionados
+    int32 SamplesInCurrentFrame; // Amostras do frame parcial (0..NumChannels-1)
+    int32 FramesInPartialBlock;  // Frames acumulados em PartialBuckets[0]
+
+    TArray<TArray<FBucket>> Levels;     // Blocos completos por nível
+    TArray<FBucket> PartialBuckets;     // Bloco em construção por nível
+    TArray<int32> PartialChildren;      // Quantos blocos filhos já foram unidos no bloco em construção (níveis > 0)
+
+    void PushBucket(int32 Level, const FBucket& Bucket);
+    void MergeRange(int32 Level, int64 FrameStart, int64 FrameEnd, FBucket& Accumulator) const;
+};
@@ -29,6 +29,10 @@
 #include "Recording/IARMIDIFileSource.h" // NOVO: Adicionado para MIDIFileSource
 #include "Recording/IARAudioFolderSource.h" // <<-- ADICIONADO
 #include "Core/IARSampleRateConverter.h" 
+#include "Core/IARRealTimeFrameMailbox.h"
+#include "AudioAnalysis/IARFeatureAggregator.h"
+#include "AudioAnalysis/IARWaveformSummary.h"
+#include "HAL/ThreadSafeCounter64.h"
 
 #include "../Core/IARLambdaLatentAction.h" // ADICIONADO: Para usar nossa LambdaLatentAction
 
@@ -44,6 +48,9 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnIARRecordingStopped);
 // --- DELEGATE PARA FRAMES EM TEMPO REAL (PADRÃO IVR) ---
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnRealTimeAudioFrameReady, const FIAR_JustRTFrame&, RealTimeFrame);
 
+// --- DELEGATE NATIVO (C++) PARA FRAMES EM TEMPO REAL: visões sem cópia, sem reflexão ---
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnIARRealTimeFrameNative, const FIAR_RTFrameView& /*FrameView*/);
+
 // --- DELEGATES PARA FEEDBACK DO PROCESSAMENTO DE DIRETÓRIO (NOVOS) ---
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnIARFolderProcessingCompleted, const FString&, OutputFolderPath);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnIARFolderProcessingError, const FString&, ErrorMessage);
@@ -60,6 +67,7 @@ public:
 
     virtual void BeginPlay() override;
     virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override; 
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
     UFUNCTION(BlueprintCallable, Category = "IAR|Audio Component")
     void SetupAudioComponent(const FIAR_AudioStreamSettings& StreamSettings);
@@ -100,6 +108,21 @@ public:
     UPROPERTY(BlueprintAssignable, Category = "IAR|Real-Time Features Events")
     FOnRealTimeAudioFrameReady OnRealTimeAudioFrameReady; 
 
+    /**
+     * Assinatura nativa na THREAD DE ANÁLISE (thread da fonte de áudio), disparada para cada frame analisado.
+     * Visões diretas sobre o frame do pool e o espectro do processador: zero cópias, taxa máxima.
+     * Regras: o callback deve ser curto e não bloqueante; as visões só valem durante o callback;
+     * faça Add/Remove apenas com a captura parada (antes de StartRecording / depois de StopRecording).
+     */
+    FOnIARRealTimeFrameNative OnRealTimeFrameAnalyzedNative;
+
+    /**
+     * Assinatura nativa na GAME THREAD, disparada junto com OnRealTimeAudioFrameReady (na taxa FeatureBroadcastRateHz),
+     * com visões sobre o snapshot da caixa de correio e as features agregadas. Nenhuma cópia por assinante.
+     * As visões só valem durante o callback. Samples fica vazio a menos que bCopyRawAudioToGameThread esteja habilitado.
+     */
+    FOnIARRealTimeFrameNative OnRealTimeFrameReadyNative;
+
     // (Novos) Delegates para Feedback do Processamento de Diretório
     UPROPERTY(BlueprintAssignable, Category = "IAR|Folder Processing Events")
     FOnIARFolderProcessingCompleted OnFolderProcessingCompleted;
@@ -137,6 +160,52 @@ protected:
 
     FIARSampleRateConverter SampleRateConverter; 
 
+    // Caixa de correio "último valor" entre a thread de áudio (produtor) e o Tick da Game Thread (consumidor).
+    // Substitui o AsyncTask por frame: no máximo um snapshot é consumido por frame de jogo.
+    FIARRealTimeFrameMailbox RealTimeFrameMailbox;
+
+    // --- TAXAS DE SAÍDA EM TEMPO REAL (independentes da taxa de análise) ---
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Real-Time Features", 
+              meta = (ClampMin = "0.0", Tooltip = "Taxa máxima (Hz) de atualização das texturas de visualização. 0 = a cada frame de jogo com dados novos."))
+    float VisualizationUpdateRateHz = 0.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Real-Time Features", 
+              meta = (ClampMin = "0.0", Tooltip = "Taxa (Hz, em tempo de áudio) de broadcast de OnRealTimeAudioFrameReady. As features analisadas entre broadcasts são agregadas. 0 = a cada frame analisado (no máximo um broadcast por frame de jogo)."))
+    float FeatureBroadcastRateHz = 30.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Real-Time Features", 
+              meta = (Tooltip = "Como as métricas instantâneas são agregadas entre broadcasts. Notas detectadas são sempre unidas e eventos MIDI concatenados."))
+    EIARFeatureAggregationMode FeatureAggregationMode = EIARFeatureAggregationMode::Mean;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Real-Time Features", 
+              meta = (Tooltip = "Copia as amostras de cada frame para a Game Thread (FIAR_JustRTFrame.RawAudioBuffer e Samples dos assinantes nativos da Game Thread). Desligado evita a cópia por frame."))
+    bool bCopyRawAudioToGameThread = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Real-Time Features", 
+              meta = (ClampMin = "16", Tooltip = "Máximo de eventos MIDI retidos enquanto a Game Thread não transmite as janelas pendentes. Os mais antigos são descartados (ver GetNumDroppedMIDIEvents)."))
+    int32 MaxPendingMIDIEvents = FIARFeatureAggregator::DefaultMaxMIDIEvents;
+
+    // Estado do produtor (thread da fonte de áudio)
+    FIARFeatureAggregator FeatureWindowAggregator;   // Janela de broadcast em andamento
+    FIARFeatureAggregator PendingFeatureAggregator;  // Janelas concluídas ainda não transmitidas
+    FIAR_AudioFeatures PendingAggregatedFeatures;    // Resultado de PendingFeatureAggregator, copiado para os snapshots
+    uint64 PendingAggregatedFeaturesVersion = 0;     // Muda a cada Finalize (nunca zera): evita recopiar features que o snapshot já tem
+    float FeatureWindowElapsedSeconds = 0.0f;
+    uint64 PublishedFeatureWindowSequence = 0;
+    int32 PendingAggregatedFrames = 0;
+
+    // Última janela transmitida pela Game Thread (lida pelo produtor para descartar janelas já entregues)
+    FThreadSafeCounter64 AcknowledgedFeatureWindowSequence;
+
+    // Eventos MIDI descartados pelo limite MaxPendingMIDIEvents na sessão de tempo real atual
+    FThreadSafeCounter DroppedMIDIEventCount;
+
+    // Estado do consumidor (Game Thread)
+    const FIAR_RTFrameSnapshot* LatestRealTimeSnapshot = nullptr; // Válido até o próximo ConsumeLatest
+    bool bRealTimeVisualizationDirty = false;
+    float VisualizationTimeAccumulator = 0.0f;
+    uint64 LastBroadcastFeatureWindowSequence = 0;
+
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "IAR|Audio Devices")
     TArray<FIAR_AudioDeviceInfo> AvailableAudioInputDevices_BPFriendly;
 
@@ -157,6 +226,12 @@ protected:
     UPROPERTY() // NOVO: O componente é dono da textura do espectrograma filtrado
     UTexture2D* FilteredSpectrogramTexture; 
 
+    UPROPERTY() // Textura da visão geral da waveform (RenderWaveformOverview)
+    UTexture2D* WaveformOverviewTexture = nullptr;
+
+    // Pirâmide Min/Max/RMS de todo o áudio processado na sessão (captura ao vivo, simulado, arquivo)
+    FIARWaveformSummary SessionWaveformSummary;
+
     UPROPERTY()
     TObjectPtr<UIARAudioToMIDITranscriber> MIDITranscriber; 
 
@@ -191,6 +266,43 @@ protected:
     void OnAudioFrameAcquired(TSharedPtr<FIAR_AudioFrameData> AudioFrame);
     void OnMIDIFrameAcquired(TSharedPtr<FIAR_MIDIFrame> MIDIFrame);
 
+    /**
+     * @brief Backpressure para fontes offline (chamado na thread da fonte): com análise em tempo real o processamento
+     * é síncrono e sempre há capacidade; na gravação, depende da fila do encoder.
+     */
+    bool HasPipelineCapacity() const;
+
+    /**
+     * @brief Publica o resultado da análise em tempo real na caixa de correio (chamado na thread da fonte de áudio).
+     */
+    void PublishRealTimeSnapshot(const TSharedPtr<FIAR_AudioFrameData>& ProcessedFrame, const FIAR_AudioFeatures& Features, float FrameDuration);
+
+    /**
+     * @brief Consome o snapshot mais recente e, respeitando as taxas configuradas, atualiza as texturas de depuração
+     * e dispara OnRealTimeAudioFrameReady (Game Thread).
+     */
+    void ConsumeRealTimeSnapshot(float DeltaTime);
+
+    /** @brief Limpa o estado de entrega em tempo real. Chamar apenas com a captura parada. */
+    void ResetRealTimeDelivery();
+
+    /**
+     * @brief (Re)cria a textura transiente se necessário e agenda o upload dos pixels via UpdateTextureRegions.
+     * @param ColumnsWritten Total de colunas escritas na imagem circular pelo produtor.
+     * @param InOutUploadedColumns Total de colunas já enviadas à GPU. Se nullptr, a imagem inteira é enviada (ex: waveform).
+     * @return A textura atualizada ou nullptr se os pixels forem inválidos.
+     */
+    UTexture2D* UpdateDebugTexture(UTexture2D*& Texture, const TArray<FColor>& Pixels, int32 Width, int32 Height, uint64 ColumnsWritten, uint64* InOutUploadedColumns, const TCHAR* DebugName);
+
+    /**
+     * @brief Envia à GPU apenas as colunas [FirstColumn, FirstColumn + NumColumns) (com wrap-around) de uma imagem.
+     */
+    static void UploadTextureColumns(UTexture2D* Texture, const TArray<FColor>& Pixels, int32 Width, int32 Height, int32 FirstColumn, int32 NumColumns);
+
+    // Colunas dos espectrogramas circulares já enviadas à GPU (Game Thread)
+    uint64 UploadedSpectrogramColumns = 0;
+    uint64 UploadedFilteredSpectrogramColumns = 0;
+
     // Handlers para os Delegates do UIARFolderSource (para retransmitir ou processar eventos)
     UFUNCTION()
     void HandleFolderProcessingCompleted(const FString& OutputFolderPath);
@@ -202,6 +314,32 @@ protected:
     void HandleFolderProcessingProgress(const FString& CurrentFileName, float ProgressRatio);
 
 public: 
+    /**
+     * @brief Renderiza a visão geral da waveform do intervalo [StartSeconds, EndSeconds) em uma textura.
+     * Usa a pirâmide de resumo (custo proporcional aos pixels, não à duração): o arquivo inteiro se a fonte
+     * for um arquivo carregado, ou todo o áudio processado na sessão atual nos demais casos.
+     * @param EndSeconds Se <= StartSeconds, renderiza até o fim do áudio disponível.
+     */
+    UFUNCTION(BlueprintCallable, Category = "IAR|Waveform Overview")
+    UTexture2D* RenderWaveformOverview(float StartSeconds, float EndSeconds, int32 Width = 1024, int32 Height = 128);
+
+    /**
+     * @brief Duração (segundos) do áudio disponível para RenderWaveformOverview.
+     */
+    UFUNCTION(BlueprintPure, Category = "IAR|Waveform Overview")
+    float GetWaveformOverviewDuration() const;
+
+    /**
+     * @brief Eventos MIDI descartados porque a Game Thread não transmitiu as janelas de features a tempo (ver MaxPendingMIDIEvents).
+     */
+    UFUNCTION(BlueprintPure, Category = "IAR|Real-Time Features")
+    int32 GetNumDroppedMIDIEvents() const { return DroppedMIDIEventCount.GetValue(); }
+
+    /**
+     * @brief Resumo usado por RenderWaveformOverview (arquivo carregado ou sessão), para consumidores C++.
+     */
+    const FIARWaveformSummary& GetWaveformOverviewSummary() const;
+
     UFUNCTION(BlueprintCallable, Category = "IAR|Audio Devices")
     void EnumerateAudioInputDevices();
 
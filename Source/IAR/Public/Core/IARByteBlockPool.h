@@ -0,0 +1,50 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/ThreadSafeCounter.h"
+
+/**
+ * @brief Pool de blocos de bytes reutilizáveis, com capacidade fixa, para os dados enviados aos escritores (pipe/arquivo).
+ * O produtor adquire um bloco, converte as amostras direto nele e o enfileira; quem consome devolve o bloco após a escrita.
+ * Acquire deve ser chamado por uma única thread; Release pode ser chamado de qualquer thread.
+ */
+class IAR_API FIARByteBlockPool
+{
+public:
+    /**
+     * @param InBlockCapacity Capacidade reservada de cada bloco (blocos maiores são criados sob demanda).
+     * @param InMaxPooledBlocks Máximo de blocos livres mantidos; o excedente é liberado.
+     */
+    explicit FIARByteBlockPool(int32 InBlockCapacity = 64 * 1024, int32 InMaxPooledBlocks = 64);
+
+    /**
+     * @brief Retorna um bloco com Num() == NumBytes (conteúdo não inicializado), reaproveitando um bloco livre quando possível.
+     */
+    TArray<uint8> Acquire(int32 NumBytes);
+
+    /**
+     * @brief Devolve um bloco ao pool. Thread-safe.
+     */
+    void Release(TArray<uint8>&& Block);
+
+    /** @brief Número de blocos livres no pool. */
+    int32 GetNumPooledBlocks() const { return NumPooledBlocks.GetValue(); }
+
+private:
+    TQueue<TArray<uint8>, EQueueMode::Mpsc> FreeBlocks; // Multi-produtor (Release), consumidor único (Acquire)
+    FThreadSafeCounter NumPooledBlocks;
+    int32 BlockCapacity;
+    int32 MaxPooledBlocks;
+
+    // Desabilita cópia e atribuição
+    FIARByteBlockPool(const FIARByteBlockPool&) = delete;
+    FIARByteBlockPool& operator=(const FIARByteBlockPool&) = delete;
+};
@@ -0,0 +1,115 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Function.h"
+
+/**
+ * @brief Thread produtora compartilhada pelas fontes sem dispositivo (arquivo, simulada): substitui os timers da Game Thread.
+ * Cada registro produz blocos de tamanho fixo (FramesPerBlock frames) no ritmo de um relógio monotônico de alta resolução.
+ * - O bloco N vence em Início + (N + 1) x FramesPerBlock / SampleRate, calculado a partir do índice (sem acumular erro).
+ * - Depois de um atraso os blocos vencidos são produzidos em sequência, então o número de blocos entregues segue o relógio.
+ *   Atrasos acima de MaxCatchUpSeconds não são recuperados: o relógio do registro é reancorado e o atraso é registrado no log.
+ * - Registros sem relógio (RegisterUnpaced, processamento offline) produzem tão rápido quanto o consumidor aceita,
+ *   limitados por uma consulta de capacidade (backpressure) e intercalados com os registros no relógio.
+ *   Com o consumidor cheio a thread dorme no evento (até NotifyCapacityAvailable ou UnpacedBackpressureWaitSeconds);
+ *   a espera ativa fica reservada aos prazos dos registros no relógio.
+ * - Os callbacks rodam na thread produtora, fora da Game Thread.
+ */
+class IAR_API FIARClockedProducer : public FRunnable
+{
+public:
+    /**
+     * @brief Produz um bloco.
+     * @param BlockIndex Índice do bloco desde o registro.
+     * @param StreamTimeSeconds Tempo do início do bloco no stream (BlockIndex x duração do bloco).
+     */
+    typedef TFunction<void(int64 BlockIndex, double StreamTimeSeconds)> FProduceCallback;
+
+    /** @brief Consulta de capacidade dos registros sem relógio: false enquanto o consumidor estiver cheio. */
+    typedef TFunction<bool()> FCapacityQuery;
+
+    /** Maior atraso recuperado em rajada; acima disso o registro é reancorado no relógio. */
+    static constexpr double MaxCatchUpSeconds = 0.5;
+    /** Blocos produzidos por registro sem relógio a cada passada, para não atrasar os registros no relógio. */
+    static constexpr int32 MaxUnpacedBlocksPerPass = 32;
+    /** Espera máxima entre consultas de capacidade enquanto o consumidor de um registro sem relógio está cheio. */
+    static constexpr double UnpacedBackpressureWaitSeconds = 0.02;
+
+    /**
+     * @brief Retorna a thread produtora compartilhada, iniciando-a no primeiro uso.
+     * @return nullptr se a thread não pôde ser criada.
+     */
+    static FIARClockedProducer* Get();
+
+    /** @brief Encerra a thread produtora (chamado no ShutdownModule). Os registros devem ter sido removidos. */
+    static void Shutdown();
+
+    /**
+     * @brief Chamado pelos consumidores ao liberar espaço na fila: acorda a thread se algum registro sem relógio
+     * estiver esperando capacidade. Barato quando ninguém espera; pode ser chamado de qualquer thread.
+     */
+    static void NotifyCapacityAvailable();
+
+    /**
+     * @brief Registra uma fonte. O primeiro bloco vence uma duração de bloco depois do registro.
+     * @return O id do registro, ou 0 se os parâmetros forem inválidos.
+     */
+    int32 Register(int32 SampleRate, int32 FramesPerBlock, FProduceCallback&& Callback);
+
+    /**
+     * @brief Registra uma fonte sem relógio: cada bloco é produzido assim que HasCapacity retorna true.
+     * Os tempos entregues ao callback continuam no relógio de amostras (BlockIndex x duração do bloco).
+     * @return O id do registro, ou 0 se os parâmetros forem inválidos.
+     */
+    int32 RegisterUnpaced(int32 SampleRate, int32 FramesPerBlock, FCapacityQuery&& HasCapacity, FProduceCallback&& Callback);
+
+    /**
+     * @brief Remove o registro e espera o callback em andamento terminar; depois disso nenhum callback é chamado.
+     * Pode ser chamado de dentro do próprio callback (ex: fim do arquivo).
+     */
+    void Unregister(int32 RegistrationId);
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FRegistration;
+
+    FIARClockedProducer();
+    virtual ~FIARClockedProducer();
+
+    /** @brief Produz os blocos vencidos de um registro. @return O instante em que vence o próximo bloco. */
+    double ProduceDueBlocks(FRegistration& Registration, double Now);
+    /**
+     * @brief Produz blocos de um registro sem relógio enquanto houver capacidade.
+     * @param bOutBackpressured true se parou porque o consumidor está cheio.
+     * @return Quando visitar o registro de novo.
+     */
+    double ProduceUnpacedBlocks(FRegistration& Registration, double Now, bool& bOutBackpressured);
+    int32 AddRegistration(TSharedPtr<FRegistration, ESPMode::ThreadSafe>&& Registration);
+
+    FRunnableThread* ProducerThread;
+    FEvent* WakeEvent; // Acorda a thread quando um registro novo vence antes da espera atual
+    FThreadSafeBool bStopRequested;
+    FThreadSafeBool bWaitingForCapacity; // Algum registro sem relógio encontrou o consumidor cheio nesta passada
+
+    FCriticalSection RegistrationsLock;
+    TMap<int32, TSharedPtr<FRegistration, ESPMode::ThreadSafe>> Registrations;
+    int32 NextRegistrationId;
+
+    // Desabilita cópia e atribuição
+    FIARClockedProducer(const FIARClockedProducer&) = delete;
+    FIARClockedProducer& operator=(const FIARClockedProducer&) = delete;
+};
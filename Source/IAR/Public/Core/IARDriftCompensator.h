@@ -0,0 +1,111 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * @brief Alinha um dispositivo de captura secundário ao relógio do dispositivo mestre.
+ * As amostras do secundário entram numa FIFO (Push, thread do secundário) e saem reamostradas no ritmo do mestre
+ * (Pull, thread do mestre), com interpolação Hermite de 4 pontos e razão ajustada continuamente:
+ * - A ocupação da FIFO é suavizada e comparada à latência alvo; um controlador PI converte o erro em uma correção
+ *   fina da razão (limitada a MaxCorrection). Em regime, o termo integral é a deriva estimada do relógio.
+ * - A ocupação medida inclui os frames que o secundário já capturou desde o último Push (pelo horário de captura):
+ *   sem isso, com blocos de mesmo tamanho nos dois lados, a fase entre os callbacks esconderia a deriva.
+ * - Falta de amostras (underrun) gera silêncio e reinicia o enchimento; excesso acima de MaxLatencyFrames é descartado.
+ * - A latência alvo nunca fica abaixo do que um Pull consome mais um bloco do secundário e a excursão do controlador
+ *   (ver GetMinimumTargetFrames): com um alvo menor, todo Pull esvaziaria a FIFO.
+ * Thread-safe entre um produtor (Push) e um consumidor (Pull).
+ */
+class IAR_API FIARDriftCompensator
+{
+public:
+    /** Maior correção aplicada sobre a razão nominal (2000 ppm). */
+    static constexpr double MaxCorrection = 0.002;
+    /** Ganhos do controlador, sobre o erro de ocupação em segundos. */
+    static constexpr double ProportionalGain = 0.05;
+    static constexpr double IntegralGain = 0.0005;
+    /** Constante de tempo da suavização da ocupação, que filtra o jitter de blocos dos drivers. */
+    static constexpr double FillSmoothingSeconds = 2.0;
+    /** Frames extras na FIFO além do consumo de um bloco: os 4 pontos da interpolação Hermite. */
+    static constexpr int32 InterpolationMarginFrames = 4;
+    /** Intervalo mínimo entre avisos de underrun no log (os underruns do intervalo são somados). */
+    static constexpr double UnderrunLogIntervalSeconds = 10.0;
+
+    FIARDriftCompensator();
+
+    /**
+     * @param InNumChannels Canais entregues por Pull (Push completa ou corta os canais do dispositivo).
+     * @param InInputSampleRate Taxa nominal do dispositivo secundário.
+     * @param InOutputSampleRate Taxa do mestre.
+     * @param InTargetLatencyFrames Ocupação alvo da FIFO, em frames do secundário (elevada ao mínimo dos blocos).
+     * @param InExpectedPullFrames Tamanho esperado de cada Pull, em frames do mestre (0 = desconhecido).
+     * @param InExpectedPushFrames Tamanho esperado de cada Push, em frames do secundário (0 = desconhecido).
+     * Blocos maiores que os esperados, observados em Push/Pull, elevam a latência alvo durante a captura.
+     * @return false se os parâmetros forem inválidos.
+     */
+    bool Initialize(int32 InNumChannels, int32 InInputSampleRate, int32 InOutputSampleRate, int32 InTargetLatencyFrames,
+        int32 InExpectedPullFrames = 0, int32 InExpectedPushFrames = 0);
+
+    /** @brief Esvazia a FIFO e zera o controlador (a deriva estimada é mantida como ponto de partida). */
+    void Reset();
+
+    /**
+     * @brief Acrescenta frames do dispositivo secundário. Chamado pela thread de captura do secundário.
+     * @param CaptureTimeSeconds Horário do callback, no mesmo relógio usado em Pull (ex.: FPlatformTime::Seconds()).
+     */
+    void Push(const float* InterleavedSamples, int32 NumFrames, int32 InNumChannels, double CaptureTimeSeconds);
+
+    /**
+     * @brief Produz NumFrames frames no relógio do mestre, escritos em Out a partir do canal ChannelOffset
+     * (Out tem OutStride canais por frame). Chamado pela thread de captura do mestre.
+     * @param CaptureTimeSeconds Horário do callback do mestre, no mesmo relógio usado em Push.
+     * @return false se a FIFO ainda estiver enchendo ou esvaziou (a parte sem dados é preenchida com silêncio).
+     */
+    bool Pull(float* Out, int32 OutStride, int32 ChannelOffset, int32 NumFrames, double CaptureTimeSeconds);
+
+    /** @brief Deriva estimada do secundário em relação ao mestre, em ppm (positivo = secundário mais rápido). */
+    double GetEstimatedDriftPPM() const;
+    int32 GetUnderrunCount() const { return UnderrunCount; }
+    /** @brief Ocupação alvo efetiva da FIFO, em frames do secundário. */
+    int32 GetTargetLatencyFrames() const;
+
+    /**
+     * @brief Menor latência alvo que sustenta os blocos: um Pull de PullFrames na razão máxima,
+     * mais um Push de PushFrames que pode chegar logo depois do Pull, mais a margem da interpolação,
+     * mais a queda de ocupação que o controlador tolera antes de saturar (MaxCorrection / ProportionalGain).
+     */
+    static int32 GetMinimumTargetFrames(double NominalRatio, int32 InputSampleRate, int32 PullFrames, int32 PushFrames);
+
+private:
+    int32 NumChannels;
+    int32 InputSampleRate;
+    double NominalRatio;       // Frames do secundário consumidos por frame do mestre, sem correção
+    int32 TargetLatencyFrames;
+    int32 MaxLatencyFrames;
+    int32 LargestPullFrames;   // Maior bloco visto (ou esperado) em Pull, em frames do mestre
+    int32 LargestPushFrames;   // Maior bloco visto (ou esperado) em Push, em frames do secundário
+
+    mutable FCriticalSection FifoLock;
+    TArray<float> Fifo;        // Frames intercalados; o primeiro é o histórico da interpolação (posição - 1)
+    double ReadPosition;       // Posição fracionária do próximo frame de saída dentro da Fifo
+    double LastPushTimeSeconds; // Horário do último Push (negativo = nenhum desde Reset)
+    bool bPrimed;
+
+    // Controlador (acessado apenas pelo consumidor, sob FifoLock)
+    double SmoothedFillFrames;
+    double IntegralTerm;
+    int32 UnderrunCount;
+    int32 UnderrunsSinceLog;
+    int64 FramesSinceUnderrunLog; // Frames do mestre desde o último aviso, saturado em UnderrunLogIntervalFrames
+    int64 UnderrunLogIntervalFrames;
+
+    /** @brief Eleva a latência alvo se os blocos vistos exigirem mais; devolve true se elevou. Sob FifoLock. */
+    bool RaiseTargetForBlocks();
+};
@@ -0,0 +1,74 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+
+/**
+ * @brief Reagrupa blocos de tamanho arbitrário (callbacks do driver) em janelas fixas de análise.
+ * Uma janela de WindowFrames frames é emitida a cada HopFrames frames (HopFrames < WindowFrames = janelas sobrepostas),
+ * com o índice exato do seu primeiro frame desde o último Reset: o custo e a latência da análise não dependem
+ * do tamanho de bloco escolhido pelo driver. Cada janela informa quantos frames iniciais repetem a anterior (a sobreposição):
+ * quem acumula o sinal (resumo da forma de onda, gravação) usa só os frames seguintes, que aparecem uma única vez.
+ * Não é thread-safe: Push e Reset devem ser chamados da mesma thread (a do callback de captura).
+ */
+class IAR_API FIARFrameReblocker
+{
+public:
+    /**
+     * @brief Recebe a janela (NumFrames x NumChannels amostras intercaladas; NumFrames < WindowFrames só no Flush),
+     * o índice do seu primeiro frame e quantos frames do início já foram entregues na janela anterior.
+     */
+    typedef TFunctionRef<void(const float* WindowSamples, int32 NumFrames, int64 StartFrameIndex, int32 OverlapFrames)> FEmitWindow;
+
+    FIARFrameReblocker();
+
+    /**
+     * @brief Define o tamanho e o passo das janelas. Descarta as amostras acumuladas.
+     * @return false se WindowFrames <= 0 ou HopFrames fora de [1, WindowFrames].
+     */
+    bool Configure(int32 InWindowFrames, int32 InHopFrames);
+
+    /**
+     * @brief Configure com o passo derivado da sobreposição (0 = janelas contíguas; limitada a 0.875).
+     */
+    bool ConfigureWithOverlap(int32 InWindowFrames, float Overlap);
+
+    /** @brief Descarta as amostras acumuladas e recomeça a contagem de frames com o formato dado. */
+    void Reset(int32 InSampleRate, int32 InNumChannels);
+
+    /**
+     * @brief Acrescenta NumFrames frames intercalados e emite, em ordem, todas as janelas completas.
+     */
+    void Push(const float* InterleavedSamples, int32 NumFrames, FEmitWindow Emit);
+
+    /**
+     * @brief Fim da captura: emite a janela parcial acumulada se ela tiver frames ainda não entregues, e a descarta.
+     */
+    void Flush(FEmitWindow Emit);
+
+    bool IsConfigured() const { return WindowFrames > 0; }
+    bool MatchesFormat(int32 InSampleRate, int32 InNumChannels) const { return SampleRate == InSampleRate && NumChannels == InNumChannels; }
+    int32 GetWindowFrames() const { return WindowFrames; }
+    int32 GetHopFrames() const { return HopFrames; }
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+    /** @brief Frames acumulados que ainda não formam uma janela completa. */
+    int32 GetPendingFrames() const { return NumChannels > 0 ? Pending.Num() / NumChannels : 0; }
+
+private:
+    int32 WindowFrames;
+    int32 HopFrames;
+    int32 SampleRate;
+    int32 NumChannels;
+
+    TArray<float> Pending;      // Amostras intercaladas a partir do início da próxima janela
+    int64 NextWindowStartFrame; // Índice (desde o Reset) do primeiro frame de Pending
+    int64 EmittedEndFrame;      // Fim (exclusivo) da última janela emitida: os frames antes dele já foram entregues
+};
@@ -0,0 +1,120 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Function.h"
+
+/**
+ * @brief Serviço de I/O compartilhado por todos os encoders: uma única thread espera (epoll) por todos os
+ * descritores registrados (o FIFO de áudio de cada FFmpeg e os pipes de stdout/stderr) e entrega cada evento
+ * a um callback executado nas threads de background do task graph.
+ * Com N encoders ativos, o número de threads continua o mesmo (a thread do reator + o pool do engine).
+ * - Registros são one-shot: depois de cada evento o descritor fica desarmado até o dono chamar Arm de novo.
+ *   Assim dois callbacks do mesmo registro nunca rodam ao mesmo tempo.
+ * - Também agenda trabalhos com atraso (DispatchAfter), para esperas que não podem ocupar uma thread do pool.
+ * - Disponível apenas no Linux; nas demais plataformas Get() retorna nullptr e os chamadores mantêm suas threads.
+ */
+class IAR_API FIARIOReactor : public FRunnable
+{
+public:
+    /** Eventos que podem ser armados e que são entregues ao callback. Erro/HUP chegam como os dois eventos. */
+    enum EIOEvent : uint32
+    {
+        Readable = 1 << 0,
+        Writable = 1 << 1
+    };
+
+    typedef TFunction<void(uint32 ReadyEvents)> FIOCallback;
+
+    /** Máximo de eventos retirados do epoll por despertar. */
+    static constexpr int32 MaxEventsPerWait = 64;
+
+    /** Intervalo de espera do Unregister pelos callbacks em andamento antes de avisar no log (e continuar esperando). */
+    static constexpr uint32 UnregisterWaitWarningMs = 2000;
+
+    /**
+     * @brief Retorna o reator compartilhado, iniciando-o no primeiro uso.
+     * @return nullptr se a plataforma não tem suporte ou se a inicialização falhou.
+     */
+    static FIARIOReactor* Get();
+
+    /** @brief Encerra o reator compartilhado (chamado no ShutdownModule). Os registros devem ter sido removidos. */
+    static void Shutdown();
+
+    /**
+     * @brief Registra um descritor (ainda desarmado). O descritor deve estar em modo não-bloqueante.
+     * @return O id do registro, ou 0 em caso de erro.
+     */
+    int32 Register(int32 FileDescriptor, FIOCallback&& Callback);
+
+    /**
+     * @brief Arma o registro para o próximo evento (Readable e/ou Writable). O callback é chamado uma vez.
+     * @return false se o registro não existe ou o epoll recusou.
+     */
+    bool Arm(int32 RegistrationId, uint32 Events);
+
+    /**
+     * @brief Remove o registro e espera os callbacks em andamento terminarem; depois disso nenhum callback é chamado.
+     * Não deve ser chamado de dentro do callback do próprio registro.
+     */
+    void Unregister(int32 RegistrationId);
+
+    /** @brief Executa um trabalho nas threads de background do task graph (o mesmo pool dos callbacks). */
+    static void Dispatch(TUniqueFunction<void()>&& Work);
+
+    /**
+     * @brief Despacha Work (como Dispatch) depois de DelaySeconds, contados pela thread do reator.
+     * No encerramento do reator os trabalhos ainda agendados são despachados na hora.
+     */
+    void DispatchAfter(double DelaySeconds, TUniqueFunction<void()>&& Work);
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FRegistration;
+
+    FIARIOReactor();
+    virtual ~FIARIOReactor();
+
+    /** @brief Cria o epoll, o eventfd de despertar e a thread. */
+    bool Start();
+
+    /** @brief Tira a thread do reator do epoll_wait (eventfd). */
+    void Wake();
+
+    /** @brief Despacha os trabalhos de DispatchAfter vencidos (todos, com bAll). @return Milissegundos até o próximo, ou -1. */
+    int32 DispatchDueTimers(bool bAll);
+
+    int32 EpollDescriptor;
+    int32 WakeDescriptor;
+    FRunnableThread* ReactorThread;
+    FThreadSafeBool bStopRequested;
+
+    FCriticalSection RegistrationsLock;
+    TMap<int32, TSharedPtr<FRegistration, ESPMode::ThreadSafe>> Registrations;
+    int32 NextRegistrationId;
+
+    struct FTimer
+    {
+        double DueTime;
+        TUniqueFunction<void()> Work;
+    };
+    FCriticalSection TimersLock;
+    TArray<FTimer> Timers;
+
+    // Desabilita cópia e atribuição
+    FIARIOReactor(const FIARIOReactor&) = delete;
+    FIARIOReactor& operator=(const FIARIOReactor&) = delete;
+};
@@ -0,0 +1,126 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/TripleBuffer.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Core/IAR_Types.h"
+
+/**
+ * @brief Snapshot de um frame analisado em tempo real, pronto para ser consumido na Game Thread.
+ * RawAudioBuffer só é preenchido se a cópia de áudio bruto estiver habilitada no componente.
+ * Os buffers são reutilizados entre publicações (Reset + Append), então, após o aquecimento,
+ * a publicação não realiza alocações.
+ */
+struct IAR_API FIAR_RTFrameSnapshot
+{
+    TArray<float> RawAudioBuffer;
+    int32 SampleRate = 0;
+    int32 NumChannels = 0;
+    float Timestamp = 0.0f;
+
+    // Espectro do último frame (cópia pequena, usada pelos assinantes nativos da Game Thread)
+    TArray<float> Spectrum;
+
+    // Features agregadas da última janela de broadcast concluída (ver FIARFeatureAggregator)
+    FIAR_AudioFeatures Features;
+    // Sequência da janela de broadcast (0 = nenhuma janela concluída); muda apenas quando há features novas a transmitir
+    uint64 FeatureWindowSequence = 0;
+    int32 NumAggregatedFrames = 0;
+    // Versão das features copiadas para este buffer (o produtor só recopia quando ela muda)
+    uint64 FeaturesVersion = 0;
+
+    // Pixels de depuração (vazios quando bDebugDrawFeatures está desligado)
+    TArray<FColor> SpectrogramPixels;
+    int32 SpectrogramWidth = 0;
+    int32 SpectrogramHeight = 0;
+
+    TArray<FColor> WaveformPixels;
+    int32 WaveformWidth = 0;
+    int32 WaveformHeight = 0;
+
+    TArray<FColor> FilteredSpectrogramPixels;
+    int32 FilteredSpectrogramWidth = 0;
+    int32 FilteredSpectrogramHeight = 0;
+
+    // Total de colunas escritas nos espectrogramas circulares (ver UIARAdvancedAudioFeatureProcessor::GetSpectrogramColumnsWritten)
+    uint64 SpectrogramColumnsWritten = 0;
+
+    // Número sequencial da publicação (permite detectar snapshots descartados)
+    uint64 SequenceNumber = 0;
+
+    /** @brief Copia pixels para um dos buffers do snapshot sem liberar a memória já reservada. */
+    static void CopyPixels(TArray<FColor>& Dest, const TArray<FColor>* Source);
+};
+
+/**
+ * @brief Visão somente-leitura (sem cópias) de um frame analisado, entregue aos assinantes nativos em C++.
+ * REGRA DE VIDA: as visões (e o ponteiro Features) apontam para buffers internos do plugin e são válidas
+ * SOMENTE durante o callback. Para guardar qualquer dado, copie-o dentro do callback.
+ */
+struct IAR_API FIAR_RTFrameView
+{
+    // Amostras intercaladas (após conversão de canais, resampling e filtros). Vazia na Game Thread se a cópia de áudio bruto não estiver habilitada.
+    TConstArrayView<float> Samples;
+    // Espectro de magnitude normalizado (0-1) do frame. Vazio se o processador de features não calcula espectro.
+    TConstArrayView<float> Spectrum;
+    // Bloco de features (por frame na thread de análise; agregado por janela na Game Thread)
+    const FIAR_AudioFeatures* Features = nullptr;
+
+    int32 SampleRate = 0;
+    int32 NumChannels = 0;
+    float Timestamp = 0.0f;
+    // Número de frames de análise representados por Features (1 na thread de análise)
+    int32 NumAggregatedFrames = 1;
+};
+
+/**
+ * @brief Caixa de correio "último valor" baseada em triple buffer.
+ * Um único produtor (thread de áudio/fonte) publica snapshots sem bloquear e sem alocar;
+ * um único consumidor (Game Thread) lê no máximo um snapshot por frame de jogo.
+ * Snapshots publicados mais rápido do que o consumo são simplesmente sobrescritos,
+ * de modo que o trabalho e a memória na Game Thread permanecem limitados.
+ */
+class IAR_API FIARRealTimeFrameMailbox
+{
+public:
+    FIARRealTimeFrameMailbox();
+
+    /**
+     * @brief Retorna o buffer de escrita atual. Apenas o produtor pode chamar.
+     * O conteúdo é o de um snapshot antigo; o produtor deve sobrescrever todos os campos.
+     */
+    FIAR_RTFrameSnapshot& BeginPublish();
+
+    /**
+     * @brief Publica o buffer preenchido em BeginPublish, tornando-o o "último valor" disponível.
+     */
+    void EndPublish();
+
+    /**
+     * @brief Consome o snapshot mais recente, se houver um novo desde a última leitura. Apenas o consumidor pode chamar.
+     * @return Ponteiro para o snapshot (válido até a próxima chamada de ConsumeLatest) ou nullptr se nada novo foi publicado.
+     */
+    const FIAR_RTFrameSnapshot* ConsumeLatest();
+
+    /** @brief True se há um snapshot publicado ainda não consumido. */
+    bool HasPendingSnapshot() const { return Buffer.IsDirty(); }
+
+    /** @brief Número de snapshots sobrescritos antes de serem consumidos (diagnóstico). */
+    int32 GetNumDroppedSnapshots() const { return DroppedSnapshots.GetValue(); }
+
+    /** @brief Limpa o estado da caixa de correio. NÃO é thread-safe: chamar apenas com o produtor parado. */
+    void Reset();
+
+private:
+    TTripleBuffer<FIAR_RTFrameSnapshot> Buffer;
+    uint64 NextSequenceNumber;
+    uint64 LastConsumedSequenceNumber;
+    FThreadSafeCounter DroppedSnapshots;
+};
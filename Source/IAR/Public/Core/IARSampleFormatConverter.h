@@ -0,0 +1,67 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief Formato das amostras gravadas (PCM little-endian intercalado).
+ */
+enum class EIARSampleFormat : uint8
+{
+    S16, // Inteiro 16 bits
+    S24, // Inteiro 24 bits (3 bytes por amostra)
+    S32, // Inteiro 32 bits
+    F32  // Float IEEE 32 bits
+};
+
+/**
+ * @brief Converte amostras float [-1, 1] para o formato de gravação, 4 amostras por vez (VectorRegister).
+ * Para S16/S24 pode aplicar dither TPDF (±1 LSB) antes da quantização.
+ * Mantém o estado do gerador de dither: use uma instância por stream, em uma única thread.
+ */
+class IAR_API FIARSampleFormatConverter
+{
+public:
+    explicit FIARSampleFormatConverter(EIARSampleFormat InFormat = EIARSampleFormat::S16, bool bInApplyDither = false);
+
+    /**
+     * @brief Resolve o formato a partir de FIAR_AudioStreamSettings (BitDepth + bUseFloatSamples).
+     * @return false se a combinação não for suportada (OutFormat não é alterado).
+     */
+    static bool FormatFromBitDepth(int32 BitDepth, bool bFloatSamples, EIARSampleFormat& OutFormat);
+
+    static int32 GetBytesPerSample(EIARSampleFormat InFormat);
+    static int32 GetBitsPerSample(EIARSampleFormat InFormat) { return GetBytesPerSample(InFormat) * 8; }
+    static bool IsFloatFormat(EIARSampleFormat InFormat) { return InFormat == EIARSampleFormat::F32; }
+
+    /** @brief Nome do formato bruto no padrão do FFmpeg (ex: "s16le"). */
+    static const TCHAR* GetRawFormatName(EIARSampleFormat InFormat);
+
+    /**
+     * @brief Converte NumSamples amostras float para o formato configurado.
+     * @param Out Destino com pelo menos NumSamples * GetBytesPerSample() bytes.
+     */
+    void Convert(const float* In, int32 NumSamples, uint8* Out);
+
+    EIARSampleFormat GetFormat() const { return Format; }
+    int32 GetBytesPerSample() const { return GetBytesPerSample(Format); }
+
+private:
+    EIARSampleFormat Format;
+    bool bApplyDither;
+    uint32 DitherState;
+    TArray<float> DitherBuffer; // Reutilizado entre chamadas
+
+    /** @brief Preenche DitherBuffer com ruído TPDF em unidades de LSB (soma de duas uniformes em [-0.5, 0.5)). */
+    void GenerateDither(int32 NumSamples);
+
+    void ConvertToS16(const float* In, int32 NumSamples, uint8* Out, const float* Dither);
+    void ConvertToS24(const float* In, int32 NumSamples, uint8* Out, const float* Dither);
+    void ConvertToS32(const float* In, int32 NumSamples, uint8* Out);
+};
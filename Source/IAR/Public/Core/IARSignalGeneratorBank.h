@@ -0,0 +1,117 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief Banco de geradores de sinais de teste determinísticos (senos, acordes, varreduras e ruído), gerados em blocos com SIMD.
+ * - Senos: osciladores recursivos (rotação complexa) em 4 lanes, ressincronizados a cada ReseedIntervalFrames a partir da
+ *   fase exata, calculada em ponto fixo de 64 bits (posição x incremento): a fase não deriva mesmo após horas de sinal.
+ * - Varreduras lineares: acumulador de fase inteiro de 64 bits, avaliado 4 amostras por vez com VectorSin.
+ * - Ruído branco: xorshift32 com semente.
+ * Cada voz soma no barramento de todos os canais ou no de um único canal; a saída é intercalada.
+ * Com a mesma configuração e a mesma sequência de blocos, a saída é idêntica bit a bit.
+ * Não é thread-safe: configure antes de gerar e gere sempre da mesma thread.
+ */
+class IAR_API FIARSignalGeneratorBank
+{
+public:
+    /** Intervalo (em frames) entre as ressincronizações dos osciladores recursivos. Múltiplo de 4. */
+    static constexpr int32 ReseedIntervalFrames = 4096;
+
+    FIARSignalGeneratorBank();
+
+    /**
+     * @brief Define o formato da saída, remove todas as vozes e volta ao frame 0.
+     * @return false se o formato for inválido.
+     */
+    bool Configure(int32 InSampleRate, int32 InNumChannels);
+
+    /**
+     * @brief Adiciona um seno de frequência fixa.
+     * @param Channel Canal de destino, ou INDEX_NONE para todos os canais.
+     * @return false se a frequência estiver fora de (0, Nyquist) ou o canal for inválido.
+     */
+    bool AddSine(float FrequencyHz, float Amplitude, int32 Channel = INDEX_NONE);
+
+    /**
+     * @brief Adiciona um acorde: um seno por razão de frequência sobre a fundamental, dividindo a amplitude entre as notas.
+     * @return false se alguma nota for inválida (nenhuma nota é adicionada).
+     */
+    bool AddChord(float RootFrequencyHz, const TArray<float>& FrequencyRatios, float Amplitude, int32 Channel = INDEX_NONE);
+
+    /**
+     * @brief Adiciona uma varredura linear de StartHz até EndHz em DurationSeconds, repetida com fase contínua.
+     * @return false se as frequências ou a duração forem inválidas.
+     */
+    bool AddSweep(float StartHz, float EndHz, float DurationSeconds, float Amplitude, int32 Channel = INDEX_NONE);
+
+    /**
+     * @brief Adiciona ruído branco uniforme reproduzível a partir de Seed.
+     * @return false se o canal for inválido.
+     */
+    bool AddNoise(uint32 Seed, float Amplitude, int32 Channel = INDEX_NONE);
+
+    /** @brief Remove todas as vozes (o formato e a posição são mantidos). */
+    void ClearVoices();
+
+    /** @brief Volta ao frame 0: a próxima geração repete o sinal desde o início. */
+    void Reset();
+
+    /**
+     * @brief Gera os próximos NumFrames frames intercalados (NumFrames x NumChannels amostras), sobrescrevendo OutInterleaved.
+     */
+    void Render(float* OutInterleaved, int32 NumFrames);
+
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+    int32 GetNumVoices() const { return Voices.Num(); }
+    /** @brief Frames já gerados desde o último Reset/Configure. */
+    int64 GetFramePosition() const { return FramePosition; }
+
+private:
+    enum class EVoiceType : uint8
+    {
+        Sine,
+        Sweep,
+        Noise,
+    };
+
+    struct FVoice
+    {
+        EVoiceType Type = EVoiceType::Sine;
+        int32 Channel = INDEX_NONE;
+        float Amplitude = 0.0f;
+        uint64 PhaseIncrement = 0;      // Fração de ciclo por frame, em ponto fixo de 64 bits (início da varredura)
+        int64 PhaseIncrementDelta = 0;  // Varredura: variação do incremento a cada frame
+        int64 SweepLengthFrames = 1;
+        uint64 Phase = 0;               // Varredura: fase do próximo frame
+        int64 SweepPosition = 0;        // Varredura: frame atual dentro do ciclo
+        uint32 NoiseSeed = 0;
+        uint32 NoiseState = 0;
+    };
+
+    typedef TArray<float, TAlignedHeapAllocator<16>> FBusBuffer;
+
+    int32 SampleRate;
+    int32 NumChannels;
+    int64 FramePosition;
+    TArray<FVoice> Voices;
+    TArray<FBusBuffer> Buses; // 0: todos os canais; 1..NumChannels: um canal
+    TArray<bool> BusUsed;
+
+    bool ValidateVoice(float FrequencyHz, int32 Channel) const;
+    void AddVoice(FVoice&& Voice);
+
+    /** @brief Soma um seno em NumFrames (múltiplo de 4) frames do barramento. */
+    void RenderSine(const FVoice& Voice, float* Bus, int32 NumFrames) const;
+    /** @brief Soma uma varredura no barramento; o estado avança NumFrames frames (a parte até PaddedFrames é descartável). */
+    void RenderSweep(FVoice& Voice, float* Bus, int32 NumFrames, int32 PaddedFrames) const;
+    void RenderNoise(FVoice& Voice, float* Bus, int32 NumFrames) const;
+};
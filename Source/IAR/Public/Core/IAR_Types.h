@@ -22,6 +22,7 @@ enum class EIARAudioSourceType : uint8
     Folder          UMETA(DisplayName = "Folder with Media Files"), // <<-- ADICIONADO
     MIDIInput       UMETA(DisplayName = "MIDI Input Device (Live)"), 
     MIDIFile        UMETA(DisplayName = "MIDI File from Disk"), 
+    AggregateDevices UMETA(DisplayName = "Multiple Audio Devices (Aggregated)"),
 };
 
 // NOVO: Enum para definir o tipo de conteúdo de mídia
@@ -33,6 +34,41 @@ enum class EIARMediaContentType : uint8
     AutoDetect      UMETA(DisplayName = "Auto-Detect from File Extension") // Para FolderSource
 };
 
+// Modo de agregação das features acumuladas entre dois broadcasts de tempo real
+UENUM(BlueprintType)
+enum class EIARFeatureAggregationMode : uint8
+{
+    Last            UMETA(DisplayName = "Last (valor do último frame)"),
+    Mean            UMETA(DisplayName = "Mean (média dos frames)"),
+    Max             UMETA(DisplayName = "Max (máximo dos frames)"),
+};
+
+// Sinal de teste gerado pela fonte simulada
+UENUM(BlueprintType)
+enum class EIARTestSignalType : uint8
+{
+    Sine            UMETA(DisplayName = "Sine"),
+    Chord           UMETA(DisplayName = "Chord (tríade maior)"),
+    Sweep           UMETA(DisplayName = "Sweep (varredura linear)"),
+    WhiteNoise      UMETA(DisplayName = "White Noise"),
+};
+
+/**
+ * @brief Um dispositivo de captura de uma fonte agregada (EIARAudioSourceType::AggregateDevices).
+ * Os canais de cada dispositivo ocupam, em ordem, uma faixa dos canais do frame de saída.
+ */
+USTRUCT(BlueprintType)
+struct IAR_API FIAR_AggregateInputDevice
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Aggregate Input Device")
+    int32 DeviceIndex = 0;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Aggregate Input Device", meta = (ClampMin = "1"))
+    int32 NumChannels = 2;
+};
+
 /**
  * @brief Estrutura para configurar as propriedades do stream de áudio (taxa de amostragem, canais, codec, etc.).
  * Esta estrutura define como o áudio será capturado ou codificado.
@@ -55,7 +91,23 @@ struct IAR_API FIAR_AudioStreamSettings
     FString Codec = TEXT("PCM"); // Ex: PCM, AAC, MP3, FLAC, OPUS
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings")
-    int32 Bitrate = 192000; // Em bps (para codecs comprimidos)
+    int32 Bitrate = 192000; // Em bps (para codecs comprimidos: AAC, MP3, OPUS)
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings",
+              meta = (Tooltip = "Com BitDepth 32, grava amostras float (IEEE) em vez de inteiros de 32 bits."))
+    bool bUseFloatSamples = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings",
+              meta = (Tooltip = "Aplica dither TPDF ao quantizar as amostras para 16 ou 24 bits na gravação. Desligado por padrão: a quantização continua idêntica à das versões anteriores."))
+    bool bApplyDither = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Encoder Queue",
+              meta = (ClampMin = "1", Tooltip = "Memória máxima (MB) da fila de escrita do encoder. Acima disso os blocos transbordam para um journal em disco."))
+    int32 EncoderQueueMemoryMB = 32;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Encoder Queue",
+              meta = (ClampMin = "0", Tooltip = "Tamanho máximo (MB) do journal em disco do encoder. Acima disso os blocos são descartados (e contados)."))
+    int32 EncoderSpillLimitMB = 4096;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings")
     EIARAudioSourceType SourceType = EIARAudioSourceType::Simulated; 
@@ -88,11 +140,80 @@ struct IAR_API FIAR_AudioStreamSettings
 meta = (EditCondition = "SourceType == EIARAudioSourceType::AudioMixer || SourceType == EIARAudioSourceType::MIDIInput", EditConditionHides))
     int32 InputDeviceIndex = 0; 
 
+    // Dispositivos da fonte agregada. O primeiro é o mestre (relógio de referência); a soma dos canais deve ser NumChannels.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::AggregateDevices", EditConditionHides))
+    TArray<FIAR_AggregateInputDevice> AggregateInputDevices;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::AggregateDevices", EditConditionHides, ClampMin = "5",
+                      Tooltip = "Latência (ms) mantida nas FIFOs dos dispositivos secundários para absorver o jitter dos drivers. Elevada automaticamente para cobrir um bloco do mestre e um do secundário."))
+    int32 AggregateTargetLatencyMs = 40;
+
+    // Janelas de análise da captura de dispositivo: os blocos do driver são reagrupados em janelas fixas (ver FIARFrameReblocker)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::AudioMixer || SourceType == EIARAudioSourceType::AggregateDevices", EditConditionHides, ClampMin = "64",
+                      Tooltip = "Frames por frame entregue ao pipeline (use o FFTWindowSize do processador de features)."))
+    int32 AnalysisWindowFrames = 1024;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::AudioMixer || SourceType == EIARAudioSourceType::AggregateDevices", EditConditionHides, ClampMin = "0", ClampMax = "0.875",
+                      Tooltip = "Sobreposição entre janelas consecutivas (0.5 = passo de meia janela). Aplicada apenas com bEnableRTFeatures: a gravação sempre recebe janelas contíguas."))
+    float AnalysisWindowOverlap = 0.0f;
+
+    // Sinal de teste da fonte simulada (determinístico: a mesma configuração gera sempre as mesmas amostras)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::Simulated", EditConditionHides))
+    EIARTestSignalType TestSignalType = EIARTestSignalType::Sine;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::Simulated", EditConditionHides, ClampMin = "1",
+                      Tooltip = "Frequência do seno, fundamental do acorde ou início da varredura (Hz)."))
+    float TestSignalFrequencyHz = 440.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::Simulated && TestSignalType == EIARTestSignalType::Sweep", EditConditionHides, ClampMin = "1"))
+    float TestSignalSweepEndHz = 8000.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::Simulated && TestSignalType == EIARTestSignalType::Sweep", EditConditionHides, ClampMin = "0.01"))
+    float TestSignalSweepSeconds = 10.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::Simulated", EditConditionHides, ClampMin = "0", ClampMax = "1"))
+    float TestSignalAmplitude = 0.5f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::Simulated", EditConditionHides,
+                      Tooltip = "Soma Canal x DetuneHz à frequência de cada canal, para distinguir os canais (0 = todos iguais)."))
+    float TestSignalChannelDetuneHz = 0.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Source Specific",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::Simulated && TestSignalType == EIARTestSignalType::WhiteNoise", EditConditionHides,
+                      Tooltip = "Semente do ruído (cada canal usa Seed + Canal)."))
+    int32 TestSignalSeed = 1;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Playback Control")
     float PlaybackSpeed = 1.0f; 
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Playback Control")
     bool bLoopPlayback = false; 
+
+    // Processamento offline: a fonte de arquivo entrega frames assim que o pipeline tem capacidade (sem o relógio de reprodução).
+    // Os timestamps seguem o relógio de amostras do arquivo. PlaybackSpeed é ignorado neste modo.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Audio Stream Settings|Playback Control",
+              meta = (EditCondition = "SourceType == EIARAudioSourceType::AudioFile", EditConditionHides))
+    bool bProcessAsFastAsPossible = false;
+
+    // Extensão dos arquivos gravados com este Codec (codecs desconhecidos são gravados como PCM)
+    FString GetDefaultExtension() const
+    {
+        if (Codec.Equals(TEXT("FLAC"), ESearchCase::IgnoreCase)) return TEXT(".flac");
+        if (Codec.Equals(TEXT("OPUS"), ESearchCase::IgnoreCase)) return TEXT(".opus");
+        if (Codec.Equals(TEXT("AAC"), ESearchCase::IgnoreCase)) return TEXT(".m4a");
+        if (Codec.Equals(TEXT("MP3"), ESearchCase::IgnoreCase)) return TEXT(".mp3");
+        return TEXT(".wav");
+    }
 };
 
 /**
@@ -115,6 +236,15 @@ struct IAR_API FIAR_AudioFrameData
     UPROPERTY(BlueprintReadOnly, Category = "IAR|Audio Frame Data")
     float Timestamp = 0.0f; 
 
+    // Índice exato do primeiro frame de amostra desde o início da captura (INDEX_NONE se a fonte não informa)
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Audio Frame Data")
+    int64 StartFrameIndex = INDEX_NONE;
+
+    // Frames iniciais que repetem o frame anterior (janelas de análise sobrepostas). Servem só à análise:
+    // quem acumula o sinal (resumo da forma de onda, gravação) começa em OverlapFrames para não contar amostras duas vezes.
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Audio Frame Data")
+    int32 OverlapFrames = 0;
+
     // ATUALIZADO: Adicionada FIAR_AudioStreamSettings ao frame para que processadores possam acessá-lo.
     // Isso é útil para flags como bDebugDrawFeatures
     FIAR_AudioStreamSettings CurrentStreamSettings;
@@ -310,6 +440,11 @@ struct IAR_API FIAR_JustRTFrame
     UPROPERTY(BlueprintReadOnly, Category = "IAR|Real-Time Output")
     UTexture2D* FilteredSpectrogramTexture = nullptr; 
 
+    // Os espectrogramas são buffers circulares de colunas (apenas as colunas novas são enviadas à GPU).
+    // Deslocamento horizontal de UV [0..1) da coluna mais antiga: amostre com U' = frac(U + SpectrogramScrollOffset).
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Real-Time Output")
+    float SpectrogramScrollOffset = 0.0f;
+
     UPROPERTY(BlueprintReadOnly, Category = "IAR|Real-Time Output")
     FIAR_AudioFeatures Features; 
 };
@@ -344,6 +479,45 @@ struct IAR_API FIAR_PipeSettings
     int32 InBufferSize = 524288; 
 };
 
+/**
+ * @brief Métricas da fila de escrita do encoder (memória + journal em disco).
+ */
+USTRUCT(BlueprintType)
+struct IAR_API FIAR_EncoderQueueStats
+{
+    GENERATED_BODY()
+
+    /** Bytes na fila em memória (incluindo o lote em trânsito para o pipe). */
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Encoder Queue")
+    int64 MemoryQueuedBytes = 0;
+
+    /** Bytes no journal em disco ainda não enviados ao pipe. */
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Encoder Queue")
+    int64 SpillPendingBytes = 0;
+
+    /** Total de bytes que já passaram pelo journal desde o início da gravação. */
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Encoder Queue")
+    int64 TotalSpilledBytes = 0;
+
+    /** Bytes descartados porque memória e journal estavam no limite. */
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Encoder Queue")
+    int64 DroppedBytes = 0;
+
+    /** Quantas vezes a fila transbordou para o disco. */
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Encoder Queue")
+    int32 SpillEventCount = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Encoder Queue")
+    bool bIsSpilling = false;
+
+    /** Tempo (s) entre o início do último transbordo e o esvaziamento do journal. */
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Encoder Queue")
+    float LastRecoverySeconds = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Encoder Queue")
+    float MaxRecoverySeconds = 0.0f;
+};
+
 // Estrutura para configurações de gravação
 USTRUCT(BlueprintType)
 struct IAR_API FIAR_RecordingSettings
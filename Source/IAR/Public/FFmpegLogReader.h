@@ -14,8 +14,10 @@
 #include "HAL/ThreadSafeBool.h"
 
 /**
- * @brief Thread de trabalho para ler a saída (stdout/stderr) de um processo externo.
+ * @brief Leitor da saída (stdout/stderr) de um processo externo.
  * Usado para capturar logs do FFmpeg sem bloquear a Game Thread.
+ * No Linux o pipe é registrado no FIARIOReactor compartilhado (sem thread própria, leitura apenas quando há dados);
+ * nas demais plataformas uma thread dedicada faz polling do pipe.
  */
 class FFMpegLogReader : public FRunnable
 {
@@ -37,21 +39,45 @@ public:
     virtual void Exit() override;
 
     /**
-     * @brief Inicia a thread de leitura.
+     * @brief Inicia a leitura (registro no reator ou thread de leitura).
      */
     void Start();
 
     /**
-     * @brief Solicita que a thread pare e espera pela sua conclusão.
+     * @brief Solicita que a leitura pare e espera pela sua conclusão.
+     * O que já estiver no pipe ainda é lido (e a última linha incompleta é logada).
      */
     void EnsureCompletion();
 
+    /** Tamanho de cada leitura do pipe. */
+    static constexpr int32 ReadChunkSize = 64 * 1024;
+    /** Leituras por evento do reator antes de devolver a thread ao pool. */
+    static constexpr int32 MaxReadsPerEvent = 16;
+
 private:
     void* ReadPipe;                 // Handle para o pipe de leitura
     FString DisplayName;            // Nome para exibição nos logs
     FRunnableThread* WorkerThread;  // A thread de execução
     FThreadSafeBool bShouldStop;    // Flag para sinalizar a parada da thread
     TArray<uint8>* OutCapturedData; // Onde os dados lidos serão armazenados
+    int32 ReactorRegistrationId;    // Registro no FIARIOReactor (0 = modo thread)
+    int32 ReadDescriptor;           // Descritor do pipe no modo reator
+    FThreadSafeBool bReachedEndOfStream; // O processo fechou o pipe
+    TArray<uint8> ReadBuffer;       // Buffer de leitura reaproveitado
+    TArray<uint8> PendingLine;      // Linha de log ainda sem terminador
+
+    /**
+     * @brief Modo reator: lê o que estiver disponível sem bloquear.
+     * @param MaxReads Limite de leituras (INDEX_NONE = até esvaziar o pipe).
+     * @return false quando o pipe foi fechado pelo processo (EOF) ou falhou.
+     */
+    bool ReadAvailable(int32 MaxReads);
+    /** @brief Callback do reator: lê e rearma o registro enquanto o pipe estiver aberto. */
+    void OnPipeReadable();
+    /** @brief Entrega os bytes lidos: acumula em OutCapturedData ou loga linha a linha. */
+    void ConsumeOutput(const uint8* Data, int32 NumBytes);
+    /** @brief Loga a linha pendente, se houver. */
+    void FlushPendingLine();
 
     // Desabilita cópia e atribuição
     FFMpegLogReader(const FFMpegLogReader&) = delete;
@@ -10,6 +10,7 @@
 #include "CoreMinimal.h"
 #include "../IAR.h"
 #include "Core/IAR_Types.h" // Inclui a USTRUCT FIAR_PipeSettings
+#include "HAL/ThreadSafeBool.h"
 
 #if PLATFORM_WINDOWS
 #include "Windows/AllowWindowsPlatformTypes.h"
@@ -20,6 +21,9 @@
 #include <sys/stat.h>   // Para mkfifo
 #include <fcntl.h>      // Para open, O_RDWR, O_CREAT
 #include <unistd.h>     // Para close, write
+#include <sys/uio.h>    // Para writev
+#include <poll.h>       // Para poll
+#include <limits.h>     // Para IOV_MAX
 #endif
 
 // Forward declarations para tipos OS-específicos
@@ -35,6 +39,25 @@ typedef int IAR_NativePipeHandle; // file descriptor é int
 // Definição de LogCategory para IAR_PipeWrapper
 DECLARE_LOG_CATEGORY_EXTERN(LogIARPipeWrapper, Log, All);
 
+/**
+ * @brief Trecho contíguo de dados para uma escrita em lote (IAR_PipeWrapper::WriteGather).
+ */
+struct FIAR_PipeWriteSegment
+{
+    const uint8* Data = nullptr;
+    int32 NumBytes = 0;
+};
+
+/**
+ * @brief Resultado de uma tentativa de conexão sem espera (IAR_PipeWrapper::TryConnect).
+ */
+enum class EIAR_PipeConnectResult : uint8
+{
+    Connected, // Pipe aberto e pronto para escrita
+    Pending,   // Nenhum leitor abriu o FIFO ainda: tentar de novo mais tarde
+    Failed     // Erro definitivo
+};
+
 /**
  * @brief Encapsula um Named Pipe multiplataforma (HANDLE no Windows, file descriptor no Linux/Mac).
  * Garante thread-safety e compatibilidade multiplataforma para comunicação inter-processos.
@@ -60,11 +83,23 @@ public:
      * (e.g., FFmpeg) se conecte ao pipe.
      * Deve ser chamado DEPOIS que o pipe é criado (com Create()) e DEPOIS que o cliente
      * que vai ler/escrever no pipe é lançado.
+     * @param bAbortRequested Opcional. Em POSIX, interrompe a espera quando a flag é ligada.
      * @return true se a conexão foi bem-sucedida, false caso contrário.
-     * Multiplataforma: Apenas implementado para Windows (ConnectNamedPipe). FIFOs POSIX
-     *                 gerenciam a conexão via open().
+     * Multiplataforma: Windows usa ConnectNamedPipe. Em POSIX, FIFOs em modo bloqueante são abertos aqui
+     *                 (e não em Create()), esperando no máximo ConnectTimeoutSeconds pelo leitor.
+     */
+    bool Connect(const FThreadSafeBool* bAbortRequested = nullptr);
+
+    /**
+     * @brief Uma única tentativa de conexão, sem espera: para quem agenda as novas tentativas por conta própria
+     * (o FIARIOReactor, que não pode bloquear as threads do task graph).
+     * @return Pending em POSIX enquanto nenhum leitor abriu o FIFO.
+     * Multiplataforma: No Windows equivale a Connect() (ConnectNamedPipe bloqueia até o cliente conectar).
      */
-    bool Connect(); 
+    EIAR_PipeConnectResult TryConnect();
+
+    /** Tempo máximo que Connect() espera o leitor abrir um FIFO POSIX. */
+    static constexpr double ConnectTimeoutSeconds = 10.0;
 
     /**
      * @brief Escreve dados no pipe.
@@ -77,6 +112,32 @@ public:
      */
     int32 Write(const uint8* Data, int32 NumBytes);
 
+    /**
+     * @brief Escreve vários trechos em uma única chamada (writev em POSIX), na ordem dada.
+     * A escrita pode ser parcial: o chamador deve reenviar a partir do byte seguinte ao último escrito.
+     * @param Segments Trechos a serem escritos.
+     * @param NumSegments Número de trechos (em POSIX, limitado a IOV_MAX por chamada).
+     * @return O número de bytes escritos (0 se o pipe está cheio em modo não-bloqueante), ou -1 em caso de erro.
+     * Multiplataforma: No Windows, os trechos são escritos em sequência com WriteFile até a primeira escrita incompleta.
+     */
+    int64 WriteGather(const FIAR_PipeWriteSegment* Segments, int32 NumSegments);
+
+    /**
+     * @brief Aguarda até haver espaço para escrita no pipe (poll com POLLOUT em POSIX).
+     * @param TimeoutMs Tempo máximo de espera em milissegundos.
+     * @return true se o pipe aceita escrita (ou tem um erro pendente, que a próxima escrita reportará), false no timeout.
+     * Multiplataforma: No Windows, pipes bloqueantes retornam true imediatamente (o WriteFile já espera);
+     *                 pipes não-bloqueantes fazem uma pausa curta, pois Named Pipes não têm espera por prontidão.
+     */
+    bool WaitForWritable(int32 TimeoutMs);
+
+    /**
+     * @brief Alterna o modo não-bloqueante do pipe depois de conectado.
+     * @return true se o modo foi aplicado.
+     * Multiplataforma: Apenas POSIX (O_NONBLOCK via fcntl). No Windows o modo definido em Create() é mantido.
+     */
+    bool SetNonBlocking(bool bNonBlocking);
+
     /**
      * @brief Fecha o pipe e libera seus recursos.
      * Para FIFOs POSIX, isso também remove o arquivo do sistema de arquivos.
@@ -96,6 +157,12 @@ public:
      */
     FString GetFullPipeName() const;
 
+    /**
+     * @brief Retorna o handle nativo (HANDLE no Windows, file descriptor em POSIX), ou IAR_INVALID_NATIVE_PIPE_HANDLE se o pipe não está aberto.
+     * Usado para registrar o pipe em um FIARIOReactor.
+     */
+    IAR_NativePipeHandle GetNativeHandle() const;
+
 private:
 
 #if PLATFORM_WINDOWS
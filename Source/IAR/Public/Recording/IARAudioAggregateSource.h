@@ -0,0 +1,85 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IARAudioSource.h" 
+#include "AudioCaptureCore.h" 
+#include "Core/IAR_Types.h" 
+#include "Core/IARDriftCompensator.h"
+#include "Core/IARFrameReblocker.h"
+
+#include "IARAudioAggregateSource.generated.h"
+
+/**
+ * @brief Fonte de áudio que captura vários dispositivos ao mesmo tempo e os entrega como um único stream multicanal.
+ * O primeiro dispositivo de AggregateInputDevices é o mestre: seus callbacks ditam o relógio da saída.
+ * Cada dispositivo secundário passa por um FIARDriftCompensator, que estima a deriva do seu relógio em relação
+ * ao mestre e a corrige com reamostragem adaptativa, mantendo as faixas alinhadas amostra a amostra por horas.
+ * Os frames combinados são reagrupados em janelas fixas (FIARFrameReblocker), como na UIARAudioMixerSource.
+ */
+UCLASS(BlueprintType)
+class IAR_API UIARAudioAggregateSource : public UIARAudioSource
+{
+    GENERATED_BODY()
+
+public:
+    UIARAudioAggregateSource();
+    virtual ~UIARAudioAggregateSource();
+
+    /**
+     * @brief Abre todos os dispositivos de AggregateInputDevices.
+     * @param StreamSettings NumChannels deve ser a soma dos canais dos dispositivos.
+     * @param InFramePool O FramePool a ser utilizado para aquisição de frames.
+     */
+    virtual void Initialize(FIAR_AudioStreamSettings& StreamSettings, UIARFramePool* InFramePool) override;
+
+    /**
+     * @brief Inicia a captura: os secundários começam antes do mestre, para já terem amostras no primeiro callback dele.
+     */
+    virtual void StartCapture() override;
+
+    /**
+     * @brief Para a captura de todos os dispositivos (o mestre primeiro).
+     */
+    virtual void StopCapture() override;
+
+    /**
+     * @brief Fecha todos os dispositivos e libera os recursos.
+     */
+    virtual void Shutdown() override;
+
+    /**
+     * @brief Deriva estimada de um dispositivo (índice em AggregateInputDevices) em relação ao mestre, em ppm.
+     */
+    UFUNCTION(BlueprintPure, Category = "IAR|Aggregate Source")
+    float GetEstimatedDriftPPM(int32 DeviceSlot) const;
+
+private:
+    struct FDeviceStream
+    {
+        TUniquePtr<Audio::FAudioCapture> Capture;
+        TUniquePtr<FIARDriftCompensator> Compensator; // Nulo no mestre
+        int32 DeviceIndex = 0;
+        int32 NumChannels = 0;
+        int32 ChannelOffset = 0; // Primeiro canal do dispositivo no frame de saída
+    };
+
+    TArray<TUniquePtr<FDeviceStream>> Devices; // Devices[0] é o mestre
+    FIARFrameReblocker Reblocker;              // Acessado apenas pela thread do mestre enquanto captura
+    TArray<float> CombinedSamples;             // Bloco combinado do callback atual do mestre
+    int64 FramesSinceDriftLog = 0;
+
+    /** @brief Combina o bloco do mestre com os secundários alinhados e emite as janelas completas. */
+    void OnMasterAudioCapture(const void* InAudio, int32 NumFrames, int32 NumChannels, int32 SampleRate, bool bOverFlow);
+
+    /** @brief Copia uma janela do Reblocker para um frame do pool e o publica em OnAudioFrameAcquired. */
+    void EmitWindow(const float* WindowData, int32 NumFrames, int64 StartFrameIndex, int32 OverlapFrames, int32 SampleRate, int32 NumChannels);
+
+    void CloseDevices();
+};
@@ -29,7 +29,8 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnIARFileMasterRecordingStopped, co
 
 /**
  * @brief Gerencia as sessões de gravação de áudio, incluindo gravações master e takes.
- * Orquestra múltiplos UIARAudioEncoder para diferentes saídas, e gerencia a rotação automática de takes.
+ * Cada gravação usa um único UIARAudioEncoder, que divide a saída em takes de duração exata (em amostras);
+ * ao parar, os takes são concatenados em um arquivo Master.
  */
 UCLASS()
 class IAR_API UIARAudioCaptureSession : public UObject
@@ -69,6 +70,15 @@ public:
 
     void OnAudioFrameReceived(TSharedPtr<FIAR_AudioFrameData> AudioFrame);
 
+    /** Fila máxima do encoder (memória + journal) aceita antes de uma fonte offline esperar. */
+    static constexpr int64 MaxOfflineEncoderBacklogBytes = 4 * 1024 * 1024;
+
+    /**
+     * @brief Backpressure para fontes offline: false enquanto o encoder da gravação tiver mais de
+     * MaxOfflineEncoderBacklogBytes ainda não escritos. Chamado na thread que entrega os frames.
+     */
+    bool HasEncoderCapacity() const;
+
     void ShutdownSession();
 
     UIARFramePool* GetFramePool() const { return FramePool; }
@@ -98,12 +108,15 @@ private:
     FIAR_AudioStreamSettings CurrentSessionStreamSettings;
     FString CurrentOverallSessionName;
 
+    // Encoder único da gravação: os takes são segmentos internos dele
     UPROPERTY()
-    TObjectPtr<UIARAudioEncoder> CurrentTakeEncoder;
+    TObjectPtr<UIARAudioEncoder> RecordingEncoder;
+
+    // Encoders de gravações já paradas, finalizando em background (mantidos vivos até o callback)
+    UPROPERTY()
+    TArray<TObjectPtr<UIARAudioEncoder>> FinalizingEncoders;
 
     TArray<FString> CompletedTakeFilePaths;
-    
-    FTimerHandle TakeRotationTimerHandle;
 
     bool bIsOverallRecordingActive = false;
 
@@ -131,14 +144,37 @@ private:
     UFUNCTION()
     void OnPipeCleared(const FString& OutputFilePath);
 
-    void StartNewTakeInternal();
+    UFUNCTION()
+    void OnEncoderSegmentStarted(int32 SegmentIndex, const FString& FilePath);
+    UFUNCTION()
+    void OnEncoderSegmentFinished(int32 SegmentIndex, const FString& FilePath);
 
-    bool StopCurrentTakeInternal();
+    /** @brief Cria e lança o encoder da gravação, segmentado em takes de TakeDurationSeconds. */
+    bool StartRecordingEncoderInternal();
 
-    UFUNCTION()
-    void RotateCurrentTake();
+    /**
+     * @brief Desliga o encoder da gravação da captura e inicia sua finalização em background, sem bloquear a Game Thread.
+     * Ao terminar, OnRecordingEncoderFinalized monta o arquivo Master em MasterFilePath.
+     */
+    bool StopRecordingEncoderInternal(const FString& MasterFilePath);
+
+    /** @brief Callback (Game Thread) da finalização: coleta os takes, libera o encoder e inicia a montagem do Master. */
+    void OnRecordingEncoderFinalized(UIARAudioEncoder* Encoder, bool bSuccess, const FString& MasterFilePath);
+
+    /** @brief Remove os bindings da sessão e desliga o encoder. */
+    void ReleaseEncoder(UIARAudioEncoder* Encoder);
 
+    /** @brief Concatena os takes no arquivo Master em background e notifica o fim da gravação. */
+    void StartMasterAssembly(const FString& MasterFilePath, const TArray<FString>& TakeFilePaths);
+
+    /**
+     * @brief Monta o arquivo Master a partir dos takes, em um diretório de trabalho exclusivo.
+     * Takes WAV PCM no mesmo formato são concatenados em processo (FIARWavConcatenator); os demais, via FFmpeg.
+     */
     bool ConcatenateTakesToMaster(const FString& MasterFilePath, const TArray<FString>& TakeFilePaths);
 
+    /** @brief Concatenação via FFmpeg (concat demuxer, -c copy), com a lista de arquivos em WorkDirPath. */
+    bool ConcatenateTakesWithFFmpeg(const FString& MasterFilePath, const TArray<FString>& TakeFilePaths, const FString& WorkDirPath);
+
     void DeleteTakeFiles(const TArray<FString>& FilePathsToDelete);
 };
@@ -12,11 +12,18 @@
 #include "Core/IAR_Types.h"      // Para FIAR_AudioStreamSettings, FIAR_AudioFrameData, FIAR_AudioConversionSettings
 #include "IAR_PipeWrapper.h"   // Para IAR_PipeWrapper
 #include "IARECFactory.h"      // Para UIARECFactory
+#include "IARWavStreamWriter.h" // Para FIARWavStreamWriter (gravação PCM sem FFmpeg)
+#include "IARSpillJournal.h"    // Para o transbordo da fila do encoder em disco
 #include "HAL/Runnable.h"       // Para FRunnable (worker thread)
 #include "HAL/RunnableThread.h"  // Para FRunnableThread
 #include "Containers/Queue.h"    // Para TQueue (thread-safe)
+#include "HAL/ThreadSafeCounter64.h" // Para a contagem de bytes ainda não enviados ao pipe
+#include "HAL/ThreadSafeCounter.h"   // Para as tarefas de escrita pendentes no modo reator
+#include "Async/Future.h"        // Para TFuture (finalização de segmentos e da gravação em background)
 #include "Misc/ScopeLock.h"      // Para FScopeLock
 #include "Core/IARFramePool.h"   // ADICIONADO: Include para UIARFramePool
+#include "Core/IARSampleFormatConverter.h" // Para a conversão float -> formato de gravação
+#include "Core/IARByteBlockPool.h"   // Para os blocos de bytes reutilizados entre encoder e worker
 #include "FFmpegLogReader.h"     // ADICIONADO: Include para FFMpegLogReader
 #include <string> // <<-- ADICIONADO: Necessário para std::string em EncodeRawPCMToFile, ConvertMIDIToAudio
 #include "TimerManager.h"
@@ -35,6 +42,10 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAudioEncodingError, const FString
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAudioPipeCongested, const FString&, OutputFilePath);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAudioPipeCleared, const FString&, OutputFilePath);
 
+// Delegates de segmentação (cada segmento é um take dentro da mesma gravação)
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAudioSegmentStarted, int32, SegmentIndex, const FString&, FilePath);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAudioSegmentFinished, int32, SegmentIndex, const FString&, FilePath);
+
 
 // DECLARAÇÃO: FIARAudioEncoderWorker.
 // Apenas a declaração da classe e seus protótipos de método.
@@ -42,7 +53,8 @@ class FIARAudioEncoderWorker : public FRunnable
 {
 public:
     // Construtor
-    FIARAudioEncoderWorker(IAR_PipeWrapper& InPipeWrapper, TQueue<TArray<uint8>, EQueueMode::Mpsc>& InDataQueue, FEvent* InDataAvailableEvent, FThreadSafeBool& InShouldStop);
+    FIARAudioEncoderWorker(IAR_PipeWrapper& InPipeWrapper, TQueue<TArray<uint8>, EQueueMode::Mpsc>& InDataQueue, FEvent* InDataAvailableEvent, FThreadSafeBool& InShouldStop, FIARByteBlockPool* InBlockPool,
+                           int64 InMemoryBudgetBytes, int64 InSpillLimitBytes, const FString& InSpillFilePath);
     
     // IMPORTANTE: O destrutor virtual é crucial para a liberação correta de recursos de classes base.
     virtual ~FIARAudioEncoderWorker();
@@ -53,30 +65,138 @@ public:
     virtual void Stop() override;
     virtual void Exit() override;
 
-    /** Enfileira dados para serem escritos no pipe. */
+    /** Número máximo de blocos agrupados em uma única escrita (writev). */
+    static constexpr int32 MaxGatherBlocks = 64;
+    /** Número máximo de bytes agrupados em uma única escrita. */
+    static constexpr int64 MaxGatherBytes = 1024 * 1024;
+    /** Tamanho de cada leitura do journal durante a recuperação. */
+    static constexpr int64 SpillReadChunkBytes = 256 * 1024;
+
+    /**
+     * Enfileira dados para serem escritos no pipe. Nunca bloqueia nem faz I/O na thread da captura:
+     * acima do orçamento de memória os bytes são entregues à thread do journal em disco e, a partir daí,
+     * tudo segue pelo journal (preservando a ordem) até o worker esvaziá-lo.
+     */
     void EnqueueData(TArray<uint8>&& Data);
+    /** Bytes enfileirados que ainda não chegaram ao pipe (na fila ou no lote em trânsito do worker). */
+    int64 GetUnsentBytes() const { return UnsentBytes.GetValue(); }
     /** Sinaliza para o worker thread parar de processar e sair. */
     void StopProcessing(); // Apenas um wrapper para Stop()
     
     // NOVO: Getter para o status de congestionamento do pipe.
     bool IsPipeCurrentlyCongested() const;
 
+    /** Métricas da fila em memória e do journal. */
+    FIAR_EncoderQueueStats GetQueueStats() const;
+
+    /**
+     * @brief Alternativa à thread dedicada: o pipe é esvaziado por tarefas no pool de background,
+     * agendadas por EnqueueData e pelo FIARIOReactor quando o FFmpeg libera espaço no pipe.
+     * @return false se o reator não estiver disponível (o chamador cria a thread do worker).
+     */
+    bool StartReactive();
+    /** @brief Encerra o modo reator e espera a última tarefa de escrita terminar. */
+    void StopReactive();
+    bool IsReactive() const { return bReactiveMode; }
+
 private:
+    /** Resultado de uma rodada de escrita. */
+    enum class EPumpResult : uint8
+    {
+        Idle,       // Nada mais a escrever
+        WouldBlock, // Pipe cheio: espera espaço para continuar
+        Stopped     // Parada solicitada ou erro fatal
+    };
+
+    /**
+     * @brief Escreve o que estiver pendente (fila em memória e journal) até esvaziar, encher o pipe ou parar.
+     * Usado pelas duas formas de execução (Run e tarefas do reator); nunca roda em duas threads ao mesmo tempo.
+     */
+    EPumpResult Pump();
+    /** @brief Conecta o pipe (espera o FFmpeg abri-lo) e o coloca em modo não-bloqueante. */
+    bool ConnectPipe();
+    /** @brief Modo reator: uma tentativa de conexão sem espera (Pending até o FFmpeg abrir o pipe ou o timeout). */
+    EIAR_PipeConnectResult TryConnectPipe();
+    /** @brief Marca o pipe como conectado e o coloca em modo não-bloqueante. */
+    void OnPipeConnected();
+    /** @brief Modo reator: agenda uma tarefa de escrita se nenhuma estiver agendada ou aguardando o pipe. */
+    void ScheduleDrain();
+    /** @brief Modo reator: corpo da tarefa de escrita (também chamado pelo reator quando o pipe tem espaço). */
+    void DrainReactive();
+    /** @brief Devolve ao pool os blocos do lote em trânsito que não foram enviados. */
+    void ReleasePendingBlocks();
+    /** @brief Acorda quem esvazia o pipe (a thread do worker ou uma tarefa do reator). */
+    void WakeConsumer();
+
     // Membros da classe worker.
     // Usamos referências (&) para evitar cópias e garantir que trabalhamos com os objetos reais.
     IAR_PipeWrapper& PipeWrapper; // Referência para o pipe
     TQueue<TArray<uint8>, EQueueMode::Mpsc>& DataQueue; // Referência para a fila de dados de áudio a serem escritos
     FThreadSafeBool& bShouldStop;    // Referência para a flag de sinalização de parada da thread
     FEvent* DataAvailableEvent; // Referência para o evento para sinalizar que há dados na fila
+    FIARByteBlockPool* BlockPool; // Pool para onde os blocos voltam depois de escritos (pode ser nulo)
 
     // NOVO: Flag atômica para indicar se o pipe está atualmente congestionado
     FThreadSafeBool bIsPipeCurrentlyCongested;
+
+    FThreadSafeCounter64 UnsentBytes; // Incrementado em EnqueueData, decrementado a cada escrita bem-sucedida
+    FThreadSafeCounter64 MemoryQueuedBytes; // Parte de UnsentBytes que está em memória (limitada por MemoryBudgetBytes)
+    FThreadSafeCounter64 TotalSpilledBytes;
+    FThreadSafeCounter64 DroppedBytes;
+    int64 MemoryBudgetBytes;
+
+    // Transbordo em disco. SpillLock protege a decisão memória/journal e as métricas de recuperação; nunca é mantido durante I/O.
+    mutable FCriticalSection SpillLock;
+    FIARSpillJournal SpillJournal;
+    bool bIsSpilling;
+    double SpillStartTime;
+    int32 SpillEventCount;
+    float LastRecoverySeconds;
+    float MaxRecoverySeconds;
+
+    /** Bloco do lote em trânsito; blocos lidos do journal não pertencem ao pool nem ao orçamento de memória. */
+    struct FPendingBlock
+    {
+        TArray<uint8> Bytes;
+        bool bFromJournal = false;
+    };
+
+    /**
+     * @brief Retira o próximo bloco na ordem de chegada: primeiro a fila em memória, depois o journal.
+     * @return false se não houver dados (ou em erro de leitura do journal).
+     */
+    bool DequeueNextBlock(FPendingBlock& OutBlock, int64 MaxJournalBytes);
+
+    /** @brief Devolve um bloco ao pool (ou o descarta se não houver pool). */
+    void ReleaseBlock(TArray<uint8>&& Block);
+
+    // Lote em trânsito: blocos já retirados da fila, na ordem. O primeiro pode ter sido escrito em parte (PendingOffset).
+    // Acessado apenas por quem está executando Pump (a thread do worker ou a tarefa de escrita do reator).
+    TArray<FPendingBlock> PendingBlocks;
+    TArray<FIAR_PipeWriteSegment> Segments;
+    int32 PendingOffset;
+    int64 PendingBytes;
+    bool bIsPipeConnected;
+
+    // Modo reator
+    bool bReactiveMode;
+    int32 ReactorRegistrationId;
+    double ReactiveConnectDeadline; // Limite para o FFmpeg abrir o pipe (IAR_PipeWrapper::ConnectTimeoutSeconds)
+    static constexpr double ReactiveConnectRetrySeconds = 0.005; // Intervalo entre tentativas, no timer do reator
+    FThreadSafeBool bDrainScheduled; // Uma tarefa de escrita está agendada, rodando ou aguardando o pipe
+    FThreadSafeCounter OutstandingDrainTasks; // Tarefas despachadas e ainda não terminadas + 1 referência do modo reator
+    FEvent* DrainTasksDoneEvent;              // Sinalizado por quem leva OutstandingDrainTasks a 0 (a última tarefa ou o StopReactive)
+    static constexpr uint32 StopWaitWarningMs = 2000; // Espera do StopReactive antes de avisar no log (e continuar esperando)
+
+    /** @brief Conclui uma tarefa de escrita (ou solta a referência do modo reator); a última sinaliza DrainTasksDoneEvent. */
+    void FinishDrainTask();
 };
 
 
 /**
  * @brief Gerencia a codificação de áudio para um arquivo usando um processo externo (FFmpeg).
  * Utiliza Named Pipes/FIFOs para comunicação e uma worker thread para escrita eficiente.
+ * Quando o codec é PCM, o FFmpeg não é lançado: o WAV é escrito em processo por um FIARWavStreamWriter.
  */
 UCLASS()
 class IAR_API UIARAudioEncoder : public UObject
@@ -118,6 +238,28 @@ public:
     UFUNCTION(BlueprintCallable, Category = "IAR|Encoder")
     bool LaunchEncoder(const FString& LiveOutputFilePath);
 
+    /** Marcador do índice do segmento no caminho passado a LaunchEncoder quando a segmentação está ativa. */
+    static constexpr const TCHAR* SegmentIndexToken = TEXT("%03d");
+
+    /**
+     * @brief Divide a gravação em segmentos de exatamente InSegmentFrames frames, sem relançar o encoder.
+     * Deve ser chamada antes de LaunchEncoder, cujo caminho passa a ser um padrão com SegmentIndexToken no lugar do índice.
+     * PCM: o escritor nativo troca de arquivo na amostra exata. Demais codecs: o mesmo processo FFmpeg usa o segment muxer,
+     * e InSegmentFrames é arredondado para um múltiplo de UIARECFactory::SegmentPacketFrames (deve ser chamada após Initialize).
+     * @param InSegmentFrames Frames por segmento (0 desativa a segmentação).
+     * @param InFirstSegmentIndex Índice do primeiro segmento.
+     */
+    void SetSegmentation(int64 InSegmentFrames, int32 InFirstSegmentIndex);
+
+    /** @brief Caminho do segmento SegmentIndex (padrão de LaunchEncoder com o índice formatado). */
+    FString GetSegmentFilePath(int32 SegmentIndex) const;
+
+    /**
+     * @brief Arquivos já concluídos, na ordem de gravação. Após FinishEncoding inclui o último segmento
+     * (sem segmentação, o único arquivo da gravação).
+     */
+    TArray<FString> GetCompletedSegmentFilePaths() const;
+
     /**
      * @brief Encerra o codificador e limpa todos os recursos (pipes, processo FFmpeg, threads).
      */
@@ -140,6 +282,17 @@ public:
     UFUNCTION(BlueprintCallable, Category = "IAR|Encoder")
     bool FinishEncoding();
 
+    /**
+     * @brief Versão não bloqueante de FinishEncoding: a partir desta chamada nenhum frame novo é aceito,
+     * e o esvaziamento das filas, a finalização dos arquivos e a espera pelo FFmpeg rodam em background.
+     * Ao terminar, OnFinished e OnAudioEncodingFinished são chamados na Game Thread; só então ShutdownEncoder é barato.
+     * @return false se o encoder não estiver inicializado ou já estiver finalizando.
+     */
+    bool FinishEncodingAsync(TFunction<void(bool bSuccess)> OnFinished);
+
+    /** @brief true enquanto a finalização iniciada por FinishEncodingAsync não terminou. */
+    bool IsFinishing() const { return FinishTask.IsValid() && !FinishTask.IsReady(); }
+
     /**
      * @brief Executa um processo FFmpeg em um background thread e aguarda sua conclusão.
      * Esta função é bloqueante para o thread que a chama, mas não para a Game Thread se chamada via AsyncTask.
@@ -152,6 +305,7 @@ public:
 
     /**
      * @brief Decodifica um arquivo de áudio de entrada para dados PCM brutos (s16le) usando FFmpeg.
+     * O arquivo inteiro fica em memória; para arquivos longos prefira FIARStreamingAudioDecoder (frames f32 com memória constante).
 * @param InputFilePath Caminho completo para o arquivo de áudio de entrada no disco.
      * @param TargetSampleRate A taxa de amostragem desejada para o PCM de saída.
      * @param TargetNumChannels O número de canais desejado para o PCM de saída.
@@ -183,17 +337,42 @@ public:
      * @param SampleRate A taxa de amostragem do áudio.
      * @param NumChannels O número de canais do áudio.
      * @param OutputFilePath O caminho completo para o arquivo de saída (ex: "C:/path/output.wav").
-     * @param BitDepth A profundidade de bits desejada para a saída (ex: 16 para PCM_S16LE). Apenas 16-bit suportado na implementação atual.
+     * @param BitDepth A profundidade de bits desejada para a saída (16, 24 ou 32 bits, PCM inteiro).
+     * @param bApplyDither Aplica dither TPDF ao quantizar para 16 ou 24 bits (desligado por padrão, como em FIAR_AudioStreamSettings).
      * @return true se a codificação foi bem-sucedida, false caso contrário.
      */
     UFUNCTION(BlueprintCallable, Category = "IAR|Encoder",
               meta = (DisplayName = "Encode Raw PCM to File",
                       Tooltip = "Encodes raw float PCM data to a specified audio file format (e.g., WAV) using dr_wav."))
-    static bool EncodeRawPCMToFile(const TArray<float>& RawPCMData, int32 SampleRate, int32 NumChannels, const FString& OutputFilePath, int32 BitDepth = 16);
+    static bool EncodeRawPCMToFile(const TArray<float>& RawPCMData, int32 SampleRate, int32 NumChannels, const FString& OutputFilePath, int32 BitDepth = 16, bool bApplyDither = false);
 
     UFUNCTION(BlueprintPure, Category = "IAR")
     bool IsInitialized() const { return bIsInitialized; }
 
+    /**
+     * @brief Indica se as configurações podem ser gravadas pelo escritor WAV nativo (sem FFmpeg).
+     */
+    static bool CanUseNativeWavWriter(const FIAR_AudioStreamSettings& Settings);
+
+    /**
+     * @brief Informa a duração esperada da gravação, usada pelo escritor nativo para pré-alocar o arquivo
+     * e decidir entre RIFF e RF64. Deve ser chamada antes de LaunchEncoder. 0 = desconhecida (o contêiner é
+     * decidido ao fechar: RIFF se o take couber em 4GB, RF64 caso contrário).
+     */
+    void SetExpectedRecordingDuration(float Seconds) { ExpectedRecordingDurationSeconds = FMath::Max(0.0f, Seconds); }
+
+    /**
+     * @brief Retorna true se este encoder grava pelo escritor WAV nativo em vez do FFmpeg.
+     */
+    UFUNCTION(BlueprintPure, Category = "IAR|Audio Encoder")
+    bool IsUsingNativeWavWriter() const { return bUseNativeWavWriter; }
+
+    /**
+     * @brief Métricas da fila de escrita do pipe (bytes em memória, transbordo em disco e tempo de recuperação).
+     */
+    UFUNCTION(BlueprintCallable, Category = "IAR|Audio Encoder")
+    FIAR_EncoderQueueStats GetQueueStats() const;
+
     /**
      * @brief Verifica se a codificação está ativa.
      */
@@ -204,7 +383,7 @@ public:
      * @brief Retorna o caminho completo do arquivo de saída que este encoder está gravando.
      */
     UFUNCTION(BlueprintCallable, BlueprintPure, Category = "IAR|Audio Encoder")
-    FString GetCurrentOutputFilePath() const { return CurrentOutputFilePath; }
+    FString GetCurrentOutputFilePath() const;
 
     // Delegates para notificação
     UPROPERTY(BlueprintAssignable, Category = "IAR|Audio Encoder|Delegates")
@@ -220,6 +399,12 @@ public:
     UPROPERTY(BlueprintAssignable, Category = "IAR|Audio Encoder|Delegates")
     FOnAudioPipeCleared OnAudioPipeCleared;
 
+    UPROPERTY(BlueprintAssignable, Category = "IAR|Audio Encoder|Delegates")
+    FOnAudioSegmentStarted OnAudioSegmentStarted;
+
+    UPROPERTY(BlueprintAssignable, Category = "IAR|Audio Encoder|Delegates")
+    FOnAudioSegmentFinished OnAudioSegmentFinished;
+
     // Declaração de GetFFmpegExecutablePathInternal como public para acesso de UIARAudioComponent
     // Agora é um método const static para evitar criar um objeto Default e permitir fácil acesso.
     UFUNCTION(BlueprintCallable, BlueprintPure, Category = "IAR|Encoder")
@@ -255,6 +440,8 @@ private:
     
     FThreadSafeBool bStopWorkerThread; // Flag atômica para sinalizar ao worker thread para parar
     FThreadSafeBool bNoMoreFramesToEncode; // Flag atômica para sinalizar que todos os frames foram submetidos (não haverá mais Enqueue)
+    FThreadSafeBool bAcceptingFrames; // false a partir do início da finalização: EncodeFrame recusa frames novos
+    FThreadSafeCounter FramesInFlight; // Chamadas de EncodeFrame em andamento (podem estar dentro de SubmitSamples/BeginNextSegment)
     FThreadSafeBool bIsInitialized; // Estado interno para controle de inicialização (FThreadSafeBool implicitamente conversível para bool)
     FThreadSafeBool bIsPipeCurrentlyCongestedInternal; // NOVO: Flag interna para o Encoder para evitar broadcast repetitivo.
     
@@ -275,4 +462,87 @@ private:
 
     // NOVO: Método para verificar o status de congestionamento do pipe.
     void CheckPipeCongestionStatus();
+
+    // Escritor WAV em processo, usado no lugar de FFmpeg + pipe quando o codec é PCM
+    TUniquePtr<FIARWavStreamWriter> NativeWavWriter;
+    bool bUseNativeWavWriter;
+    bool bNativeWriterErrorReported;
+    float ExpectedRecordingDurationSeconds;
+
+    // Conversão float -> BitDepth da gravação, direto em blocos reaproveitados do pool
+    FIARSampleFormatConverter SampleConverter;
+    FIARByteBlockPool EncodedBlockPool;
+
+    // Segmentação (takes) dentro de uma única gravação
+    int64 SegmentFrames;
+    int32 CurrentSegmentIndex;
+    int64 FramesInCurrentSegment;
+    FString SegmentPathPattern;
+    TArray<FString> CompletedSegmentPaths;
+    TArray<TFuture<bool>> PendingSegmentCloses; // Escritores de segmentos anteriores sendo finalizados em background
+    // Escritor do próximo segmento, aberto em background enquanto o atual grava (só quem chama EncodeFrame o troca)
+    TFuture<TUniquePtr<FIARWavStreamWriter>> PreparedSegmentWriter;
+    FThreadSafeBool bSegmentCloseFailed;
+    mutable FCriticalSection SegmentLock; // Protege CurrentOutputFilePath, CompletedSegmentPaths, PendingSegmentCloses e UnconfirmedSegments (EncodeFrame pode rodar fora da Game Thread)
+
+    /** Segmento cortado pelo FFmpeg cujo arquivo ainda pode estar aberto (OnAudioSegmentFinished só sai depois de fechado). */
+    struct FUnconfirmedSegment
+    {
+        int32 Index;
+        FString Path;
+        FString NextPath; // Vazio no último segmento: só o fim do processo confirma
+    };
+    TArray<FUnconfirmedSegment> UnconfirmedSegments;
+
+    // Finalização iniciada por FinishEncodingAsync (ShutdownEncoder aguarda antes de liberar os recursos)
+    TFuture<bool> FinishTask;
+
+    /** @brief Cria e abre um escritor WAV nativo para FilePath, com o tamanho esperado de um segmento (ou da gravação). */
+    bool OpenNativeWavWriter(const FString& FilePath, TUniquePtr<FIARWavStreamWriter>& OutWriter);
+
+    /**
+     * @brief Abre em background o escritor do segmento SegmentIndex (criação do arquivo, pré-alocação e thread de I/O),
+     * para que a troca na fronteira do take seja só uma troca de ponteiros.
+     */
+    void PrepareNextSegmentWriter(int32 SegmentIndex);
+
+    /** @brief Entrega o escritor preparado para NextPath (espera a abertura só se ela ainda não terminou). */
+    TUniquePtr<FIARWavStreamWriter> TakePreparedSegmentWriter(const FString& NextPath);
+
+    /** @brief Fecha e remove o arquivo de um escritor preparado que não chegou a ser usado (fim da gravação). */
+    void DiscardPreparedSegmentWriter();
+
+    /**
+     * @brief Para de aceitar frames e aguarda as chamadas de EncodeFrame em andamento terminarem.
+     * Depois dela nenhuma thread toca no escritor nativo nem no worker, então eles podem ser fechados.
+     */
+    void StopAcceptingFrames();
+
+    /** @brief Converte NumSamples amostras intercaladas e as entrega ao escritor nativo ou ao worker do pipe. */
+    void SubmitSamples(const float* Samples, int32 NumSamples);
+
+    /**
+     * @brief Fecha o segmento atual e passa ao próximo (no PCM, troca o arquivo do escritor nativo).
+     * @return false se o arquivo do próximo segmento não pôde ser aberto (a gravação para de aceitar frames).
+     */
+    bool BeginNextSegment();
+
+    /**
+     * @brief Dispara OnAudioSegmentFinished dos segmentos do FFmpeg cujo arquivo já foi fechado: o segment muxer
+     * fecha um arquivo antes de criar o seguinte, e o último só está fechado quando o processo termina.
+     * @param bProcessExited true depois que o FFmpeg terminou (confirma todos os pendentes).
+     */
+    void ConfirmClosedSegments(bool bProcessExited);
+
+    /** @brief Aguarda os escritores de segmentos anteriores terminarem de fechar. @return false se algum falhou. */
+    bool WaitForPendingSegmentCloses();
+
+    /** @brief Registra o último segmento como concluído (chamado por FinishEncoding). */
+    void CompleteFinalSegment();
+
+    /** @brief Dispara OnAudioSegmentStarted/OnAudioSegmentFinished na Game Thread. */
+    void BroadcastSegmentEvent(bool bStarted, int32 SegmentIndex, const FString& FilePath);
+
+    /** @brief Notifica (uma vez) a falha do escritor nativo via OnAudioEncodingError. */
+    void ReportNativeWriterError();
 };
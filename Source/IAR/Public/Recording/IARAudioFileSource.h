@@ -10,6 +10,11 @@
 #include "CoreMinimal.h"
 #include "IARAudioSource.h" 
 #include "Core/IARFramePool.h" // Incluído para poder referenciar IARAudioFileSource
+#include "AudioAnalysis/IARWaveformSummary.h"
+#include "Recording/IARMappedWavReader.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Async/Future.h"
 #include "TimerManager.h"
 
 #include "IARAudioFileSource.generated.h"
@@ -17,6 +22,8 @@
 /**
  * @brief Fonte de áudio que lê samples de um arquivo de áudio (ex: .wav).
  * Alimenta o pipeline com FIAR_AudioFrameData lidos do arquivo.
+ * O arquivo é mapeado em memória (FIARMappedWavReader) e convertido frame a frame durante a reprodução,
+ * então o carregamento não depende da duração do arquivo.
  */
 UCLASS(BlueprintType)
 class IAR_API UIARAudioFileSource : public UIARAudioSource // Herda de UIARAudioSource
@@ -71,19 +78,43 @@ public:
     bool Internal_LoadAudioFileBlocking(); 
     // --- FIM DA ALTERAÇÃO ESPECÍFICA DO PROBLEMA LATENTE ---
 
-    void ProcessFileFrame();
+    /**
+     * @brief Converte o próximo bloco do arquivo e o entrega ao pipeline. Chamado pela thread produtora (FIARClockedProducer).
+     * @param StreamTimeSeconds Tempo do bloco no relógio de amostras desde o início da captura (timestamp do frame).
+     */
+    void ProcessFileFrame(double StreamTimeSeconds);
+
+    /**
+     * @brief Define a consulta de capacidade do pipeline usada no processamento offline (bProcessAsFastAsPossible).
+     * Chamada na thread produtora antes de cada frame; sem consulta, a fonte produz sem limite.
+     */
+    void SetDownstreamCapacityQuery(TFunction<bool()>&& InCapacityQuery) { DownstreamCapacityQuery = MoveTemp(InCapacityQuery); }
+
+    /**
+     * @brief Resumo Min/Max/RMS do arquivo, construído em background logo após o carregamento (cresce até cobrir o arquivo inteiro).
+     * Permite desenhar/navegar pelo arquivo completo em qualquer zoom sem reler as amostras.
+     */
+    const FIARWaveformSummary& GetWaveformSummary() const { return WaveformSummary; }
 
 public: // Alterado de private para public para acesso da ação latente
     // Armazena o caminho absoluto completo do arquivo no disco
     FString FullDiskFilePathInternal; 
 
 private:
-    TArray<float> RawAudioSamples; // Samples do arquivo de áudio convertidos para float
+    FIARMappedWavReader WavReader; // Leitor sob demanda do arquivo mapeado (o cursor é a posição de reprodução)
 
-    int32 CurrentSampleIndex; // Índice do sample atual sendo lido no RawAudioSamples
     int32 NumSamplesPerFrame; // Número de samples a serem processados por frame
 
-    FTimerHandle AudioFileProcessTimerHandle; // Timer para controlar a leitura do arquivo
+    FThreadSafeCounter ProducerRegistrationId; // Registro na FIARClockedProducer enquanto captura (0 = nenhum)
+    TFunction<bool()> DownstreamCapacityQuery; // Backpressure do modo offline
 
     bool bIsFileLoaded = false; // Indica se o arquivo foi carregado com sucesso
+
+    FIARWaveformSummary WaveformSummary; // Pirâmide de resumo da waveform do arquivo carregado
+
+    TFuture<void> WaveformSummaryTask;      // Construção do resumo em background, com um leitor próprio
+    FThreadSafeBool bCancelWaveformSummary; // Interrompe a construção do resumo (reset/shutdown)
+
+    /** @brief Lê o arquivo inteiro em blocos (com um leitor próprio) e alimenta WaveformSummary. */
+    void BuildWaveformSummary(const FString& FilePath);
 };
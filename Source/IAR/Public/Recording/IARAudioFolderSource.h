@@ -11,8 +11,12 @@
 #include "IARAudioSource.h" // Herda de UIARMediaSource para integração no pipeline
 #include "Core/IAR_Types.h" // Contém structs FIAR_AudioStreamSettings, FIAR_MIDIEvent, etc.
 #include "Core/IARFramePool.h" // Para gerenciamento de memória de frames (se necessário)
+#include "Recording/IARConversionManifest.h"
 #include <string> // <<-- ADICIONADO: Necessário para std::string em ConvertMIDIToAudio/ConvertAudioToMIDI
 #include "HAL/ThreadSafeBool.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Event.h"
+#include "Async/Future.h"
 #include "IARAudioFolderSource.generated.h" // <<-- ESTE INCLUIR DEVE SER O ÚLTIMO NO ARQUIVO .h
 
 
@@ -33,6 +37,12 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnFolderProcessingProgress, const
  * @brief UIARFolderSource: Uma fonte de mídia para processamento em lote de arquivos de áudio/MIDI em diretórios.
  * Lê arquivos de entrada, converte entre áudio (.wav/.mp3) e MIDI (.mid), e salva em um diretório de saída.
  * Projetado para a criação de datasets para pesquisa em MIR, garantindo alta qualidade de áudio (.wav).
+ * Os arquivos são convertidos em paralelo por até MaxConcurrentConversions workers, cada um com o seu próprio
+ * transcritor, processador de features e pool de decodificação. O progresso é reportado na ordem dos arquivos.
+ * A pasta de entrada é percorrida uma única vez, em paralelo com as conversões: cada arquivo suportado
+ * entra na fila assim que é encontrado, sem esperar a varredura da árvore inteira.
+ * Com o manifesto de conversões habilitado, um novo lote refaz apenas os arquivos cuja entrada, configuração
+ * ou saída mudou desde a última conversão bem-sucedida.
  */
 UCLASS(BlueprintType, meta=(DisplayName="IAR Folder Media Source"))
 class IAR_API UIARFolderSource : public UIARMediaSource
@@ -46,7 +56,7 @@ public:
     virtual ~UIARFolderSource();
 
     /**
-     * @brief Inicializa a fonte de diretório, escaneando o diretório de entrada.
+     * @brief Inicializa a fonte de diretório (a varredura do diretório de entrada acontece em StartCapture).
      * @param StreamSettings Configurações gerais de áudio/mídia, incluindo tipo de conteúdo.
      * @param InFramePool Referência opcional ao FramePool.
      */
@@ -81,6 +91,14 @@ public:
               meta = (DisplayName = "Overwrite Existing Files", Tooltip = "Se verdadeiro, arquivos de saída existentes com o mesmo nome serão sobrescritos. Caso contrário, serão ignorados."))
     bool bOverwriteExistingFiles = false;
 
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Folder Source Settings",
+              meta = (DisplayName = "Use Conversion Manifest", Tooltip = "Se verdadeiro, um manifesto na pasta de saída registra o hash das entradas, as configurações e o hash das saídas. Apenas os arquivos que mudaram (ou cuja saída está incompleta) são reconvertidos. Caso contrário, basta a saída existir para o arquivo ser pulado."))
+    bool bUseConversionManifest = true;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IAR|Folder Source Settings",
+              meta = (DisplayName = "Max Concurrent Conversions", ClampMin = "0", Tooltip = "Número máximo de arquivos convertidos ao mesmo tempo. 0 = um por thread de trabalho da máquina."))
+    int32 MaxConcurrentConversions = 0;
+
     // --- Delegates para Feedback de Progresso e Conclusão ---
     UPROPERTY(BlueprintAssignable, Category = "IAR|Folder Source Events")
     FOnFolderProcessingCompleted OnFolderProcessingCompleted;
@@ -105,43 +123,120 @@ protected:
 
 private:
     // --- Membros Internos para Gerenciamento de Processamento ---
-    TArray<FString>      FilesToProcess;    // Lista de caminhos absolutos dos arquivos a serem processados
-    FThreadSafeCounter  CurrentFileIndex;   // Índice do arquivo atual sendo processado (para progresso e controle)
+    FThreadSafeCounter  NextFileIndex;      // Próximo arquivo a ser pego por um worker (pode ainda não ter sido encontrado)
     FThreadSafeBool     bProcessingActive;   // Flag atômica para indicar/controlar o estado ativo do processamento assíncrono
+    TFuture<void>       BatchTask;          // Tarefa que coordena os workers do lote atual
+    FEvent*             FilesDiscoveredEvent = nullptr; // Acorda os workers que esperam a varredura encontrar mais arquivos
+
+    // Lista crescente de arquivos e progresso em ordem (um arquivo só é reportado depois de todos os anteriores)
+    FCriticalSection    FileListLock;
+    TArray<FString>     FilesToProcess;     // Caminhos absolutos, na ordem em que a varredura os encontra
+    TSet<FString>       ClaimedOutputPaths; // Saídas dos arquivos já encontrados: não são tratadas como entradas nem geradas duas vezes
+    bool                bScanComplete = false;
+    TArray<bool>        FileFinished;       // Indexado como FilesToProcess
+    TArray<FString>     FileErrors;         // Mensagem de erro de cada arquivo concluído (vazia = sucesso ou pulado)
+    int32               NextFileToReport = 0;
+
+    // Conversões válidas de lotes anteriores e as chaves das configurações do lote atual
+    FIARConversionManifest ConversionManifest;
+    FString             AudioToMIDISettingsKey;
+    FString             MIDIToAudioSettingsKey;
+
+    // Contexto de cada worker (mesmo índice em todos os arrays): nada é compartilhado entre conversões simultâneas
+    UPROPERTY()
+    TArray<TObjectPtr<UIARAudioToMIDITranscriber>> WorkerTranscribers;
+
+    UPROPERTY()
+    TArray<TObjectPtr<UIARFeatureProcessor>> WorkerFeatureProcessors; // UIARFeatureProcessor: pode ser o Basic ou o Advanced
+
+    // Pools dos frames decodificados em streaming na conversão Áudio -> MIDI (AcquireFrame tem um único consumidor);
+    // também é o pool da fonte MIDI do mesmo worker, que nunca roda ao mesmo tempo que a decodificação
+    UPROPERTY()
+    TArray<TObjectPtr<UIARFramePool>> WorkerDecodeFramePools;
 
-     // NOVO: Adicione estas duas propriedades para gerenciar o transcritor e o feature processor
+    // Leitor MIDI e sintetizador da conversão MIDI -> Áudio, reinicializados a cada arquivo
     UPROPERTY()
-    TObjectPtr<UIARAudioToMIDITranscriber> Transcriber; // <-- Agora é um membro da classe
+    TArray<TObjectPtr<UIARMIDIFileSource>> WorkerMIDIFileSources;
 
     UPROPERTY()
-    TObjectPtr<UIARFeatureProcessor> FeatureProcessor; // <-- Agora é um membro da classe
-                                                      //     Use UIARFeatureProcessor pois você pode ter o Basic ou Advanced
+    TArray<TObjectPtr<UIARMIDIToAudioSynthesizer>> WorkerSynthesizers;
     // --- Funções Auxiliares de Lógica ---
 
+    /**
+     * @brief Cria (na Game Thread) os contextos que faltam para NumWorkers workers.
+     * @return false se algum objeto não pôde ser criado.
+     */
+    bool EnsureWorkerContexts(int32 NumWorkers);
+
     /**
      * @brief O método principal de execução da tarefa assíncrona de processamento de arquivos.
-     * Itera sobre a lista de arquivos, determinando o tipo de conversão e delegando.
+     * Dispara a varredura e os workers, espera todos terminarem e sinaliza a conclusão na Game Thread.
      */
     void ProcessFileConversionAsyncTask();
 
+    /**
+     * @brief Percorre a pasta de entrada uma única vez, enfileirando os arquivos suportados à medida que são encontrados.
+     */
+    void EnumerateInputFiles();
+
+    /**
+     * @brief Acrescenta um arquivo encontrado à lista (se não for a saída de outro arquivo do lote) e acorda os workers.
+     */
+    void AddDiscoveredFile(const FString& InputFilePath, bool bIsAudioFile);
+
+    /**
+     * @brief Espera a varredura encontrar o arquivo FileIndex.
+     * @return false se a varredura terminou antes disso ou o lote foi interrompido.
+     */
+    bool WaitForDiscoveredFile(int32 FileIndex, FString& OutFilePath);
+
+    /**
+     * @brief Loop de um worker: pega o próximo arquivo ainda não processado até a lista acabar ou o lote ser interrompido.
+     */
+    void RunConversionWorker(int32 WorkerIndex);
+
+    /**
+     * @brief Converte um arquivo de acordo com a extensão (ou o pula, se a saída já existir).
+     * @return A mensagem de erro, ou vazia se o arquivo foi convertido ou pulado.
+     */
+    FString ProcessSingleFile(const FString& InputFilePath, int32 WorkerIndex);
+
+    /**
+     * @brief Decide se o arquivo precisa ser convertido (sobrescrita, manifesto ou existência da saída).
+     */
+    bool NeedsConversion(const FString& InputFilePath, const FString& OutputFilePath, const FString& SettingsKey);
+
+    /**
+     * @brief Monta as chaves das configurações que afetam as saídas (comparadas com as do manifesto).
+     */
+    void BuildSettingsKeys();
+
+    /**
+     * @brief Registra o término de um arquivo e reporta, em ordem, todos os arquivos consecutivos já concluídos.
+     */
+    void ReportFileFinished(int32 FileIndex, FString&& ErrorMessage);
+
     /**
      * @brief Converte um arquivo de áudio (.wav ou .mp3) para MIDI (.mid).
      * Decodifica áudio, transcreve para MIDI e salva o arquivo MIDI.
      * @param AudioFilePath Caminho completo do arquivo de áudio de entrada.
      * @param MIDIOutputFilePath Caminho completo para salvar o arquivo MIDI de saída.
+     * @param WorkerIndex Contexto (transcritor, processador e pool) usado na conversão.
      * @return true se a conversão foi bem-sucedida, false caso contrário.
      */
-    bool ConvertAudioToMIDI(const FString& AudioFilePath, const FString& MIDIOutputFilePath);
+    bool ConvertAudioToMIDI(const FString& AudioFilePath, const FString& MIDIOutputFilePath, int32 WorkerIndex);
 
     /**
      * @brief Converte um arquivo MIDI (.mid) para áudio (.wav).
-     * Carrega o MIDI, sintetiza o áudio e salva o arquivo WAV.
+     * Carrega o MIDI, sintetiza o áudio e o escreve em streaming no arquivo WAV, em blocos de tamanho fixo
+     * e com a fila de escrita limitada: o áudio da música nunca fica inteiro em memória.
      * A saída de áudio será sempre em formato .wav sem perdas.
      * @param MIDIFilePath Caminho completo do arquivo MIDI de entrada.
      * @param AudioOutputFilePath Caminho completo para salvar o arquivo de áudio WAV de saída.
+     * @param WorkerIndex Contexto (leitor MIDI, sintetizador e pool) usado na conversão.
      * @return true se a conversão foi bem-sucedida, false caso contrário.
      */
-    bool ConvertMIDIToAudio(const FString& MIDIFilePath, const FString& AudioOutputFilePath);
+    bool ConvertMIDIToAudio(const FString& MIDIFilePath, const FString& AudioOutputFilePath, int32 WorkerIndex);
 
     /**
      * @brief Constrói o caminho completo do arquivo de saída, determinando a extensão correta.
@@ -14,6 +14,7 @@
 #include "AudioCaptureCore.h" 
 #include "AudioCaptureDeviceInterface.h" 
 #include "Core/IAR_Types.h" 
+#include "Core/IARFrameReblocker.h"
 
 using namespace Audio;
 
@@ -22,6 +23,8 @@ using namespace Audio;
 /**
  * @brief Fonte de áudio que gerencia entradas de áudio físico, como microfones ou mixers.
  * Utiliza o módulo AudioCapture da Unreal Engine para acesso ao microfone.
+ * Os blocos do driver (de tamanho variável) são reagrupados em janelas fixas de AnalysisWindowFrames,
+ * com timestamps no relógio de amostras (StartFrameIndex / SampleRate).
  */
 UCLASS(BlueprintType)
 class IAR_API UIARAudioMixerSource : public UIARAudioSource // ATUALIZADO: Herda de UIARAudioSource
@@ -58,7 +61,11 @@ public:
 
 private:
     TUniquePtr<FAudioCapture> AudioCapture; 
+    FIARFrameReblocker Reblocker; // Acessado apenas pela thread de captura enquanto captura
     
     // Callback para receber os dados de áudio do sistema
     void OnAudioCapture(const void* InAudio, int32 NumFrames, int32 NumChannels, int32 SampleRate, double StreamTime, bool bOverFlow);
+
+    /** @brief Copia uma janela do Reblocker para um frame do pool e o publica em OnAudioFrameAcquired. */
+    void EmitWindow(const float* WindowData, int32 NumFrames, int64 StartFrameIndex, int32 OverlapFrames, int32 SampleRate, int32 NumChannels);
 };
@@ -11,14 +11,17 @@
 // ATUALIZADO: Herda de UIARAudioSource, que já herda de UIARMediaSource
 #include "IARAudioSource.h" 
 #include "Core/IARFramePool.h" 
+#include "Core/IARSignalGeneratorBank.h"
 #include "Misc/ScopeLock.h" 
+#include "HAL/ThreadSafeCounter.h"
 #include "TimerManager.h"
 
 #include "IARAudioSimulatedSource.generated.h"
 
 /**
- * @brief Fonte de áudio simulada que gera uma onda senoidal programaticamente.
- * Ideal para testes do pipeline de áudio sem depender de hardware real.
+ * @brief Fonte de áudio simulada que gera sinais de teste programaticamente (seno, acorde, varredura ou ruído).
+ * Ideal para testes do pipeline de áudio sem depender de hardware real: o sinal é determinístico
+ * (FIARSignalGeneratorBank), então execuções longas geram sempre as mesmas amostras.
  */
 UCLASS(BlueprintType)
 class IAR_API UIARAudioSimulatedSource : public UIARAudioSource // ATUALIZADO: Herda de UIARAudioSource
@@ -31,17 +34,17 @@ public:
 
     /**
      * @brief Inicializa a fonte de áudio simulada.
-     * @param StreamSettings As configurações do stream de áudio (SampleRate, NumChannels).
+     * @param StreamSettings As configurações do stream de áudio (SampleRate, NumChannels e os parâmetros TestSignal*).
      */
     virtual void Initialize(FIAR_AudioStreamSettings& StreamSettings, UIARFramePool* InFramePool) override;
 
     /**
-     * @brief Inicia a geração da onda senoidal e o envio de frames.
+     * @brief Inicia a geração do sinal (desde o início) e o envio de frames.
      */
     virtual void StartCapture() override;
 
     /**
-     * @brief Para a geração da onda senoidal e o envio de frames.
+     * @brief Para a geração do sinal e o envio de frames.
      */
     virtual void StopCapture() override;
 
@@ -52,20 +55,21 @@ public:
 
 protected:
     /**
-     * @brief Preenche um FIAR_AudioFrameData com dados de onda senoidal simulados.
-     * Esta função é chamada periodicamente por um timer.
+     * @brief Preenche um FIAR_AudioFrameData com o próximo bloco do sinal de teste.
+     * Esta função é chamada periodicamente pela thread produtora (FIARClockedProducer), fora da Game Thread.
+     * @param StreamTimeSeconds Tempo do bloco desde o início da captura (timestamp do frame).
      */
-    void FillSimulatedFrame();
+    void FillSimulatedFrame(double StreamTimeSeconds);
 
 private:
     
-    FTimerHandle AudioGenerationTimerHandle; // Timer para gerar frames periodicamente
+    FThreadSafeCounter ProducerRegistrationId; // Registro na FIARClockedProducer enquanto captura (0 = nenhum)
     
-    float CurrentTimeAccumulator; // Acumulador de tempo para a geração da onda senoidal
-    float SineWaveFrequencyHz; // Frequência da onda senoidal em Hz
+    FIARSignalGeneratorBank SignalBank; // Gerador do sinal (acessado pela thread produtora durante a captura)
 
     int32 SamplesPerFrame; // Quantidade de amostras por frame
     float FrameDurationSeconds; // Duração de cada frame em segundos
 
-    float AmplitudeModulationTime; // Para variar a amplitude ao longo do tempo
+    /** @brief Monta as vozes do SignalBank a partir dos parâmetros TestSignal* das configurações. */
+    bool ConfigureSignalBank();
 };
@@ -0,0 +1,96 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * @brief Manifesto persistente das conversões em lote, para reprocessar apenas o que mudou.
+ * Cada entrada guarda o tamanho, a data de modificação e o hash (MD5) do arquivo de entrada,
+ * a chave das configurações usadas na conversão e o mesmo estado do arquivo de saída.
+ * Uma conversão continua válida quando entrada, configurações e saída batem com o registrado:
+ * tamanho e data iguais dispensam a leitura do arquivo; o hash só é recalculado quando a data mudou.
+ * Os caminhos são gravados relativos às pastas de entrada e saída. Thread-safe.
+ */
+class IAR_API FIARConversionManifest
+{
+public:
+    FIARConversionManifest();
+
+    /**
+     * @brief Carrega o manifesto (um arquivo inexistente resulta em um manifesto vazio).
+     * @param InManifestPath Arquivo do manifesto.
+     * @param InInputRoot Pasta base dos caminhos de entrada.
+     * @param InOutputRoot Pasta base dos caminhos de saída.
+     * @return false se o arquivo existe mas não pôde ser lido.
+     */
+    bool Load(const FString& InManifestPath, const FString& InInputRoot, const FString& InOutputRoot);
+
+    /** @brief Grava o manifesto (em um arquivo temporário, depois renomeado) se houver alterações. */
+    bool Save();
+
+    /** @brief Chama Save() se houver alterações e a última gravação tiver mais de MinIntervalSeconds. */
+    bool SaveIfDue(double MinIntervalSeconds);
+
+    /**
+     * @brief Verifica se a saída registrada para a entrada ainda é válida.
+     * @return true se a entrada e a saída não mudaram desde Record() e as configurações são as mesmas.
+     */
+    bool IsUpToDate(const FString& InputFilePath, const FString& OutputFilePath, const FString& SettingsKey);
+
+    /**
+     * @brief Registra uma conversão concluída, calculando os hashes da entrada e da saída.
+     * @return false se algum dos arquivos não pôde ser lido (a entrada é descartada).
+     */
+    bool Record(const FString& InputFilePath, const FString& OutputFilePath, const FString& SettingsKey);
+
+    /** @brief Descarta a entrada registrada (ex.: conversão que falhou). */
+    void Invalidate(const FString& InputFilePath);
+
+    int32 Num() const;
+
+    /** @brief Hash MD5 do conteúdo do arquivo, em hexadecimal (vazio se não puder ser lido). */
+    static FString HashFile(const FString& FilePath);
+
+private:
+    struct FFileState
+    {
+        int64 Size = -1;
+        int64 ModificationTicks = 0;
+        FString Hash;
+    };
+
+    struct FEntry
+    {
+        FFileState Input;
+        FString SettingsKey;
+        FString OutputPath; // Relativo a OutputRoot
+        FFileState Output;
+    };
+
+    FString ManifestPath;
+    FString InputRoot;
+    FString OutputRoot;
+    TMap<FString, FEntry> Entries; // Chave: caminho de entrada relativo a InputRoot
+    bool bDirty;
+    double LastSaveTime;
+    mutable FCriticalSection ManifestLock;
+    FCriticalSection SaveLock; // Serializa Save(); adquirido antes de ManifestLock
+
+    /** @brief Lê tamanho e data de modificação (sem hash). */
+    static bool ReadFileState(const FString& FilePath, FFileState& OutState);
+
+    /**
+     * @brief Compara o arquivo com o estado registrado. Se só a data mudou e o hash bate,
+     * atualiza a data em Recorded e marca bOutRefreshed.
+     */
+    static bool MatchesRecordedState(const FString& FilePath, FFileState& Recorded, bool& bOutRefreshed);
+
+    static FString MakeRelative(const FString& FilePath, const FString& Root);
+};
@@ -30,16 +30,23 @@ public:
     void Initialize();
     void Shutdown();
 
+    /** Frames por pacote na gravação segmentada pelo FFmpeg (o tamanho do segmento deve ser múltiplo dele para o corte ser exato). */
+    static constexpr int32 SegmentPacketFrames = 1024;
+
     /**
      * @brief Constrói o comando FFmpeg para codificar um stream de áudio bruto (PCM)
      * lido de um pipe e salvá-lo em um arquivo.
+     * O Codec define o encoder e o contêiner (FLAC -> .flac, OPUS -> Ogg, AAC -> MP4 fragmentado, MP3; PCM -> WAV),
+     * e Bitrate é usado pelos codecs com perdas.
      * @param StreamSettings As configurações do stream de áudio (codec, sample rate, canais, bitrate).
      * @param InputPipeName O nome completo do Named Pipe/FIFO de onde o FFmpeg deve ler o áudio bruto.
-     * @param OutputFilePath O caminho completo para o arquivo de saída.
+     * @param OutputFilePath O caminho completo para o arquivo de saída (com SegmentFrames > 0, um padrão com "%03d" no lugar do índice).
+     * @param SegmentFrames Se > 0, divide a saída em arquivos de SegmentFrames frames (segment muxer); exato quando múltiplo de SegmentPacketFrames.
+     * @param FirstSegmentIndex Índice do primeiro segmento.
      * @return A string de comando FFmpeg completa.
      */
     UFUNCTION(BlueprintCallable, Category = "IAR|Encoder Commands")
-    static FString BuildAudioEncodeCommand(const FIAR_AudioStreamSettings& StreamSettings, const FString& InputPipeName, const FString& OutputFilePath);
+    static FString BuildAudioEncodeCommand(const FIAR_AudioStreamSettings& StreamSettings, const FString& InputPipeName, const FString& OutputFilePath, int64 SegmentFrames = 0, int32 FirstSegmentIndex = 0);
 
     /**
      * @brief Constrói o comando para encerrar um processo pelo seu ID.
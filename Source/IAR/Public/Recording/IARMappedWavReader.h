@@ -0,0 +1,74 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+// --- IMPORTANTE: NÃO INCLUIR dr_wav.h AQUI NO .h (o estado do dr_wav fica em FDrWavState, no .cpp) ---
+
+/**
+ * @brief Leitor de WAV sob demanda sobre o arquivo mapeado em memória.
+ * O cabeçalho é lido pelo dr_wav direto do mapeamento e só os frames pedidos são convertidos para float:
+ * abrir um arquivo de qualquer duração é imediato, e a memória residente se limita às páginas tocadas,
+ * que o sistema pode descartar e reler do page cache.
+ * O mapeamento de um mesmo arquivo é compartilhado entre todos os leitores abertos nele (cada leitor tem o seu cursor).
+ * Se a plataforma não suportar mapeamento, o dr_wav lê do arquivo com E/S comum, também sob demanda.
+ * Não é thread-safe: cada thread deve usar o seu próprio leitor.
+ */
+class IAR_API FIARMappedWavReader
+{
+public:
+    FIARMappedWavReader();
+    ~FIARMappedWavReader();
+
+    /**
+     * @brief Mapeia o arquivo (ou reutiliza o mapeamento já aberto) e lê o cabeçalho.
+     * @return false se o arquivo não existir, não for um WAV válido ou não tiver áudio.
+     */
+    bool Open(const FString& InFilePath);
+
+    /** @brief Fecha o leitor. O mapeamento é desfeito quando o último leitor do arquivo fecha. */
+    void Close();
+
+    /**
+     * @brief Converte até NumFrames frames a partir do cursor para float intercalado e avança o cursor.
+     * @param OutSamples Destino com espaço para NumFrames x canais amostras.
+     * @return O número de frames lidos (menor que NumFrames no fim do arquivo).
+     */
+    int64 ReadFrames(float* OutSamples, int64 NumFrames);
+
+    /** @brief Posiciona o cursor no frame indicado. */
+    bool SeekToFrame(int64 FrameIndex);
+
+    bool IsOpen() const { return WavState != nullptr; }
+    /** @brief true se o arquivo está mapeado (false quando o leitor caiu para E/S comum). */
+    bool IsMapped() const { return Mapping.IsValid(); }
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+    int64 GetNumFrames() const { return NumFrames; }
+    int64 GetCursorFrame() const { return CursorFrame; }
+    const FString& GetFilePath() const { return FilePath; }
+
+private:
+    struct FDrWavState;
+    struct FMappedFile;
+
+    FString FilePath;
+    FDrWavState* WavState;
+    TSharedPtr<FMappedFile, ESPMode::ThreadSafe> Mapping;
+    int32 SampleRate;
+    int32 NumChannels;
+    int64 NumFrames;
+    int64 CursorFrame;
+
+    /** @brief Retorna o mapeamento do arquivo, reutilizando o de outro leitor se o arquivo não mudou desde então. */
+    static TSharedPtr<FMappedFile, ESPMode::ThreadSafe> AcquireMapping(const FString& InFilePath);
+
+    // Desabilita cópia e atribuição
+    FIARMappedWavReader(const FIARMappedWavReader&) = delete;
+    FIARMappedWavReader& operator=(const FIARMappedWavReader&) = delete;
+};
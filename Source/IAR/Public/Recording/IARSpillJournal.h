@@ -0,0 +1,104 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Containers/Queue.h"
+#include "Core/IARByteBlockPool.h"
+
+class IFileHandle;
+
+/**
+ * @brief Journal sequencial em disco para os bytes que não cabem na fila em memória do encoder.
+ * Funciona como um fluxo de bytes FIFO: o produtor acrescenta no fim e o consumidor lê do início, na mesma ordem.
+ * - Append nunca toca o disco: o bloco entra em uma fila em memória (limitada por MaxStagedBytes) e uma thread
+ *   de escrita dedicada o grava no arquivo. Assim a captura não espera por um disco lento.
+ * - Read lê apenas o que a thread de escrita já gravou, por um handle próprio e sem segurar o lock durante a leitura.
+ * - O arquivo é criado na primeira escrita e volta a ser escrito desde o início sempre que o consumidor alcança o produtor.
+ * Thread-safe entre um produtor (Append) e um consumidor (Read).
+ */
+class IAR_API FIARSpillJournal : public FRunnable
+{
+public:
+    /**
+     * @param InFilePath Caminho do arquivo do journal (removido em Close).
+     * @param InMaxBytes Limite dos bytes pendentes (na fila e no arquivo). Append falha quando o limite seria ultrapassado.
+     * @param InMaxStagedBytes Limite dos bytes na fila em memória aguardando a thread de escrita.
+     * @param InBlockPool Pool para onde os blocos voltam depois de gravados (pode ser nulo).
+     */
+    FIARSpillJournal(const FString& InFilePath, int64 InMaxBytes, int64 InMaxStagedBytes, FIARByteBlockPool* InBlockPool);
+    virtual ~FIARSpillJournal();
+
+    /** @brief Inicia a thread de escrita. Chamado fora da thread de captura, antes do primeiro Append. */
+    bool Start();
+
+    /**
+     * @brief Chamado pela thread de escrita depois de cada bloco: bWritten = true se os bytes ficaram disponíveis para Read,
+     * false se a gravação falhou e o bloco foi perdido.
+     */
+    void SetOnBlockWritten(TFunction<void(bool bWritten, int64 NumBytes)>&& InOnBlockWritten) { OnBlockWritten = MoveTemp(InOnBlockWritten); }
+
+    /**
+     * @brief Enfileira um bloco para o fim do journal. Não bloqueia nem faz I/O.
+     * @return false se algum limite seria ultrapassado ou a thread não estiver ativa (o bloco fica com o chamador).
+     */
+    bool Append(TArray<uint8>&& Block);
+
+    /**
+     * @brief Lê até MaxBytes bytes do início do conteúdo já gravado e ainda não lido. Chamado apenas pelo consumidor.
+     * @return O número de bytes lidos (0 se nada foi gravado ainda), ou -1 em erro de I/O.
+     */
+    int64 Read(uint8* OutData, int64 MaxBytes);
+
+    /** @brief Bytes enfileirados ou gravados e ainda não lidos. */
+    int64 GetPendingBytes() const;
+
+    /** @brief Bytes já gravados e ainda não lidos (o que Read pode entregar agora). */
+    int64 GetReadableBytes() const;
+
+    /** @brief Para a thread de escrita, fecha e remove o arquivo, descartando o conteúdo não lido. */
+    void Close();
+
+    const FString& GetFilePath() const { return FilePath; }
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    FString FilePath;
+    int64 MaxBytes;
+    int64 MaxStagedBytes;
+    FIARByteBlockPool* BlockPool;
+    TFunction<void(bool, int64)> OnBlockWritten;
+
+    FRunnableThread* WriterThread;
+    FEvent* DataAvailableEvent;
+    FThreadSafeBool bStopRequested;
+    TQueue<TArray<uint8>, EQueueMode::Mpsc> StagedBlocks;
+
+    IFileHandle* WriteHandle; // Usado apenas pela thread de escrita
+    IFileHandle* ReadHandle;  // Usado apenas pelo consumidor
+
+    // Protegidos por JournalLock, que nunca é mantido durante I/O
+    mutable FCriticalSection JournalLock;
+    int64 StagedBytes;
+    int64 ReadOffset;
+    int64 WriteOffset;
+
+    /** @brief Grava os blocos enfileirados no arquivo (thread de escrita). */
+    void WriteStagedBlocks();
+
+    // Desabilita cópia e atribuição
+    FIARSpillJournal(const FIARSpillJournal&) = delete;
+    FIARSpillJournal& operator=(const FIARSpillJournal&) = delete;
+};
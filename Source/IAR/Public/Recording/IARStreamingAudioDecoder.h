@@ -0,0 +1,115 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/PlatformProcess.h"
+#include "Containers/Queue.h"
+#include "Core/IAR_Types.h"
+#include "Core/IARFramePool.h"
+
+class FFMpegLogReader;
+
+/**
+ * @brief Decodificador em streaming: o FFmpeg decodifica o arquivo para float 32 (f32le) intercalado no stdout,
+ * e uma thread de leitura copia blocos de tamanho fixo direto nos buffers de frames de um UIARFramePool.
+ * - Memória constante: no máximo MaxQueuedFrames frames decodificados esperam o consumidor; com a fila cheia
+ *   a thread para de ler, o pipe enche e o próprio FFmpeg fica bloqueado (backpressure até o processo).
+ * - Decodificação e análise se sobrepõem: o consumidor processa um frame enquanto os próximos são decodificados.
+ * O tamanho de cada frame é o do pool (FrameBufferSizeInSamples x canais); o último frame pode ser menor.
+ */
+class IAR_API FIARStreamingAudioDecoder : public FRunnable
+{
+public:
+    /** Frames decodificados que podem esperar o consumidor antes de a leitura parar. */
+    static constexpr int32 DefaultMaxQueuedFrames = 8;
+
+    FIARStreamingAudioDecoder();
+    virtual ~FIARStreamingAudioDecoder();
+
+    /**
+     * @brief Lança o FFmpeg e a thread de leitura.
+     * @param InputFilePath Arquivo de áudio de entrada (qualquer formato que o FFmpeg decodifique).
+     * @param InSampleRate Taxa de amostragem de saída.
+     * @param InNumChannels Número de canais de saída.
+     * @param InFramePool Pool de onde vêm os frames, inicializado com a mesma taxa e canais. Deve continuar vivo até Close;
+     *                    frames são adquiridos apenas pela thread de leitura.
+     * @param InMaxQueuedFrames Limite da fila de frames decodificados.
+     * @return true se o processo e a thread foram iniciados.
+     */
+    bool Open(const FString& InputFilePath, int32 InSampleRate, int32 InNumChannels, UIARFramePool* InFramePool, int32 InMaxQueuedFrames = DefaultMaxQueuedFrames);
+
+    /**
+     * @brief Retorna o próximo frame decodificado, esperando a thread de leitura se necessário.
+     * O frame deve voltar ao pool (ReleaseFrame) depois de processado.
+     * @return nullptr no fim do arquivo ou em erro (ver HasFailed).
+     */
+    TSharedPtr<FIAR_AudioFrameData> ReadFrame();
+
+    /** @brief Devolve um frame processado ao pool. */
+    void ReleaseFrame(TSharedPtr<FIAR_AudioFrameData> Frame);
+
+    /**
+     * @brief Encerra a decodificação (termina o FFmpeg se ele ainda estiver rodando) e libera os recursos.
+     * Frames ainda na fila voltam ao pool.
+     */
+    void Close();
+
+    bool IsOpen() const { return ReaderThread != nullptr; }
+    /** @brief true se o FFmpeg falhou ou a leitura foi interrompida por erro. */
+    bool HasFailed() const { return bHasFailed; }
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+    /** @brief Amostras por canal já decodificadas. */
+    int64 GetDecodedSampleFrames() const { return DecodedSampleFrames; }
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    FString InputPath;
+    int32 SampleRate;
+    int32 NumChannels;
+    int32 MaxQueuedFrames;
+    UIARFramePool* FramePool;
+
+    FProcHandle ProcessHandle;
+    void* ReadPipeStdout;
+    void* ReadPipeStderr;
+    FFMpegLogReader* StderrReader;
+    TArray<uint8> StderrOutput;
+    FRunnableThread* ReaderThread;
+
+    TQueue<TSharedPtr<FIAR_AudioFrameData>, EQueueMode::Spsc> DecodedFrames;
+    FThreadSafeCounter NumQueuedFrames;
+    FEvent* FrameAvailableEvent; // Sinalizado pela thread de leitura a cada frame e no fim
+    FEvent* SpaceAvailableEvent; // Sinalizado pelo consumidor a cada frame retirado
+    FThreadSafeBool bStopRequested;
+    FThreadSafeBool bEndOfStream;
+    FThreadSafeBool bHasFailed;
+    int64 DecodedSampleFrames; // Escrito apenas pela thread de leitura
+
+    // Sobra de uma leitura que não coube no frame anterior (caminho genérico, sem leitura direta no buffer)
+    TArray<uint8> StagingBytes;
+    int32 StagingOffset;
+
+    /**
+     * @brief Lê do stdout do FFmpeg até preencher NumBytes (ou até o fim do stream).
+     * @return false no fim do stream, em erro ou parada; OutBytesRead indica o que foi lido mesmo assim.
+     */
+    bool ReadBlock(uint8* Dest, int64 NumBytes, int64& OutBytesRead);
+
+    // Desabilita cópia e atribuição
+    FIARStreamingAudioDecoder(const FIARStreamingAudioDecoder&) = delete;
+    FIARStreamingAudioDecoder& operator=(const FIARStreamingAudioDecoder&) = delete;
+};
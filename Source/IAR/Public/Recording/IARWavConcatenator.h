@@ -0,0 +1,49 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief Monta um único WAV a partir de vários WAVs PCM no mesmo formato, em processo (sem FFmpeg).
+ * Apenas os cabeçalhos das entradas são interpretados: os chunks de dados são copiados em blocos grandes e
+ * sequenciais para um arquivo pré-alocado, com um único cabeçalho escrito no início
+ * (RIFF, ou RF64 quando o total não cabe em 4GB).
+ */
+class IAR_API FIARWavConcatenator
+{
+public:
+    /** Tamanho de cada leitura/escrita da cópia dos dados. */
+    static constexpr int64 CopyBlockSize = 8 * 1024 * 1024;
+
+    /** Localização dos dados de áudio e formato (chunk "fmt " bruto) de um arquivo WAV. */
+    struct FWavLayout
+    {
+        TArray<uint8> FormatChunk;
+        int64 DataOffset = 0;
+        int64 DataBytes = 0;
+    };
+
+    /**
+     * @brief Lê o cabeçalho de um WAV (RIFF ou RF64) sem ler os dados.
+     * @return false se o arquivo não existir ou não for um WAV válido.
+     */
+    static bool ReadLayout(const FString& FilePath, FWavLayout& OutLayout);
+
+    /**
+     * @brief Verifica se todas as entradas são WAV PCM/float com o mesmo chunk "fmt " (concatenáveis sem reamostrar).
+     */
+    static bool CanConcatenate(const TArray<FString>& InputPaths);
+
+    /**
+     * @brief Concatena os dados das entradas, na ordem, em OutputPath.
+     * O arquivo é montado em WorkDirectory e só é movido para OutputPath quando está completo.
+     * @return true se o arquivo de saída foi escrito por completo.
+     */
+    static bool Concatenate(const TArray<FString>& InputPaths, const FString& OutputPath, const FString& WorkDirectory);
+};
@@ -0,0 +1,135 @@
+﻿// -------------------------------------------------------------------------------
+// Copyright 2025 William Wolff. All Rights Reserved.
+// This code is property of William Wolff and protected by copywright law.
+// Proibited copy or distribution without expressed authorization of the Author.
+// Creation: 05/08/2025
+// Author  : William Wolff
+// -------------------------------------------------------------------------------
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Containers/Queue.h"
+#include "Core/IARSampleFormatConverter.h"
+#include "Core/IARByteBlockPool.h"
+// --- IMPORTANTE: NÃO INCLUIR dr_wav.h AQUI NO .h (o estado do dr_wav fica em FDrWavState, no .cpp) ---
+
+class IFileHandle;
+
+/**
+ * @brief Escritor de WAV em streaming, em processo, construído sobre o dr_wav.
+ * Substitui o FFmpeg (processo + pipe) quando a saída é PCM: os blocos de amostras são enfileirados
+ * por qualquer thread e escritos por uma thread de I/O dedicada.
+ * - Escritas grandes e alinhadas: o dr_wav escreve em um buffer alinhado de WriteBlockSize bytes,
+ *   que só vai para o disco quando está cheio (ou no fechamento).
+ * - Extensões pré-alocadas: o arquivo cresce em passos de PreallocationExtentSize via Truncate,
+ *   à frente do cursor de escrita, e é cortado no tamanho exato ao fechar.
+ * - RIFF ou RF64: com tamanho esperado conhecido, o contêiner é escolhido na abertura. Com tamanho desconhecido,
+ *   o cabeçalho é reservado no layout do RF64 (o ds64 ocupa o lugar de um chunk JUNK de mesmo tamanho) e, ao fechar,
+ *   é reescrito no lugar como RIFF + JUNK se os dados couberem em 4GB. Só takes realmente maiores ficam em RF64.
+ */
+class IAR_API FIARWavStreamWriter : public FRunnable
+{
+public:
+    /** Tamanho de cada escrita em disco (e do buffer alinhado). */
+    static constexpr int64 WriteBlockSize = 1024 * 1024;
+    /** Alinhamento do buffer de escrita (tamanho de página / setor). */
+    static constexpr uint32 WriteBlockAlignment = 4096;
+    /** Passo de crescimento do arquivo à frente do cursor de escrita. */
+    static constexpr int64 PreallocationExtentSize = 64 * 1024 * 1024;
+    /** Maior bloco de dados que um contêiner RIFF comporta (o tamanho do chunk RIFF é 36 + dados, em 32 bits). */
+    static constexpr int64 RIFFMaxDataBytes = 0xFFFFFFFFll - 36;
+
+    FIARWavStreamWriter();
+    virtual ~FIARWavStreamWriter();
+
+    /**
+     * @brief Cria o arquivo, escreve o cabeçalho e inicia a thread de I/O.
+     * @param InFilePath Caminho completo do arquivo de saída.
+     * @param SampleRate Taxa de amostragem.
+     * @param NumChannels Número de canais.
+     * @param SampleFormat Formato das amostras que serão enfileiradas.
+     * @param ExpectedDataBytes Tamanho esperado dos dados de áudio. Acima de RIFFMaxDataBytes seleciona RF64;
+     *        <= 0 (desconhecido) adia a escolha para o fechamento (RIFF se couber, RF64 caso contrário).
+     * @return true se o arquivo foi aberto com sucesso.
+     */
+    bool Open(const FString& InFilePath, int32 SampleRate, int32 NumChannels, EIARSampleFormat SampleFormat, int64 ExpectedDataBytes);
+
+    /**
+     * @brief Define o pool para onde os blocos são devolvidos depois de escritos. Deve ser chamado antes de Open.
+     */
+    void SetBlockPool(FIARByteBlockPool* InBlockPool) { BlockPool = InBlockPool; }
+
+    /**
+     * @brief Enfileira um bloco de amostras já no formato de saída (PCM little-endian intercalado). Não bloqueia.
+     * @return false se o escritor não estiver aberto ou tiver falhado.
+     */
+    bool EnqueueSamples(TArray<uint8>&& SampleBytes);
+
+    /**
+     * @brief Escreve tudo o que estiver na fila, finaliza o cabeçalho e fecha o arquivo.
+     * Bloqueia até a thread de I/O terminar.
+     * @return true se o arquivo foi finalizado sem erros.
+     */
+    bool Close();
+
+    bool IsOpen() const { return WriterThread != nullptr; }
+    bool HasFailed() const { return bHasFailed; }
+    /** @brief Contêiner atual (com tamanho desconhecido, só é definitivo depois de Close). */
+    bool IsRF64() const { return bUseRF64; }
+    const FString& GetFilePath() const { return FilePath; }
+
+    /** @brief Bytes de áudio já entregues ao dr_wav pela thread de I/O. */
+    int64 GetDataBytesWritten() const { return DataBytesWritten.GetValue(); }
+
+    /** @brief Bytes enfileirados e ainda não entregues ao dr_wav. */
+    int64 GetQueuedBytes() const { return QueuedBytes.GetValue(); }
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FDrWavState;
+
+    FString FilePath;
+    IFileHandle* FileHandle;
+    FDrWavState* WavState;
+    FRunnableThread* WriterThread;
+    FIARByteBlockPool* BlockPool;
+
+    TQueue<TArray<uint8>, EQueueMode::Mpsc> PendingBlocks;
+    FEvent* DataAvailableEvent;
+    FThreadSafeBool bStopRequested;
+    FThreadSafeBool bHasFailed;
+    FThreadSafeCounter64 DataBytesWritten;
+    FThreadSafeCounter64 QueuedBytes;
+    bool bUseRF64;
+    bool bDeferContainerChoice; // Tamanho desconhecido na abertura: RF64 reescrito como RIFF no fechamento, se couber
+
+    // Buffer alinhado de escrita (acessado apenas pela thread de I/O após Open)
+    uint8* WriteBuffer;
+    int64 WriteBufferFill;
+    int64 WriteBufferFileOffset; // Posição no arquivo do primeiro byte do buffer
+    int64 FileEndOffset;         // Maior posição já escrita (tamanho final do arquivo)
+    int64 PreallocatedSize;      // Tamanho atual do arquivo em disco, incluindo a extensão pré-alocada
+
+    /** @brief Copia bytes para o buffer alinhado, descarregando blocos cheios no disco. */
+    bool BufferedWrite(const uint8* Data, int64 NumBytes);
+    /** @brief Descarrega o buffer e reposiciona o cursor (usado pelo dr_wav para atualizar o cabeçalho). */
+    bool BufferedSeek(int64 Offset);
+    /** @brief Escreve o conteúdo do buffer no disco, estendendo a pré-alocação se necessário. */
+    bool FlushWriteBuffer();
+    /** @brief Finaliza o dr_wav, descarrega o buffer, corta a pré-alocação e fecha o arquivo. */
+    void FinalizeFile();
+    /** @brief Reescreve no lugar um cabeçalho RF64 como RIFF, trocando o ds64 por um JUNK do mesmo tamanho. */
+    bool RewriteHeaderAsRIFF(int64 DataChunkDataPos, int64 DataBytes);
+    void FailWithError(const FString& ErrorMessage);
+
+    // Desabilita cópia e atribuição
+    FIARWavStreamWriter(const FIARWavStreamWriter&) = delete;
+    FIARWavStreamWriter& operator=(const FIARWavStreamWriter&) = delete;
+};
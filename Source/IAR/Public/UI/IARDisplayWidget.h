@@ -44,6 +44,10 @@ public:
     UPROPERTY(BlueprintReadWrite, Category = "IAR|Display")
     UTexture2D* CurrentFilterTexture; // Textura que será exibida (geralmente ligada a um UImage no BP)
 
+    // Deslocamento de UV dos espectrogramas circulares (ligar a um parâmetro de material: U' = frac(U + Offset))
+    UPROPERTY(BlueprintReadOnly, Category = "IAR|Display")
+    float CurrentSpectrogramScrollOffset = 0.0f;
+
     /**
      * @brief Atualiza a textura do espectrograma exibida no widget.
      * Esta função é para o usuário chamar, passando a textura do FIAR_JustRTFrame.
@@ -79,6 +83,7 @@ public:
     /**
      * @brief Evento disparado quando um novo FIAR_JustRTFrame é recebido e processado.
      * Pode ser implementado em Blueprint para reagir aos dados em tempo real.
+     * Dispara na taxa FeatureBroadcastRateHz do UIARAudioComponent (features agregadas entre disparos), não a cada frame de áudio.
      * @param FrameData O frame de áudio em tempo real contendo dados brutos, features e texturas.
      */
     UFUNCTION(BlueprintImplementableEvent, Category = "IAR|Display Events", DisplayName = "On New Real-Time Audio Frame Data")